@@ -28,7 +28,7 @@ include(SharedLibraries)
 set(INCLUDES arpa/inet.h fcntl.h inttypes.h limits.h netdb.h
     netinet/in.h stddef.h stdlib.h string.h sys/mman.h
     sys/resource.h sys/rusage.h sys/socket.h sys/statvfs.h sys/time.h
-    syslog.h unistd.h stdbool.h isa-l/erasure_code.h
+    syslog.h unistd.h stdbool.h isa-l/erasure_code.h linux/io_uring.h
 )
 
 if(CMAKE_SYSTEM_NAME STREQUAL "FreeBSD")
@@ -258,6 +258,7 @@ rm -rf $RPM_BUILD_ROOT
 %attr(755,root,root) %{_sbindir}/sfsmaster
 %attr(755,root,root) %{_sbindir}/sfsrestoremaster
 %attr(755,root,root) %{_sbindir}/sfsmetadump
+%attr(755,root,root) %{_sbindir}/sfschangelogconv
 %attr(755,root,root) %{_sbindir}/sfsmetarestore
 %dir %{sau_confdir}
 %attr(755,%{sau_user},%{sau_group}) %dir %{sau_confdir}
@@ -271,6 +272,7 @@ rm -rf $RPM_BUILD_ROOT
 %{_mandir}/man7/saunafs.7*
 %{_mandir}/man8/sfsmaster.8*
 %{_mandir}/man8/sfsmetadump.8*
+%{_mandir}/man8/sfschangelogconv.8*
 %{_mandir}/man8/sfsmetarestore.8*
 %{_mandir}/man8/sfsrestoremaster.8*
 %{sau_master_examples}/sfsexports.cfg
@@ -83,6 +83,7 @@ const static std::unordered_map<std::string, std::string> defaultOptionsMaster =
     {"CUSTOM_GOALS_FILENAME", ""},
     {"PREFER_LOCAL_CHUNKSERVER", "1"},
     {"BACK_LOGS", "50"},
+    {"CHANGELOG_FORMAT", "text"},
     {"BACK_META_KEEP_PREVIOUS", "3"},
     {"AUTO_RECOVERY", "0"},
     {"REPLICATIONS_DELAY_INIT", "300"},
@@ -102,6 +103,7 @@ const static std::unordered_map<std::string, std::string> defaultOptionsMaster =
     {"CHUNKS_LOOP_MIN_TIME", "300"},
     {"CHUNKS_LOOP_PERIOD", "1000"},
     {"CHUNKS_LOOP_MAX_CPU", "60"},
+    {"CHUNKS_LOOP_THREADS", "0"},
     {"USE_LINEAR_ASSIGNMENT_OPTIMIZER", "1"},
     {"CHUNKS_SOFT_DEL_LIMIT", "10"},
     {"CHUNKS_HARD_DEL_LIMIT", "25"},
@@ -119,6 +121,7 @@ const static std::unordered_map<std::string, std::string> defaultOptionsMaster =
     {"METADATA_CHECKSUM_RECALCULATION_SPEED", "100"},
     {"DISABLE_METADATA_CHECKSUM_VERIFICATION", "0"},
     {"NO_ATIME", "0"},
+    {"METADATA_READER_THREADS", "0"},
     {"METADATA_SAVE_REQUEST_MIN_PERIOD", "1800"},
     {"SESSION_SUSTAIN_TIME", "86400"},
     {"USE_BDB_FOR_NAME_STORAGE", "0"},
@@ -127,6 +130,7 @@ const static std::unordered_map<std::string, std::string> defaultOptionsMaster =
     {"REDUNDANCY_LEVEL", "0"},
     {"SNAPSHOT_INITIAL_BATCH_SIZE", "1000"},
     {"SNAPSHOT_INITIAL_BATCH_SIZE_LIMIT", "10000"},
+    {"SNAPSHOT_COPY_ON_WRITE", "0"},
     {"FILE_TEST_LOOP_MIN_TIME", "3600"},
     {"PRIORITIZE_DATA_PARTS", "1"},
 };
@@ -157,6 +161,7 @@ const static std::unordered_map<std::string, std::string> defaultOptionsCS = {
     {"HDD_CONF_FILENAME", ETC_PATH "/sfshdd.cfg"},
     {"HDD_TEST_FREQ", "10.0"},
     {"HDD_CHECK_CRC_WHEN_READING", "1"},
+    {"HDD_ZERO_COPY_READS", "0"},
     {"HDD_CHECK_CRC_WHEN_WRITING", "1"},
     {"HDD_ADVISE_NO_CACHE", "0"},
     {"HDD_PUNCH_HOLES", "0"},
@@ -171,6 +176,9 @@ const static std::unordered_map<std::string, std::string> defaultOptionsCS = {
     {"REPLICATION_TOTAL_TIMEOUT_MS", "60000"},
     {"REPLICATION_CONNECTION_TIMEOUT_MS", "1000"},
     {"REPLICATION_WAVE_TIMEOUT_MS", "500"},
+    {"URING_QUEUE_DEPTH", "64"},
+    {"URING_DIRECT_IO", "0"},
+    {"URING_REGISTERED_BUFFERS", "0"},
 };
 
 const static std::unordered_map<std::string, std::string> defaultOptionsMeta = {
@@ -181,6 +189,7 @@ const static std::unordered_map<std::string, std::string> defaultOptionsMeta = {
     {"LOCK_MEMORY", "0"},
     {"NICE_LEVEL", "-19"},
     {"BACK_LOGS", "50"},
+    {"CHANGELOG_FORMAT", "text"},
     {"BACK_META_KEEP_PREVIOUS", "3"},
     {"META_DOWNLOAD_FREQ", "24"},
     {"MASTER_HOST", "sfsmaster"},
@@ -0,0 +1,88 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "common/changelog_file.h"
+#include "common/crc.h"
+
+static void usage(const char *appname) {
+	fprintf(stderr,
+	        "usage: %s text|binary INPUT OUTPUT\n\n"
+	        "Converts the metadata change log INPUT (in any format) to OUTPUT in the\n"
+	        "given format. OUTPUT must not exist.\n",
+	        appname);
+	exit(1);
+}
+
+int main(int argc, char **argv) {
+	if (argc != 4) {
+		usage(argv[0]);
+	}
+	ChangelogFormat format;
+	if (strcmp(argv[1], "text") == 0) {
+		format = ChangelogFormat::kText;
+	} else if (strcmp(argv[1], "binary") == 0) {
+		format = ChangelogFormat::kBinary;
+	} else {
+		usage(argv[0]);
+	}
+	mycrc32_init();
+
+	ChangelogFileReader reader(argv[2]);
+	if (!reader.isOpen()) {
+		fprintf(stderr, "can't open %s: %s\n", argv[2], strerror(errno));
+		return 1;
+	}
+	FILE *output = fopen(argv[3], "wx");
+	if (output == nullptr) {
+		fprintf(stderr, "can't create %s: %s\n", argv[3], strerror(errno));
+		return 1;
+	}
+	bool ok = format == ChangelogFormat::kText || writeBinaryChangelogHeader(output);
+
+	uint64_t version;
+	uint64_t count = 0;
+	std::string entry;
+	while (ok && reader.next(version, entry)) {
+		// Skip the ": " separating the entry from the version
+		ok = writeChangelogEntry(output, format, version, entry.c_str() + 2);
+		++count;
+	}
+	if (fclose(output) != 0) {
+		ok = false;
+	}
+	if (!ok) {
+		fprintf(stderr, "can't write %s: %s\n", argv[3], strerror(errno));
+		return 1;
+	}
+	if (!reader.error().empty()) {
+		fprintf(stderr, "%s: %s, the following changes were not converted\n", argv[2],
+		        reader.error().c_str());
+		return 1;
+	}
+	printf("%" PRIu64 " changes converted\n", count);
+	return 0;
+}
@@ -21,6 +21,7 @@
 #include "common/platform.h"
 #include "chunkserver/bgjobs.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cinttypes>
 #include <climits>
@@ -32,13 +33,17 @@
 #include <cassert>
 #include <cstdint>
 #include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include "chunkserver/chunk_replicator.h"
 #include "chunkserver/hddspacemgr.h"
+#include "chunkserver/job_queue.h"
 #include "common/chunk_part_type.h"
 #include "common/chunk_type_with_address.h"
 #include "common/massert.h"
 #include "common/pcqueue.h"
+#include "config/cfg.h"
 #include "devtools/TracePrinter.h"
 #include "devtools/request_log.h"
 
@@ -52,7 +57,6 @@ enum {
 };
 
 enum {
-	OP_EXIT,
 	OP_INVAL,
 	OP_CHUNKOP,
 	OP_OPEN,
@@ -60,6 +64,7 @@ enum {
 	OP_READ,
 	OP_PREFETCH,
 	OP_WRITE,
+	OP_WRITE_BLOCKS,
 	OP_REPLICATE,
 	OP_GET_BLOCKS
 };
@@ -111,6 +116,16 @@ struct chunk_prefetch_args {
 	const uint8_t *buffer;
 };
 
+// for OP_WRITE_BLOCKS
+struct chunk_write_blocks_args {
+	uint64_t chunkId;
+	uint32_t chunkVersion;
+	ChunkPartType chunkType;
+	uint32_t count;
+	ChunkBlockWrite blocks[kMaxBlocksPerWriteJob];
+	uint32_t *blocksWritten;
+};
+
 struct chunk_get_blocks_args {
 	uint64_t chunkId;
 	uint32_t chunkVersion;
@@ -147,23 +162,43 @@ struct jobpool {
 	pthread_t *workerthreads;
 	std::mutex pipeMutex;
 	std::mutex jobsMutex;
-	std::unique_ptr<ProducerConsumerQueue> jobsQueue;
+	std::unique_ptr<JobQueue> jobsQueue;
 	std::unique_ptr<ProducerConsumerQueue> statusQueue;
 	job* jobhash[JHASHSIZE];
 	uint32_t nextjobid = 1;
 
-	jobpool(int rpipe, int wpipe, uint8_t workers, uint32_t maxJobs)
+	jobpool(int rpipe, int wpipe, uint8_t workers, uint32_t maxJobs,
+	        const JobQueue::Limits &limits)
 	    : rpipe(rpipe), wpipe(wpipe), workers(workers) {
 		workerthreads = (pthread_t *)malloc(sizeof(pthread_t) * workers);
 		passert(workerthreads);
 
-		jobsQueue = std::make_unique<ProducerConsumerQueue>(maxJobs);
+		jobsQueue = std::make_unique<JobQueue>(maxJobs, limits);
 		statusQueue = std::make_unique<ProducerConsumerQueue>();
 
 		for (auto &job : jobhash) { job = nullptr; }
 	};
 };
 
+// All the pools, for reloading their limits and for gathering their statistics
+static std::mutex gJobPoolsMutex;
+static std::vector<jobpool *> gJobPools;
+
+/// Limits of jobs run at once by \a workers workers, client jobs may use all of them
+static JobQueue::Limits job_pool_limits(uint8_t workers) {
+	auto share = [workers](const char *option, uint32_t defaultPercent) {
+		uint32_t percent = cfg_get_minmaxvalue<uint32_t>(option, defaultPercent, 1, 100);
+		return std::max<uint32_t>(1, (workers * percent + 99) / 100);
+	};
+	JobQueue::Limits limits;
+	limits.maxRunning[JobQueue::kForegroundRead] = workers;
+	limits.maxRunning[JobQueue::kForegroundWrite] = workers;
+	limits.maxRunning[JobQueue::kReplication] = share("BGJOBS_REPLICATION_WORKERS_PERCENT", 50);
+	limits.maxRunning[JobQueue::kHousekeeping] = share("BGJOBS_HOUSEKEEPING_WORKERS_PERCENT", 25);
+	limits.maxRunningPerDisk = share("BGJOBS_DISK_WORKERS_PERCENT", 75);
+	return limits;
+}
+
 static inline void job_send_status(jobpool *jp, uint32_t jobid, uint8_t status) {
 	TRACETHIS2(jobid, (int)status);
 
@@ -205,11 +240,11 @@ void* job_worker(void *th_arg) {
 	uint8_t status, jstate;
 	uint32_t jobid;
 	uint32_t op;
+	JobQueue::Ticket ticket;
 
 	std::unique_lock jobsUniqueLock(jp->jobsMutex, std::defer_lock);
 
-	for (;;) {
-		jp->jobsQueue->get(&jobid, &op, &jptrarg, nullptr);
+	while (jp->jobsQueue->get(&jobid, &op, &jptrarg, &ticket)) {
 		jptr = (job*)jptrarg;
 		PRINTTHIS(op);
 		jobsUniqueLock.lock();
@@ -224,6 +259,7 @@ void* job_worker(void *th_arg) {
 		jobsUniqueLock.unlock();
 		switch (op) {
 			case OP_INVAL:
+			default:
 				status = SAUNAFS_ERROR_EINVAL;
 				break;
 			case OP_CHUNKOP:
@@ -311,6 +347,22 @@ void* job_worker(void *th_arg) {
 				}
 				break;
 			}
+			case OP_WRITE_BLOCKS:
+			{
+				auto wrargs = (chunk_write_blocks_args*)(jptr->args);
+				*wrargs->blocksWritten = 0;
+				if (jstate==JSTATE_DISABLED) {
+					status = SAUNAFS_ERROR_NOTDONE;
+				} else {
+					status = hddChunkWriteBlocks(wrargs->chunkId, wrargs->chunkVersion,
+							wrargs->chunkType, wrargs->blocks, wrargs->count,
+							wrargs->blocksWritten);
+				}
+				if (status != SAUNAFS_STATUS_OK) {
+						safs::log_err("Failed to write chunk id {}: {}", wrargs->chunkId, saunafs_error_string(status));
+				}
+				break;
+			}
 			case OP_GET_BLOCKS:
 			{
 				auto gbargs = (chunk_get_blocks_args*)(jptr->args);
@@ -342,14 +394,16 @@ void* job_worker(void *th_arg) {
 				}
 				break;
 			}
-			default:
-				return nullptr;
 		}
+		jp->jobsQueue->done(ticket);
 		job_send_status(jp,jobid,status);
 	}
+	return nullptr;
 }
 
-static inline uint32_t job_new(jobpool *jp,uint32_t op,void *args,void (*callback)(uint8_t status,void *extra),void *extra) {
+static inline uint32_t job_new(jobpool *jp, uint32_t op, void *args,
+		void (*callback)(uint8_t status, void *extra), void *extra,
+		JobQueue::Priority priority, const IDisk *disk) {
 	TRACETHIS();
 	uint32_t jobid = jp->nextjobid;
 	uint32_t jhpos = JHASHPOS(jobid);
@@ -363,7 +417,7 @@ static inline uint32_t job_new(jobpool *jp,uint32_t op,void *args,void (*callbac
 	jptr->jstate = JSTATE_ENABLED;
 	jptr->next = jp->jobhash[jhpos];
 	jp->jobhash[jhpos] = jptr;
-	jp->jobsQueue->put(jobid, op, reinterpret_cast<uint8_t*>(jptr), 1);
+	jp->jobsQueue->put(jobid, op, reinterpret_cast<uint8_t*>(jptr), priority, disk);
 	jp->nextjobid++;
 	if (jp->nextjobid==0) {
 		jp->nextjobid=1;
@@ -383,7 +437,7 @@ void* job_pool_new(uint8_t workers,uint32_t jobs,int *wakeupdesc) {
 	if (pipe(fd)<0) {
 		return NULL;
 	}
-	jp = new jobpool(fd[0], fd[1], workers, jobs);
+	jp = new jobpool(fd[0], fd[1], workers, jobs, job_pool_limits(workers));
 	passert(jp);
 	*wakeupdesc = fd[0];
 	zassert(pthread_attr_init(&thattr));
@@ -393,9 +447,37 @@ void* job_pool_new(uint8_t workers,uint32_t jobs,int *wakeupdesc) {
 		zassert(pthread_create(jp->workerthreads + i, &thattr, job_worker, jp));
 	}
 	zassert(pthread_attr_destroy(&thattr));
+	std::lock_guard jobPoolsLockGuard(gJobPoolsMutex);
+	gJobPools.push_back(jp);
 	return jp;
 }
 
+void job_pools_reload() {
+	std::lock_guard jobPoolsLockGuard(gJobPoolsMutex);
+	for (jobpool *jp : gJobPools) {
+		jp->jobsQueue->setLimits(job_pool_limits(jp->workers));
+	}
+}
+
+void job_pools_disk_queue_stats(uint32_t *maxQueuedJobs, uint32_t *maxAverageWaitUsec) {
+	std::unordered_map<JobQueue::DiskKey, JobQueue::DiskStats> stats;
+	{
+		std::lock_guard jobPoolsLockGuard(gJobPoolsMutex);
+		for (jobpool *jp : gJobPools) {
+			jp->jobsQueue->takeDiskStats(stats);
+		}
+	}
+	*maxQueuedJobs = 0;
+	*maxAverageWaitUsec = 0;
+	for (const auto &[disk, diskStats] : stats) {
+		*maxQueuedJobs = std::max(*maxQueuedJobs, diskStats.peakQueued);
+		if (diskStats.waitCount > 0) {
+			*maxAverageWaitUsec = std::max<uint32_t>(*maxAverageWaitUsec,
+					diskStats.waitUsecSum / diskStats.waitCount);
+		}
+	}
+}
+
 uint32_t job_pool_jobs_count(void *jpool) {
 	TRACETHIS();
 	jobpool* jp = (jobpool*)jpool;
@@ -486,9 +568,11 @@ void job_pool_delete(void *jpool) {
 	jobpool* jp = (jobpool*)jpool;
 	uint32_t i;
 
-	for (i = 0; i < jp->workers; i++) {
-		jp->jobsQueue->put(0, OP_EXIT, nullptr, 1);
+	{
+		std::lock_guard jobPoolsLockGuard(gJobPoolsMutex);
+		std::erase(gJobPools, jp);
 	}
+	jp->jobsQueue->close();
 
 	for (i = 0; i < jp->workers; i++) {
 		zassert(pthread_join(jp->workerthreads[i], NULL));
@@ -511,7 +595,7 @@ void job_pool_delete(void *jpool) {
 uint32_t job_inval(void *jpool,void (*callback)(uint8_t status,void *extra),void *extra) {
 	TRACETHIS();
 	jobpool* jp = (jobpool*)jpool;
-	return job_new(jp,OP_INVAL,NULL,callback,extra);
+	return job_new(jp, OP_INVAL, NULL, callback, extra, JobQueue::kForegroundRead, nullptr);
 }
 
 uint32_t job_chunkop(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
@@ -529,7 +613,11 @@ uint32_t job_chunkop(void *jpool, void (*callback)(uint8_t status, void *extra),
 	args->copyversion = copyversion;
 	args->length = length;
 	args->chunkType = chunkType;
-	return job_new(jp,OP_CHUNKOP,args,callback,extra);
+	// Deletions and tests are not waited for by anybody, other operations precede writes
+	bool housekeeping = newversion == 0 && (length == 0 || length == 2);
+	return job_new(jp, OP_CHUNKOP, args, callback, extra,
+			housekeeping ? JobQueue::kHousekeeping : JobQueue::kForegroundWrite,
+			hddGetChunkDisk(chunkid, chunkType));
 }
 
 uint32_t job_open(void *jpool, void (*callback)(uint8_t status,void *extra), void *extra,
@@ -541,7 +629,8 @@ uint32_t job_open(void *jpool, void (*callback)(uint8_t status,void *extra), voi
 	passert(args);
 	args->chunkid = chunkid;
 	args->chunkType = chunkType;
-	return job_new(jp,OP_OPEN,args,callback,extra);
+	return job_new(jp, OP_OPEN, args, callback, extra, JobQueue::kForegroundRead,
+			hddGetChunkDisk(chunkid, chunkType));
 }
 
 uint32_t job_close(void *jpool, void (*callback)(uint8_t status,void *extra), void *extra,
@@ -553,7 +642,8 @@ uint32_t job_close(void *jpool, void (*callback)(uint8_t status,void *extra), vo
 	passert(args);
 	args->chunkid = chunkid;
 	args->chunkType = chunkType;
-	return job_new(jp,OP_CLOSE,args,callback,extra);
+	return job_new(jp, OP_CLOSE, args, callback, extra, JobQueue::kForegroundRead,
+			hddGetChunkDisk(chunkid, chunkType));
 }
 
 uint32_t job_read(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
@@ -574,7 +664,8 @@ uint32_t job_read(void *jpool, void (*callback)(uint8_t status, void *extra), vo
 	args->blocksToBeReadAhead = blocksToBeReadAhead;
 	args->outputBuffer = outputBuffer;
 	args->performHddOpen = performHddOpen;
-	return job_new(jp,OP_READ,args,callback,extra);
+	return job_new(jp, OP_READ, args, callback, extra, JobQueue::kForegroundRead,
+			hddGetChunkDisk(chunkid, chunkType));
 }
 
 uint32_t job_prefetch(void *jpool, uint64_t chunkid, uint32_t version, ChunkPartType chunkType,
@@ -589,7 +680,8 @@ uint32_t job_prefetch(void *jpool, uint64_t chunkid, uint32_t version, ChunkPart
 	args->chunkType = chunkType;
 	args->firstBlock = firstBlockToBePrefetched;
 	args->nrOfBlocks = nrOfBlocksToBePrefetched;
-	return job_new(jp,OP_PREFETCH, args, nullptr, nullptr);
+	return job_new(jp, OP_PREFETCH, args, nullptr, nullptr, JobQueue::kForegroundRead,
+			hddGetChunkDisk(chunkid, chunkType));
 }
 
 
@@ -609,7 +701,27 @@ uint32_t job_write(void *jpool, void (*callback)(uint8_t status, void *extra), v
 	args->size = size;
 	args->crc = crc;
 	args->buffer = buffer;
-	return job_new(jp, OP_WRITE, args, callback, extra);
+	return job_new(jp, OP_WRITE, args, callback, extra, JobQueue::kForegroundWrite,
+			hddGetChunkDisk(chunkId, chunkType));
+}
+
+uint32_t job_write_blocks(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
+		uint64_t chunkId, uint32_t chunkVersion, ChunkPartType chunkType,
+		const ChunkBlockWrite *blocks, uint32_t count, uint32_t *blocksWritten) {
+	TRACETHIS();
+	jobpool* jp = (jobpool*)jpool;
+	chunk_write_blocks_args *args;
+	sassert(count > 0 && count <= kMaxBlocksPerWriteJob);
+	args = (chunk_write_blocks_args*) malloc(sizeof(chunk_write_blocks_args));
+	passert(args);
+	args->chunkId = chunkId;
+	args->chunkVersion = chunkVersion;
+	args->chunkType = chunkType;
+	args->count = count;
+	std::copy(blocks, blocks + count, args->blocks);
+	args->blocksWritten = blocksWritten;
+	return job_new(jp, OP_WRITE_BLOCKS, args, callback, extra, JobQueue::kForegroundWrite,
+			hddGetChunkDisk(chunkId, chunkType));
 }
 
 uint32_t job_get_blocks(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
@@ -623,7 +735,8 @@ uint32_t job_get_blocks(void *jpool, void (*callback)(uint8_t status, void *extr
 	args->chunkVersion = version;
 	args->chunkType = chunkType;
 	args->blocks = blocks;
-	return job_new(jp, OP_GET_BLOCKS, args, callback, extra);
+	return job_new(jp, OP_GET_BLOCKS, args, callback, extra, JobQueue::kForegroundRead,
+			hddGetChunkDisk(chunkId, chunkType));
 }
 
 uint32_t job_replicate(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
@@ -645,5 +758,6 @@ uint32_t job_replicate(void *jpool, void (*callback)(uint8_t status, void *extra
 	args->sourcesBuffer = (uint8_t*)args + sizeof(chunk_replication_args);
 	memcpy((void*)args->sourcesBuffer, (void*)sourcesBuffer, sourcesBufferSize);
 
-	return job_new(jp, OP_REPLICATE, args, callback, extra);
+	// The disk of a replicated part is chosen when it is created
+	return job_new(jp, OP_REPLICATE, args, callback, extra, JobQueue::kReplication, nullptr);
 }
@@ -26,6 +26,7 @@
 #include <vector>
 
 #include "chunkserver/output_buffer.h"
+#include "chunkserver-common/disk_interface.h"
 #include "common/chunk_type_with_address.h"
 
 void* job_pool_new(uint8_t workers,uint32_t jobs,int *wakeupdesc);
@@ -36,6 +37,15 @@ void job_pool_check_jobs(void *jpool);
 void job_pool_change_callback(void *jpool,uint32_t jobid,void (*callback)(uint8_t status,void *extra),void *extra);
 void job_pool_delete(void *jpool);
 
+/// Re-reads the limits of jobs run at once by the workers of all the pools.
+void job_pools_reload();
+
+/// Queue statistics of all the pools since the previous call: the greatest number
+/// of jobs queued for a single disk and the longest average wait of a disk's jobs.
+void job_pools_disk_queue_stats(uint32_t *maxQueuedJobs, uint32_t *maxAverageWaitUsec);
+
+/// Greatest number of blocks written by a single job_write_blocks.
+constexpr uint32_t kMaxBlocksPerWriteJob = 16;
 
 uint32_t job_inval(void *jpool,void (*callback)(uint8_t status,void *extra),void *extra);
 uint32_t job_chunkop(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
@@ -91,6 +101,12 @@ uint32_t job_prefetch(void *jpool, uint64_t chunkid, uint32_t version, ChunkPart
 uint32_t job_write(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
 		uint64_t chunkId, uint32_t chunkVersion, ChunkPartType chunkType,
 		uint16_t blocknum, uint32_t offset, uint32_t size, uint32_t crc, const uint8_t *buffer);
+/// Writes \a count (up to kMaxBlocksPerWriteJob) blocks of a chunk in one job, which
+/// lets the disk merge the writes of adjacent blocks. The number of blocks written before
+/// a failure is stored in \a blocksWritten. The buffers have to live until the job ends.
+uint32_t job_write_blocks(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
+		uint64_t chunkId, uint32_t chunkVersion, ChunkPartType chunkType,
+		const ChunkBlockWrite *blocks, uint32_t count, uint32_t *blocksWritten);
 uint32_t job_get_blocks(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
 		uint64_t chunkId, uint32_t version, ChunkPartType chunkType, uint16_t* blocks);
 uint32_t job_replicate(void *jpool, void (*callback)(uint8_t status, void *extra), void *extra,
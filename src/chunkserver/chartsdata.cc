@@ -32,6 +32,7 @@
 #include <unistd.h>
 
 #include "chunkserver-common/hdd_stats.h"
+#include "chunkserver/bgjobs.h"
 #include "chunkserver/chunk_replicator.h"
 #include "chunkserver/masterconn.h"
 #include "chunkserver/network_stats.h"
@@ -70,8 +71,10 @@
 #define CHARTS_TEST 27
 #define CHARTS_CHUNKIOJOBS 28
 #define CHARTS_CHUNKOPJOBS 29
+#define CHARTS_DISKQUEUE 30
+#define CHARTS_DISKWAIT 31
 
-#define CHARTS_NUMBER 30
+#define CHARTS_NUMBER 32
 
 /* name , join mode , percent , scale , multiplier , divisor */
 #define STATDEFS { \
@@ -105,6 +108,8 @@
 	{"test"             ,CHARTS_MODE_ADD,0,CHARTS_SCALE_NONE ,   1, 1}, \
 	{"chunkiojobs"      ,CHARTS_MODE_MAX,0,CHARTS_SCALE_NONE ,   1, 1}, \
 	{"chunkopjobs"      ,CHARTS_MODE_MAX,0,CHARTS_SCALE_NONE ,   1, 1}, \
+	{"diskqueue"        ,CHARTS_MODE_MAX,0,CHARTS_SCALE_NONE ,   1, 1}, \
+	{"diskwait"         ,CHARTS_MODE_MAX,0,CHARTS_SCALE_MICRO,   1, 1}, \
 	{NULL               ,0              ,0,0                 ,   0, 0}  \
 };
 
@@ -142,6 +147,7 @@ void chartsdata_refresh(void) {
 	uint32_t opsCreate, opsDelete, opsUpdateVersion, opsDuplicate, opsTruncate;
 	uint32_t opsDupTrunc, opsTest;
 	uint32_t maxChunkServerJobsCount, maxMasterJobsCount;
+	uint32_t maxDiskQueuedJobs, maxDiskWaitTime;
 
 	// Timer runs only when the process is executing.
 	struct itimerval userTime;
@@ -229,6 +235,11 @@ void chartsdata_refresh(void) {
 	data[CHARTS_DUPTRUNC] = opsDupTrunc;
 	data[CHARTS_TEST] = opsTest;
 
+	// Of the most loaded disk
+	job_pools_disk_queue_stats(&maxDiskQueuedJobs, &maxDiskWaitTime);
+	data[CHARTS_DISKQUEUE] = maxDiskQueuedJobs;
+	data[CHARTS_DISKWAIT] = maxDiskWaitTime;
+
 	charts_add(data, eventloop_time() - SECONDS_IN_ONE_MINUTE);
 }
 
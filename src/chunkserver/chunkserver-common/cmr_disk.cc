@@ -1,9 +1,12 @@
 #include "cmr_disk.h"
 
+#include <climits>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/statvfs.h>
+#include <sys/uio.h>
 #include <linux/falloc.h>
+#include <vector>
 
 #include "chunkserver-common/chunk_interface.h"
 #include "chunkserver-common/cmr_chunk.h"
@@ -210,6 +213,23 @@ ssize_t CmrDisk::preadData(IChunk *chunk, uint8_t *blockBuffer, uint64_t size,
 	return ::pread(chunk->dataFD(), blockBuffer, size, offset);
 }
 
+ssize_t CmrDisk::spliceData(IChunk *chunk, int pipeFD, uint64_t size,
+                            uint64_t offset) {
+	auto inputOffset = static_cast<loff_t>(offset);
+	return ::splice(chunk->dataFD(), &inputOffset, pipeFD, nullptr, size,
+	                SPLICE_F_MOVE);
+}
+
+ssize_t CmrDisk::pwriteData(IChunk *chunk, const uint8_t *buffer,
+                            uint64_t size, uint64_t offset) {
+	return ::pwrite(chunk->dataFD(), buffer, size, offset);
+}
+
+ssize_t CmrDisk::pwritevData(IChunk *chunk, const struct iovec *iov,
+                             int iovcnt, uint64_t offset) {
+	return ::pwritev(chunk->dataFD(), iov, iovcnt, offset);
+}
+
 void CmrDisk::prefetchChunkBlocks(IChunk &chunk, uint16_t firstBlock,
                                   uint32_t blockCount) {
 	if (blockCount > 0) {
@@ -236,8 +256,8 @@ int CmrDisk::readBlockAndCrc(IChunk *chunk, uint8_t *blockBuffer,
 	{
 		DiskReadStatsUpdater updater(chunk->owner(), SFSBLOCKSIZE);
 		const ssize_t bytesRead =
-		    ::pread(chunk->dataFD(), blockBuffer + kCrcSize, SFSBLOCKSIZE,
-		            chunk->getBlockOffset(blocknum));
+		    preadData(chunk, blockBuffer + kCrcSize, SFSBLOCKSIZE,
+		              chunk->getBlockOffset(blocknum));
 		if (bytesRead != SFSBLOCKSIZE) {
 			hddAddErrorAndPreserveErrno(chunk);
 			safs_silent_errlog(LOG_WARNING, "%s: file:%s - read error",
@@ -287,8 +307,8 @@ int CmrDisk::writePartialBlockAndCrc(IChunk *chunk, const uint8_t *buffer,
 	{
 		DiskWriteStatsUpdater updater(chunk->owner(), size);
 
-		auto ret = pwrite(chunk->dataFD(), buffer, size,
-		                  chunk->getBlockOffset(blockNum) + offsetInBlock);
+		auto ret = pwriteData(chunk, buffer, size,
+		                      chunk->getBlockOffset(blockNum) + offsetInBlock);
 
 		if (ret != size) {
 			hddAddErrorAndPreserveErrno(chunk);
@@ -507,6 +527,111 @@ int CmrDisk::writeChunkBlock(IChunk *chunk, uint32_t version, uint16_t blocknum,
 	return SAUNAFS_STATUS_OK;
 }
 
+int CmrDisk::writeChunkBlocks(IChunk *chunk, uint32_t version,
+                              const ChunkBlockWrite *blocks, uint32_t count,
+                              uint8_t *crcData, uint32_t *blocksWritten) {
+	assert(chunk);
+	*blocksWritten = 0;
+
+	auto isCompleteBlock = [](const ChunkBlockWrite &block) {
+		return block.offsetInBlock == 0 && block.size == SFSBLOCKSIZE;
+	};
+
+	uint32_t first = 0;
+	while (first < count) {
+		uint32_t end = first + 1;
+		if (isCompleteBlock(blocks[first])) {
+			while (end < count && end - first < IOV_MAX &&
+			       isCompleteBlock(blocks[end]) &&
+			       blocks[end].blocknum == blocks[end - 1].blocknum + 1) {
+				++end;
+			}
+		}
+
+		int status;
+		if (end - first > 1) {
+			status = writeCompleteBlocks(chunk, version, blocks + first,
+			                             end - first, crcData);
+		} else {
+			const ChunkBlockWrite &block = blocks[first];
+			status = writeChunkBlock(chunk, version, block.blocknum,
+			                         block.offsetInBlock, block.size, block.crc,
+			                         crcData, block.buffer);
+		}
+		if (status != SAUNAFS_STATUS_OK) {
+			return status;
+		}
+		*blocksWritten += end - first;
+		first = end;
+	}
+
+	return SAUNAFS_STATUS_OK;
+}
+
+int CmrDisk::writeCompleteBlocks(IChunk *chunk, uint32_t version,
+                                 const ChunkBlockWrite *blocks, uint32_t count,
+                                 uint8_t *crcData) {
+	LOG_AVG_TILL_END_OF_SCOPE0("writeCompleteBlocks");
+	TRACETHIS3(chunk->id(), blocks[0].blocknum, count);
+
+	if (chunk->version() != version && version > 0) {
+		return SAUNAFS_ERROR_WRONGVERSION;
+	}
+	uint16_t lastBlock = blocks[count - 1].blocknum;
+	if (lastBlock >= chunk->maxBlocksInFile()) {
+		return SAUNAFS_ERROR_BNUMTOOBIG;
+	}
+	if (gCheckCrcWhenWriting) {
+		for (uint32_t i = 0; i < count; ++i) {
+			if (blocks[i].crc != mycrc32(0, blocks[i].buffer, SFSBLOCKSIZE)) {
+				return SAUNAFS_ERROR_CRC;
+			}
+		}
+	}
+
+	chunk->setWasChanged(1U);
+	if (lastBlock >= chunk->blocks()) {
+		// Fill new blocks' CRCs with empty data, the written ones are set below
+		for (uint16_t i = chunk->blocks(); i < blocks[0].blocknum; i++) {
+			memcpy(crcData + i * kCrcSize, &gEmptyBlockCrc, kCrcSize);
+		}
+		chunk->setBlocks(lastBlock + 1);
+	}
+
+	std::vector<struct iovec> iov(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		iov[i].iov_base = const_cast<uint8_t *>(blocks[i].buffer);
+		iov[i].iov_len = SFSBLOCKSIZE;
+	}
+	uint64_t offset = chunk->getBlockOffset(blocks[0].blocknum);
+	uint64_t size = static_cast<uint64_t>(count) * SFSBLOCKSIZE;
+
+	{
+		DiskWriteStatsUpdater updater(chunk->owner(), size);
+
+		auto ret = pwritevData(chunk, iov.data(), count, offset);
+
+		if (ret < 0 || static_cast<uint64_t>(ret) != size) {
+			hddAddErrorAndPreserveErrno(chunk);
+			safs_silent_errlog(LOG_WARNING,
+			                   "writeChunkBlocks: file:%s - write error",
+			                   chunk->fullMetaFilename().c_str());
+			hddReportDamagedChunk(chunk->id(), chunk->type());
+			updater.markWriteAsFailed();
+			return SAUNAFS_ERROR_IO;
+		}
+	}
+
+	for (uint32_t i = 0; i < count; ++i) {
+		punchHoles(chunk, blocks[i].buffer, offset + i * SFSBLOCKSIZE,
+		           SFSBLOCKSIZE);
+		uint8_t *crcPointer = crcData + blocks[i].blocknum * kCrcSize;
+		put32bit(&crcPointer, blocks[i].crc);
+	}
+
+	return SAUNAFS_STATUS_OK;
+}
+
 int CmrDisk::writeChunkData(IChunk *chunk, uint8_t *blockBuffer,
                             int32_t blockSize, off64_t offset) {
 	(void)offset;  // Not needed for conventional disks
@@ -2,6 +2,8 @@
 
 #include "common/platform.h"
 
+#include <sys/uio.h>
+
 #include "chunkserver-common/disk_with_fd.h"
 
 class CmrDisk : public FDDisk {
@@ -89,6 +91,10 @@ public:
 	ssize_t preadData(IChunk *chunk, uint8_t *blockBuffer, uint64_t size,
 	                  uint64_t offset) override;
 
+	/// splice wrapper, moves the data from the page cache into the pipe
+	ssize_t spliceData(IChunk *chunk, int pipeFD, uint64_t size,
+	                   uint64_t offset) override;
+
 	/// Reads ahead blockCount blocks from firstBlock in an attempt to
 	/// improve the performance of next reads.
 	void prefetchChunkBlocks(IChunk &chunk, uint16_t firstBlock,
@@ -126,7 +132,28 @@ public:
 	                    uint32_t offsetInBlock, uint32_t size, uint32_t crc,
 	                    uint8_t *crcData, const uint8_t *buffer) override;
 
+	/// Writes Chunk blocks, runs of complete adjacent blocks with one pwritev
+	int writeChunkBlocks(IChunk *chunk, uint32_t version,
+	                     const ChunkBlockWrite *blocks, uint32_t count,
+	                     uint8_t *crcData, uint32_t *blocksWritten) override;
+
 	/// Writes to device custom blockSize from blockBuffer
 	int writeChunkData(IChunk *chunk, uint8_t *blockBuffer, int32_t blockSize,
 	                   off64_t offset) override;
+
+protected:
+	/// pwrite wrapper, counterpart of preadData, used for all the data writes
+	/// at a known offset. Allows derived Disks to replace the I/O mechanism.
+	virtual ssize_t pwriteData(IChunk *chunk, const uint8_t *buffer,
+	                           uint64_t size, uint64_t offset);
+
+	/// pwritev wrapper, writes the buffers one after another at \a offset
+	virtual ssize_t pwritevData(IChunk *chunk, const struct iovec *iov,
+	                            int iovcnt, uint64_t offset);
+
+private:
+	/// Writes complete blocks which follow each other in the file at once
+	int writeCompleteBlocks(IChunk *chunk, uint32_t version,
+	                        const ChunkBlockWrite *blocks, uint32_t count,
+	                        uint8_t *crcData);
 };
@@ -44,15 +44,16 @@ int DefaultDiskManager::parseCfgLine(std::string hddCfgLine) {
 
 	IDisk *currentDisk = DiskNotFound;
 
-	if (configuration.isZoned) {
+	if (!configuration.prefix.empty()) {
 		currentDisk = pluginManager.createDisk(configuration);
 	} else {
 		currentDisk = new CmrDisk(configuration);
 	}
 
 	if (currentDisk == DiskNotFound) {
-		throw InitializeException("HDD configuration line not valid: " +
-		                          hddCfgLine);
+		throw InitializeException("HDD configuration line not valid, no "
+		                          "plugin loaded for prefix '" +
+		                          configuration.prefix + "': " + hddCfgLine);
 	}
 
 	{
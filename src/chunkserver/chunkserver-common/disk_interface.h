@@ -12,6 +12,15 @@ constexpr IDisk* DiskNotFound = nullptr;
 
 class IChunk;
 
+/// A part of a single Chunk block to be written, see IDisk::writeChunkBlocks
+struct ChunkBlockWrite {
+	uint16_t blocknum;
+	uint32_t offsetInBlock;
+	uint32_t size;
+	uint32_t crc;
+	const uint8_t *buffer;
+};
+
 /// Represents a data disk in the Chunkserver context.
 ///
 /// Each Disk maps to a single line in the hdd.cfg file.
@@ -158,6 +167,14 @@ public:
 	virtual ssize_t preadData(IChunk *chunk, uint8_t *blockBuffer,
 	                          uint64_t size, uint64_t offset) = 0;
 
+	/// Moves \a size bytes starting at \a offset into the pipe \a pipeFD
+	/// without copying them to user space (zero-copy reads).
+	///
+	/// Returns the number of moved bytes, or -1 with errno set (ENOTSUP if
+	/// the Disk cannot provide the data this way).
+	virtual ssize_t spliceData(IChunk *chunk, int pipeFD, uint64_t size,
+	                           uint64_t offset) = 0;
+
 	/// lseeks the metadata file descriptor
 	///
 	/// Should be possible for all Disk types if the metadata is stored in CMR
@@ -206,6 +223,14 @@ public:
 	                            uint32_t size, uint32_t crc, uint8_t *crcData,
 	                            const uint8_t *buffer) = 0;
 
+	/// Writes a sequence of Chunk blocks in order, like consecutive calls to
+	/// writeChunkBlock but allowing to merge the writes of adjacent blocks.
+	/// \param blocksWritten Number of blocks written before the first failure.
+	/// \return SAUNAFS_STATUS_OK on success or specific SAUNAFS_ error code
+	virtual int writeChunkBlocks(IChunk *chunk, uint32_t version,
+	                             const ChunkBlockWrite *blocks, uint32_t count,
+	                             uint8_t *crcData, uint32_t *blocksWritten) = 0;
+
 	/// Writes the Chunk header into the device
 	///
 	/// Assumes that the thread local header buffer was filled with correct
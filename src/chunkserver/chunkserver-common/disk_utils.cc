@@ -37,13 +37,23 @@ Configuration::Configuration(std::string hddCfgLine) {
 		hddCfgLine.erase(hddCfgLine.begin());
 	}
 
-	static const std::string zonedToken = "zonefs:";
-	if (hddCfgLine.find(zonedToken) == 0) {
-		prefix = hddCfgLine.substr(0, zonedToken.size() - 1);
-		isZoned = true;
-		hddCfgLine.erase(0, zonedToken.size());
+	// Optional 'prefix:' selecting the plugin to handle this Disk, e.g.:
+	// zonefs:/mnt/meta | /mnt/data or uring:/mnt/hdd
+	auto prefixEnd = hddCfgLine.find(':');
+	if (prefixEnd != std::string::npos && prefixEnd > 0 &&
+	    std::all_of(hddCfgLine.begin(), hddCfgLine.begin() + prefixEnd,
+	                [](char symbol) {
+		                return std::isalnum<char>(symbol,
+		                                          std::locale::classic()) ||
+		                       symbol == '_';
+	                })) {
+		prefix = hddCfgLine.substr(0, prefixEnd);
+		hddCfgLine.erase(0, prefixEnd + 1);
 	}
 
+	static const std::string zonedPrefix = "zonefs";
+	isZoned = (prefix == zonedPrefix);
+
 	static std::string const delimiter = " | ";
 	auto delimiterPos = hddCfgLine.find(delimiter);
 
@@ -103,8 +103,9 @@ struct Configuration {
 	/// if there is only one path in the hdd cfg line.
 	std::string dataPath;
 
-	/// Used to determine the type of Disk to instantiate. E.g.: zonefs.
-	/// Empty prefix is handled by CmrDisks.
+	/// Used to determine the type of Disk to instantiate. E.g.: zonefs or
+	/// uring. Empty prefix is handled by CmrDisks, any other prefix by the
+	/// DiskPlugin registered for it.
 	std::string prefix;
 
 	/// Tells if the entry is marked for removal (i.e.,
@@ -47,6 +47,7 @@
 #include "protocol/cstocs.h"
 #include "common/datapack.h"
 #include "common/event_loop.h"
+#include "common/event_poller.h"
 #include "common/saunafs_version.h"
 #include "common/massert.h"
 #include "protocol/SFSCommunication.h"
@@ -162,22 +163,35 @@ ChunkserverEntry::createDetachedPacketWithOutputBuffer(
 }
 
 ChunkserverEntry::~ChunkserverEntry() {
-	if (sock >= 0) { tcpclose(sock); }
-	if (fwdSocket >= 0) { tcpclose(fwdSocket); }
+	if (sock >= 0) {
+		if (poller != nullptr) { poller->remove(sock); }
+		tcpclose(sock);
+	}
+	if (fwdSocket >= 0) { closeFwdSocket(); }
+}
+
+void ChunkserverEntry::closeFwdSocket() {
+	// The descriptor number may be reused by the next socket, so the stale
+	// registration must not outlive it
+	if (poller != nullptr) { poller->remove(fwdSocket); }
+	tcpclose(fwdSocket);
+	fwdSocket = kInvalidSocket;
 }
 
 void ChunkserverEntry::attachPacket(std::unique_ptr<PacketStruct> &&packet) {
 	outputPackets.push_back(std::move(packet));
 }
 
-void ChunkserverEntry::preserveInputPacket() {
+std::unique_ptr<PacketStruct> ChunkserverEntry::preserveInputPacket() {
 	TRACETHIS();
+	auto packet = std::make_unique<PacketStruct>();
 
 	if (inputPacket.useAlignedMemory) {
-		writePacket->alignedBuffer = std::move(inputPacket.alignedBuffer);
+		packet->alignedBuffer = std::move(inputPacket.alignedBuffer);
 	} else {
-		writePacket->packet = std::move(inputPacket.packet);
+		packet->packet = std::move(inputPacket.packet);
 	}
+	return packet;
 }
 
 void ChunkserverEntry::createAttachedPacket(std::vector<uint8_t> &packet) {
@@ -241,16 +255,14 @@ int ChunkserverEntry::initConnection() {
 
 	if (tcpnonblock(fwdSocket) < 0) {
 		safs_pretty_errlog(LOG_WARNING, "set nonblock, error");
-		tcpclose(fwdSocket);
-		fwdSocket = kInvalidSocket;
+		closeFwdSocket();
 		return kInitConnectionFailed;
 	}
 
 	status = tcpnumconnect(fwdSocket, fwdServer.ip, fwdServer.port);
 	if (status < 0) {
 		safs_pretty_errlog(LOG_WARNING, "connect failed, error");
-		tcpclose(fwdSocket);
-		fwdSocket = kInvalidSocket;
+		closeFwdSocket();
 		return kInitConnectionFailed;
 	}
 
@@ -267,8 +279,7 @@ int ChunkserverEntry::initConnection() {
 
 void ChunkserverEntry::retryConnect() {
 	TRACETHIS();
-	tcpclose(fwdSocket);
-	fwdSocket = kInvalidSocket;
+	closeFwdSocket();
 	connectRetryCounter++;
 
 	if (connectRetryCounter < kConnectRetries) {
@@ -519,41 +530,98 @@ void ChunkserverEntry::writeFinishedCallback(uint8_t status, void *entry) {
 	auto *eptr = static_cast<ChunkserverEntry *>(entry);
 	eptr->writeJobId = 0;
 	sassert(eptr->messageSerializer != nullptr);
-	if (status != SAUNAFS_STATUS_OK) {
-		std::vector<uint8_t> buffer;
-		eptr->messageSerializer->serializeCstoclWriteStatus(
-		    buffer, eptr->chunkId, eptr->writeJobWriteId, status);
-		eptr->createAttachedPacket(buffer);
-		eptr->state = State::WriteFinish;
-		return;
+
+	// Blocks of a multi-block job written before a failure are done as well
+	std::vector<uint32_t> writeIds;
+	if (eptr->runningWrites.size() > 1) {
+		uint32_t written = (status == SAUNAFS_STATUS_OK)
+		                       ? eptr->runningWrites.size()
+		                       : eptr->writeJobBlocksWritten;
+		for (uint32_t i = 0; i < written; ++i) {
+			writeIds.push_back(eptr->runningWrites[i].writeId);
+		}
+		if (status != SAUNAFS_STATUS_OK) {
+			eptr->writeJobWriteId = eptr->runningWrites[written].writeId;
+		}
+	} else if (status == SAUNAFS_STATUS_OK) {
+		writeIds.push_back(eptr->writeJobWriteId);
 	}
-	if (eptr->writeJobWriteId == 0) {
+	eptr->runningWrites.clear();
+
+	if (status == SAUNAFS_STATUS_OK && eptr->writeJobWriteId == 0) {
+		// The chunk was opened, which is acknowledged as write 0
 		eptr->isChunkOpen = 1;
 	}
-	if (eptr->state == State::WriteLast) {
-		std::vector<uint8_t> buffer;
-		eptr->messageSerializer->serializeCstoclWriteStatus(
-		    buffer, eptr->chunkId, eptr->writeJobWriteId, status);
-		eptr->createAttachedPacket(buffer);
-	} else {
-		if (eptr->partiallyCompletedWrites.count(eptr->writeJobWriteId) > 0) {
+	for (uint32_t writeId : writeIds) {
+		if (eptr->state == State::WriteLast) {
+			std::vector<uint8_t> buffer;
+			eptr->messageSerializer->serializeCstoclWriteStatus(
+			    buffer, eptr->chunkId, writeId, SAUNAFS_STATUS_OK);
+			eptr->createAttachedPacket(buffer);
+		} else if (eptr->partiallyCompletedWrites.count(writeId) > 0) {
 			// found - it means that it was added by status_receive, ie. next
 			// chunkserver from a chain finished writing before our worker
-			sassert(eptr->messageSerializer != nullptr);
 			std::vector<uint8_t> buffer;
 			eptr->messageSerializer->serializeCstoclWriteStatus(
-			    buffer, eptr->chunkId, eptr->writeJobWriteId,
-			    SAUNAFS_STATUS_OK);
+			    buffer, eptr->chunkId, writeId, SAUNAFS_STATUS_OK);
 			eptr->createAttachedPacket(buffer);
-			eptr->partiallyCompletedWrites.erase(eptr->writeJobWriteId);
+			eptr->partiallyCompletedWrites.erase(writeId);
 		} else {
 			// not found - so add it
-			eptr->partiallyCompletedWrites.insert(eptr->writeJobWriteId);
+			eptr->partiallyCompletedWrites.insert(writeId);
 		}
 	}
+	if (status != SAUNAFS_STATUS_OK) {
+		std::vector<uint8_t> buffer;
+		eptr->messageSerializer->serializeCstoclWriteStatus(
+		    buffer, eptr->chunkId, eptr->writeJobWriteId, status);
+		eptr->createAttachedPacket(buffer);
+		eptr->pendingWrites.clear();
+		eptr->state = State::WriteFinish;
+		return;
+	}
+	eptr->writePendingBlocks();
 	eptr->checkNextPacket();
 }
 
+void ChunkserverEntry::writePendingBlocks() {
+	TRACETHIS();
+	if (pendingWrites.empty()) {
+		return;
+	}
+	sassert(writeJobId == 0 && runningWrites.empty());
+	runningWrites.swap(pendingWrites);
+	writeJobWriteId = runningWrites.front().writeId;
+
+	if (runningWrites.size() == 1) {
+		const ChunkBlockWrite &block = runningWrites.front().block;
+		writeJobId = job_write(workerJobPool, writeFinishedCallback, this,
+		                       chunkId, chunkVersion, chunkType, block.blocknum,
+		                       block.offsetInBlock, block.size, block.crc,
+		                       block.buffer);
+		return;
+	}
+
+	std::vector<ChunkBlockWrite> blocks;
+	blocks.reserve(runningWrites.size());
+	for (const auto &write : runningWrites) {
+		blocks.push_back(write.block);
+	}
+	writeJobId = job_write_blocks(workerJobPool, writeFinishedCallback, this,
+	                              chunkId, chunkVersion, chunkType,
+	                              blocks.data(), blocks.size(),
+	                              &writeJobBlocksWritten);
+}
+
+bool ChunkserverEntry::canProcessPacket(uint32_t type) const {
+	if (writeJobId == 0) {
+		return true;
+	}
+	return (type == CLTOCS_WRITE_DATA || type == SAU_CLTOCS_WRITE_DATA) &&
+	       (state == State::WriteLast || state == State::WriteForward) &&
+	       pendingWrites.size() < kMaxBlocksPerWriteJob;
+}
+
 void serializeCltocsWriteInit(std::vector<uint8_t> &buffer, uint64_t chunkId,
                               uint32_t chunkVersion, ChunkPartType chunkType,
                               const std::vector<ChunkTypeWithAddress> &chain,
@@ -715,11 +783,12 @@ void ChunkserverEntry::writeData(const uint8_t *data, PacketHeader::Type type,
 		return;
 	}
 
-	preserveInputPacket();
-	writeJobWriteId = writeId;
-	writeJobId = job_write(workerJobPool, writeFinishedCallback, this,
-	                       opChunkId, chunkVersion, chunkType, blocknum,
-	                       opOffset, opSize, crc, dataToWrite);
+	pendingWrites.push_back(BlockWrite{
+	    writeId, ChunkBlockWrite{blocknum, opOffset, opSize, crc, dataToWrite},
+	    preserveInputPacket()});
+	if (writeJobId == 0) {
+		writePendingBlocks();
+	}
 }
 
 void ChunkserverEntry::writeStatus(const uint8_t *data, PacketHeader::Type type,
@@ -830,8 +899,7 @@ void ChunkserverEntry::writeEnd(const uint8_t *data, uint32_t length) {
 	if (fwdSocket > 0) {
 		// TODO(msulikowski) if we want to use a ConnectionPool, this the right
 		// place to put the connection to the pool.
-		tcpclose(fwdSocket);
-		fwdSocket = kInvalidSocket;
+		closeFwdSocket();
 	}
 	inputPacket.useAlignedMemory = false;
 	state = State::Idle;
@@ -1173,13 +1241,16 @@ void ChunkserverEntry::checkNextPacket() {
 	uint32_t opSize;
 	const uint8_t *ptr;
 
+	ptr = headerBuffer;
+	type = get32bit(&ptr);
+	opSize = get32bit(&ptr);
+	if (!canProcessPacket(type)) {
+		return;
+	}
+
 	if (state == State::WriteForward) {
 		if (mode == Mode::Data && inputPacket.bytesLeft == 0 &&
 		    fwdBytesLeft == 0) {
-			ptr = headerBuffer;
-			type = get32bit(&ptr);
-			opSize = get32bit(&ptr);
-
 			mode = Mode::Header;
 			inputPacket.bytesLeft = PacketHeader::kSize;
 			inputPacket.startPtr = headerBuffer;
@@ -1196,10 +1267,6 @@ void ChunkserverEntry::checkNextPacket() {
 		}
 	} else {
 		if (mode == Mode::Data && inputPacket.bytesLeft == 0) {
-			ptr = headerBuffer;
-			type = get32bit(&ptr);
-			opSize = get32bit(&ptr);
-
 			mode = Mode::Header;
 			inputPacket.bytesLeft = PacketHeader::kSize;
 			inputPacket.startPtr = headerBuffer;
@@ -1438,7 +1505,7 @@ void ChunkserverEntry::forward() {
 		fwdBytesLeft -= bytesReadOrWritten;
 	}
 
-	if (inputPacket.bytesLeft == 0 && fwdBytesLeft == 0 && writeJobId == 0) {
+	if (inputPacket.bytesLeft == 0 && fwdBytesLeft == 0) {
 		PacketHeader header;
 		try {
 			deserializePacketHeader(headerBuffer, sizeof(headerBuffer), header);
@@ -1448,6 +1515,9 @@ void ChunkserverEntry::forward() {
 			state = State::Close;
 			return;
 		}
+		if (!canProcessPacket(header.type)) {
+			return;
+		}
 		mode = Mode::Header;
 		inputPacket.bytesLeft = PacketHeader::kSize;
 		inputPacket.startPtr = headerBuffer;
@@ -1544,11 +1614,10 @@ void ChunkserverEntry::readFromSocket() {
 				return;
 			}
 		}
-		if (writeJobId == 0) {
-			ptr = headerBuffer;
-			type = get32bit(&ptr);
-			opSize = get32bit(&ptr);
-
+		ptr = headerBuffer;
+		type = get32bit(&ptr);
+		opSize = get32bit(&ptr);
+		if (canProcessPacket(type)) {
 			mode = Mode::Header;
 			inputPacket.bytesLeft = PacketHeader::kSize;
 			inputPacket.startPtr = headerBuffer;
@@ -27,6 +27,7 @@
 #include <set>
 #include <vector>
 
+#include "chunkserver-common/disk_interface.h"
 #include "chunkserver-common/disk_utils.h"
 #include "chunkserver/aligned_allocator.h"
 #include "chunkserver/output_buffer.h"
@@ -36,6 +37,8 @@
 #include "devtools/request_log.h"
 #include "protocol/cltocs.h"
 
+class EventPoller;
+
 using AlignedVectorForIO =
     std::vector<uint8_t, AlignedAllocator<uint8_t, disk::kIoBlockSize>>;
 
@@ -130,8 +133,8 @@ struct ChunkserverEntry {
 	uint64_t connectStartTimeUSec = 0; ///< for timeout and retry (usec)
 	uint8_t connectRetryCounter = 0; ///< for timeout and retry
 	NetworkAddress fwdServer; // the next server in write chain
-	int32_t pDescPos = -1;  ///< Position in the poll descriptors array
-	int32_t fwdPDescPos = -1;  ///< Position in poll descriptors for fwdSocket
+	/// Poller of the network worker the sockets are registered in
+	EventPoller *poller = nullptr;
 	uint32_t lastActivity = 0; ///< Last activity time
 	uint8_t headerBuffer[PacketHeader::kSize]{};  ///< buffer for packet header
 	uint8_t fwdHeaderBuffer[PacketHeader::kSize]{};  ///< fwd packet header buff
@@ -147,7 +150,11 @@ struct ChunkserverEntry {
 
 	/* write */
 	uint32_t writeJobId = 0; ///< ID of the current write job being processed
-	uint32_t writeJobWriteId = 0; ///< Specific write operation from client
+	/// Specific write operation from client (the first one of the job's
+	/// blocks), 0 if the job opens the chunk
+	uint32_t writeJobWriteId = 0;
+	/// Number of blocks the current write job wrote before failing
+	uint32_t writeJobBlocksWritten = 0;
 	/// writeJobWriteId's which:
 	/// - have been completed by our worker, but need ack from the next
 	///   chunkserver from the chain.
@@ -155,6 +162,18 @@ struct ChunkserverEntry {
 	///   being written by us.
 	std::set<uint32_t> partiallyCompletedWrites;
 
+	/// A block received in a WRITE_DATA packet, with the packet's buffer
+	struct BlockWrite {
+		uint32_t writeId;
+		ChunkBlockWrite block;
+		std::unique_ptr<PacketStruct> packet;
+	};
+	/// Blocks written by the current write job
+	std::vector<BlockWrite> runningWrites;
+	/// Blocks received while the write job was running, all of them are
+	/// written by the next job (which merges the writes of adjacent blocks)
+	std::vector<BlockWrite> pendingWrites;
+
 	/* read */
 	uint32_t readJobId = 0; ///< ID of the current read job being processed.
 	uint8_t todoReadCounter = 0; ///< R (read finished + send finished)
@@ -163,10 +182,7 @@ struct ChunkserverEntry {
 	uint32_t getBlocksJobId = 0; ///< Current job ID for retrieving chunk blocks
 	uint16_t getBlocksJobResult = 0; ///< Result of the get blocks job
 
-	/* common for read and write but meaning is different !!! */
 	std::unique_ptr<PacketStruct> readPacket = nullptr;
-	std::unique_ptr<PacketStruct> writePacket =
-	    std::make_unique<PacketStruct>();
 
 	uint8_t isChunkOpen = 0;
 	uint64_t chunkId = 0; // R+W
@@ -198,12 +214,15 @@ struct ChunkserverEntry {
 	/// Destructor: closes the sockets.
 	~ChunkserverEntry();
 
+	/// Closes the forwarding socket, removing it from the poller first.
+	void closeFwdSocket();
+
 	/// Attaches a packet to the output packet list (taking ownership).
 	inline void attachPacket(std::unique_ptr<PacketStruct> &&packet);
 
-	/// Preserves the inputPacket buffer into writePacket (to avoid copying it).
+	/// Moves the inputPacket buffer into a new packet (to avoid copying it).
 	/// Used for write operations, where the data comes from the network.
-	inline void preserveInputPacket();
+	inline std::unique_ptr<PacketStruct> preserveInputPacket();
 
 	/// Creates an attached packet from the given vector.
 	/// The function takes ownership of the vector.
@@ -285,6 +304,15 @@ struct ChunkserverEntry {
 	/// Checks and processes the next packet in the input buffer.
 	void checkNextPacket();
 
+	/// Tells if a received packet of \a type can be processed now.
+	///
+	/// While a write job runs, only WRITE_DATA packets are processed (and
+	/// queued in pendingWrites, up to kMaxBlocksPerWriteJob of them).
+	bool canProcessPacket(uint32_t type) const;
+
+	/// Starts a write job for all the pendingWrites, if there are any.
+	void writePendingBlocks();
+
 	/// Processes a received packet based on its type.
 	///
 	/// @param type The type of the packet.
@@ -71,3 +71,20 @@ TEST(DiskTests, ParseZonedHddLine) {
 	ASSERT_FALSE(diskConfig2.isValid);
 }
 
+TEST(DiskTests, ParsePluginPrefixHddLine) {
+	const disk::Configuration diskConfig("*uring:/mnt/nvme_01 | /mnt/hdd_01");
+
+	ASSERT_TRUE(diskConfig.isValid);
+	ASSERT_TRUE(diskConfig.isMarkedForRemoval);
+	ASSERT_FALSE(diskConfig.isZoned);
+	ASSERT_EQ(diskConfig.prefix, "uring");
+	ASSERT_EQ(diskConfig.metaPath, "/mnt/nvme_01/");
+	ASSERT_EQ(diskConfig.dataPath, "/mnt/hdd_01/");
+
+	// A colon inside a path is not a prefix
+	const disk::Configuration diskConfig2("/mnt/hdd:01");
+
+	ASSERT_TRUE(diskConfig2.isValid);
+	ASSERT_TRUE(diskConfig2.prefix.empty());
+	ASSERT_EQ(diskConfig2.metaPath, "/mnt/hdd:01/");
+}
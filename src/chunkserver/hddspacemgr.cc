@@ -100,6 +100,9 @@ constexpr int kErrorLimit = 2;
 constexpr int kLastErrorTime = 60;
 
 inline std::atomic_bool gCheckCrcWhenReading{true};
+/// Serve full block reads with splice instead of copying them to user space.
+/// Only used when the CRC does not need to be checked on the chunkserver side.
+inline std::atomic_bool gZeroCopyReads{false};
 
 void hddGetDamagedChunks(std::vector<ChunkWithType>& chunks,
                          std::size_t limit) {
@@ -505,6 +508,12 @@ int hddGetLoadFactor() {
 	return gIoStat.getLoadFactor();
 }
 
+IDisk *hddGetChunkDisk(uint64_t chunkId, ChunkPartType chunkType) {
+	std::lock_guard chunksMapLockGuard(gChunksMapMutex);
+	auto chunkIter = gChunksMap.find(makeChunkKey(chunkId, chunkType));
+	return chunkIter == gChunksMap.end() ? nullptr : chunkIter->second->owner();
+}
+
 /* I/O operations */
 int hddOpen(IChunk *chunk) {
 	assert(chunk);
@@ -558,7 +567,7 @@ int hddClose(uint64_t chunkId, ChunkPartType chunkType) {
 }
 
 int hddReadCrcAndBlock(IChunk *chunk, uint16_t blockNumber,
-                       OutputBuffer *outputBuffer) {
+                       OutputBuffer *outputBuffer, bool zeroCopy) {
 	LOG_AVG_TILL_END_OF_SCOPE0("hddReadCrcAndBlock");
 	assert(chunk);
 	TRACETHIS2(chunk->id(), blockNumber);
@@ -584,7 +593,13 @@ int hddReadCrcAndBlock(IChunk *chunk, uint16_t blockNumber,
 		    gOpenChunks.getResource(chunk->metaFD()).crcData() +
 		    blockNumber * kCrcSize;
 		outputBuffer->copyIntoBuffer(crcData, kCrcSize);
-		bytesRead = outputBuffer->copyIntoBuffer(chunk, SFSBLOCKSIZE, off);
+		bytesRead = -1;
+		if (zeroCopy) {
+			bytesRead = outputBuffer->spliceIntoBuffer(chunk, SFSBLOCKSIZE, off);
+		}
+		if (bytesRead < 0) {  // Zero-copy disabled or not possible
+			bytesRead = outputBuffer->copyIntoBuffer(chunk, SFSBLOCKSIZE, off);
+		}
 
 		if (bytesRead != toBeRead) {
 			hddAddErrorAndPreserveErrno(chunk);
@@ -657,7 +672,7 @@ static void hddReadAheadAndBehind(IChunk *chunk, uint16_t block,
 		OutputBuffer buffer =
 		    OutputBuffer(kHddBlockSize * (block - firstBlockToRead));
 		for (uint16_t b = firstBlockToRead; b < block; ++b) {
-			hddReadCrcAndBlock(chunk, b, &buffer);
+			hddReadCrcAndBlock(chunk, b, &buffer, false);
 		}
 	} else {
 		chunk->owner()->prefetchChunkBlocks(*chunk, block, blocksToBeReadAhead);
@@ -739,14 +754,17 @@ int hddRead(uint64_t chunkId, uint32_t version, ChunkPartType chunkType,
 	int status = SAUNAFS_STATUS_OK;
 
 	if (size == SFSBLOCKSIZE) {  // Full block
-		status = hddReadCrcAndBlock(chunk, block, outputBuffer);
+		// The data is checked by the clients against the sent CRC anyway, the
+		// zero-copy path only skips the additional check on the chunkserver.
+		const bool zeroCopy = gZeroCopyReads && !gCheckCrcWhenReading;
+		status = hddReadCrcAndBlock(chunk, block, outputBuffer, zeroCopy);
 
 		if (status == SAUNAFS_STATUS_OK) {
 			status = hddCheckCrcForFullBlock(chunk, block, outputBuffer, false);
 		}
 	} else {  // Partial block
 		OutputBuffer tmp(kHddBlockSize);
-		status = hddReadCrcAndBlock(chunk, block, &tmp);
+		status = hddReadCrcAndBlock(chunk, block, &tmp, false);
 
 		if (status == SAUNAFS_STATUS_OK) {  // Successful read of the full block
 			status = hddCheckCrcForFullBlock(chunk, block, &tmp, true);
@@ -800,6 +818,25 @@ int hddChunkWriteBlock(uint64_t chunkId, uint32_t version,
 	return status;
 }
 
+int hddChunkWriteBlocks(uint64_t chunkId, uint32_t version,
+                        ChunkPartType chunkType, const ChunkBlockWrite *blocks,
+                        uint32_t count, uint32_t *blocksWritten) {
+	*blocksWritten = 0;
+	auto *chunk = hddChunkFindAndLock(chunkId, chunkType);
+
+	if (chunk == ChunkNotFound) {
+		safs::log_err("hddChunkWriteBlocks: ChunkNotFound; chunkId {}, version {}, type {}", chunkId, version, chunkType.toString());
+		return SAUNAFS_ERROR_NOCHUNK;
+	}
+
+	auto *crcData = gOpenChunks.getResource(chunk->metaFD()).crcData();
+	int status = chunk->owner()->writeChunkBlocks(
+	    chunk, version, blocks, count, crcData, blocksWritten);
+	hddChunkRelease(chunk);
+
+	return status;
+}
+
 /* chunk info */
 
 int hddChunkGetNumberOfBlocks(uint64_t chunkId, ChunkPartType chunkType,
@@ -2505,6 +2542,7 @@ void hddReload(void) {
 	gHDDTestFreq_ms =
 	    cfg_ranged_get("HDD_TEST_FREQ", 10., 0.001, 1000000.) * 1000;
 	gCheckCrcWhenReading = cfg_getuint8("HDD_CHECK_CRC_WHEN_READING", 1) != 0U;
+	gZeroCopyReads = cfg_getuint8("HDD_ZERO_COPY_READS", 0) != 0U;
 	gCheckCrcWhenWriting = cfg_getuint8("HDD_CHECK_CRC_WHEN_WRITING", 1) != 0U;
 	gPunchHolesInFiles = cfg_getuint32("HDD_PUNCH_HOLES", 0);
 
@@ -2662,6 +2700,7 @@ int hddInit() {
 	gHDDTestFreq_ms =
 	    cfg_ranged_get("HDD_TEST_FREQ", 10., 0.001, 1000000.) * 1000;
 	gCheckCrcWhenReading = cfg_getuint8("HDD_CHECK_CRC_WHEN_READING", 1) != 0U;
+	gZeroCopyReads = cfg_getuint8("HDD_ZERO_COPY_READS", 0) != 0U;
 	gCheckCrcWhenWriting = cfg_getuint8("HDD_CHECK_CRC_WHEN_WRITING", 1) != 0U;
 
 	gPunchHolesInFiles = cfg_getuint32("HDD_PUNCH_HOLES", 0);
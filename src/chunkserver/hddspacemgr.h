@@ -55,6 +55,10 @@ void hddGetTotalSpace(uint64_t *usedSpace, uint64_t *totalSpace,
                       uint64_t *toDelTotalSpace, uint32_t *toDelChunkCount);
 int hddGetLoadFactor();
 
+/// Disk holding the chunk, nullptr if the chunk does not exist.
+/// Meant for grouping jobs by disk, the disk may be gone when it is used.
+IDisk *hddGetChunkDisk(uint64_t chunkId, ChunkPartType chunkType);
+
 /* I/O operations */
 int hddOpen(IChunk *chunk);
 int hddOpen(uint64_t chunkId, ChunkPartType chunkType);
@@ -71,6 +75,10 @@ int hddChunkWriteBlock(uint64_t chunkId, uint32_t version,
                        ChunkPartType chunkType, uint16_t blocknum,
                        uint32_t offset, uint32_t size, uint32_t crc,
                        const uint8_t *buffer);
+/// Writes \a count blocks of the chunk in order, see IDisk::writeChunkBlocks.
+int hddChunkWriteBlocks(uint64_t chunkId, uint32_t version,
+                        ChunkPartType chunkType, const ChunkBlockWrite *blocks,
+                        uint32_t count, uint32_t *blocksWritten);
 
 /* chunk info */
 int hddChunkGetNumberOfBlocks(uint64_t chunkId, ChunkPartType chunkType,
@@ -0,0 +1,158 @@
+/*
+   Copyright 2023      Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "chunkserver/job_queue.h"
+
+#include <algorithm>
+
+#include "common/massert.h"
+
+JobQueue::JobQueue(uint32_t maxSize, const Limits &limits)
+    : maxSize_(maxSize), limits_(limits), queued_(0), closed_(false), running_() {
+}
+
+void JobQueue::put(uint32_t jobId, uint32_t op, uint8_t *data, Priority priority,
+		DiskKey disk) {
+	std::unique_lock lock(mutex_);
+	notFull_.wait(lock, [this] { return maxSize_ == 0 || queued_ < maxSize_; });
+
+	DiskState &state = disks_[disk];
+	if (state.jobs[priority].empty()) {
+		readyDisks_[priority].push_back(disk);
+	}
+	state.jobs[priority].push_back(Job{jobId, op, data, SteadyClock::now()});
+	state.queued++;
+	state.stats.peakQueued = std::max(state.stats.peakQueued, state.queued);
+	queued_++;
+	jobAvailable_.notify_one();
+}
+
+bool JobQueue::tryTakeOfClass(uint8_t priority, SteadyTimePoint now, bool onlyOverdue, Job &job,
+		Ticket &ticket) {
+	if (running_[priority] >= limits_.maxRunning[priority]) {
+		return false;
+	}
+	auto &ready = readyDisks_[priority];
+	for (size_t i = 0, count = ready.size(); i < count; ++i) {
+		DiskKey disk = ready.front();
+		ready.pop_front();
+		DiskState &state = disks_.at(disk);
+		auto &jobs = state.jobs[priority];
+		// A disk may use more workers only if no other disk has jobs waiting
+		bool overDiskLimit =
+				state.running >= limits_.maxRunningPerDisk && state.queued < queued_;
+		if (overDiskLimit || (onlyOverdue && now - jobs.front().queuedAt <= kMaxPriorityWait)) {
+			ready.push_back(disk);
+			continue;
+		}
+		job = jobs.front();
+		jobs.pop_front();
+		if (!jobs.empty()) {
+			ready.push_back(disk);
+		}
+		state.queued--;
+		state.running++;
+		state.stats.waitUsecSum +=
+				std::chrono::duration_cast<std::chrono::microseconds>(now - job.queuedAt).count();
+		state.stats.waitCount++;
+		running_[priority]++;
+		queued_--;
+		ticket = Ticket{disk, static_cast<Priority>(priority)};
+		return true;
+	}
+	return false;
+}
+
+bool JobQueue::tryTake(SteadyTimePoint now, Job &job, Ticket &ticket) {
+	for (uint8_t priority = 0; priority < kPriorityCount; ++priority) {
+		if (tryTakeOfClass(priority, now, true, job, ticket)) {
+			return true;
+		}
+	}
+	for (uint8_t priority = 0; priority < kPriorityCount; ++priority) {
+		if (tryTakeOfClass(priority, now, false, job, ticket)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool JobQueue::get(uint32_t *jobId, uint32_t *op, uint8_t **data, Ticket *ticket) {
+	std::unique_lock lock(mutex_);
+	Job job;
+	while (!tryTake(SteadyClock::now(), job, *ticket)) {
+		if (closed_ && queued_ == 0) {
+			return false;
+		}
+		jobAvailable_.wait(lock);
+	}
+	*jobId = job.jobId;
+	*op = job.op;
+	*data = job.data;
+	notFull_.notify_one();
+	if (queued_ > 0) {
+		// Another job may be allowed to run as well, let the next worker check it
+		jobAvailable_.notify_one();
+	}
+	return true;
+}
+
+void JobQueue::done(const Ticket &ticket) {
+	std::lock_guard lock(mutex_);
+	DiskState &state = disks_.at(ticket.disk);
+	sassert(state.running > 0 && running_[ticket.priority] > 0);
+	state.running--;
+	running_[ticket.priority]--;
+	jobAvailable_.notify_one();
+}
+
+void JobQueue::close() {
+	std::lock_guard lock(mutex_);
+	closed_ = true;
+	jobAvailable_.notify_all();
+}
+
+void JobQueue::setLimits(const Limits &limits) {
+	std::lock_guard lock(mutex_);
+	limits_ = limits;
+	jobAvailable_.notify_all();
+}
+
+uint32_t JobQueue::elements() const {
+	std::lock_guard lock(mutex_);
+	return queued_;
+}
+
+void JobQueue::takeDiskStats(std::unordered_map<DiskKey, DiskStats> &stats) {
+	std::lock_guard lock(mutex_);
+	for (auto it = disks_.begin(); it != disks_.end();) {
+		DiskState &state = it->second;
+		DiskStats &diskStats = stats[it->first];
+		diskStats.peakQueued += state.stats.peakQueued;
+		diskStats.waitUsecSum += state.stats.waitUsecSum;
+		diskStats.waitCount += state.stats.waitCount;
+		state.stats = DiskStats();
+		state.stats.peakQueued = state.queued;
+		if (state.queued == 0 && state.running == 0) {
+			it = disks_.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
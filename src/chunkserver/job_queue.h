@@ -0,0 +1,138 @@
+/*
+   Copyright 2023      Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+#include "common/time_utils.h"
+
+/// Queue of background jobs of a job pool, served by the pool's workers.
+///
+/// Jobs are kept in separate queues for each disk and priority class. A worker
+/// takes a job of the most important class which may run, so client reads are
+/// not stuck behind a burst of replications. The disks with jobs of a class are
+/// served in turns, so a slow disk does not hold back jobs of healthy ones.
+///
+/// The number of jobs of a class run at once is limited, and so is the number of
+/// jobs run at once on a single disk while other disks have jobs waiting, which
+/// keeps some workers free for the other classes and disks. A job which waited
+/// longer than kMaxPriorityWait is served before the jobs of more important
+/// classes, so no class starves.
+class JobQueue {
+public:
+	enum Priority : uint8_t {
+		kForegroundRead,
+		kForegroundWrite,
+		kReplication,
+		kHousekeeping,
+		kPriorityCount
+	};
+
+	/// Identifies the disk of a job, jobs of unknown disks share nullptr.
+	using DiskKey = const void *;
+
+	/// Limits of the number of jobs run at once.
+	struct Limits {
+		std::array<uint32_t, kPriorityCount> maxRunning;  ///< For each class
+		uint32_t maxRunningPerDisk;
+	};
+
+	/// What the worker hands back in done() after running a job.
+	struct Ticket {
+		DiskKey disk;
+		Priority priority;
+	};
+
+	/// Queue statistics of a disk since the previous takeDiskStats().
+	struct DiskStats {
+		uint32_t peakQueued = 0;   ///< Greatest number of queued jobs
+		uint64_t waitUsecSum = 0;  ///< Total time the taken jobs waited in the queue
+		uint32_t waitCount = 0;    ///< Number of taken jobs
+	};
+
+	static constexpr std::chrono::milliseconds kMaxPriorityWait{500};
+
+	/// \param maxSize Number of queued jobs at which put() blocks, 0 means no limit.
+	JobQueue(uint32_t maxSize, const Limits &limits);
+
+	/// Adds a job, waits if the queue is full.
+	void put(uint32_t jobId, uint32_t op, uint8_t *data, Priority priority, DiskKey disk);
+
+	/// Waits for a job which may run now and takes it.
+	/// Returns false if the queue is closed and empty, the worker should exit then.
+	/// Each taken job has to be reported with done() when it finishes.
+	bool get(uint32_t *jobId, uint32_t *op, uint8_t **data, Ticket *ticket);
+
+	/// Tells that the job taken with \a ticket finished.
+	void done(const Ticket &ticket);
+
+	/// Makes get() return false once all the jobs are taken.
+	void close();
+
+	void setLimits(const Limits &limits);
+
+	/// Number of queued jobs.
+	uint32_t elements() const;
+
+	bool isEmpty() const {
+		return elements() == 0;
+	}
+
+	/// Adds statistics of each disk gathered since the previous call to \a stats.
+	void takeDiskStats(std::unordered_map<DiskKey, DiskStats> &stats);
+
+private:
+	struct Job {
+		uint32_t jobId;
+		uint32_t op;
+		uint8_t *data;
+		SteadyTimePoint queuedAt;
+	};
+
+	struct DiskState {
+		std::array<std::deque<Job>, kPriorityCount> jobs;
+		uint32_t queued = 0;
+		uint32_t running = 0;
+		DiskStats stats;
+	};
+
+	/// Takes a job which may run now, if there is one.
+	bool tryTake(SteadyTimePoint now, Job &job, Ticket &ticket);
+	bool tryTakeOfClass(uint8_t priority, SteadyTimePoint now, bool onlyOverdue, Job &job,
+			Ticket &ticket);
+
+	uint32_t maxSize_;
+	Limits limits_;
+	uint32_t queued_;
+	bool closed_;
+	std::unordered_map<DiskKey, DiskState> disks_;
+	/// Disks with queued jobs of each class, in the order they are served in
+	std::array<std::deque<DiskKey>, kPriorityCount> readyDisks_;
+	std::array<uint32_t, kPriorityCount> running_;
+	mutable std::mutex mutex_;
+	std::condition_variable notFull_;
+	std::condition_variable jobAvailable_;
+};
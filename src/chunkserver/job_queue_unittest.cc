@@ -0,0 +1,142 @@
+/*
+   Copyright 2023      Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "chunkserver/job_queue.h"
+
+#include <thread>
+#include <unordered_map>
+
+#include <gtest/gtest.h>
+
+static const int kDiskA = 1, kDiskB = 2;
+static const JobQueue::DiskKey kA = &kDiskA, kB = &kDiskB;
+
+static JobQueue::Limits limits(uint32_t replication, uint32_t perDisk) {
+	JobQueue::Limits limits;
+	limits.maxRunning = {100, 100, replication, 100};
+	limits.maxRunningPerDisk = perDisk;
+	return limits;
+}
+
+/// Takes a job which has to be there and returns its id
+static uint32_t take(JobQueue &queue, JobQueue::Ticket &ticket) {
+	uint32_t jobId, op;
+	uint8_t *data;
+	EXPECT_TRUE(queue.get(&jobId, &op, &data, &ticket));
+	return jobId;
+}
+
+TEST(JobQueueTests, MoreImportantClassesFirst) {
+	JobQueue queue(0, limits(100, 100));
+	JobQueue::Ticket ticket;
+	queue.put(1, 0, nullptr, JobQueue::kHousekeeping, kA);
+	queue.put(2, 0, nullptr, JobQueue::kReplication, kA);
+	queue.put(3, 0, nullptr, JobQueue::kForegroundWrite, kB);
+	queue.put(4, 0, nullptr, JobQueue::kForegroundRead, kA);
+	EXPECT_EQ(queue.elements(), 4U);
+	EXPECT_EQ(take(queue, ticket), 4U);
+	EXPECT_EQ(ticket.priority, JobQueue::kForegroundRead);
+	EXPECT_EQ(take(queue, ticket), 3U);
+	EXPECT_EQ(ticket.disk, kB);
+	EXPECT_EQ(take(queue, ticket), 2U);
+	EXPECT_EQ(take(queue, ticket), 1U);
+	EXPECT_TRUE(queue.isEmpty());
+}
+
+TEST(JobQueueTests, ClassLimit) {
+	JobQueue queue(0, limits(1, 100));
+	JobQueue::Ticket replication, ticket;
+	queue.put(1, 0, nullptr, JobQueue::kReplication, kA);
+	queue.put(2, 0, nullptr, JobQueue::kReplication, kA);
+	queue.put(3, 0, nullptr, JobQueue::kHousekeeping, kA);
+	EXPECT_EQ(take(queue, replication), 1U);
+	// The second replication has to wait for the first one
+	EXPECT_EQ(take(queue, ticket), 3U);
+	queue.done(replication);
+	EXPECT_EQ(take(queue, ticket), 2U);
+}
+
+TEST(JobQueueTests, DisksInTurns) {
+	JobQueue queue(0, limits(100, 100));
+	JobQueue::Ticket ticket;
+	queue.put(1, 0, nullptr, JobQueue::kForegroundRead, kA);
+	queue.put(2, 0, nullptr, JobQueue::kForegroundRead, kA);
+	queue.put(3, 0, nullptr, JobQueue::kForegroundRead, kA);
+	queue.put(4, 0, nullptr, JobQueue::kForegroundRead, kB);
+	EXPECT_EQ(take(queue, ticket), 1U);
+	EXPECT_EQ(take(queue, ticket), 4U);
+	EXPECT_EQ(take(queue, ticket), 2U);
+	EXPECT_EQ(take(queue, ticket), 3U);
+}
+
+TEST(JobQueueTests, DiskLimit) {
+	JobQueue queue(0, limits(100, 1));
+	JobQueue::Ticket ticket;
+	queue.put(1, 0, nullptr, JobQueue::kForegroundRead, kA);
+	queue.put(2, 0, nullptr, JobQueue::kForegroundRead, kA);
+	queue.put(3, 0, nullptr, JobQueue::kForegroundWrite, kB);
+	EXPECT_EQ(take(queue, ticket), 1U);
+	// A read of the busy disk waits while the other disk has a job to do
+	EXPECT_EQ(take(queue, ticket), 3U);
+	// but not when the workers have nothing else to do
+	EXPECT_EQ(take(queue, ticket), 2U);
+}
+
+TEST(JobQueueTests, OverdueJobsFirst) {
+	JobQueue queue(0, limits(100, 100));
+	JobQueue::Ticket ticket;
+	queue.put(1, 0, nullptr, JobQueue::kHousekeeping, kA);
+	std::this_thread::sleep_for(JobQueue::kMaxPriorityWait + std::chrono::milliseconds(10));
+	queue.put(2, 0, nullptr, JobQueue::kForegroundRead, kA);
+	EXPECT_EQ(take(queue, ticket), 1U);
+	EXPECT_EQ(take(queue, ticket), 2U);
+}
+
+TEST(JobQueueTests, DiskStats) {
+	JobQueue queue(0, limits(100, 100));
+	JobQueue::Ticket ticket;
+	queue.put(1, 0, nullptr, JobQueue::kForegroundRead, kA);
+	queue.put(2, 0, nullptr, JobQueue::kForegroundRead, kA);
+	queue.put(3, 0, nullptr, JobQueue::kForegroundRead, kB);
+	take(queue, ticket);
+
+	std::unordered_map<JobQueue::DiskKey, JobQueue::DiskStats> stats;
+	queue.takeDiskStats(stats);
+	ASSERT_EQ(stats.size(), 2U);
+	EXPECT_EQ(stats[kA].peakQueued, 2U);
+	EXPECT_EQ(stats[kA].waitCount, 1U);
+	EXPECT_EQ(stats[kB].peakQueued, 1U);
+	EXPECT_EQ(stats[kB].waitCount, 0U);
+
+	stats.clear();
+	queue.takeDiskStats(stats);
+	EXPECT_EQ(stats[kA].peakQueued, 1U);
+	EXPECT_EQ(stats[kA].waitCount, 0U);
+}
+
+TEST(JobQueueTests, Close) {
+	JobQueue queue(0, limits(100, 100));
+	JobQueue::Ticket ticket;
+	uint32_t jobId, op;
+	uint8_t *data;
+	queue.put(1, 0, nullptr, JobQueue::kForegroundRead, kA);
+	queue.close();
+	EXPECT_EQ(take(queue, ticket), 1U);
+	EXPECT_FALSE(queue.get(&jobId, &op, &data, &ticket));
+}
@@ -119,6 +119,7 @@ void mainNetworkThreadReload(void) {
 				ex.what());
 	}
 	chunkReplicatorReload();
+	job_pools_reload();
 
 	gHDDReadAhead.setReadAhead_kB(
 			cfg_get_maxvalue<uint32_t>("READ_AHEAD_KB", 0, SFSCHUNKSIZE / 1024));
@@ -66,6 +66,8 @@ NetworkWorkerThread::NetworkWorkerThread(uint32_t nrOfBgjobsWorkers,
 #endif
 	bgJobPool_ =
 	    job_pool_new(nrOfBgjobsWorkers, bgjobsCount, &bgJobPoolWakeUpFd_);
+	eassert(poller_.add(notify_pipe[0], POLLIN));
+	eassert(poller_.add(bgJobPoolWakeUpFd_, POLLIN));
 }
 
 void NetworkWorkerThread::operator()() {
@@ -76,8 +78,9 @@ void NetworkWorkerThread::operator()() {
 	pthread_setname_np(pthread_self(), threadName.c_str());
 
 	while (!doTerminate) {
-		preparePollFds();
-		int i = poll(pdesc.data(), pdesc.size(), gPollTimeout);
+		updatePollerEvents();
+		int i = poller_.wait(gPollTimeout, ready_);
+		readyEvents_.clear();
 		if (i < 0) {
 			if (errno == EAGAIN) {
 				safs_pretty_syslog(LOG_WARNING, "poll returned EAGAIN");
@@ -90,9 +93,12 @@ void NetworkWorkerThread::operator()() {
 				break;
 			}
 		} else {
-			if ((pdesc[0].revents) & POLLIN) {
+			for (const auto &descriptor : ready_) {
+				readyEvents_[descriptor.fd] = descriptor.revents;
+			}
+			if (readyEvents(notify_pipe[0]) & POLLIN) {
 				uint8_t notifyByte;
-				eassert(read(pdesc[0].fd, &notifyByte, 1) == 1);
+				eassert(read(notify_pipe[0], &notifyByte, 1) == 1);
 			}
 		}
 		servePoll();
@@ -117,70 +123,99 @@ void NetworkWorkerThread::terminate() {
 	}
 }
 
-void NetworkWorkerThread::preparePollFds() {
-	LOG_AVG_TILL_END_OF_SCOPE0("preparePollFds");
+namespace {
+
+/// Makes \a poller wait for \a events on \a fd if \a polled, otherwise
+/// removes it, so that errors on a socket not polled in its current state
+/// do not wake the worker up over and over (epoll reports them always).
+void setPollerEvents(EventPoller &poller, int fd, bool polled, short events) {
+	if (!polled) {
+		poller.remove(fd);
+	} else if (poller.contains(fd)) {
+		eassert(poller.modify(fd, events));
+	} else if (!poller.add(fd, events)) {
+		safs_pretty_errlog(LOG_WARNING, "can't add socket to poller");
+	}
+}
+
+}  // namespace
+
+void NetworkWorkerThread::updatePollerEvents() {
+	LOG_AVG_TILL_END_OF_SCOPE0("updatePollerEvents");
 	TRACETHIS();
-	pdesc.clear();
-	pdesc.emplace_back(pollfd(notify_pipe[0], POLLIN, 0));
-	pdesc.emplace_back(pollfd(bgJobPoolWakeUpFd_, POLLIN, 0));
-	sassert(JOB_FD_PDESC_POS == (pdesc.size() - 1));
 
 	std::unique_lock lock(csservheadLock);
 	for (auto& entry : csservEntries) {
-		entry.pDescPos = -1;
-		entry.fwdPDescPos = -1;
+		bool sockPolled = false;
+		short sockEvents = 0;
+		bool fwdPolled = false;
+		short fwdEvents = 0;
+
 		switch (entry.state) {
 			case ChunkserverEntry::State::Idle:
 			case ChunkserverEntry::State::Read:
 			case ChunkserverEntry::State::GetBlock:
 			case ChunkserverEntry::State::WriteLast:
-				pdesc.emplace_back(pollfd(entry.sock, 0, 0));
-				entry.pDescPos = pdesc.size() - 1;
+				sockPolled = true;
 				if (entry.inputPacket.bytesLeft > 0) {
-					pdesc.back().events |= POLLIN;
+					sockEvents |= POLLIN;
 				}
 				if (!entry.outputPackets.empty()) {
-					pdesc.back().events |= POLLOUT;
+					sockEvents |= POLLOUT;
 				}
 				break;
 			case ChunkserverEntry::State::Connecting:
-				pdesc.emplace_back(pollfd(entry.fwdSocket, POLLOUT, 0));
-				entry.fwdPDescPos = pdesc.size() - 1;
+				fwdPolled = true;
+				fwdEvents = POLLOUT;
 				break;
 			case ChunkserverEntry::State::WriteInit:
 				if (entry.fwdBytesLeft > 0) {
-					pdesc.emplace_back(pollfd(entry.fwdSocket, POLLOUT, 0));
-					entry.fwdPDescPos = pdesc.size() - 1;
+					fwdPolled = true;
+					fwdEvents = POLLOUT;
 				}
 				break;
 			case ChunkserverEntry::State::WriteForward:
-				pdesc.emplace_back(pollfd(entry.fwdSocket, POLLIN, 0));
-				entry.fwdPDescPos = pdesc.size() - 1;
+				fwdPolled = true;
+				fwdEvents = POLLIN;
 				if (entry.fwdBytesLeft > 0) {
-					pdesc.back().events |= POLLOUT;
+					fwdEvents |= POLLOUT;
 				}
 
-				pdesc.emplace_back(pollfd(entry.sock, 0, 0));
-				entry.pDescPos = pdesc.size() - 1;
+				sockPolled = true;
 				if (entry.inputPacket.bytesLeft > 0) {
-					pdesc.back().events |= POLLIN;
+					sockEvents |= POLLIN;
 				}
 				if (!entry.outputPackets.empty()) {
-					pdesc.back().events |= POLLOUT;
+					sockEvents |= POLLOUT;
 				}
 				break;
 			case ChunkserverEntry::State::WriteFinish:
 				if (!entry.outputPackets.empty()) {
-					pdesc.emplace_back(pollfd(entry.sock, POLLOUT, 0));
-					entry.pDescPos = pdesc.size() - 1;
+					sockPolled = true;
+					sockEvents = POLLOUT;
 				}
 				break;
 			default:
 				break;
 		}
+
+		if (entry.sock >= 0) {
+			setPollerEvents(poller_, entry.sock, sockPolled, sockEvents);
+		}
+		if (entry.fwdSocket >= 0) {
+			setPollerEvents(poller_, entry.fwdSocket, fwdPolled, fwdEvents);
+		}
 	}
 }
 
+short NetworkWorkerThread::readyEvents(int fd) const {
+	// Sockets closed (or opened) while serving are not (yet) registered, a
+	// new socket could have got the descriptor number of a closed ready one
+	if (fd < 0 || !poller_.contains(fd)) { return 0; }
+	auto it = readyEvents_.find(fd);
+	return it != readyEvents_.end() ? it->second : 0;
+}
+
 void NetworkWorkerThread::servePoll() {
 	LOG_AVG_TILL_END_OF_SCOPE0("servePoll");
 	TRACETHIS();
@@ -189,17 +224,17 @@ void NetworkWorkerThread::servePoll() {
 	uint32_t jobscnt;
 	ChunkserverEntry::State lstate;
 
-	if (pdesc[JOB_FD_PDESC_POS].revents & POLLIN) {
+	if (readyEvents(bgJobPoolWakeUpFd_) & POLLIN) {
 		job_pool_check_jobs(bgJobPool_);
 	}
 	std::unique_lock lock(csservheadLock);
 	for (auto& entry : csservEntries) {
 		ChunkserverEntry* eptr = &entry;
-		if (entry.pDescPos >= 0
-				&& (pdesc[entry.pDescPos].revents & (POLLERR | POLLHUP))) {
+		short sockRevents = readyEvents(entry.sock);
+		short fwdRevents = readyEvents(entry.fwdSocket);
+		if (sockRevents & (POLLERR | POLLHUP)) {
 			entry.state = ChunkserverEntry::State::Close;
-		} else if (entry.fwdPDescPos >= 0
-				&& (pdesc[entry.fwdPDescPos].revents & (POLLERR | POLLHUP))) {
+		} else if (fwdRevents & (POLLERR | POLLHUP)) {
 			eptr->fwdError();
 		}
 		lstate = entry.state;
@@ -208,21 +243,16 @@ void NetworkWorkerThread::servePoll() {
 		    lstate == ChunkserverEntry::State::WriteLast ||
 		    lstate == ChunkserverEntry::State::WriteFinish ||
 		    lstate == ChunkserverEntry::State::GetBlock) {
-			if (entry.pDescPos >= 0 &&
-			    (pdesc[entry.pDescPos].revents & POLLIN)) {
+			if (sockRevents & POLLIN) {
 				entry.lastActivity = now;
 				eptr->readFromSocket();
 			}
-			if (entry.pDescPos >= 0 &&
-			    (pdesc[entry.pDescPos].revents & POLLOUT) &&
-			    entry.state == lstate) {
+			if ((sockRevents & POLLOUT) && entry.state == lstate) {
 				entry.lastActivity = now;
 				eptr->writeToSocket();
 			}
 		} else if (lstate == ChunkserverEntry::State::Connecting &&
-		           entry.fwdPDescPos >= 0 &&
-		           (pdesc[entry.fwdPDescPos].revents &
-		            POLLOUT)) {  // FD_ISSET(entry.fwdsock,wset)) {
+		           (fwdRevents & POLLOUT)) {  // FD_ISSET(entry.fwdsock,wset)) {
 			entry.lastActivity = now;
 			eptr->fwdConnected();
 			if (entry.state == ChunkserverEntry::State::WriteInit) {
@@ -232,31 +262,23 @@ void NetworkWorkerThread::servePoll() {
 				eptr->forward(); // and also some data can be forwarded
 			}
 		} else if (entry.state == ChunkserverEntry::State::WriteInit &&
-		           entry.fwdPDescPos >= 0 &&
-		           (pdesc[entry.fwdPDescPos].revents &
-		            POLLOUT)) {  // FD_ISSET(entry.fwdsock,wset)) {
+		           (fwdRevents & POLLOUT)) {  // FD_ISSET(entry.fwdsock,wset)) {
 			entry.lastActivity = now;
 			eptr->fwdWrite(); // after sending init packet
 			if (entry.state == ChunkserverEntry::State::WriteForward) {
 				eptr->forward(); // likely some data can be forwarded
 			}
 		} else if (entry.state == ChunkserverEntry::State::WriteForward) {
-			if ((entry.pDescPos >= 0 &&
-			     (pdesc[entry.pDescPos].revents & POLLIN)) ||
-			    (entry.fwdPDescPos >= 0 &&
-			     (pdesc[entry.fwdPDescPos].revents & POLLOUT))) {
+			if ((sockRevents & POLLIN) ||
+			    (fwdRevents & POLLOUT)) {
 				entry.lastActivity = now;
 				eptr->forward();
 			}
-			if (entry.fwdPDescPos >= 0 &&
-			    (pdesc[entry.fwdPDescPos].revents & POLLIN) &&
-			    entry.state == lstate) {
+			if ((fwdRevents & POLLIN) && entry.state == lstate) {
 				entry.lastActivity = now;
 				eptr->fwdRead();
 			}
-			if (entry.pDescPos >= 0 &&
-			    (pdesc[entry.pDescPos].revents & POLLOUT) &&
-			    entry.state == lstate) {
+			if ((sockRevents & POLLOUT) && entry.state == lstate) {
 				entry.lastActivity = now;
 				eptr->writeToSocket();
 			}
@@ -320,6 +342,8 @@ void NetworkWorkerThread::addConnection(int newSocketFD) {
 	std::unique_lock lock(csservheadLock);
 	csservEntries.emplace_front(newSocketFD, bgJobPool_);
 	csservEntries.front().lastActivity = eventloop_time();
+	// Registered in the poller by the worker thread, in updatePollerEvents()
+	csservEntries.front().poller = &poller_;
 
 	eassert(write(notify_pipe[1], "9", 1) == 1);
 }
@@ -25,9 +25,11 @@
 #include <cstdint>
 #include <list>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include "chunkserver/chunkserver_entry.h"
+#include "common/event_poller.h"
 
 class NetworkWorkerThread {
 public:
@@ -47,18 +49,25 @@ public:
 	}
 
 private:
-	void preparePollFds();
+	void updatePollerEvents();
 	void servePoll() ;
 	void terminate();
 
+	/// Returns the events received on \a fd in the last wait, 0 if the
+	/// descriptor is no longer registered.
+	short readyEvents(int fd) const;
+
 	std::atomic<bool> doTerminate;
 	std::mutex csservheadLock;
+	/// Declared before the entries, which remove their sockets from it
+	EventPoller poller_;
 	std::list<ChunkserverEntry> csservEntries;
 
 	void *bgJobPool_;
 	int bgJobPoolWakeUpFd_;
-	static const uint32_t JOB_FD_PDESC_POS = 1;
-	std::vector<struct pollfd> pdesc;
+	/// Descriptors ready after the last wait and the events received on them
+	std::vector<struct pollfd> ready_;
+	std::unordered_map<int, short> readyEvents_;
 	int notify_pipe[2];
 };
 
@@ -41,10 +41,14 @@ OutputBuffer::OutputBuffer(size_t internalBufferCapacity)
 	buffer_.reserve(internalBufferCapacityAligned_);
 }
 
+OutputBuffer::~OutputBuffer() {
+	closePipe();
+}
+
 OutputBuffer::WriteStatus OutputBuffer::writeOutToAFileDescriptor(int outputFileDescriptor) {
-	while (bytesInABuffer() > 0) {
+	while (bufferUnflushedDataOneAfterLastIndex_ > bufferUnflushedDataFirstIndex_) {
 		ssize_t ret = ::write(outputFileDescriptor, &buffer_[bufferUnflushedDataFirstIndex_],
-				bytesInABuffer());
+				bufferUnflushedDataOneAfterLastIndex_ - bufferUnflushedDataFirstIndex_);
 		if (ret <= 0) {
 			if (ret == 0 || errno == EAGAIN) {
 				return WRITE_AGAIN;
@@ -53,21 +57,67 @@ OutputBuffer::WriteStatus OutputBuffer::writeOutToAFileDescriptor(int outputFile
 		}
 		bufferUnflushedDataFirstIndex_ += ret;
 	}
+	while (bytesInPipe_ > 0) {
+		ssize_t ret = ::splice(pipeReadFD_, nullptr, outputFileDescriptor, nullptr,
+				bytesInPipe_, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		if (ret <= 0) {
+			if (ret == 0 || errno == EAGAIN) {
+				return WRITE_AGAIN;
+			}
+			return WRITE_ERROR;
+		}
+		bytesInPipe_ -= ret;
+	}
 	return WRITE_DONE;
 }
 
 size_t OutputBuffer::bytesInABuffer() const {
-	return bufferUnflushedDataOneAfterLastIndex_ - bufferUnflushedDataFirstIndex_;
+	return bufferUnflushedDataOneAfterLastIndex_ - bufferUnflushedDataFirstIndex_ +
+			bytesInPipe_;
 }
 
 void OutputBuffer::clear() {
 	bufferUnflushedDataFirstIndex_ = padding_;
 	bufferUnflushedDataOneAfterLastIndex_ = padding_;
+	if (bytesInPipe_ > 0) {
+		// Unsent data is left in the pipe, it is cheaper to drop it entirely
+		closePipe();
+	}
+}
+
+bool OutputBuffer::openPipe() {
+	if (pipeWriteFD_ >= 0) {
+		return true;
+	}
+
+	int pipeFileDescriptors[2];
+	if (::pipe2(pipeFileDescriptors, O_NONBLOCK | O_CLOEXEC) < 0) {
+		return false;
+	}
+	pipeReadFD_ = pipeFileDescriptors[0];
+	pipeWriteFD_ = pipeFileDescriptors[1];
+
+	// The pipe must be able to hold the whole payload, the default size
+	// (16 pages) is only enough for a page aligned block. Failing to enlarge
+	// it is not fatal, spliceIntoBuffer will report a short transfer.
+	::fcntl(pipeWriteFD_, F_SETPIPE_SZ, internalBufferCapacityAligned_);
+	return true;
+}
+
+void OutputBuffer::closePipe() {
+	if (pipeReadFD_ >= 0) {
+		::close(pipeReadFD_);
+		::close(pipeWriteFD_);
+	}
+	pipeReadFD_ = -1;
+	pipeWriteFD_ = -1;
+	bytesInPipe_ = 0;
 }
 
 ssize_t OutputBuffer::copyIntoBuffer(IChunk *chunk, size_t len, off_t offset) {
 	eassert(len + bufferUnflushedDataOneAfterLastIndex_ <=
 	        internalBufferCapacityAligned_);
+	eassert(bytesInPipe_ == 0);
 	off_t bytes_written = 0;
 
 	while (len > 0) {
@@ -84,6 +134,28 @@ ssize_t OutputBuffer::copyIntoBuffer(IChunk *chunk, size_t len, off_t offset) {
 	return bytes_written;
 }
 
+ssize_t OutputBuffer::spliceIntoBuffer(IChunk *chunk, size_t len, off_t offset) {
+	eassert(len + bufferUnflushedDataOneAfterLastIndex_ + bytesInPipe_ <=
+	        internalBufferCapacityAligned_);
+	if (!openPipe()) {
+		return -1;
+	}
+	ssize_t bytes_spliced = 0;
+
+	while (len > 0) {
+		ssize_t ret = chunk->owner()->spliceData(chunk, pipeWriteFD_, len, offset);
+		if (ret <= 0) {
+			return bytes_spliced > 0 ? bytes_spliced : ret;
+		}
+		len -= ret;
+		offset += ret;
+		bytesInPipe_ += ret;
+		bytes_spliced += ret;
+	}
+
+	return bytes_spliced;
+}
+
 bool OutputBuffer::checkCRC(size_t bytes, uint32_t crc) const {
 	assert(bufferUnflushedDataOneAfterLastIndex_ - bytes > 0
 			&& bufferUnflushedDataOneAfterLastIndex_ - bytes < buffer_.size());
@@ -93,6 +165,7 @@ bool OutputBuffer::checkCRC(size_t bytes, uint32_t crc) const {
 ssize_t OutputBuffer::copyIntoBuffer(const void *mem, size_t len) {
 	eassert(bufferUnflushedDataOneAfterLastIndex_ + len <=
 	        internalBufferCapacityAligned_);
+	eassert(bytesInPipe_ == 0);
 	memcpy((void*)&buffer_[bufferUnflushedDataOneAfterLastIndex_], mem, len);
 	bufferUnflushedDataOneAfterLastIndex_ += len;
 
@@ -39,11 +39,26 @@ public:
 	};
 
 	explicit OutputBuffer(size_t internalBufferCapacity);
-	~OutputBuffer() = default;
+	~OutputBuffer();
+
+	OutputBuffer(const OutputBuffer &) = delete;
+	OutputBuffer &operator=(const OutputBuffer &) = delete;
+	OutputBuffer(OutputBuffer &&) = delete;
+	OutputBuffer &operator=(OutputBuffer &&) = delete;
 
 	ssize_t copyIntoBuffer(IChunk *chunk, size_t len, off_t offset);
 	ssize_t copyIntoBuffer(const void *mem, size_t len);
 
+	/// Zero-copy counterpart of copyIntoBuffer(IChunk *, ...).
+	///
+	/// The data is moved from the page cache into a pipe owned by this buffer
+	/// and later spliced directly into the socket, so it never reaches user
+	/// space. It is sent after everything already copied into the buffer,
+	/// thus no more data can be copied in after this call.
+	/// Returns the number of bytes moved, or -1 with errno set if nothing
+	/// could be moved (the caller is expected to use copyIntoBuffer then).
+	ssize_t spliceIntoBuffer(IChunk *chunk, size_t len, off_t offset);
+
 	bool checkCRC(size_t bytes, uint32_t crc) const;
 
 	ssize_t copyIntoBuffer(const std::vector<uint8_t>& mem) {
@@ -66,12 +81,23 @@ public:
 	}
 
 private:
+	/// Creates the pipe used by spliceIntoBuffer, if not already created
+	bool openPipe();
+	void closePipe();
+
 	const size_t internalBufferCapacity_;
 	const size_t internalBufferCapacityAligned_;
 	const size_t padding_;
 	std::vector<uint8_t, AlignedAllocator<uint8_t, disk::kIoBlockSize>> buffer_;
 	size_t bufferUnflushedDataFirstIndex_;
 	size_t bufferUnflushedDataOneAfterLastIndex_;
+
+	/// Pipe holding the spliced data, created on first use and kept while the
+	/// buffer is reused from the pool.
+	int pipeReadFD_ = -1;
+	int pipeWriteFD_ = -1;
+	/// Number of bytes waiting in the pipe to be sent after the buffer data
+	size_t bytesInPipe_ = 0;
 };
 
 using OutputBufferPool = BuffersPool<OutputBuffer>;
@@ -19,11 +19,16 @@
 
 #include "common/platform.h"
 #include <fcntl.h>
+#include <algorithm>
 #include <cstdlib>
 #include <string>
+#include <vector>
 #include <gtest/gtest.h>
 
+#include "chunkserver-common/cmr_chunk.h"
+#include "chunkserver-common/cmr_disk.h"
 #include "chunkserver/output_buffer.h"
+#include "common/slice_traits.h"
 #include "unittests/TemporaryDirectory.h"
 
 TEST(OutputBufferTests, outputBuffersTest) {
@@ -66,3 +71,54 @@ TEST(OutputBufferTests, outputBuffersTest) {
 	close(auxPipeFileDescriptors[0]);
 	close(auxPipeFileDescriptors[1]);
 }
+
+TEST(OutputBufferTests, spliceIntoBufferTest) {
+	TemporaryDirectory temp("/tmp", "saunafs_output_buffer");
+	std::string fileName = temp.name() + "/data";
+	std::vector<uint8_t> fileData(2 * SFSBLOCKSIZE);
+	for (size_t i = 0; i < fileData.size(); ++i) {
+		fileData[i] = i % 251;
+	}
+	int dataFD = open(fileName.c_str(), O_RDWR | O_CREAT, 0644);
+	ASSERT_NE(dataFD, -1);
+	ASSERT_EQ(pwrite(dataFD, fileData.data(), fileData.size(), 0),
+	          static_cast<ssize_t>(fileData.size()));
+
+	CmrDisk disk(temp.name(), temp.name(), false, false);
+	CmrChunk chunk(1, slice_traits::standard::ChunkPartType(),
+	               ChunkState::Available);
+	chunk.setOwner(&disk);
+	chunk.setDataFD(dataFD);
+
+	const std::vector<uint8_t> prefix{1, 2, 3, 4, 5};
+	OutputBuffer outputBuffer(prefix.size() + SFSBLOCKSIZE);
+	ASSERT_EQ(outputBuffer.copyIntoBuffer(prefix), 5);
+	ASSERT_EQ(outputBuffer.spliceIntoBuffer(&chunk, SFSBLOCKSIZE, SFSBLOCKSIZE),
+	          SFSBLOCKSIZE);
+	ASSERT_EQ(outputBuffer.bytesInABuffer(), prefix.size() + SFSBLOCKSIZE);
+
+	int auxPipeFileDescriptors[2];
+	ASSERT_NE(pipe2(auxPipeFileDescriptors, O_NONBLOCK), -1);
+	ASSERT_NE(fcntl(auxPipeFileDescriptors[1], F_SETPIPE_SZ, 512*1024), -1);
+	ASSERT_EQ(outputBuffer.writeOutToAFileDescriptor(auxPipeFileDescriptors[1]),
+	          OutputBuffer::WRITE_DONE);
+	ASSERT_EQ(outputBuffer.bytesInABuffer(), 0U);
+
+	std::vector<uint8_t> received(prefix.size() + SFSBLOCKSIZE);
+	ASSERT_EQ(read(auxPipeFileDescriptors[0], received.data(), received.size()),
+	          static_cast<ssize_t>(received.size()));
+	EXPECT_TRUE(std::equal(prefix.begin(), prefix.end(), received.begin()));
+	EXPECT_TRUE(std::equal(fileData.begin() + SFSBLOCKSIZE, fileData.end(),
+	                       received.begin() + prefix.size()));
+
+	// A reused buffer starts empty, whether or not the pipe was sent
+	ASSERT_EQ(outputBuffer.spliceIntoBuffer(&chunk, SFSBLOCKSIZE, 0),
+	          SFSBLOCKSIZE);
+	outputBuffer.clear();
+	EXPECT_EQ(outputBuffer.bytesInABuffer(), 0U);
+
+	chunk.setDataFD(-1);
+	close(dataFD);
+	close(auxPipeFileDescriptors[0]);
+	close(auxPipeFileDescriptors[1]);
+}
@@ -0,0 +1,301 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+
+#include "io_uring_queue.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#include "common/massert.h"
+#include "slogger/slogger.h"
+
+#ifdef SAUNAFS_HAVE_LINUX_IO_URING_H
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+inline uint32_t loadAcquire(uint32_t *value) {
+	return std::atomic_ref<uint32_t>(*value).load(std::memory_order_acquire);
+}
+
+inline void storeRelease(uint32_t *value, uint32_t newValue) {
+	std::atomic_ref<uint32_t>(*value).store(newValue,
+	                                        std::memory_order_release);
+}
+
+inline void *ringOffset(void *base, uint32_t offset) {
+	return static_cast<uint8_t *>(base) + offset;
+}
+
+}  // namespace
+
+IoUringQueue::IoUringQueue(uint32_t entries) {
+	io_uring_params params{};
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = 2 * entries;
+
+	int ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+	if (ringFd < 0) {
+		safs::log_warn("IoUringQueue: io_uring_setup failed: {}",
+		               strerror(errno));
+		return;
+	}
+
+	sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	cqRingSize_ =
+	    params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMmap) {
+		sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+	}
+
+	sqRingPtr_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE,
+	                  MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+	if (sqRingPtr_ == MAP_FAILED) {
+		sqRingPtr_ = nullptr;
+		::close(ringFd);
+		return;
+	}
+
+	if (singleMmap) {
+		cqRingPtr_ = sqRingPtr_;
+	} else {
+		cqRingPtr_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE,
+		                  MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+		if (cqRingPtr_ == MAP_FAILED) {
+			cqRingPtr_ = nullptr;
+			munmap(sqRingPtr_, sqRingSize_);
+			sqRingPtr_ = nullptr;
+			::close(ringFd);
+			return;
+		}
+	}
+
+	sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+	sqesPtr_ = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE,
+	                MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+	if (sqesPtr_ == MAP_FAILED) {
+		sqesPtr_ = nullptr;
+		if (cqRingPtr_ != sqRingPtr_) { munmap(cqRingPtr_, cqRingSize_); }
+		munmap(sqRingPtr_, sqRingSize_);
+		sqRingPtr_ = cqRingPtr_ = nullptr;
+		::close(ringFd);
+		return;
+	}
+
+	sqHead_ = static_cast<uint32_t *>(ringOffset(sqRingPtr_, params.sq_off.head));
+	sqTail_ = static_cast<uint32_t *>(ringOffset(sqRingPtr_, params.sq_off.tail));
+	sqMask_ = *static_cast<uint32_t *>(
+	    ringOffset(sqRingPtr_, params.sq_off.ring_mask));
+	sqEntries_ = params.sq_entries;
+
+	cqHead_ = static_cast<uint32_t *>(ringOffset(cqRingPtr_, params.cq_off.head));
+	cqTail_ = static_cast<uint32_t *>(ringOffset(cqRingPtr_, params.cq_off.tail));
+	cqMask_ = *static_cast<uint32_t *>(
+	    ringOffset(cqRingPtr_, params.cq_off.ring_mask));
+	cqEntries_ = params.cq_entries;
+
+	// Identity mapping: the n-th submission slot always uses the n-th sqe
+	auto *sqArray =
+	    static_cast<uint32_t *>(ringOffset(sqRingPtr_, params.sq_off.array));
+	for (uint32_t i = 0; i < sqEntries_; ++i) { sqArray[i] = i; }
+
+	cqesOffset_ = params.cq_off.cqes;
+	ringFd_ = ringFd;
+}
+
+IoUringQueue::~IoUringQueue() {
+	if (sqesPtr_ != nullptr) { munmap(sqesPtr_, sqesSize_); }
+	if (cqRingPtr_ != nullptr && cqRingPtr_ != sqRingPtr_) {
+		munmap(cqRingPtr_, cqRingSize_);
+	}
+	if (sqRingPtr_ != nullptr) { munmap(sqRingPtr_, sqRingSize_); }
+	if (ringFd_ >= 0) { ::close(ringFd_); }
+}
+
+bool IoUringQueue::registerBuffers(const std::vector<iovec> &buffers) {
+	if (!isValid() || buffers.empty()) { return false; }
+
+	int ret = static_cast<int>(
+	    syscall(__NR_io_uring_register, ringFd_, IORING_REGISTER_BUFFERS,
+	            buffers.data(), static_cast<unsigned>(buffers.size())));
+	if (ret < 0) {
+		safs::log_warn("IoUringQueue: registering {} buffers failed: {}",
+		               buffers.size(), strerror(errno));
+		return false;
+	}
+
+	hasRegisteredBuffers_ = true;
+	return true;
+}
+
+bool IoUringQueue::canQueue() const {
+	uint32_t sqUsed = *sqTail_ - loadAcquire(sqHead_);
+	return sqUsed < sqEntries_ && (inFlightCount_ + queuedCount_) < cqEntries_;
+}
+
+void IoUringQueue::queue(IoUringRequest &request) {
+	uint32_t tail = *sqTail_;
+	auto *sqe = static_cast<io_uring_sqe *>(sqesPtr_) + (tail & sqMask_);
+	std::memset(sqe, 0, sizeof(*sqe));
+
+	bool fixed = hasRegisteredBuffers_ && request.bufferIndex >= 0;
+	if (request.type == IoUringRequest::Type::kRead) {
+		sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+	} else {
+		sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+	}
+	if (fixed) { sqe->buf_index = static_cast<uint16_t>(request.bufferIndex); }
+
+	sqe->fd = request.fd;
+	sqe->addr = reinterpret_cast<uint64_t>(request.buffer);
+	sqe->len = request.size;
+	sqe->off = request.offset;
+	sqe->user_data = reinterpret_cast<uint64_t>(&request);
+
+	storeRelease(sqTail_, tail + 1);
+	++queuedCount_;
+}
+
+void IoUringQueue::reapCompletions() {
+	uint32_t head = *cqHead_;
+	uint32_t tail = loadAcquire(cqTail_);
+	auto *cqes = static_cast<io_uring_cqe *>(ringOffset(cqRingPtr_, cqesOffset_));
+
+	for (; head != tail; ++head) {
+		const io_uring_cqe &cqe = cqes[head & cqMask_];
+		auto *request = reinterpret_cast<IoUringRequest *>(cqe.user_data);
+		request->result = cqe.res;
+		--(*request->pendingInBatch);
+		--inFlightCount_;
+	}
+
+	storeRelease(cqHead_, head);
+}
+
+void IoUringQueue::submitAndReap(std::unique_lock<std::mutex> &lock) {
+	reaping_ = true;
+
+	uint32_t toSubmit = queuedCount_;
+	queuedCount_ = 0;
+	inFlightCount_ += toSubmit;
+	unsigned minComplete = inFlightCount_ > 0 ? 1 : 0;
+
+	lock.unlock();
+	int ret = static_cast<int>(syscall(__NR_io_uring_enter, ringFd_, toSubmit,
+	                                   minComplete, IORING_ENTER_GETEVENTS,
+	                                   nullptr, 0));
+	int savedErrno = errno;
+	lock.lock();
+
+	if (ret < 0) {
+		if (savedErrno != EINTR && savedErrno != EAGAIN &&
+		    savedErrno != EBUSY) {
+			safs::log_err("IoUringQueue: io_uring_enter failed: {}",
+			              strerror(savedErrno));
+			mabort("io_uring_enter failed with a non recoverable error");
+		}
+		ret = 0;
+	}
+
+	// Not submitted entries remain in the ring for the next reaper
+	uint32_t notSubmitted = toSubmit - std::min<uint32_t>(ret, toSubmit);
+	queuedCount_ += notSubmitted;
+	inFlightCount_ -= notSubmitted;
+
+	reapCompletions();
+
+	reaping_ = false;
+	reaped_.notify_all();
+}
+
+void IoUringQueue::submitAndWait(std::span<IoUringRequest> requests) {
+	sassert(isValid());
+
+	uint32_t pendingInBatch = requests.size();
+	size_t nextToQueue = 0;
+
+	std::unique_lock lock(mutex_);
+
+	while (pendingInBatch > 0) {
+		while (nextToQueue < requests.size() && canQueue()) {
+			requests[nextToQueue].pendingInBatch = &pendingInBatch;
+			queue(requests[nextToQueue++]);
+		}
+
+		if (pendingInBatch == 0) { break; }
+
+		if (reaping_) {
+			// Other thread will submit our entries when it returns
+			reaped_.wait(lock);
+		} else {
+			submitAndReap(lock);
+		}
+	}
+}
+
+ssize_t IoUringQueue::execute(IoUringRequest::Type type, int fd, void *buffer,
+                              uint32_t size, uint64_t offset,
+                              int bufferIndex) {
+	IoUringRequest request;
+	request.type = type;
+	request.fd = fd;
+	request.buffer = buffer;
+	request.size = size;
+	request.offset = offset;
+	request.bufferIndex = bufferIndex;
+
+	submitAndWait(std::span(&request, 1));
+
+	if (request.result < 0) {
+		errno = -request.result;
+		return -1;
+	}
+
+	return request.result;
+}
+
+#else  // SAUNAFS_HAVE_LINUX_IO_URING_H
+
+IoUringQueue::IoUringQueue(uint32_t /*entries*/) {}
+
+IoUringQueue::~IoUringQueue() = default;
+
+bool IoUringQueue::registerBuffers(const std::vector<iovec> & /*buffers*/) {
+	return false;
+}
+
+void IoUringQueue::submitAndWait(std::span<IoUringRequest> /*requests*/) {
+	mabort("io_uring is not supported on this platform");
+}
+
+ssize_t IoUringQueue::execute(IoUringRequest::Type /*type*/, int /*fd*/,
+                              void * /*buffer*/, uint32_t /*size*/,
+                              uint64_t /*offset*/, int /*bufferIndex*/) {
+	errno = ENOSYS;
+	return -1;
+}
+
+#endif  // SAUNAFS_HAVE_LINUX_IO_URING_H
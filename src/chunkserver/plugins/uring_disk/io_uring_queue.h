@@ -0,0 +1,131 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <vector>
+
+/// A single read or write operation submitted through an IoUringQueue.
+struct IoUringRequest {
+	enum class Type : uint8_t { kRead, kWrite };
+
+	Type type = Type::kRead;
+	int fd = -1;
+	void *buffer = nullptr;
+	uint32_t size = 0;
+	uint64_t offset = 0;
+	/// Index of the registered buffer containing `buffer`, or -1 if `buffer`
+	/// is regular (not registered) memory.
+	int bufferIndex = -1;
+
+	/// Number of transferred bytes or -errno, filled on completion.
+	int32_t result = 0;
+
+	/// Internal: counter of the batch this request belongs to.
+	uint32_t *pendingInBatch = nullptr;
+};
+
+/// Minimal io_uring based submission/completion queue using the raw kernel
+/// interface (no liburing dependency).
+///
+/// The queue is meant to be shared by all the threads performing I/O on one
+/// Disk. Requests of every caller are appended to the submission ring under a
+/// mutex, and whichever thread is not blocked waiting becomes the 'reaper':
+/// it submits everything queued so far in one io_uring_enter call and
+/// distributes the completions. Concurrent callers are thus naturally batched
+/// into a single system call, without the need for an extra thread.
+class IoUringQueue {
+public:
+	/// Sets up the rings with \p entries submission entries.
+	/// Use isValid to check if the kernel supports io_uring.
+	explicit IoUringQueue(uint32_t entries);
+	~IoUringQueue();
+
+	IoUringQueue(const IoUringQueue &) = delete;
+	IoUringQueue(IoUringQueue &&) = delete;
+	IoUringQueue &operator=(const IoUringQueue &) = delete;
+	IoUringQueue &operator=(IoUringQueue &&) = delete;
+
+	/// True if the rings were correctly set up and the queue can be used.
+	bool isValid() const { return ringFd_ >= 0; }
+
+	/// Registers \p buffers as fixed buffers (IORING_REGISTER_BUFFERS).
+	/// Requests referencing them must set IoUringRequest::bufferIndex.
+	/// Returns true on success.
+	bool registerBuffers(const std::vector<iovec> &buffers);
+
+	/// Submits all \p requests (possibly together with requests of other
+	/// threads) and blocks until every one of them is completed.
+	/// The per-request status is stored in IoUringRequest::result.
+	void submitAndWait(std::span<IoUringRequest> requests);
+
+	/// Convenience wrapper for a single request.
+	/// Returns the number of transferred bytes or -1 setting errno.
+	ssize_t execute(IoUringRequest::Type type, int fd, void *buffer,
+	                uint32_t size, uint64_t offset, int bufferIndex = -1);
+
+private:
+	/// True if there is room for one more request in the rings.
+	bool canQueue() const;
+
+	/// Fills the next submission entry for \p request. Needs mutex_ locked.
+	void queue(IoUringRequest &request);
+
+	/// Submits the queued entries and waits for at least one completion.
+	/// Needs mutex_ locked; it is released during the system call.
+	void submitAndReap(std::unique_lock<std::mutex> &lock);
+
+	/// Consumes all the available completion entries. Needs mutex_ locked.
+	void reapCompletions();
+
+	int ringFd_ = -1;
+
+	void *sqRingPtr_ = nullptr;
+	size_t sqRingSize_ = 0;
+	void *cqRingPtr_ = nullptr;
+	size_t cqRingSize_ = 0;
+	void *sqesPtr_ = nullptr;
+	size_t sqesSize_ = 0;
+
+	uint32_t *sqHead_ = nullptr;
+	uint32_t *sqTail_ = nullptr;
+	uint32_t sqMask_ = 0;
+	uint32_t sqEntries_ = 0;
+
+	uint32_t *cqHead_ = nullptr;
+	uint32_t *cqTail_ = nullptr;
+	uint32_t cqMask_ = 0;
+	uint32_t cqEntries_ = 0;
+	uint32_t cqesOffset_ = 0;
+
+	bool hasRegisteredBuffers_ = false;
+
+	std::mutex mutex_;
+	std::condition_variable reaped_;
+	bool reaping_ = false;         ///< Some thread is inside io_uring_enter
+	uint32_t queuedCount_ = 0;     ///< Entries in the SQ not yet submitted
+	uint32_t inFlightCount_ = 0;   ///< Submitted entries not yet completed
+};
@@ -0,0 +1,160 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "io_uring_queue.h"
+#include "unittests/TemporaryDirectory.h"
+
+class IoUringQueueTests : public ::testing::Test {
+protected:
+	void SetUp() override {
+		temp_ = std::make_unique<TemporaryDirectory>(
+		    "/tmp", ::testing::UnitTest::GetInstance()->current_test_info()->name());
+		fd_ = ::open((temp_->name() + "/file").c_str(), O_RDWR | O_CREAT, 0644);
+		ASSERT_GE(fd_, 0);
+	}
+
+	void TearDown() override { ::close(fd_); }
+
+	std::unique_ptr<TemporaryDirectory> temp_;
+	int fd_ = -1;
+};
+
+TEST_F(IoUringQueueTests, WriteAndReadBack) {
+	IoUringQueue queue(8);
+	if (!queue.isValid()) { GTEST_SKIP() << "io_uring not supported"; }
+
+	std::vector<uint8_t> data(16 * 1024);
+	for (size_t i = 0; i < data.size(); ++i) { data[i] = i % 251; }
+
+	ASSERT_EQ(queue.execute(IoUringRequest::Type::kWrite, fd_, data.data(),
+	                        data.size(), 4096),
+	          static_cast<ssize_t>(data.size()));
+
+	std::vector<uint8_t> readBack(data.size());
+	ASSERT_EQ(queue.execute(IoUringRequest::Type::kRead, fd_, readBack.data(),
+	                        readBack.size(), 4096),
+	          static_cast<ssize_t>(readBack.size()));
+	EXPECT_EQ(data, readBack);
+
+	// Reading past the end of file is a short read
+	EXPECT_EQ(queue.execute(IoUringRequest::Type::kRead, fd_, readBack.data(),
+	                        readBack.size(), 4096 + 8192),
+	          8192);
+}
+
+TEST_F(IoUringQueueTests, BatchLargerThanRing) {
+	IoUringQueue queue(4);
+	if (!queue.isValid()) { GTEST_SKIP() << "io_uring not supported"; }
+
+	constexpr size_t kRequests = 50;
+	constexpr size_t kSize = 512;
+	std::vector<uint8_t> data(kRequests * kSize);
+	std::vector<IoUringRequest> requests(kRequests);
+	for (size_t i = 0; i < kRequests; ++i) {
+		std::fill(data.begin() + i * kSize, data.begin() + (i + 1) * kSize, i);
+		requests[i].type = IoUringRequest::Type::kWrite;
+		requests[i].fd = fd_;
+		requests[i].buffer = data.data() + i * kSize;
+		requests[i].size = kSize;
+		requests[i].offset = i * kSize;
+	}
+
+	queue.submitAndWait(requests);
+	for (const auto &request : requests) {
+		EXPECT_EQ(request.result, static_cast<int32_t>(kSize));
+	}
+
+	std::vector<uint8_t> readBack(data.size());
+	ASSERT_EQ(::pread(fd_, readBack.data(), readBack.size(), 0),
+	          static_cast<ssize_t>(readBack.size()));
+	EXPECT_EQ(data, readBack);
+}
+
+TEST_F(IoUringQueueTests, ConcurrentCallers) {
+	IoUringQueue queue(8);
+	if (!queue.isValid()) { GTEST_SKIP() << "io_uring not supported"; }
+
+	constexpr int kThreads = 8;
+	constexpr int kWritesPerThread = 64;
+	constexpr size_t kSize = 256;
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < kThreads; ++t) {
+		threads.emplace_back([&, t]() {
+			std::vector<uint8_t> buffer(kSize, t);
+			for (int i = 0; i < kWritesPerThread; ++i) {
+				uint64_t offset = (t * kWritesPerThread + i) * kSize;
+				EXPECT_EQ(queue.execute(IoUringRequest::Type::kWrite, fd_,
+				                        buffer.data(), kSize, offset),
+				          static_cast<ssize_t>(kSize));
+			}
+		});
+	}
+	for (auto &thread : threads) { thread.join(); }
+
+	std::vector<uint8_t> readBack(kSize);
+	for (int t = 0; t < kThreads; ++t) {
+		for (int i = 0; i < kWritesPerThread; ++i) {
+			uint64_t offset = (t * kWritesPerThread + i) * kSize;
+			ASSERT_EQ(::pread(fd_, readBack.data(), kSize, offset),
+			          static_cast<ssize_t>(kSize));
+			EXPECT_EQ(readBack, std::vector<uint8_t>(kSize, t));
+		}
+	}
+}
+
+TEST_F(IoUringQueueTests, RegisteredBuffers) {
+	IoUringQueue queue(8);
+	if (!queue.isValid()) { GTEST_SKIP() << "io_uring not supported"; }
+
+	constexpr size_t kSize = 8192;
+	auto *buffer = static_cast<uint8_t *>(std::aligned_alloc(4096, kSize));
+	ASSERT_TRUE(queue.registerBuffers({{buffer, kSize}}));
+
+	std::fill(buffer, buffer + kSize, 0xAB);
+	EXPECT_EQ(queue.execute(IoUringRequest::Type::kWrite, fd_, buffer, kSize,
+	                        0, 0),
+	          static_cast<ssize_t>(kSize));
+
+	std::fill(buffer, buffer + kSize, 0);
+	EXPECT_EQ(queue.execute(IoUringRequest::Type::kRead, fd_, buffer, kSize, 0,
+	                        0),
+	          static_cast<ssize_t>(kSize));
+	EXPECT_EQ(buffer[0], 0xAB);
+	EXPECT_EQ(buffer[kSize - 1], 0xAB);
+
+	std::free(buffer);
+}
+
+TEST_F(IoUringQueueTests, ErrorIsReported) {
+	IoUringQueue queue(8);
+	if (!queue.isValid()) { GTEST_SKIP() << "io_uring not supported"; }
+
+	uint8_t byte = 0;
+	EXPECT_EQ(queue.execute(IoUringRequest::Type::kRead, -1, &byte, 1, 0), -1);
+	EXPECT_EQ(errno, EBADF);
+}
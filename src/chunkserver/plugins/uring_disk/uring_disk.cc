@@ -0,0 +1,338 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "uring_disk.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include "chunkserver-common/chunk_interface.h"
+#include "slogger/slogger.h"
+
+namespace {
+
+inline uint64_t alignDown(uint64_t value) {
+	return value - (value % disk::kIoBlockSize);
+}
+
+inline uint64_t alignUp(uint64_t value) {
+	return alignDown(value + disk::kIoBlockSize - 1);
+}
+
+inline bool isAligned(const void *buffer, uint64_t size, uint64_t offset) {
+	return (reinterpret_cast<uintptr_t>(buffer) % disk::kIoBlockSize) == 0 &&
+	       (size % disk::kIoBlockSize) == 0 &&
+	       (offset % disk::kIoBlockSize) == 0;
+}
+
+}  // namespace
+
+UringDisk::UringDisk(const disk::Configuration &configuration,
+                     const UringDiskOptions &options)
+    : CmrDisk(configuration),
+      options_(options),
+      queue_(std::make_unique<IoUringQueue>(options.queueDepth)),
+      directIoActive_(options.directIo) {
+	if (!queue_->isValid()) {
+		safs::log_warn("UringDisk {}: io_uring not available, using regular "
+		               "pread/pwrite",
+		               getPaths());
+		queue_.reset();
+	}
+
+	if (!options_.directIo || options_.registeredBuffers == 0) { return; }
+
+	bounceArena_ = static_cast<uint8_t *>(std::aligned_alloc(
+	    disk::kIoBlockSize,
+	    static_cast<size_t>(kBounceBufferSize) * options_.registeredBuffers));
+	if (bounceArena_ == nullptr) { return; }
+
+	std::vector<iovec> iovecs;
+	for (uint32_t i = 0; i < options_.registeredBuffers; ++i) {
+		uint8_t *data = bounceArena_ + static_cast<size_t>(i) * kBounceBufferSize;
+		iovecs.push_back({data, kBounceBufferSize});
+		freeBounceBuffers_.push_back({data, static_cast<int>(i)});
+	}
+
+	if (!queue_ || !queue_->registerBuffers(iovecs)) {
+		// Still useful as a pool, just not registered in the kernel
+		for (auto &buffer : freeBounceBuffers_) { buffer.registeredIndex = -1; }
+	}
+}
+
+UringDisk::~UringDisk() {
+	// The ring must be released before the registered memory
+	queue_.reset();
+	std::free(bounceArena_);
+}
+
+int UringDisk::openData(IChunk *chunk, int flags) {
+	if (directIoActive_) {
+		int fd = ::open(chunk->fullDataFilename().c_str(), flags | O_DIRECT,
+		                disk::kDefaultOpenMode);
+		if (fd >= 0 || errno != EINVAL) { return fd; }
+
+		// The filesystem does not support O_DIRECT (e.g. tmpfs)
+		safs::log_warn("UringDisk {}: O_DIRECT not supported, disabling it",
+		               getPaths());
+		directIoActive_ = false;
+	}
+
+	return ::open(chunk->fullDataFilename().c_str(), flags,
+	              disk::kDefaultOpenMode);
+}
+
+void UringDisk::creat(IChunk *chunk) {
+	chunk->setMetaFD(::open(chunk->fullMetaFilename().c_str(),
+	                        O_RDWR | O_TRUNC | O_CREAT,
+	                        disk::kDefaultOpenMode));
+	chunk->setDataFD(openData(chunk, O_RDWR | O_TRUNC | O_CREAT));
+}
+
+void UringDisk::open(IChunk *chunk) {
+	const int flags = isReadOnly() ? O_RDONLY : O_RDWR;
+	chunk->setMetaFD(::open(chunk->fullMetaFilename().c_str(), flags));
+	chunk->setDataFD(openData(chunk, flags));
+}
+
+ssize_t UringDisk::preadData(IChunk *chunk, uint8_t *blockBuffer,
+                             uint64_t size, uint64_t offset) {
+	return transfer(IoUringRequest::Type::kRead, chunk->dataFD(), blockBuffer,
+	                size, offset);
+}
+
+ssize_t UringDisk::pwriteData(IChunk *chunk, const uint8_t *buffer,
+                              uint64_t size, uint64_t offset) {
+	return transfer(IoUringRequest::Type::kWrite, chunk->dataFD(),
+	                const_cast<uint8_t *>(buffer), size, offset);
+}
+
+ssize_t UringDisk::pwritevData(IChunk *chunk, const struct iovec *iov,
+                               int iovcnt, uint64_t offset) {
+	ssize_t total = 0;
+	for (int i = 0; i < iovcnt; ++i) {
+		ssize_t written = pwriteData(
+		    chunk, static_cast<const uint8_t *>(iov[i].iov_base),
+		    iov[i].iov_len, offset + total);
+		if (written < 0) { return -1; }
+		total += written;
+		if (static_cast<size_t>(written) != iov[i].iov_len) { break; }
+	}
+	return total;
+}
+
+ssize_t UringDisk::spliceData(IChunk *chunk, int pipeFD, uint64_t size,
+                              uint64_t offset) {
+	if (directIoActive_) {
+		errno = ENOTSUP;
+		return -1;
+	}
+
+	return CmrDisk::spliceData(chunk, pipeFD, size, offset);
+}
+
+int UringDisk::writeChunkData(IChunk *chunk, uint8_t *blockBuffer,
+                              int32_t blockSize, off64_t offset) {
+	(void)offset;  // Like CmrDisk, writes at the current file position
+
+	off64_t position = ::lseek(chunk->dataFD(), 0, SEEK_CUR);
+	if (position < 0) { return -1; }
+
+	ssize_t written = transfer(IoUringRequest::Type::kWrite, chunk->dataFD(),
+	                           blockBuffer, blockSize, position);
+	if (written > 0) { ::lseek(chunk->dataFD(), position + written, SEEK_SET); }
+
+	return static_cast<int>(written);
+}
+
+void UringDisk::prefetchChunkBlocks(IChunk &chunk, uint16_t firstBlock,
+                                    uint32_t blockCount) {
+	if (!directIoActive_) {
+		CmrDisk::prefetchChunkBlocks(chunk, firstBlock, blockCount);
+	}
+}
+
+ssize_t UringDisk::transfer(IoUringRequest::Type type, int fd,
+                            uint8_t *buffer, uint64_t size, uint64_t offset) {
+	if (options_.directIo && !isAligned(buffer, size, offset)) {
+		return type == IoUringRequest::Type::kRead
+		           ? readUnaligned(fd, buffer, size, offset)
+		           : writeUnaligned(fd, buffer, size, offset);
+	}
+
+	if (!queue_) {
+		return type == IoUringRequest::Type::kRead
+		           ? ::pread(fd, buffer, size, offset)
+		           : ::pwrite(fd, buffer, size, offset);
+	}
+
+	return queue_->execute(type, fd, buffer, size, offset);
+}
+
+UringDisk::BounceBuffer UringDisk::acquireBounceBuffer() {
+	{
+		std::lock_guard lock(bounceMutex_);
+		if (!freeBounceBuffers_.empty()) {
+			BounceBuffer buffer = freeBounceBuffers_.back();
+			freeBounceBuffers_.pop_back();
+			return buffer;
+		}
+	}
+
+	// Pool exhausted (or disabled), use a temporary buffer
+	return {static_cast<uint8_t *>(
+	            std::aligned_alloc(disk::kIoBlockSize, kBounceBufferSize)),
+	        -1};
+}
+
+void UringDisk::releaseBounceBuffer(const BounceBuffer &buffer) {
+	uint8_t *arenaEnd = bounceArena_ + static_cast<size_t>(kBounceBufferSize) *
+	                                       options_.registeredBuffers;
+	if (bounceArena_ != nullptr && buffer.data >= bounceArena_ &&
+	    buffer.data < arenaEnd) {
+		std::lock_guard lock(bounceMutex_);
+		freeBounceBuffers_.push_back(buffer);
+		return;
+	}
+
+	std::free(buffer.data);
+}
+
+ssize_t UringDisk::readUnaligned(int fd, uint8_t *buffer, uint64_t size,
+                                 uint64_t offset) {
+	// Split into pieces of at most one block, each one read through its own
+	// bounce buffer; all of them are submitted as a single batch.
+	const uint64_t pieceCount = (size + SFSBLOCKSIZE - 1) / SFSBLOCKSIZE;
+	std::vector<BounceBuffer> bounces;
+	std::vector<IoUringRequest> requests(pieceCount);
+
+	for (uint64_t i = 0; i < pieceCount; ++i) {
+		uint64_t pieceOffset = offset + i * SFSBLOCKSIZE;
+		uint64_t pieceSize = std::min<uint64_t>(SFSBLOCKSIZE,
+		                                        size - i * SFSBLOCKSIZE);
+		uint64_t alignedOffset = alignDown(pieceOffset);
+
+		bounces.push_back(acquireBounceBuffer());
+		auto &request = requests[i];
+		request.type = IoUringRequest::Type::kRead;
+		request.fd = fd;
+		request.buffer = bounces.back().data;
+		request.size = alignUp(pieceOffset + pieceSize) - alignedOffset;
+		request.offset = alignedOffset;
+		request.bufferIndex = bounces.back().registeredIndex;
+	}
+
+	if (queue_) {
+		queue_->submitAndWait(requests);
+	} else {
+		for (auto &request : requests) {
+			ssize_t ret =
+			    ::pread(fd, request.buffer, request.size, request.offset);
+			request.result = ret < 0 ? -errno : static_cast<int32_t>(ret);
+		}
+	}
+
+	// Copy the pieces in order, stopping at the first short or failed one
+	ssize_t totalRead = 0;
+	int readErrno = 0;
+	for (uint64_t i = 0; i < pieceCount; ++i) {
+		const auto &request = requests[i];
+		uint64_t skip = offset + i * SFSBLOCKSIZE - request.offset;
+		uint64_t wanted =
+		    std::min<uint64_t>(SFSBLOCKSIZE, size - i * SFSBLOCKSIZE);
+
+		if (request.result < 0) {
+			readErrno = -request.result;
+			break;
+		}
+
+		uint64_t available = 0;
+		if (static_cast<uint64_t>(request.result) > skip) {
+			available = std::min<uint64_t>(request.result - skip, wanted);
+		}
+		std::memcpy(buffer + i * SFSBLOCKSIZE, bounces[i].data + skip,
+		            available);
+		totalRead += available;
+
+		if (available < wanted) { break; }
+	}
+
+	for (const auto &bounce : bounces) { releaseBounceBuffer(bounce); }
+
+	if (totalRead == 0 && readErrno != 0) {
+		errno = readErrno;
+		return -1;
+	}
+
+	return totalRead;
+}
+
+ssize_t UringDisk::writeUnaligned(int fd, const uint8_t *buffer, uint64_t size,
+                                  uint64_t offset) {
+	BounceBuffer bounce = acquireBounceBuffer();
+	ssize_t totalWritten = 0;
+
+	while (static_cast<uint64_t>(totalWritten) < size) {
+		uint64_t pieceOffset = offset + totalWritten;
+		uint64_t pieceSize =
+		    std::min<uint64_t>(SFSBLOCKSIZE, size - totalWritten);
+		uint64_t alignedOffset = alignDown(pieceOffset);
+		uint64_t alignedSize = alignUp(pieceOffset + pieceSize) - alignedOffset;
+
+		// Read the enclosing aligned range; past the end of file reads zeros
+		ssize_t readBytes = queue_ ? queue_->execute(
+		                                 IoUringRequest::Type::kRead, fd,
+		                                 bounce.data, alignedSize,
+		                                 alignedOffset, bounce.registeredIndex)
+		                           : ::pread(fd, bounce.data, alignedSize,
+		                                     alignedOffset);
+		if (readBytes < 0) { break; }
+		std::memset(bounce.data + readBytes, 0, alignedSize - readBytes);
+
+		std::memcpy(bounce.data + (pieceOffset - alignedOffset),
+		            buffer + totalWritten, pieceSize);
+
+		ssize_t written = queue_ ? queue_->execute(
+		                               IoUringRequest::Type::kWrite, fd,
+		                               bounce.data, alignedSize, alignedOffset,
+		                               bounce.registeredIndex)
+		                         : ::pwrite(fd, bounce.data, alignedSize,
+		                                    alignedOffset);
+		if (written != static_cast<ssize_t>(alignedSize)) { break; }
+
+		// Do not let the alignment grow the file past the requested end
+		uint64_t previousEnd = alignedOffset + readBytes;
+		uint64_t requestedEnd = pieceOffset + pieceSize;
+		if (previousEnd < alignedOffset + alignedSize) {
+			if (::ftruncate(fd, std::max(previousEnd, requestedEnd)) < 0) {
+				break;
+			}
+		}
+
+		totalWritten += pieceSize;
+	}
+
+	releaseBounceBuffer(bounce);
+
+	if (totalWritten == 0 && size > 0) { return -1; }
+
+	return totalWritten;
+}
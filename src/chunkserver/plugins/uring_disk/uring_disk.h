@@ -0,0 +1,138 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "chunkserver-common/cmr_disk.h"
+#include "io_uring_queue.h"
+
+/// Options of the io_uring Disks, read from sfschunkserver.cfg.
+struct UringDiskOptions {
+	/// Number of submission entries of each Disk ring (URING_QUEUE_DEPTH).
+	uint32_t queueDepth = 64;
+	/// Open the data parts with O_DIRECT (URING_DIRECT_IO).
+	bool directIo = false;
+	/// Number of bounce buffers registered in the kernel for unaligned
+	/// O_DIRECT transfers (URING_REGISTERED_BUFFERS).
+	uint32_t registeredBuffers = 0;
+};
+
+/// CMR Disk performing the data I/O through a per-Disk io_uring.
+///
+/// Handles the lines of the hdd.cfg file prefixed with 'uring:', e.g.:
+/// uring:/mnt/nvme01
+/// uring:/mnt/nvme01/meta | /mnt/nvme01/data
+///
+/// The on-disk format is exactly the same as for CmrDisk, so a Disk can be
+/// switched between both implementations just by editing the prefix.
+/// The reads and writes of all the bgjobs threads working on this Disk share
+/// one ring, so that concurrent requests are submitted and reaped together.
+/// If the kernel does not support io_uring, the Disk behaves as a CmrDisk.
+class UringDisk : public CmrDisk {
+public:
+	/// Constructs a Disk from a Configuration object read from hdd.cfg.
+	UringDisk(const disk::Configuration &configuration,
+	          const UringDiskOptions &options);
+
+	UringDisk(const UringDisk &) = delete;
+	UringDisk(UringDisk &&) = delete;
+	UringDisk &operator=(const UringDisk &) = delete;
+	UringDisk &operator=(UringDisk &&) = delete;
+
+	~UringDisk() override;
+
+	/// Creates the Chunk files, using O_DIRECT for the data part if enabled
+	void creat(IChunk *chunk) override;
+
+	/// Opens the Chunk files, using O_DIRECT for the data part if enabled
+	void open(IChunk *chunk) override;
+
+	/// Reads \a size bytes at \a offset of the data part through the ring
+	ssize_t preadData(IChunk *chunk, uint8_t *blockBuffer, uint64_t size,
+	                  uint64_t offset) override;
+
+	/// Zero-copy reads need the page cache, not available with O_DIRECT
+	ssize_t spliceData(IChunk *chunk, int pipeFD, uint64_t size,
+	                   uint64_t offset) override;
+
+	/// Writes at the current position of the data part through the ring
+	int writeChunkData(IChunk *chunk, uint8_t *blockBuffer, int32_t blockSize,
+	                   off64_t offset) override;
+
+	/// The page cache is bypassed when using O_DIRECT, nothing to prefetch
+	void prefetchChunkBlocks(IChunk &chunk, uint16_t firstBlock,
+	                         uint32_t blockCount) override;
+
+protected:
+	/// Writes \a size bytes at \a offset of the data part through the ring
+	ssize_t pwriteData(IChunk *chunk, const uint8_t *buffer, uint64_t size,
+	                   uint64_t offset) override;
+
+	/// Writes the buffers one by one through the ring, which may need to
+	/// bounce each of them to satisfy the O_DIRECT constraints
+	ssize_t pwritevData(IChunk *chunk, const struct iovec *iov, int iovcnt,
+	                    uint64_t offset) override;
+
+private:
+	/// Aligned memory used to satisfy the O_DIRECT constraints for requests
+	/// not aligned to disk::kIoBlockSize.
+	struct BounceBuffer {
+		uint8_t *data = nullptr;
+		int registeredIndex = -1;  ///< -1 for temporary (not pooled) buffers
+	};
+
+	/// Size of each bounce buffer: one block plus alignment on both ends
+	static constexpr uint32_t kBounceBufferSize =
+	    SFSBLOCKSIZE + 2 * disk::kIoBlockSize;
+
+	/// Opens the data part with the configured flags
+	int openData(IChunk *chunk, int flags);
+
+	/// Reads or writes through the ring (or plain syscalls as fallback)
+	ssize_t transfer(IoUringRequest::Type type, int fd, uint8_t *buffer,
+	                 uint64_t size, uint64_t offset);
+
+	/// Reads a range not satisfying the O_DIRECT alignment constraints
+	ssize_t readUnaligned(int fd, uint8_t *buffer, uint64_t size,
+	                      uint64_t offset);
+
+	/// Writes a range not satisfying the O_DIRECT alignment constraints by
+	/// reading, modifying and writing back the enclosing aligned range.
+	ssize_t writeUnaligned(int fd, const uint8_t *buffer, uint64_t size,
+	                       uint64_t offset);
+
+	BounceBuffer acquireBounceBuffer();
+	void releaseBounceBuffer(const BounceBuffer &buffer);
+
+	UringDiskOptions options_;
+	std::unique_ptr<IoUringQueue> queue_;
+
+	/// O_DIRECT is actually in use (it may be unsupported by the filesystem)
+	std::atomic_bool directIoActive_;
+
+	std::mutex bounceMutex_;
+	uint8_t *bounceArena_ = nullptr;
+	std::vector<BounceBuffer> freeBounceBuffers_;
+};
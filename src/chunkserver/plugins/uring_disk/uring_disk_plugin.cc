@@ -0,0 +1,47 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "uring_disk_plugin.h"
+
+#include <boost/make_shared.hpp>
+
+#include "config/cfg.h"
+
+static constexpr uint32_t kMinQueueDepth = 4;
+static constexpr uint32_t kMaxQueueDepth = 4096;
+
+bool UringDiskPlugin::initialize() {
+	DiskPlugin::initialize();
+
+	options_.queueDepth = std::clamp(cfg_getuint32("URING_QUEUE_DEPTH", 64),
+	                                 kMinQueueDepth, kMaxQueueDepth);
+	options_.directIo = cfg_getuint8("URING_DIRECT_IO", 0) != 0U;
+	options_.registeredBuffers = cfg_getuint32("URING_REGISTERED_BUFFERS", 0);
+
+	return true;
+}
+
+IDisk *UringDiskPlugin::createDisk(const disk::Configuration &configuration) {
+	return new UringDisk(configuration, options_);
+}
+
+boost::shared_ptr<IPlugin> UringDiskPlugin::create() {
+	return boost::make_shared<UringDiskPlugin>();
+}
+
+BOOST_DLL_ALIAS(UringDiskPlugin::create, createPlugin)
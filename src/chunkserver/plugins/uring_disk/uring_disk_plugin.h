@@ -0,0 +1,43 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include "chunkserver-common/disk_plugin.h"
+#include "uring_disk.h"
+
+/// Plugin providing the UringDisk for the 'uring:' prefixed hdd.cfg lines.
+class BOOST_SYMBOL_VISIBLE UringDiskPlugin : public DiskPlugin {
+public:
+	/// Reads the URING_* options from the chunkserver configuration
+	bool initialize() override;
+
+	std::string name() override { return "UringDiskPlugin"; }
+
+	std::string prefix() override { return "uring"; }
+
+	IDisk *createDisk(const disk::Configuration &configuration) override;
+
+	/// Factory exported to the PluginManager as 'createPlugin'
+	static boost::shared_ptr<IPlugin> create();
+
+private:
+	UringDiskOptions options_;
+};
@@ -44,8 +44,80 @@ static inline void blockXorAligned(uint8_t* dest, const uint8_t* source, size_t
 static inline void blockXorUnaligned(uint8_t* dest, const uint8_t* source, size_t size);
 
 
+#if defined(SAUNAFS_HAVE_CPU_CHECK) && defined(__x86_64__) && __GNUC__ >= 11
+
+#include <immintrin.h>
+
+// Explicit AVX kernels, as the byte loops are vectorized only for the baseline SSE2. Unaligned
+// loads and stores of these CPUs are as fast as aligned ones when the data happens to be aligned.
+
+__attribute__((target("avx2")))
+static void blockXorAvx2(uint8_t* dest, const uint8_t* source, size_t size) {
+	size_t i = 0;
+	for (; i + 128 <= size; i += 128) {
+		for (size_t j = i; j < i + 128; j += 32) {
+			__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dest + j));
+			__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + j));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + j), _mm256_xor_si256(d, s));
+		}
+	}
+	for (; i + 32 <= size; i += 32) {
+		__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dest + i));
+		__m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), _mm256_xor_si256(d, s));
+	}
+	for (; i < size; ++i) {
+		dest[i] ^= source[i];
+	}
+}
+
+__attribute__((target("avx512f")))
+static void blockXorAvx512(uint8_t* dest, const uint8_t* source, size_t size) {
+	size_t i = 0;
+	for (; i + 256 <= size; i += 256) {
+		for (size_t j = i; j < i + 256; j += 64) {
+			__m512i d = _mm512_loadu_si512(dest + j);
+			__m512i s = _mm512_loadu_si512(source + j);
+			_mm512_storeu_si512(dest + j, _mm512_xor_si512(d, s));
+		}
+	}
+	for (; i + 64 <= size; i += 64) {
+		__m512i d = _mm512_loadu_si512(dest + i);
+		__m512i s = _mm512_loadu_si512(source + i);
+		_mm512_storeu_si512(dest + i, _mm512_xor_si512(d, s));
+	}
+	for (; i < size; ++i) {
+		dest[i] ^= source[i];
+	}
+}
+
+typedef void (*BlockXorFunction)(uint8_t* dest, const uint8_t* source, size_t size);
+
+static BlockXorFunction blockXorGetFunction() {
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		return blockXorAvx512;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		return blockXorAvx2;
+	}
+	return nullptr;
+}
+
+static BlockXorFunction gBlockXorFunction = blockXorGetFunction();
+
+#else
+
+static constexpr void (*gBlockXorFunction)(uint8_t*, const uint8_t*, size_t) = nullptr;
+
+#endif
+
 // Public interface, tries to do it as well as possible.
 void blockXor(uint8_t* dest, const uint8_t* source, size_t size) {
+	if (gBlockXorFunction != nullptr) {
+		gBlockXorFunction(dest, source, size);
+		return;
+	}
 	intptr_t d = reinterpret_cast<intptr_t>(dest);
 	intptr_t s = reinterpret_cast<intptr_t>(source);
 	if (d % ALIGNMENT == s % ALIGNMENT) {
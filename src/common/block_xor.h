@@ -27,8 +27,8 @@
 /*
  * XOR dest in-place with source.
  *
- * Implementation will try to use vector instructions if dest and source
- * are well-aligned or, at least, the difference between them is divisible
- * by vector width.
+ * Implementation uses AVX2 or AVX-512 when the CPU supports them. Otherwise
+ * it will try to use vector instructions if dest and source are well-aligned
+ * or, at least, the difference between them is divisible by vector width.
  */
 void blockXor(uint8_t* dest, const uint8_t* source, size_t size);
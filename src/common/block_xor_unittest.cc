@@ -20,8 +20,11 @@
 #include "common/platform.h"
 #include "common/block_xor.h"
 
+#include <iostream>
 #include <gtest/gtest.h>
 
+#include "common/time_utils.h"
+
 TEST(BlockXorTests, BlockXor) {
 	std::vector<uint8_t> v1(7000);
 	std::vector<uint8_t> v2(v1.size());
@@ -34,3 +37,38 @@ TEST(BlockXorTests, BlockXor) {
 		}
 	}
 }
+
+TEST(BlockXorTests, BlockXorResult) {
+	std::vector<uint8_t> v1(7000), v2(v1.size()), expected;
+	for (size_t i = 0; i < v1.size(); ++i) {
+		v1[i] = i * 7;
+		v2[i] = i * 13 + 5;
+	}
+	for (size_t offset1 : {0, 1, 31, 32}) {
+		for (size_t offset2 : {0, 3, 32}) {
+			for (size_t size : {0, 5, 63, 64, 65, 255, 256, 257, 6000}) {
+				expected = v1;
+				for (size_t i = 0; i < size; ++i) {
+					expected[offset1 + i] ^= v2[offset2 + i];
+				}
+				std::vector<uint8_t> result = v1;
+				blockXor(result.data() + offset1, v2.data() + offset2, size);
+				ASSERT_EQ(expected, result)
+				    << "offset1=" << offset1 << " offset2=" << offset2 << " size=" << size;
+			}
+		}
+	}
+}
+
+TEST(BlockXorTests, BlockXorBenchmark) {
+	const size_t size = 64 * 1024;
+	const int repeatCount = 10000;
+	std::vector<uint8_t> v1(size, 1), v2(size, 2);
+	Timer time;
+	for (int i = 0; i < repeatCount; ++i) {
+		blockXor(v1.data(), v2.data(), size);
+	}
+	int64_t speed = (int64_t)size * repeatCount / std::max<int64_t>(time.elapsed_us(), 1);
+	std::cout << "blockXor of 64 KiB blocks = " << speed << "MB/s\n";
+	EXPECT_EQ(v1[0], 1);
+}
@@ -0,0 +1,125 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "common/changelog_file.h"
+
+#include <cinttypes>
+#include <cstdlib>
+#include <cstring>
+
+#include "common/crc.h"
+#include "common/datapack.h"
+
+bool writeBinaryChangelogHeader(FILE *file) {
+	return fwrite(kBinaryChangelogHeader, 1, kBinaryChangelogHeaderSize, file) ==
+	       kBinaryChangelogHeaderSize;
+}
+
+bool writeChangelogEntry(FILE *file, ChangelogFormat format, uint64_t version,
+                         const char *entry) {
+	if (format == ChangelogFormat::kText) {
+		return fprintf(file, "%" PRIu64 ": %s\n", version, entry) > 0;
+	}
+
+	uint32_t size = strlen(entry);
+	uint8_t header[kBinaryChangelogRecordHeaderSize];
+	uint8_t *ptr = header + 4;
+	put32bit(&ptr, size);
+	put8bit(&ptr, static_cast<uint8_t>(ChangelogRecordType::kChange));
+	put64bit(&ptr, version);
+	uint32_t crc = mycrc32(0, header + 4, kBinaryChangelogRecordHeaderSize - 4);
+	crc = mycrc32(crc, reinterpret_cast<const uint8_t *>(entry), size);
+	ptr = header;
+	put32bit(&ptr, crc);
+	return fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+	       fwrite(entry, 1, size, file) == size;
+}
+
+ChangelogFileReader::ChangelogFileReader(const std::string &filename)
+    : file_(filename, std::ios::binary) {
+	char header[kBinaryChangelogHeaderSize];
+	if (file_.read(header, sizeof(header)) &&
+	    memcmp(header, kBinaryChangelogHeader, sizeof(header)) == 0) {
+		format_ = ChangelogFormat::kBinary;
+	} else {
+		file_.clear();
+		file_.seekg(0);
+	}
+}
+
+bool ChangelogFileReader::next(uint64_t &version, std::string &entry) {
+	if (!file_.is_open() || !error_.empty()) {
+		return false;
+	}
+	return format_ == ChangelogFormat::kText ? nextText(version, entry)
+	                                         : nextBinary(version, entry);
+}
+
+bool ChangelogFileReader::nextText(uint64_t &version, std::string &entry) {
+	// A line without the LF at the end is a truncated one
+	if (!std::getline(file_, line_).good()) {
+		return false;
+	}
+	char *end = nullptr;
+	version = strtoull(line_.c_str(), &end, 10);
+	if (end == line_.c_str() || *end != ':') {
+		error_ = "malformed line: " + line_.substr(0, 50);
+		return false;
+	}
+	entry.assign(end);
+	lastVersion_ = version;
+	return true;
+}
+
+bool ChangelogFileReader::nextBinary(uint64_t &version, std::string &entry) {
+	uint8_t header[kBinaryChangelogRecordHeaderSize];
+	if (!file_.read(reinterpret_cast<char *>(header), sizeof(header))) {
+		return false;
+	}
+	const uint8_t *ptr = header;
+	uint32_t crc = get32bit(&ptr);
+	uint32_t size = get32bit(&ptr);
+	uint8_t type = get8bit(&ptr);
+	version = get64bit(&ptr);
+	if (size > kMaxLogLineSize) {
+		error_ = "record too long after change " + std::to_string(lastVersion_);
+		return false;
+	}
+	// The ": " prefix of a text line is kept to give restore() the same input
+	line_.resize(2 + size);
+	if (!file_.read(line_.data() + 2, size)) {
+		return false;
+	}
+	uint32_t expectedCrc = mycrc32(0, header + 4, sizeof(header) - 4);
+	expectedCrc =
+	    mycrc32(expectedCrc, reinterpret_cast<const uint8_t *>(line_.data() + 2), size);
+	if (crc != expectedCrc) {
+		error_ = "checksum mismatch after change " + std::to_string(lastVersion_);
+		return false;
+	}
+	if (type != static_cast<uint8_t>(ChangelogRecordType::kChange)) {
+		error_ = "unknown type of change " + std::to_string(version);
+		return false;
+	}
+	line_[0] = ':';
+	line_[1] = ' ';
+	entry.swap(line_);
+	lastVersion_ = version;
+	return true;
+}
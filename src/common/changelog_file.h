@@ -0,0 +1,95 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+/// Maximal length of a changelog entry (or line in the text format)
+constexpr uint32_t kMaxLogLineSize = 200000;
+
+/*! \brief Formats of the changelog files.
+ *
+ * Text changelogs have one "<version>: <ts>|<COMMAND>(arg1,arg2,...)" line per change.
+ * Binary changelogs start with kBinaryChangelogHeader, followed by records of:
+ *   crc:32 size:32 type:8 version:64 entry:size
+ * where the entry is the "<ts>|<COMMAND>(arg1,arg2,...)" part of the text line and the
+ * crc covers everything after itself. The records are not separated by anything, so
+ * a reader finds the next one without scanning for a line end, and a record written
+ * partially (e.g. the master was killed during a write) is detected by the crc.
+ */
+enum class ChangelogFormat { kText, kBinary };
+
+constexpr char kBinaryChangelogHeader[] = "SAUCLOG1";
+constexpr uint32_t kBinaryChangelogHeaderSize = sizeof(kBinaryChangelogHeader) - 1;
+constexpr uint32_t kBinaryChangelogRecordHeaderSize = 4 + 4 + 1 + 8;
+
+/// Types of the binary changelog records.
+enum class ChangelogRecordType : uint8_t {
+	kChange = 1,  ///< a metadata change, in the same syntax as in the text changelogs
+};
+
+/// Writes the header of a binary changelog, returns false on an error.
+bool writeBinaryChangelogHeader(FILE *file);
+
+/// Appends a change to a changelog in the given format, returns false on an error.
+bool writeChangelogEntry(FILE *file, ChangelogFormat format, uint64_t version,
+                         const char *entry);
+
+/*! \brief Reader of changelog files of both formats.
+ *
+ * The format is detected from the beginning of the file. Entries are returned in
+ * the form expected by restore(), i.e. ": <ts>|<COMMAND>(arg1,arg2,...)".
+ */
+class ChangelogFileReader {
+public:
+	/// Opens the file, check isOpen() for the result.
+	explicit ChangelogFileReader(const std::string &filename);
+
+	ChangelogFileReader(const ChangelogFileReader &) = delete;
+	ChangelogFileReader &operator=(const ChangelogFileReader &) = delete;
+
+	bool isOpen() const { return file_.is_open(); }
+	ChangelogFormat format() const { return format_; }
+
+	/*! \brief Reads the next change.
+	 *
+	 * Returns false at the end of the file and when the rest of the file can't be
+	 * read, in which case error() describes the problem. A truncated last text line
+	 * or binary record is silently treated as the end of the file.
+	 */
+	bool next(uint64_t &version, std::string &entry);
+
+	/// Description of the damage which stopped the reading, empty if there was none.
+	const std::string &error() const { return error_; }
+
+private:
+	bool nextText(uint64_t &version, std::string &entry);
+	bool nextBinary(uint64_t &version, std::string &entry);
+
+	std::ifstream file_;
+	ChangelogFormat format_ = ChangelogFormat::kText;
+	std::string line_;
+	std::string error_;
+	uint64_t lastVersion_ = 0;
+};
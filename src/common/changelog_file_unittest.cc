@@ -0,0 +1,104 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "common/changelog_file.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "unittests/TemporaryDirectory.h"
+
+static const std::vector<std::string> kEntries = {
+    "1700000000|CREATE(1,file%2Cname,f,420,0,0,0):2",
+    "1700000001|WRITE(2,0,1):1",
+    "1700000002|UNLINK(1,file%2Cname):2",
+};
+
+static void writeChangelog(const std::string &fileName, ChangelogFormat format) {
+	FILE *file = fopen(fileName.c_str(), "w");
+	ASSERT_NE(file, nullptr);
+	if (format == ChangelogFormat::kBinary) {
+		ASSERT_TRUE(writeBinaryChangelogHeader(file));
+	}
+	for (size_t i = 0; i < kEntries.size(); ++i) {
+		ASSERT_TRUE(writeChangelogEntry(file, format, 100 + i, kEntries[i].c_str()));
+	}
+	fclose(file);
+}
+
+static void expectEntries(ChangelogFileReader &reader, size_t count) {
+	uint64_t version;
+	std::string entry;
+	for (size_t i = 0; i < count; ++i) {
+		ASSERT_TRUE(reader.next(version, entry));
+		EXPECT_EQ(version, 100 + i);
+		EXPECT_EQ(entry, ": " + kEntries[i]);
+	}
+	EXPECT_FALSE(reader.next(version, entry));
+}
+
+TEST(ChangelogFileTests, ReadBothFormats) {
+	TemporaryDirectory temp("/tmp", "saunafs_changelog_file");
+	for (auto format : {ChangelogFormat::kText, ChangelogFormat::kBinary}) {
+		std::string fileName = temp.name() + "/changelog.sfs";
+		writeChangelog(fileName, format);
+		ChangelogFileReader reader(fileName);
+		ASSERT_TRUE(reader.isOpen());
+		EXPECT_EQ(reader.format(), format);
+		expectEntries(reader, kEntries.size());
+		EXPECT_EQ(reader.error(), "");
+	}
+	EXPECT_FALSE(ChangelogFileReader(temp.name() + "/missing").isOpen());
+}
+
+TEST(ChangelogFileTests, TruncatedBinaryRecordEndsTheFile) {
+	TemporaryDirectory temp("/tmp", "saunafs_changelog_file");
+	std::string fileName = temp.name() + "/changelog.sfs";
+	writeChangelog(fileName, ChangelogFormat::kBinary);
+	struct stat st;
+	ASSERT_EQ(stat(fileName.c_str(), &st), 0);
+	ASSERT_EQ(truncate(fileName.c_str(), st.st_size - 3), 0);
+
+	ChangelogFileReader reader(fileName);
+	expectEntries(reader, kEntries.size() - 1);
+	EXPECT_EQ(reader.error(), "");
+}
+
+TEST(ChangelogFileTests, DamagedBinaryRecordIsDetected) {
+	TemporaryDirectory temp("/tmp", "saunafs_changelog_file");
+	std::string fileName = temp.name() + "/changelog.sfs";
+	writeChangelog(fileName, ChangelogFormat::kBinary);
+	// Change one character of the second entry
+	long offset = kBinaryChangelogHeaderSize + kBinaryChangelogRecordHeaderSize +
+	              kEntries[0].size() + kBinaryChangelogRecordHeaderSize + 5;
+	FILE *file = fopen(fileName.c_str(), "r+");
+	ASSERT_NE(file, nullptr);
+	fseek(file, offset, SEEK_SET);
+	fputc('9', file);
+	fclose(file);
+
+	ChangelogFileReader reader(fileName);
+	expectEntries(reader, 1);
+	EXPECT_EQ(reader.error(), "checksum mismatch after change 100");
+}
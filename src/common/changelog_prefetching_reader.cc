@@ -0,0 +1,99 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "common/changelog_prefetching_reader.h"
+
+ChangelogPrefetchingReader::ChangelogPrefetchingReader(const std::string &filename)
+    : reader_(filename) {
+	if (reader_.isOpen()) {
+		worker_ = std::thread(&ChangelogPrefetchingReader::run, this);
+	} else {
+		finished_ = true;
+	}
+}
+
+ChangelogPrefetchingReader::~ChangelogPrefetchingReader() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	batchTaken_.notify_one();
+	if (worker_.joinable()) {
+		worker_.join();
+	}
+}
+
+void ChangelogPrefetchingReader::run() {
+	Batch batch;
+	while (true) {
+		batch.entries.resize(kBatchSize);
+		bool more = true;
+		for (batch.size = 0; batch.size < kBatchSize; ++batch.size) {
+			auto &entry = batch.entries[batch.size];
+			if (!(more = reader_.next(entry.first, entry.second))) {
+				break;
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		batchTaken_.wait(lock, [this] { return stop_ || batches_.size() < kMaxBatches; });
+		if (stop_) {
+			return;
+		}
+		if (batch.size > 0) {
+			batches_.push_back(std::move(batch));
+		}
+		if (!more) {
+			error_ = reader_.error();
+			finished_ = true;
+		}
+		batchReady_.notify_one();
+		if (finished_) {
+			return;
+		}
+		if (spare_.empty()) {
+			batch = Batch();
+		} else {
+			batch = std::move(spare_.back());
+			spare_.pop_back();
+		}
+	}
+}
+
+bool ChangelogPrefetchingReader::next(uint64_t &version, std::string &entry) {
+	while (position_ >= current_.size) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (!current_.entries.empty()) {
+			spare_.push_back(std::move(current_));
+			current_ = Batch();
+		}
+		batchReady_.wait(lock, [this] { return finished_ || !batches_.empty(); });
+		if (batches_.empty()) {
+			return false;
+		}
+		current_ = std::move(batches_.front());
+		batches_.pop_front();
+		position_ = 0;
+		batchTaken_.notify_one();
+	}
+	auto &next = current_.entries[position_++];
+	version = next.first;
+	entry.swap(next.second);
+	return true;
+}
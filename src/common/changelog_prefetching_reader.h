@@ -0,0 +1,91 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "common/changelog_file.h"
+
+/*! \brief Reader of changelog files which decodes the file on its own thread.
+ *
+ * Reading the file, splitting it into entries and verifying the checksums of the
+ * binary records is done by a worker thread, ahead of the consumer, so replaying
+ * a changelog costs the consumer only the application of the changes. The worker
+ * stays at most kMaxBatches batches of kBatchSize entries ahead.
+ *
+ * The interface is the one of ChangelogFileReader.
+ */
+class ChangelogPrefetchingReader {
+public:
+	static constexpr size_t kBatchSize = 1024;
+	static constexpr size_t kMaxBatches = 4;
+
+	/// Opens the file and starts the worker, check isOpen() for the result.
+	explicit ChangelogPrefetchingReader(const std::string &filename);
+
+	/// Stops the worker, also when the file wasn't read to its end.
+	~ChangelogPrefetchingReader();
+
+	ChangelogPrefetchingReader(const ChangelogPrefetchingReader &) = delete;
+	ChangelogPrefetchingReader &operator=(const ChangelogPrefetchingReader &) = delete;
+
+	bool isOpen() const { return reader_.isOpen(); }
+	ChangelogFormat format() const { return reader_.format(); }
+
+	/// Returns the next change, see ChangelogFileReader::next.
+	bool next(uint64_t &version, std::string &entry);
+
+	/// Description of the damage which stopped the reading, valid after next() returned
+	/// false.
+	const std::string &error() const { return error_; }
+
+private:
+	struct Batch {
+		/// Always kBatchSize long, the strings of a reused batch keep their memory
+		std::vector<std::pair<uint64_t, std::string>> entries;
+		size_t size = 0;  ///< number of the valid entries
+	};
+
+	void run();
+
+	ChangelogFileReader reader_;
+
+	std::mutex mutex_;
+	std::condition_variable batchReady_;
+	std::condition_variable batchTaken_;
+	std::deque<Batch> batches_;  ///< decoded batches, not yet taken by the consumer
+	std::vector<Batch> spare_;   ///< consumed batches, reused to keep the allocated strings
+	bool finished_ = false;      ///< the worker has read everything it could
+	bool stop_ = false;          ///< the reader is being destroyed
+
+	Batch current_;          ///< batch being consumed
+	size_t position_ = 0;    ///< position of the next entry in current_
+	std::string error_;      ///< copied from reader_ after the worker finished
+
+	std::thread worker_;
+};
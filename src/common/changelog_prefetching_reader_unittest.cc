@@ -0,0 +1,108 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "common/changelog_prefetching_reader.h"
+
+#include <cstdio>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "unittests/TemporaryDirectory.h"
+
+// More than the worker may decode ahead, so it has to wait for the consumer
+static constexpr uint64_t kEntriesCount =
+    ChangelogPrefetchingReader::kBatchSize * ChangelogPrefetchingReader::kMaxBatches * 3 + 7;
+
+static std::string entryText(uint64_t version) {
+	return std::to_string(1700000000 + version) + "|ACCESS(" + std::to_string(version) + ")";
+}
+
+static void writeChangelog(const std::string &fileName, ChangelogFormat format) {
+	FILE *file = fopen(fileName.c_str(), "w");
+	ASSERT_NE(file, nullptr);
+	if (format == ChangelogFormat::kBinary) {
+		ASSERT_TRUE(writeBinaryChangelogHeader(file));
+	}
+	for (uint64_t version = 1; version <= kEntriesCount; ++version) {
+		ASSERT_TRUE(writeChangelogEntry(file, format, version, entryText(version).c_str()));
+	}
+	fclose(file);
+}
+
+TEST(ChangelogPrefetchingReaderTests, ReadsAllEntriesInOrder) {
+	TemporaryDirectory temp("/tmp", "saunafs_changelog_prefetching_reader");
+	for (auto format : {ChangelogFormat::kText, ChangelogFormat::kBinary}) {
+		std::string fileName = temp.name() + "/changelog.sfs";
+		writeChangelog(fileName, format);
+		ChangelogPrefetchingReader reader(fileName);
+		ASSERT_TRUE(reader.isOpen());
+		EXPECT_EQ(reader.format(), format);
+		uint64_t version;
+		std::string entry;
+		for (uint64_t expected = 1; expected <= kEntriesCount; ++expected) {
+			ASSERT_TRUE(reader.next(version, entry));
+			ASSERT_EQ(version, expected);
+			ASSERT_EQ(entry, ": " + entryText(expected));
+		}
+		EXPECT_FALSE(reader.next(version, entry));
+		EXPECT_FALSE(reader.next(version, entry));
+		EXPECT_EQ(reader.error(), "");
+	}
+}
+
+TEST(ChangelogPrefetchingReaderTests, ReportsDamage) {
+	TemporaryDirectory temp("/tmp", "saunafs_changelog_prefetching_reader");
+	std::string fileName = temp.name() + "/changelog.sfs";
+	writeChangelog(fileName, ChangelogFormat::kText);
+	FILE *file = fopen(fileName.c_str(), "a");
+	ASSERT_NE(file, nullptr);
+	fputs("garbage\n", file);
+	fclose(file);
+
+	ChangelogPrefetchingReader reader(fileName);
+	uint64_t version;
+	std::string entry;
+	uint64_t count = 0;
+	while (reader.next(version, entry)) {
+		++count;
+	}
+	EXPECT_EQ(count, kEntriesCount);
+	EXPECT_EQ(reader.error(), "malformed line: garbage");
+}
+
+TEST(ChangelogPrefetchingReaderTests, StopsWithoutReadingToTheEnd) {
+	TemporaryDirectory temp("/tmp", "saunafs_changelog_prefetching_reader");
+	std::string fileName = temp.name() + "/changelog.sfs";
+	writeChangelog(fileName, ChangelogFormat::kBinary);
+	ChangelogPrefetchingReader reader(fileName);
+	uint64_t version;
+	std::string entry;
+	ASSERT_TRUE(reader.next(version, entry));
+	EXPECT_EQ(version, 1U);
+	// The destructor has to stop the worker waiting for free space
+}
+
+TEST(ChangelogPrefetchingReaderTests, MissingFile) {
+	ChangelogPrefetchingReader reader("/nonexistent/changelog.sfs");
+	EXPECT_FALSE(reader.isOpen());
+	uint64_t version;
+	std::string entry;
+	EXPECT_FALSE(reader.next(version, entry));
+}
@@ -21,6 +21,8 @@
 
 #include "common/platform.h"
 
+#include <vector>
+
 #include "common/chunk_part_type.h"
 #include "common/network_address.h"
 #include "common/serialization_macros.h"
@@ -85,3 +87,11 @@ struct ChunkTypeWithAddress {
 
 	SAUNAFS_DEFINE_SERIALIZE_METHODS(address, chunk_type, chunkserver_version);
 };
+
+/// Version and locations of a chunk, as sent to clients locating many chunks of a file at once.
+SERIALIZABLE_CLASS_BEGIN(ChunkWithVersionAndLocations)
+SERIALIZABLE_CLASS_BODY(ChunkWithVersionAndLocations,
+		uint64_t, chunk_id,
+		uint32_t, chunk_version,
+		std::vector<ChunkTypeWithAddress>, locations)
+SERIALIZABLE_CLASS_END;
@@ -20,6 +20,8 @@
 #include "common/platform.h"
 #include "common/chunkserver_stats.h"
 
+#include <algorithm>
+#include <limits>
 #include <mutex>
 #include <unordered_map>
 
@@ -28,7 +30,29 @@
 constexpr int ChunkserverStats::ChunkserverEntry::defectiveTimeout_ms;
 
 ChunkserverStats::ChunkserverEntry::ChunkserverEntry(): pendingReads_(0), pendingWrites_(0),
-		defects_(0), defectiveTimeout_(std::chrono::milliseconds(defectiveTimeout_ms)) {
+		defects_(0), defectiveTimeout_(std::chrono::milliseconds(defectiveTimeout_ms)),
+		readLatencies_us_(), readLatencyCount_(0) {
+}
+
+std::optional<std::chrono::microseconds>
+ChunkserverStats::ChunkserverEntry::readLatencyPercentile(int percentile) const {
+	int count = std::min<int>(readLatencyCount_, kLatencySamples);
+	if (count < kMinLatencySamples) {
+		return std::nullopt;
+	}
+	std::array<uint32_t, kLatencySamples> samples = readLatencies_us_;
+	auto nth = samples.begin() + std::min(count - 1, count * percentile / 100);
+	std::nth_element(samples.begin(), nth, samples.begin() + count);
+	return std::chrono::microseconds(*nth);
+}
+
+std::optional<std::chrono::microseconds>
+ChunkserverStats::ChunkserverEntry::expectedReadLatency(uint32_t blocks) const {
+	auto latency = readLatencyPercentile(95);
+	if (!latency) {
+		return std::nullopt;
+	}
+	return *latency * std::max<uint32_t>(blocks, 1);
 }
 
 // ChunkserverStats implementation
@@ -73,12 +97,31 @@ void ChunkserverStats::markDefective(const NetworkAddress& address) {
 	chunkserver.defectiveTimeout_.reset();
 }
 
+void ChunkserverStats::recordReadLatency(const NetworkAddress& address,
+		std::chrono::microseconds latency, uint32_t blocks) {
+	uint32_t latency_us = std::min<int64_t>(latency.count() / std::max<uint32_t>(blocks, 1),
+			std::numeric_limits<uint32_t>::max());
+	std::unique_lock<std::mutex> lock(mutex_);
+	ChunkserverEntry &chunkserver = chunkserverEntries_[address];
+	chunkserver.readLatencies_us_[chunkserver.readLatencyCount_ % ChunkserverEntry::kLatencySamples] =
+			latency_us;
+	chunkserver.readLatencyCount_++;
+	if (chunkserver.readLatencyCount_ == 2 * ChunkserverEntry::kLatencySamples) {
+		// keep the counter small, it only has to tell whether the buffer is full
+		chunkserver.readLatencyCount_ = ChunkserverEntry::kLatencySamples;
+	}
+}
+
 float ChunkserverStats::ChunkserverEntry::score() const {
+	float score = 1;
 	if (defects_ > 0 && !defectiveTimeout_.expired()) {
-		return 1. / (defects_ + 1);
-	} else {
-		return 1;
+		score = 1. / (defects_ + 1);
+	}
+	auto latency = readLatencyPercentile(50);
+	if (latency) {
+		score /= 1. + (float)latency->count() / kReferenceLatency_us;
 	}
+	return score;
 }
 
 // ChunkserverStatsProxy implementation
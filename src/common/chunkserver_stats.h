@@ -21,8 +21,10 @@
 
 #include "common/platform.h"
 
+#include <array>
 #include <chrono>
 #include <mutex>
+#include <optional>
 #include <unordered_map>
 
 #include "common/network_address.h"
@@ -43,6 +45,10 @@
 //
 // Successful operations on chunkservers considered "defective" should call markWorking().
 //
+// Finished reads should be reported with recordReadLatency(). The latency of the most recent
+// reads, per block read, is used to prefer fast chunkservers and to tell when a read takes
+// unusually long, so that the same data can be requested from other chunkservers.
+//
 // All methods are thread safe.
 //
 class ChunkserverStats {
@@ -65,13 +71,30 @@ public:
 
 		float score() const;
 
+		/// Returns the given percentile of the latency of recent reads per block,
+		/// or std::nullopt if too few reads were recorded.
+		std::optional<std::chrono::microseconds> readLatencyPercentile(int percentile) const;
+
+		/// Returns how long a read of \a blocks blocks takes at most, unless something
+		/// goes wrong, or std::nullopt if it is not known yet.
+		std::optional<std::chrono::microseconds> expectedReadLatency(uint32_t blocks) const;
+
+		/// Number of recent reads which latency is remembered
+		static constexpr int kLatencySamples = 32;
+		/// Number of reads needed to estimate the latency
+		static constexpr int kMinLatencySamples = 8;
+
 	private:
 		static constexpr int defectiveTimeout_ms = 2000;
+		/// Median read latency per block which halves the score
+		static constexpr int64_t kReferenceLatency_us = 5000;
 
 		uint32_t pendingReads_;
 		uint32_t pendingWrites_;
 		uint32_t defects_;
 		Timeout defectiveTimeout_;
+		std::array<uint32_t, kLatencySamples> readLatencies_us_;
+		uint32_t readLatencyCount_;
 
 		friend class ChunkserverStats;
 	};
@@ -89,6 +112,10 @@ public:
 	void markDefective(const NetworkAddress& address);
 	void markWorking(const NetworkAddress& address);
 
+	/// Records that a read of \a blocks blocks from the chunkserver took \a latency.
+	void recordReadLatency(const NetworkAddress& address, std::chrono::microseconds latency,
+			uint32_t blocks);
+
 private:
 	std::mutex mutex_;
 	std::unordered_map<NetworkAddress, ChunkserverEntry> chunkserverEntries_;
@@ -139,3 +139,28 @@ TEST(ChunkserverStatsTests, AllPendingDefectiveLonger) {
 	EXPECT_EQ(stats.getStatisticsFor(server1).score(), 1.);
 	EXPECT_LT(stats.getStatisticsFor(server2).score(), 1.);
 }
+
+TEST(ChunkserverStatsTests, ReadLatency) {
+	using std::chrono::microseconds;
+	ChunkserverStats stats;
+	NetworkAddress server1(1111, 11);
+	NetworkAddress server2(2222, 22);
+
+	EXPECT_FALSE(stats.getStatisticsFor(server1).expectedReadLatency(1));
+	for (int i = 1; i <= 100; ++i) {
+		// per block latency 100..200 us, with an occasional very slow read
+		stats.recordReadLatency(server1, microseconds(i % 10 == 0 ? 8000 : 100 + i), 2);
+		stats.recordReadLatency(server2, microseconds(10000), 1);
+	}
+
+	auto entry1 = stats.getStatisticsFor(server1);
+	ASSERT_TRUE(entry1.readLatencyPercentile(50));
+	EXPECT_LT(*entry1.readLatencyPercentile(50), microseconds(150));
+	EXPECT_EQ(*entry1.readLatencyPercentile(95), microseconds(4000));
+	EXPECT_EQ(*entry1.expectedReadLatency(4), microseconds(16000));
+
+	auto entry2 = stats.getStatisticsFor(server2);
+	EXPECT_EQ(*entry2.readLatencyPercentile(50), microseconds(10000));
+	EXPECT_GT(entry1.score(), 2 * entry2.score());
+	EXPECT_LT(entry1.score(), 1.);
+}
@@ -23,6 +23,7 @@
 
 #include <inttypes.h>
 #include <stdlib.h>
+#include <array>
 #include <cstring>
 
 #include "protocol/SFSCommunication.h"
@@ -35,6 +36,10 @@ uint32_t mycrc32(uint32_t, const uint8_t*, uint32_t) {
 	return FAKE_CRC;
 }
 
+uint32_t mycrc32_generic(uint32_t, const uint8_t*, uint32_t) {
+	return FAKE_CRC;
+}
+
 uint32_t mycrc32_combine(uint32_t, uint32_t, uint32_t) {
 	return FAKE_CRC;
 }
@@ -42,6 +47,10 @@ uint32_t mycrc32_combine(uint32_t, uint32_t, uint32_t) {
 void mycrc32_init(void) {
 }
 
+const char *mycrc32_implementation(void) {
+	return "none";
+}
+
 #else // ENABLE_CRC
 
 /*
@@ -53,14 +62,10 @@ void mycrc32_init(void) {
 
 static crcutil::GenericCrc<uint64_t, uint64_t, uint64_t, 4> gCrc(CRC_POLY, 32, true);
 
-uint32_t mycrc32(uint32_t crc, const uint8_t *block, uint32_t leng) {
+uint32_t mycrc32_generic(uint32_t crc, const uint8_t *block, uint32_t leng) {
 	return gCrc.CrcDefault(block, leng, crc);
 }
 
-uint32_t mycrc32_combine(uint32_t crc1, uint32_t crc2, uint32_t leng2) {
-	return gCrc.Base().Concatenate(crc1, crc2, leng2);
-}
-
 void mycrc32_init(void) {
 	// This implementation does not need any initialization
 }
@@ -112,7 +117,7 @@ void crc_generate_main_tables(void) {
 	}
 }
 
-uint32_t mycrc32(uint32_t crc,const uint8_t *block,uint32_t leng) {
+uint32_t mycrc32_generic(uint32_t crc,const uint8_t *block,uint32_t leng) {
 	const uint32_t *block4;
 #ifdef WORDS_BIGENDIAN
 #define CRC_REORDER crc=(BYTEREV(crc))^0xFFFFFFFF
@@ -152,85 +157,255 @@ uint32_t mycrc32(uint32_t crc,const uint8_t *block,uint32_t leng) {
 	return crc;
 }
 
-/* crc_combine */
+void mycrc32_init(void) {
+	crc_generate_main_tables();
+}
 
-static uint32_t crc_combine_table[32][4][256];
+#endif // HAVE_CRCUTIL
 
-static void crc_matrix_square(uint32_t sqr[32], uint32_t m[32]) {
-	uint32_t i,j,s,v;
-	for (i=0; i<32; i++) {
-		for (j=0,s=0,v=m[i] ; v && j<32 ; j++, v>>=1) {
-			if (v&1) {
-				s^=m[j];
+/* crc_combine */
+
+namespace {
+
+/// Multiplies two polynomials modulo CRC_POLY, both in the reflected bit order of the CRC.
+constexpr uint32_t crc_multiply_mod_poly(uint32_t a, uint32_t b) {
+	uint32_t m = 1U << 31;
+	uint32_t p = 0;
+	for (;;) {
+		if (a & m) {
+			p ^= b;
+			if ((a & (m - 1)) == 0) {
+				break;
 			}
 		}
-		sqr[i] = s;
+		m >>= 1;
+		b = (b & 1) ? (b >> 1) ^ CRC_POLY : b >> 1;
 	}
+	return p;
 }
 
-static void crc_generate_combine_tables(void) {
-	uint32_t i,j,k,l,sum;
-	uint32_t m1[32],m2[32],*mc,*m;
-	m1[0]=CRC_POLY;
-	j=1;
-	for (i=1 ; i<32 ; i++) {
-		m1[i]=j;
-		j<<=1;
-	}
-	crc_matrix_square(m2,m1); // 1 bit -> 2 bits
-	crc_matrix_square(m1,m2); // 2 bits -> 4 bits
-
-	for (i=0 ; i<32 ; i++) {
-		if (i&1) {
-			crc_matrix_square(m1,m2);
-			mc = m1;
-		} else {
-			crc_matrix_square(m2,m1);
-			mc = m2;
-		}
-		for (j=0 ; j<4 ; j++) {
-			for (k=0 ; k<256 ; k++) {
-				sum = 0;
-				l=k;
-				m=mc+(j*8);
-				while (l) {
-					if (l&1) {
-						sum ^= *m;
-					}
-					l>>=1;
-					m++;
-				}
-				crc_combine_table[i][j][k]=sum;
-			}
-		}
+/// x^(2^n) modulo CRC_POLY for each n
+constexpr std::array<uint32_t, 32> crc_generate_x2n_table() {
+	std::array<uint32_t, 32> table{};
+	uint32_t p = 1U << 30; // x^1
+	table[0] = p;
+	for (int n = 1; n < 32; n++) {
+		p = crc_multiply_mod_poly(p, p);
+		table[n] = p;
 	}
+	return table;
 }
 
+constexpr std::array<uint32_t, 32> kCrcX2nTable = crc_generate_x2n_table();
+
+} // anonymous namespace
+
 uint32_t mycrc32_combine(uint32_t crc1, uint32_t crc2, uint32_t leng2) {
-	uint8_t i;
-
-	/* add leng2 zeros to crc1 */
-	i=0;
-	while (leng2) {
-		if (leng2&1) {
-			crc1 = crc_combine_table[i][3][(crc1>>24)] \
-			     ^ crc_combine_table[i][2][(crc1>>16)&0xFF] \
-			     ^ crc_combine_table[i][1][(crc1>>8)&0xFF] \
-			     ^ crc_combine_table[i][0][crc1&0xFF];
+	/* add leng2 zeros to crc1, ie. multiply it by x^(8*leng2) */
+	uint32_t power = 1U << 31; // x^0
+	for (uint32_t n = 3; leng2; n++, leng2 >>= 1) {
+		if (leng2 & 1) {
+			power = crc_multiply_mod_poly(kCrcX2nTable[n & 31], power);
 		}
-		i++;
-		leng2>>=1;
-	};
+	}
 	/* then combine crc1 and crc2 as output */
-	return crc1^crc2;
+	return crc_multiply_mod_poly(power, crc1) ^ crc2;
 }
 
-void mycrc32_init(void) {
-	crc_generate_main_tables();
-	crc_generate_combine_tables();
+/* hardware accelerated implementations */
+
+#if defined(SAUNAFS_HAVE_CPU_CHECK) && defined(__x86_64__)
+
+#include <immintrin.h>
+
+/*
+ * Folds 64 bytes at a time with carry-less multiplication, see "Fast CRC Computation for
+ * Generic Polynomials Using PCLMULQDQ Instruction" by Intel. The crc32 instruction of SSE4.2
+ * can't be used, as it computes CRC32C, which has a different polynomial.
+ * Requires leng >= 64 and a multiple of 16, crc is not negated on the input nor output.
+ */
+__attribute__((target("pclmul,sse4.1")))
+static uint32_t crc32_fold_pclmul(uint32_t crc, const uint8_t *block, uint32_t leng) {
+	// Powers of x modulo CRC_POLY: x^(4*128+32), x^(4*128-32), x^(128+32), x^(128-32), x^64,
+	// then the Barrett reduction constants: CRC_POLY with the implicit x^32 and floor(x^64/P)
+	alignas(16) static const uint64_t k1k2[] = {0x0154442bd4, 0x01c6e41596};
+	alignas(16) static const uint64_t k3k4[] = {0x01751997d0, 0x00ccaa009e};
+	alignas(16) static const uint64_t k5k0[] = {0x0163cd6124, 0x0000000000};
+	alignas(16) static const uint64_t poly[] = {0x01db710641, 0x01f7011641};
+
+	__m128i x0, x1, x2, x3, x4, x5, x6, x7, x8, y5, y6, y7, y8;
+
+	x1 = _mm_loadu_si128((const __m128i *)(block + 0x00));
+	x2 = _mm_loadu_si128((const __m128i *)(block + 0x10));
+	x3 = _mm_loadu_si128((const __m128i *)(block + 0x20));
+	x4 = _mm_loadu_si128((const __m128i *)(block + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(crc));
+	x0 = _mm_load_si128((const __m128i *)k1k2);
+	block += 64;
+	leng -= 64;
+
+	// Fold 4 x 128 bits in parallel
+	while (leng >= 64) {
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+		y5 = _mm_loadu_si128((const __m128i *)(block + 0x00));
+		y6 = _mm_loadu_si128((const __m128i *)(block + 0x10));
+		y7 = _mm_loadu_si128((const __m128i *)(block + 0x20));
+		y8 = _mm_loadu_si128((const __m128i *)(block + 0x30));
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), y5);
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), y6);
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), y7);
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), y8);
+		block += 64;
+		leng -= 64;
+	}
+
+	// Fold the 4 registers into one
+	x0 = _mm_load_si128((const __m128i *)k3k4);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	// Fold the remaining 16 byte blocks
+	while (leng >= 16) {
+		x2 = _mm_loadu_si128((const __m128i *)block);
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+		block += 16;
+		leng -= 16;
+	}
+
+	// Fold 128 bits into 64 bits
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x1 = _mm_srli_si128(x1, 8);
+	x1 = _mm_xor_si128(x1, x2);
+	x0 = _mm_loadl_epi64((const __m128i *)k5k0);
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, x3);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	// Barrett reduction to 32 bits
+	x0 = _mm_load_si128((const __m128i *)poly);
+	x2 = _mm_and_si128(x1, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+	x2 = _mm_and_si128(x2, x3);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+	return _mm_extract_epi32(x1, 1);
 }
 
-#endif // HAVE_CRCUTIL
+static uint32_t mycrc32_pclmul(uint32_t crc, const uint8_t *block, uint32_t leng) {
+	if (leng >= 64) {
+		uint32_t folded = leng & ~15U;
+		crc = ~crc32_fold_pclmul(~crc, block, folded);
+		block += folded;
+		leng -= folded;
+	}
+	return leng ? mycrc32_generic(crc, block, leng) : crc;
+}
+
+#define CRC_HAVE_PCLMUL
+
+#elif defined(__aarch64__) && defined(__linux__)
+
+#include <arm_acle.h>
+#include <sys/auxv.h>
+
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+
+/*
+ * The crc32 instructions of ARMv8 use CRC_POLY (unlike crc32c ones), so they are used directly.
+ */
+__attribute__((target("+crc")))
+static uint32_t mycrc32_armv8(uint32_t crc, const uint8_t *block, uint32_t leng) {
+	crc = ~crc;
+	while (leng && ((uintptr_t)block & 7)) {
+		crc = __crc32b(crc, *block++);
+		leng--;
+	}
+	while (leng >= 32) {
+		uint64_t words[4];
+		memcpy(words, block, sizeof(words));
+		crc = __crc32d(crc, words[0]);
+		crc = __crc32d(crc, words[1]);
+		crc = __crc32d(crc, words[2]);
+		crc = __crc32d(crc, words[3]);
+		block += 32;
+		leng -= 32;
+	}
+	while (leng >= 8) {
+		uint64_t word;
+		memcpy(&word, block, sizeof(word));
+		crc = __crc32d(crc, word);
+		block += 8;
+		leng -= 8;
+	}
+	while (leng) {
+		crc = __crc32b(crc, *block++);
+		leng--;
+	}
+	return ~crc;
+}
+
+#define CRC_HAVE_ARMV8
+
+#endif
+
+/* runtime dispatch */
+
+namespace {
+
+struct CrcImplementation {
+	const char *name;
+	uint32_t (*function)(uint32_t crc, const uint8_t *block, uint32_t leng);
+};
+
+CrcImplementation crc_choose_implementation() {
+#if defined(CRC_HAVE_PCLMUL)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1")) {
+		return {"pclmul", mycrc32_pclmul};
+	}
+#elif defined(CRC_HAVE_ARMV8)
+	if (getauxval(AT_HWCAP) & HWCAP_CRC32) {
+		return {"armv8-crc32", mycrc32_armv8};
+	}
+#endif
+	return {"generic", mycrc32_generic};
+}
+
+// Chosen on the first use, which may happen during the initialization of other static objects
+const CrcImplementation &crc_implementation() {
+	static const CrcImplementation implementation = crc_choose_implementation();
+	return implementation;
+}
+
+} // anonymous namespace
+
+uint32_t mycrc32(uint32_t crc, const uint8_t *block, uint32_t leng) {
+	return crc_implementation().function(crc, block, leng);
+}
+
+const char *mycrc32_implementation(void) {
+	return crc_implementation().name;
+}
 
 #endif // ENABLE_CRC
 
@@ -24,13 +24,18 @@
 
 #include <inttypes.h>
 
+/// Uses the fastest implementation available on the CPU, chosen on the first call.
 uint32_t mycrc32(uint32_t crc,const uint8_t *block,uint32_t leng);
+/// Portable implementation of mycrc32, the accelerated ones are checked against it.
+uint32_t mycrc32_generic(uint32_t crc, const uint8_t *block, uint32_t leng);
 uint32_t mycrc32_combine(uint32_t crc1, uint32_t crc2, uint32_t leng2);
 #define mycrc32_zeroblock(crc,zeros) mycrc32_combine((crc)^0xFFFFFFFF,0xFFFFFFFF,(zeros))
 #define mycrc32_zeroexpanded(crc,block,leng,zeros) mycrc32_zeroblock(mycrc32((crc),(block),(leng)),(zeros))
 #define mycrc32_xorblocks(crc,crcblock1,crcblock2,leng) ((crcblock1)^(crcblock2)^mycrc32_zeroblock(crc,leng))
 
 void mycrc32_init(void);
+/// Name of the implementation used by mycrc32, e.g. "pclmul" or "generic".
+const char *mycrc32_implementation(void);
 /**
  * In the special case when the block consists only of zeros and passed crc is equal to 0 update
  * crc to be equal to mycrc32_zeroblock(0, SFSBLOCKSIZE)
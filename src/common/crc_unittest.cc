@@ -21,9 +21,13 @@
 #include "common/platform.h"
 #include "common/crc.h"
 
+#include <algorithm>
+#include <iostream>
+#include <random>
 #include <string>
 #include <gtest/gtest.h>
 
+#include "common/time_utils.h"
 #include "protocol/SFSCommunication.h"
 
 TEST(CrcTests, MyCrc32) {
@@ -63,3 +67,71 @@ TEST(CrcTests, MyCrc32Combine) {
 		}
 	}
 }
+
+TEST(CrcTests, MyCrc32MatchesGeneric) {
+	SCOPED_TRACE(std::string("Implementation: ") + mycrc32_implementation());
+	std::mt19937 generator(1234);
+	std::vector<uint8_t> data(SFSBLOCKSIZE + 64);
+	for (auto &byte : data) {
+		byte = generator();
+	}
+	// Every alignment and every length around the sizes processed at once by the kernels
+	for (uint32_t offset = 0; offset < 16; ++offset) {
+		for (uint32_t length = 0; length <= 1024; ++length) {
+			uint32_t crc = generator();
+			ASSERT_EQ(mycrc32_generic(crc, data.data() + offset, length),
+			          mycrc32(crc, data.data() + offset, length))
+			    << "offset=" << offset << " length=" << length;
+		}
+	}
+	for (uint32_t length : {SFSBLOCKSIZE - 65, SFSBLOCKSIZE - 1, SFSBLOCKSIZE, SFSBLOCKSIZE + 63}) {
+		for (uint32_t offset : {0, 1}) {
+			EXPECT_EQ(mycrc32_generic(0, data.data() + offset, length),
+			          mycrc32(0, data.data() + offset, length))
+			    << "offset=" << offset << " length=" << length;
+		}
+	}
+}
+
+TEST(CrcTests, MyCrc32CombineMatchesGeneric) {
+	std::mt19937 generator(4321);
+	std::vector<uint8_t> data(3 * SFSBLOCKSIZE);
+	for (auto &byte : data) {
+		byte = generator();
+	}
+	uint32_t crc = mycrc32_generic(0, data.data(), data.size());
+	std::uniform_int_distribution<uint32_t> split(0, data.size());
+	for (int i = 0; i < 1000; ++i) {
+		uint32_t length1 = (i < 2) ? i * data.size() : split(generator);
+		uint32_t length2 = data.size() - length1;
+		uint32_t crc1 = mycrc32_generic(0, data.data(), length1);
+		uint32_t crc2 = mycrc32_generic(0, data.data() + length1, length2);
+		ASSERT_EQ(crc, mycrc32_combine(crc1, crc2, length2)) << "length2=" << length2;
+	}
+	std::vector<uint8_t> zeros(SFSCHUNKSIZE);
+	EXPECT_EQ(mycrc32_generic(0, zeros.data(), zeros.size()),
+	          mycrc32_zeroblock(0, SFSCHUNKSIZE));
+}
+
+TEST(CrcTests, MyCrc32Benchmark) {
+	std::vector<uint8_t> data(64 * SFSBLOCKSIZE);
+	std::mt19937 generator(1);
+	for (auto &byte : data) {
+		byte = generator();
+	}
+	auto measure = [&](const char *name, uint32_t (*crcFunction)(uint32_t, const uint8_t *, uint32_t)) {
+		const int repeatCount = 16;
+		uint32_t crc = 0;
+		Timer time;
+		for (int i = 0; i < repeatCount; ++i) {
+			for (size_t offset = 0; offset < data.size(); offset += SFSBLOCKSIZE) {
+				crc ^= crcFunction(0, data.data() + offset, SFSBLOCKSIZE);
+			}
+		}
+		int64_t speed = (int64_t)data.size() * repeatCount / std::max<int64_t>(time.elapsed_us(), 1);
+		std::cout << "mycrc32 (" << name << ") = " << speed << "MB/s\n";
+		return crc;
+	};
+	uint32_t generic = measure("generic", mycrc32_generic);
+	EXPECT_EQ(generic, measure(mycrc32_implementation(), mycrc32));
+}
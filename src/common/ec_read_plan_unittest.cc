@@ -33,7 +33,8 @@ ChunkPartType ec(int data_part_count, int parity_part_count, int part_index) {
 
 static void checkReadingParts(int first_block, int block_count,
 		const SliceReadPlanner::PartsContainer &target_parts,
-		const SliceReadPlanner::PartsContainer &available_parts) {
+		const SliceReadPlanner::PartsContainer &available_parts,
+		const SliceReadPlanner::ScoreContainer &scores = {}) {
 	std::map<ChunkPartType, std::vector<uint8_t>> part_data;
 
 	for (const auto &part : target_parts) {
@@ -48,6 +49,7 @@ static void checkReadingParts(int first_block, int block_count,
 	for (const auto &part : target_parts) {
 		parts.push_back(part.getSlicePart());
 	}
+	planner.setScores(scores);
 	planner.prepare(target_parts[0].getSliceType(), parts, available_parts);
 
 	ASSERT_TRUE(planner.isReadingPossible());
@@ -120,3 +122,45 @@ TEST(ECReadPlanTests, VerifyRead5) {
 TEST(ECReadPlanTests, VerifyChunkRead1) {
 	checkReadingChunk(0, 10, {ec(3, 2, 1), ec(3, 2, 2), ec(3, 2, 4)});
 }
+
+static int firstWaveOf(const ReadPlan &plan, ChunkPartType part) {
+	for (const auto &op : plan.read_operations) {
+		if (op.first == part) {
+			return op.second.wave;
+		}
+	}
+	return -1;
+}
+
+TEST(ECReadPlanTests, SlowPartIsRecovered) {
+	SliceReadPlanner::PartsContainer available{ec(3, 2, 0), ec(3, 2, 1), ec(3, 2, 2),
+	                                           ec(3, 2, 3), ec(3, 2, 4)};
+	SliceReadPlanner::ScoreContainer scores;
+	for (const auto &part : available) {
+		scores[part] = 1;
+	}
+	scores[ec(3, 2, 1)] = 0.1;
+	checkReadingParts(0, 10, {ec(3, 2, 0), ec(3, 2, 1), ec(3, 2, 2)}, available, scores);
+
+	SliceReadPlanner planner;
+	planner.setScores(scores);
+	planner.prepare(ec(3, 2, 0).getSliceType(), {0, 1, 2}, available);
+	auto plan = planner.buildPlanFor(0, 10);
+	EXPECT_EQ(firstWaveOf(*plan, ec(3, 2, 0)), 0);
+	EXPECT_GT(firstWaveOf(*plan, ec(3, 2, 1)), 0);
+	EXPECT_EQ(firstWaveOf(*plan, ec(3, 2, 2)), 0);
+
+	// A slightly slower part is still read rather than recovered
+	scores[ec(3, 2, 1)] = 0.7;
+	planner.setScores(scores);
+	planner.prepare(ec(3, 2, 0).getSliceType(), {0, 1, 2}, available);
+	plan = planner.buildPlanFor(0, 10);
+	EXPECT_EQ(firstWaveOf(*plan, ec(3, 2, 1)), 0);
+
+	// Reading fewer parts than needed for recovery is still cheaper than recovering them
+	scores[ec(3, 2, 1)] = 0.1;
+	planner.setScores(scores);
+	planner.prepare(ec(3, 2, 0).getSliceType(), {1}, available);
+	plan = planner.buildPlanFor(0, 10);
+	EXPECT_EQ(firstWaveOf(*plan, ec(3, 2, 1)), 0);
+}
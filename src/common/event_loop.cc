@@ -25,10 +25,13 @@
 
 #include <atomic>
 #include <list>
+#include <memory>
+#include <unordered_map>
 #include <sys/time.h>
 #include <unistd.h>
 
 #include "config/cfg.h"
+#include "common/event_poller.h"
 #include "common/exception.h"
 #include "common/massert.h"
 #include "errors/sfserr.h"
@@ -50,6 +53,16 @@ namespace {
 std::list<pollentry> gPollEntries;
 }
 
+struct fdentry {
+	void (*serve)(void *data, short revents);
+	void *data;
+};
+
+namespace {
+std::unordered_map<int, fdentry> gFdEntries;
+std::unique_ptr<EventPoller> gEventPoller;
+}
+
 struct timeentry {
 	typedef void (*fun_t)(void);
 	timeentry(uint64_t ne, uint64_t sec, uint64_t off, int mod, fun_t f, bool ms)
@@ -112,6 +125,29 @@ void eventloop_pollregister(void (*desc)(std::vector<pollfd>&),void (*serve)(con
 	gPollEntries.push_back({desc,serve});
 }
 
+bool eventloop_fdregister(int fd, short events, void (*serve)(void *data, short revents),
+		void *data) {
+	if (!gEventPoller) {
+		gEventPoller = std::make_unique<EventPoller>();
+	}
+	if (!gEventPoller->add(fd, events)) {
+		return false;
+	}
+	gFdEntries[fd] = {serve, data};
+	return true;
+}
+
+bool eventloop_fdmodify(int fd, short events) {
+	return gEventPoller && gEventPoller->modify(fd, events);
+}
+
+void eventloop_fdunregister(int fd) {
+	if (gEventPoller) {
+		gEventPoller->remove(fd);
+	}
+	gFdEntries.erase(fd);
+}
+
 void eventloop_eachloopregister (FunctionEntry fun) {
 	gEachLoopEntries.push_front(fun);
 }
@@ -188,6 +224,8 @@ void eventloop_release_resources(void) {
 	gEachLoopEntries.clear();
 	gPollEntries.clear();
 	gTimeEntries.clear();
+	gFdEntries.clear();
+	gEventPoller.reset();
 }
 
 /* internal */
@@ -227,6 +265,7 @@ void eventloop_run() {
 	uint32_t prevtime  = 0;
 	uint64_t prevmtime = 0;
 	std::vector<pollfd> pdesc;
+	std::vector<pollfd> ready;
 	int i;
 
 	eventloop_load_poll_timeout();
@@ -236,6 +275,10 @@ void eventloop_run() {
 		for (auto &pollit: gPollEntries) {
 			pollit.desc(pdesc);
 		}
+		bool pollerAppended = !gFdEntries.empty();
+		if (pollerAppended) {
+			gEventPoller->appendTo(pdesc);
+		}
 #if defined(_WIN32)
 		i = tcppoll(pdesc, nextPollNonblocking ? 0 : gPollTimeout);
 #else
@@ -258,6 +301,16 @@ void eventloop_run() {
 			for (auto &pollit : gPollEntries) {
 				pollit.serve(pdesc);
 			}
+			if (pollerAppended) {
+				gEventPoller->collect(pdesc, ready);
+				for (const pollfd &readyfd : ready) {
+					// Previous handlers could have unregistered this descriptor
+					auto entry = gFdEntries.find(readyfd.fd);
+					if (entry != gFdEntries.end()) {
+						entry->second.serve(entry->second.data, readyfd.revents);
+					}
+				}
+			}
 		}
 		for (const FunctionEntry &fun : gEachLoopEntries) {
 			fun();
@@ -59,6 +59,35 @@ void eventloop_reloadregister (void (*fun)(void));
 void eventloop_pollregister (void (*desc)(std::vector<pollfd>&),void (*serve)(const std::vector<pollfd>&));
 void eventloop_eachloopregister (void (*fun)(void));
 
+/*! \brief Register a descriptor waited for events until it is unregistered.
+ *
+ * Unlike the descriptors passed by the desc functions of eventloop_pollregister,
+ * it is not passed again in every loop, only the changes of the waited events have
+ * to be reported (eventloop_fdmodify). It makes the cost of a loop independent of
+ * the number of idle descriptors, which matters for modules serving many connections.
+ *
+ * \param fd     descriptor to wait for.
+ * \param events poll() events to wait for (POLLIN, POLLOUT).
+ * \param serve  function called with data and the received events when fd is ready.
+ * \param data   pointer passed to serve.
+ * \return true on success, false (with errno set) otherwise.
+ */
+bool eventloop_fdregister(int fd, short events, void (*serve)(void *data, short revents),
+		void *data);
+
+/*! \brief Change the events waited for on a descriptor registered with eventloop_fdregister.
+ *
+ * Nothing is done if the events did not change, so it can be called freely.
+ */
+bool eventloop_fdmodify(int fd, short events);
+
+/*! \brief Unregister a descriptor registered with eventloop_fdregister.
+ *
+ * Must be called before closing the descriptor. Its serve function will not be
+ * called anymore, even for events received in the current loop.
+ */
+void eventloop_fdunregister(int fd);
+
 /*! \brief Register handler for recurring event.
  *
  * \param mode Event mode. Can be one of
@@ -0,0 +1,199 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+
+#include "common/event_poller.h"
+
+#include <algorithm>
+#include <cerrno>
+
+#ifdef __linux__
+  #include <sys/epoll.h>
+  #include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+  #include "common/sockets.h"
+#endif
+
+#ifdef __linux__
+namespace {
+
+uint32_t toEpollEvents(short events) {
+	uint32_t result = 0;
+	if (events & POLLIN) { result |= EPOLLIN; }
+	if (events & POLLOUT) { result |= EPOLLOUT; }
+	return result;
+}
+
+short fromEpollEvents(uint32_t events) {
+	short result = 0;
+	if (events & EPOLLIN) { result |= POLLIN; }
+	if (events & EPOLLOUT) { result |= POLLOUT; }
+	if (events & EPOLLERR) { result |= POLLERR; }
+	if (events & EPOLLHUP) { result |= POLLHUP; }
+	return result;
+}
+
+}  // namespace
+#endif
+
+EventPoller::EventPoller() {
+#ifdef __linux__
+	epollFD_ = ::epoll_create1(EPOLL_CLOEXEC);
+#endif
+}
+
+EventPoller::~EventPoller() {
+#ifdef __linux__
+	if (epollFD_ >= 0) { ::close(epollFD_); }
+#endif
+}
+
+bool EventPoller::add(int fd, short events) {
+	if (contains(fd)) {
+		errno = EEXIST;
+		return false;
+	}
+
+#ifdef __linux__
+	if (epollFD_ >= 0) {
+		epoll_event event{};
+		event.events = toEpollEvents(events);
+		event.data.fd = fd;
+		if (::epoll_ctl(epollFD_, EPOLL_CTL_ADD, fd, &event) < 0) {
+			return false;
+		}
+	}
+#endif
+
+	positions_[fd] = descriptors_.size();
+	descriptors_.push_back({fd, events, 0});
+	return true;
+}
+
+bool EventPoller::modify(int fd, short events) {
+	auto it = positions_.find(fd);
+	if (it == positions_.end()) {
+		errno = ENOENT;
+		return false;
+	}
+
+	pollfd &descriptor = descriptors_[it->second];
+	if (descriptor.events == events) { return true; }
+
+#ifdef __linux__
+	if (epollFD_ >= 0) {
+		epoll_event event{};
+		event.events = toEpollEvents(events);
+		event.data.fd = fd;
+		if (::epoll_ctl(epollFD_, EPOLL_CTL_MOD, fd, &event) < 0) {
+			return false;
+		}
+	}
+#endif
+
+	descriptor.events = events;
+	return true;
+}
+
+void EventPoller::remove(int fd) {
+	auto it = positions_.find(fd);
+	if (it == positions_.end()) { return; }
+
+#ifdef __linux__
+	if (epollFD_ >= 0) {
+		// Passing an event is needed by kernels older than 2.6.9
+		epoll_event event{};
+		::epoll_ctl(epollFD_, EPOLL_CTL_DEL, fd, &event);
+	}
+#endif
+
+	// Keep the vector dense by moving the last descriptor into the hole
+	size_t position = it->second;
+	positions_.erase(it);
+	if (position != descriptors_.size() - 1) {
+		descriptors_[position] = descriptors_.back();
+		positions_[descriptors_[position].fd] = position;
+	}
+	descriptors_.pop_back();
+}
+
+int EventPoller::wait(int timeoutMs, std::vector<pollfd> &ready) {
+	ready.clear();
+
+#ifdef __linux__
+	if (epollFD_ >= 0) {
+		epoll_event events[kMaxEventsPerWait];
+		int count = ::epoll_wait(epollFD_, events, kMaxEventsPerWait, timeoutMs);
+		for (int i = 0; i < count; ++i) {
+			auto it = positions_.find(events[i].data.fd);
+			if (it == positions_.end()) { continue; }
+			ready.push_back({events[i].data.fd, descriptors_[it->second].events,
+			                 fromEpollEvents(events[i].events)});
+		}
+		return count < 0 ? count : static_cast<int>(ready.size());
+	}
+#endif
+
+#if defined(_WIN32)
+	int count = tcppoll(descriptors_, timeoutMs);
+#else
+	int count = ::poll(descriptors_.data(), descriptors_.size(), timeoutMs);
+#endif
+	if (count <= 0) { return count; }
+
+	for (const auto &descriptor : descriptors_) {
+		if (descriptor.revents != 0) { ready.push_back(descriptor); }
+	}
+	return static_cast<int>(ready.size());
+}
+
+void EventPoller::appendTo(std::vector<pollfd> &pdesc) {
+	pdescPos_ = static_cast<int32_t>(pdesc.size());
+
+	if (epollFD_ >= 0) {
+		pdesc.push_back({epollFD_, POLLIN, 0});
+	} else {
+		pdesc.insert(pdesc.end(), descriptors_.begin(), descriptors_.end());
+	}
+	pdescCount_ = pdesc.size() - pdescPos_;
+}
+
+int EventPoller::collect(const std::vector<pollfd> &pdesc,
+                         std::vector<pollfd> &ready) {
+	ready.clear();
+	if (pdescPos_ < 0 || static_cast<size_t>(pdescPos_) >= pdesc.size()) {
+		return 0;
+	}
+
+	if (epollFD_ >= 0) {
+		if ((pdesc[pdescPos_].revents & POLLIN) == 0) { return 0; }
+		return wait(0, ready);
+	}
+
+	// Descriptors removed after appendTo() may still be in pdesc
+	size_t end = std::min(pdesc.size(), pdescPos_ + pdescCount_);
+	for (size_t i = pdescPos_; i < end; ++i) {
+		if (pdesc[i].revents != 0 && contains(pdesc[i].fd)) {
+			ready.push_back(pdesc[i]);
+		}
+	}
+	return static_cast<int>(ready.size());
+}
@@ -0,0 +1,97 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+  #include "winsock2.h"
+#else
+  #include <poll.h>
+#endif
+
+/// Set of file descriptors waited for events, with persistent registrations.
+///
+/// Unlike a pollfd vector rebuilt before every poll() call, the descriptors
+/// stay registered until removed and only the changes of interest have to be
+/// reported, so the cost of a wakeup depends on the number of ready
+/// descriptors instead of the number of registered ones.
+///
+/// Backed by level-triggered epoll on Linux, by poll() elsewhere. The event
+/// masks use the poll() flags (POLLIN, POLLOUT, POLLERR, POLLHUP), so code
+/// written for the pollfd vectors can be moved to it with few changes.
+class EventPoller {
+public:
+	EventPoller();
+	~EventPoller();
+
+	EventPoller(const EventPoller &) = delete;
+	EventPoller &operator=(const EventPoller &) = delete;
+	EventPoller(EventPoller &&) = delete;
+	EventPoller &operator=(EventPoller &&) = delete;
+
+	/// Starts waiting for \a events on \a fd.
+	/// Returns false (with errno set) on failure.
+	bool add(int fd, short events);
+
+	/// Changes the events waited for on an already added \a fd.
+	/// Nothing is done if the events did not change.
+	bool modify(int fd, short events);
+
+	/// Stops waiting for events on \a fd. Must be called before closing it.
+	void remove(int fd);
+
+	bool contains(int fd) const { return positions_.count(fd) > 0; }
+	size_t size() const { return descriptors_.size(); }
+
+	/// Waits up to \a timeoutMs milliseconds for events.
+	///
+	/// The ready descriptors are stored in \a ready (fd, registered events and
+	/// received events in revents). Returns the number of ready descriptors or
+	/// -1 with errno set.
+	int wait(int timeoutMs, std::vector<pollfd> &ready);
+
+	/// Adds the descriptors needed to wait for this set from an outer poll()
+	/// call: only the epoll descriptor if available, all of them otherwise.
+	void appendTo(std::vector<pollfd> &pdesc);
+
+	/// Collects the ready descriptors after the outer poll() call whose
+	/// \a pdesc was filled with appendTo(). Returns as wait().
+	int collect(const std::vector<pollfd> &pdesc, std::vector<pollfd> &ready);
+
+private:
+	/// Upper bound of the events returned by a single epoll_wait call, the
+	/// remaining ones are returned by the next calls (level-triggered).
+	static constexpr int kMaxEventsPerWait = 1024;
+
+	/// Registered descriptors with their events
+	std::vector<pollfd> descriptors_;
+	/// Positions of the descriptors in descriptors_
+	std::unordered_map<int, size_t> positions_;
+	/// Position and count of the descriptors appended to the outer pdesc
+	int32_t pdescPos_ = -1;
+	size_t pdescCount_ = 0;
+	/// epoll instance, -1 if not available (poll() is used then)
+	int epollFD_ = -1;
+};
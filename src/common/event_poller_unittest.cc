@@ -0,0 +1,109 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "common/event_poller.h"
+
+#include <unistd.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class EventPollerTests : public ::testing::Test {
+protected:
+	void SetUp() override {
+		ASSERT_EQ(pipe(first_), 0);
+		ASSERT_EQ(pipe(second_), 0);
+	}
+
+	void TearDown() override {
+		for (int fd : {first_[0], first_[1], second_[0], second_[1]}) {
+			if (fd >= 0) { close(fd); }
+		}
+	}
+
+	int first_[2] = {-1, -1};
+	int second_[2] = {-1, -1};
+};
+
+TEST_F(EventPollerTests, AddModifyRemove) {
+	EventPoller poller;
+	std::vector<pollfd> ready;
+
+	ASSERT_TRUE(poller.add(first_[0], POLLIN));
+	ASSERT_TRUE(poller.add(second_[1], 0));
+	EXPECT_FALSE(poller.add(first_[0], POLLIN));
+	EXPECT_EQ(poller.size(), 2U);
+	EXPECT_FALSE(poller.modify(second_[0], POLLIN));
+
+	// Nothing to read and no interest in the writable end yet
+	EXPECT_EQ(poller.wait(0, ready), 0);
+	EXPECT_TRUE(ready.empty());
+
+	ASSERT_TRUE(poller.modify(second_[1], POLLOUT));
+	ASSERT_EQ(poller.wait(0, ready), 1);
+	EXPECT_EQ(ready[0].fd, second_[1]);
+	EXPECT_EQ(ready[0].events, POLLOUT);
+	EXPECT_TRUE(ready[0].revents & POLLOUT);
+
+	ASSERT_EQ(write(first_[1], "x", 1), 1);
+	EXPECT_EQ(poller.wait(0, ready), 2);
+
+	// Removing the first descriptor moves the last one into its place
+	poller.remove(first_[0]);
+	EXPECT_FALSE(poller.contains(first_[0]));
+	EXPECT_TRUE(poller.contains(second_[1]));
+	ASSERT_EQ(poller.wait(0, ready), 1);
+	EXPECT_EQ(ready[0].fd, second_[1]);
+
+	poller.remove(second_[1]);
+	EXPECT_EQ(poller.size(), 0U);
+	EXPECT_EQ(poller.wait(0, ready), 0);
+}
+
+TEST_F(EventPollerTests, HangUp) {
+	EventPoller poller;
+	std::vector<pollfd> ready;
+
+	ASSERT_TRUE(poller.add(first_[0], 0));
+	close(first_[1]);
+	first_[1] = -1;
+
+	// Hang ups are reported even without any requested events
+	ASSERT_EQ(poller.wait(0, ready), 1);
+	EXPECT_TRUE(ready[0].revents & POLLHUP);
+}
+
+TEST_F(EventPollerTests, NestedInOuterPoll) {
+	EventPoller poller;
+	std::vector<pollfd> pdesc;
+	std::vector<pollfd> ready;
+
+	ASSERT_TRUE(poller.add(first_[0], POLLIN));
+	ASSERT_TRUE(poller.add(second_[0], POLLIN));
+	ASSERT_EQ(write(second_[1], "x", 1), 1);
+
+	pdesc.push_back({first_[1], POLLOUT, 0});
+	poller.appendTo(pdesc);
+	ASSERT_GE(poll(pdesc.data(), pdesc.size(), 0), 2);
+	EXPECT_TRUE(pdesc[0].revents & POLLOUT);
+
+	ASSERT_EQ(poller.collect(pdesc, ready), 1);
+	EXPECT_EQ(ready[0].fd, second_[0]);
+	EXPECT_TRUE(ready[0].revents & POLLIN);
+}
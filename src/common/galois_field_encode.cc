@@ -205,11 +205,148 @@ void ec_encode_data_avx2(int len, int srcs, int dests, uint8_t *v, uint8_t **src
 
 #endif
 
+#if __GNUC__ >= 11
+
+#include <vector>
+
+static inline void ec_encode_data_tail(int i, int len, int srcs, uint8_t *v, uint8_t **src,
+		uint8_t *dest) {
+	for (; i < len; i++) {
+		uint8_t s = 0;
+		uint8_t *tbl = v;
+		for (int j = 0; j < srcs; j++) {
+			uint8_t a = src[j][i];
+			s ^= tbl[a & 0xF] ^ tbl[16 + (a >> 4)];
+			tbl += 32;
+		}
+		dest[i] = s;
+	}
+}
+
+__attribute__((target("avx512bw")))
+void ec_encode_data_avx512(int len, int srcs, int dests, uint8_t *v, uint8_t **src, uint8_t **dest) {
+	const __m512i mask = _mm512_set1_epi8(0x0F);
+
+	for (int l = 0; l < dests; l++) {
+		int i = 0;
+
+		for (; (i + 64) <= len; i += 64) {
+			uint8_t *tbl = v;
+			__m512i s = _mm512_setzero_si512();
+			for (int j = 0; j < srcs; j++) {
+				__m512i a = _mm512_loadu_si512(src[j] + i);
+				__m512i tbl_lo = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)tbl));
+				__m512i tbl_hi =
+				    _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)(tbl + 16)));
+
+				__m512i mask_lo = _mm512_and_si512(a, mask);
+				__m512i mask_hi = _mm512_and_si512(_mm512_srli_epi64(a, 4), mask);
+
+				s = _mm512_ternarylogic_epi64(s, _mm512_shuffle_epi8(tbl_lo, mask_lo),
+				                              _mm512_shuffle_epi8(tbl_hi, mask_hi), 0x96);
+
+				tbl += 32;
+			}
+
+			_mm512_storeu_si512(dest[l] + i, s);
+		}
+
+		ec_encode_data_tail(i, len, srcs, v, src, dest[l]);
+		v += srcs * 32;
+	}
+}
+
+/*! \brief Matrix of multiplication by the coefficient of the tables, for GF2P8AFFINEQB.
+ *
+ * Multiplication by a constant is linear over GF(2), so the matrix is made of the products
+ * of the coefficient and each power of two, which are in the tables. Row i (the byte 7 - i)
+ * tells which bits of the input give the bit i of the output.
+ */
+static uint64_t ec_affine_matrix(const uint8_t *tbl) {
+	uint64_t matrix = 0;
+	for (int i = 0; i < 8; i++) {
+		uint64_t row = 0;
+		for (int j = 0; j < 8; j++) {
+			uint8_t product = (j < 4) ? tbl[1 << j] : tbl[16 + (1 << (j - 4))];
+			row |= ((product >> i) & 1) << j;
+		}
+		matrix |= row << (8 * (7 - i));
+	}
+	return matrix;
+}
+
+__attribute__((target("avx512bw,gfni")))
+void ec_encode_data_gfni_avx512(int len, int srcs, int dests, uint8_t *v, uint8_t **src,
+		uint8_t **dest) {
+	std::vector<uint64_t> matrices(srcs);
+
+	for (int l = 0; l < dests; l++) {
+		for (int j = 0; j < srcs; j++) {
+			matrices[j] = ec_affine_matrix(v + j * 32);
+		}
+		int i = 0;
+
+		for (; (i + 64) <= len; i += 64) {
+			__m512i s = _mm512_setzero_si512();
+			for (int j = 0; j < srcs; j++) {
+				__m512i a = _mm512_loadu_si512(src[j] + i);
+				s = _mm512_xor_si512(s, _mm512_gf2p8affine_epi64_epi8(
+				                            a, _mm512_set1_epi64(matrices[j]), 0));
+			}
+
+			_mm512_storeu_si512(dest[l] + i, s);
+		}
+
+		ec_encode_data_tail(i, len, srcs, v, src, dest[l]);
+		v += srcs * 32;
+	}
+}
+
+__attribute__((target("avx2,gfni")))
+void ec_encode_data_gfni_avx2(int len, int srcs, int dests, uint8_t *v, uint8_t **src,
+		uint8_t **dest) {
+	std::vector<uint64_t> matrices(srcs);
+
+	for (int l = 0; l < dests; l++) {
+		for (int j = 0; j < srcs; j++) {
+			matrices[j] = ec_affine_matrix(v + j * 32);
+		}
+		int i = 0;
+
+		for (; (i + 32) <= len; i += 32) {
+			__m256i s = _mm256_setzero_si256();
+			for (int j = 0; j < srcs; j++) {
+				__m256i a = _mm256_loadu_si256((const __m256i *)(src[j] + i));
+				s = _mm256_xor_si256(s, _mm256_gf2p8affine_epi64_epi8(
+				                            a, _mm256_set1_epi64x(matrices[j]), 0));
+			}
+
+			_mm256_storeu_si256((__m256i *)(dest[l] + i), s);
+		}
+
+		ec_encode_data_tail(i, len, srcs, v, src, dest[l]);
+		v += srcs * 32;
+	}
+}
+
+#endif
+
 typedef void (*encode_function_type)(int len, int srcs, int dests, uint8_t *v, uint8_t **src, uint8_t **dest);
 
 static encode_function_type ec_get_encode_function() {
 	__builtin_cpu_init();
 
+#if __GNUC__ >= 11
+	if (__builtin_cpu_supports("gfni") && __builtin_cpu_supports("avx512bw")) {
+		return ec_encode_data_gfni_avx512;
+	}
+	if (__builtin_cpu_supports("avx512bw")) {
+		return ec_encode_data_avx512;
+	}
+	if (__builtin_cpu_supports("gfni") && __builtin_cpu_supports("avx2")) {
+		return ec_encode_data_gfni_avx2;
+	}
+#endif
 #if __GNUC__ >= 5
 	if (__builtin_cpu_supports("avx2")) {
 		return ec_encode_data_avx2;
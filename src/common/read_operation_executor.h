@@ -89,6 +89,16 @@ public:
 		return readOperation_.wave;
 	}
 
+	/// Number of blocks requested from the chunkserver.
+	uint32_t requestedBlocks() const {
+		return (readOperation_.request_size + SFSBLOCKSIZE - 1) / SFSBLOCKSIZE;
+	}
+
+	/// Time since the operation was created.
+	SteadyDuration elapsedTime() const {
+		return timer_.elapsedTime();
+	}
+
 private:
 	enum ReadOperationState {
 		kSendingRequest,
@@ -136,6 +146,9 @@ private:
 	/* checksum will be used to receive crc of complete data blocks */
 	uint32_t currentlyReadBlockCrc_;
 
+	/* Measures the latency of the operation */
+	Timer timer_;
+
 	/*
 	 * Four functions below are called when all the data
 	 * in the corresponding state has been received
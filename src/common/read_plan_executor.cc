@@ -20,6 +20,7 @@
 #include "common/platform.h"
 #include "common/read_plan_executor.h"
 
+#include <algorithm>
 #include <chrono>
 #include <map>
 #include <set>
@@ -40,6 +41,7 @@
 std::atomic<uint64_t> ReadPlanExecutor::executions_total_;
 std::atomic<uint64_t> ReadPlanExecutor::executions_with_additional_operations_;
 std::atomic<uint64_t> ReadPlanExecutor::executions_finished_by_additional_operations_;
+std::atomic<uint64_t> ReadPlanExecutor::executions_hedged_;
 
 ReadPlanExecutor::ReadPlanExecutor(ChunkserverStats &chunkserver_stats, uint64_t chunk_id,
 		uint32_t chunk_version, std::unique_ptr<ReadPlan> plan)
@@ -85,6 +87,12 @@ bool ReadPlanExecutor::startReadOperation(ExecuteParams &params, ChunkPartType c
 			ReadOperationExecutor executor(op, chunk_id_, chunk_version_, chunk_type, ctwa.address,
 			                               ctwa.chunkserver_version, fd, params.buffer);
 			executor.sendReadRequest(connect_timeout);
+			auto expected_latency =
+			    stats_.getStatisticsFor(ctwa.address).expectedReadLatency(executor.requestedBlocks());
+			if (expected_latency) {
+				hedge_deadlines_[fd] = SteadyClock::now() +
+				                       std::max<SteadyDuration>(*expected_latency, kMinHedgeDelay);
+			}
 			executors_.insert(std::make_pair(fd, std::move(executor)));
 		} catch (...) {
 			tcpclose(fd);
@@ -220,6 +228,10 @@ bool ReadPlanExecutor::waitForData(ExecuteParams &params, Timeout &wave_timeout,
 	// Call poll
 	int poll_timeout = std::max(
 	    0, (int)std::min(params.total_timeout.remaining_ms(), wave_timeout.remaining_ms()));
+	int hedge_timeout = timeToHedge_ms(SteadyClock::now());
+	if (hedge_timeout >= 0) {
+		poll_timeout = std::min(poll_timeout, hedge_timeout);
+	}
 	int status = tcppoll(poll_fds, poll_timeout);
 	if (status < 0) {
 #ifdef _WIN32
@@ -256,6 +268,7 @@ bool ReadPlanExecutor::readSomeData(ExecuteParams &params, const pollfd &poll_fd
 		stats_.markDefective(server);
 		networking_failures_.push_back(executor.chunkType());
 		tcpclose(poll_fd.fd);
+		hedge_deadlines_.erase(poll_fd.fd);
 		executors_.erase(poll_fd.fd);
 		if (!plan_->isFinishingPossible(networking_failures_)) {
 			throw;
@@ -266,24 +279,65 @@ bool ReadPlanExecutor::readSomeData(ExecuteParams &params, const pollfd &poll_fd
 	if (executor.isFinished()) {
 		stats_.unregisterReadOperation(server);
 		stats_.markWorking(server);
+		stats_.recordReadLatency(server,
+		                         std::chrono::duration_cast<std::chrono::microseconds>(
+		                             executor.elapsedTime()),
+		                         executor.requestedBlocks());
 		params.connector.endUsingConnection(poll_fd.fd, server);
 		available_parts_.push_back(executor.chunkType());
+		hedge_deadlines_.erase(poll_fd.fd);
 		executors_.erase(poll_fd.fd);
 	}
 
 	return true;
 }
 
+/*! \brief Check if a read of the current wave takes longer than expected.
+ *
+ * A read is late when it takes longer than the 95th percentile of the recent reads
+ * from its chunkserver. The reads of the next wave are started then, without waiting
+ * for the wave timeout, so a single slow chunkserver does not delay the whole read.
+ */
+bool ReadPlanExecutor::isReadLate(SteadyTimePoint now) const {
+	return std::any_of(hedge_deadlines_.begin(), hedge_deadlines_.end(),
+	                   [now](const auto &fd_and_deadline) {
+		                   return fd_and_deadline.second <= now;
+	                   });
+}
+
+/*! \brief Milliseconds (rounded up) until some read of the current wave becomes late,
+ *         or -1 if no read can become late.
+ */
+int ReadPlanExecutor::timeToHedge_ms(SteadyTimePoint now) const {
+	if (hedge_deadlines_.empty()) {
+		return -1;
+	}
+	SteadyTimePoint deadline = std::min_element(hedge_deadlines_.begin(), hedge_deadlines_.end(),
+	                                            [](const auto &a, const auto &b) {
+		                                            return a.second < b.second;
+	                                            })->second;
+	auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+	return std::max<int64_t>(0, remaining.count());
+}
+
 /*! \brief Execute read operation (without post-process). */
 void ReadPlanExecutor::executeReadOperations(ExecuteParams &params) {
 	assert(!plan_->read_operations.empty());
 
 	int failed_reads;
 	int wave = 0;
+	int last_wave = 0;
+	for (const auto &read_operation : plan_->read_operations) {
+		last_wave = std::max(last_wave, read_operation.second.wave);
+	}
 
 	// start reads for first wave (index 0)
 	failed_reads = startReadsForWave(params, wave);
 	startPrefetchForWave(params, wave + 1);
+	if (wave >= last_wave) {
+		// there is nothing to start early
+		hedge_deadlines_.clear();
+	}
 
 	assert((executors_.size() + networking_failures_.size()) > 0);
 
@@ -303,13 +357,21 @@ void ReadPlanExecutor::executeReadOperations(ExecuteParams &params) {
 			throw RecoverableReadException("Chunkservers communication timed out");
 		}
 
-		if (wave_timeout.expired() || failed_reads) {
+		// Reads of the next wave are started early if some read is late
+		bool hedge = !wave_timeout.expired() && !failed_reads && wave < last_wave &&
+		             isReadLate(SteadyClock::now());
+		if (wave_timeout.expired() || failed_reads || hedge) {
 			// start next wave
 			executions_with_additional_operations_ += wave == 0;
+			executions_hedged_ += hedge;
 			++wave;
 			wave_timeout.reset();
+			hedge_deadlines_.clear();
 			failed_reads = startReadsForWave(params, wave);
 			startPrefetchForWave(params, wave + 1);
+			if (wave >= last_wave) {
+				hedge_deadlines_.clear();
+			}
 		}
 
 		if (!waitForData(params, wave_timeout, poll_fds)) {
@@ -408,6 +470,7 @@ void ReadPlanExecutor::executePlan(std::vector<uint8_t> &buffer,
 		int connect_timeout, int level_timeout,
 		const Timeout &total_timeout) {
 	executors_.clear();
+	hedge_deadlines_.clear();
 	networking_failures_.clear();
 	available_parts_.clear();
 	++executions_total_;
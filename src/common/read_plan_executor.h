@@ -89,6 +89,12 @@ public:
 	/// Counter for the .saunafs_tweaks file.
 	static std::atomic<uint64_t> executions_finished_by_additional_operations_;
 
+	/// Counter for the .saunafs_tweaks file.
+	static std::atomic<uint64_t> executions_hedged_;
+
+	/// Least time a read has to take before the next wave is started because it is late.
+	static constexpr std::chrono::milliseconds kMinHedgeDelay{10};
+
 protected:
 	struct ExecuteParams {
 		uint8_t *buffer;
@@ -110,6 +116,8 @@ protected:
 	bool waitForData(ExecuteParams &params, Timeout &wave_timeout, std::vector<pollfd> &poll_fds);
 	bool readSomeData(ExecuteParams &params, const pollfd &poll_fd,
 	                  ReadOperationExecutor &executor);
+	bool isReadLate(SteadyTimePoint now) const;
+	int timeToHedge_ms(SteadyTimePoint now) const;
 	void executeReadOperations(ExecuteParams &params);
 
 private:
@@ -119,6 +127,8 @@ private:
 	std::unique_ptr<ReadPlan> plan_;
 
 	flat_map<int, ReadOperationExecutor> executors_;
+	/// Times when reads of the current wave become late, if their latency can be estimated
+	flat_map<int, SteadyTimePoint> hedge_deadlines_;
 	ReadPlan::PartsContainer available_parts_;
 	ReadPlan::PartsContainer networking_failures_;
 	NetworkAddress last_connection_failure_;
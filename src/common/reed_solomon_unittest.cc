@@ -225,6 +225,63 @@ TEST(ReedSolomon, EncodeBenchmarkBig) {
 	benchmark_encoding(data, 4, 5);
 }
 
+TEST(ReedSolomon, EncodeDataMatchesScalar) {
+	for (auto [srcs, dests] : {std::pair{3, 2}, {8, 4}, {32, 8}}) {
+		std::vector<uint8_t> coefficients(srcs * dests);
+		for (size_t i = 0; i < coefficients.size(); ++i) {
+			coefficients[i] = rand();
+		}
+		std::vector<uint8_t> tables(32 * srcs * dests);
+		ec_init_tables(srcs, dests, coefficients.data(), tables.data());
+
+		std::vector<std::vector<uint8_t>> input, output(dests);
+		generate_random_data(input, srcs, SMALL_TEST_DATA_SIZE + 100);
+		std::vector<uint8_t *> input_ptrs, output_ptrs;
+		for (auto &part : input) {
+			input_ptrs.push_back(part.data());
+		}
+		for (auto &part : output) {
+			part.resize(input[0].size());
+			output_ptrs.push_back(part.data());
+		}
+
+		// Lengths which end in the middle of the vectors, and offsets which break the alignment
+		for (int offset : {0, 1}) {
+			for (int len : {1, 31, 63, 64, 100, SMALL_TEST_DATA_SIZE, SMALL_TEST_DATA_SIZE + 99}) {
+				std::vector<uint8_t *> src, dest;
+				for (auto ptr : input_ptrs) {
+					src.push_back(ptr + offset);
+				}
+				for (auto ptr : output_ptrs) {
+					dest.push_back(ptr);
+				}
+				ec_encode_data(len, srcs, dests, tables.data(), src.data(), dest.data());
+				for (int l = 0; l < dests; ++l) {
+					for (int i = 0; i < len; ++i) {
+						uint8_t expected = 0;
+						for (int j = 0; j < srcs; ++j) {
+							uint8_t a = src[j][i];
+							const uint8_t *tbl = tables.data() + 32 * (l * srcs + j);
+							expected ^= tbl[a & 0xF] ^ tbl[16 + (a >> 4)];
+						}
+						ASSERT_EQ(expected, dest[l][i]) << "(" << srcs << "," << dests
+						    << ") len=" << len << " offset=" << offset << " at " << i;
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST(ReedSolomon, EncodeBenchmarkGeometries) {
+	// Typical EC(k,m) goals, with parts of a block size
+	std::vector<std::vector<uint8_t>> data;
+	for (auto [k, m] : {std::pair{2, 1}, {3, 2}, {4, 2}, {6, 3}, {8, 2}, {8, 4}, {16, 4}}) {
+		generate_random_data(data, k, SMALL_TEST_DATA_SIZE);
+		benchmark_encoding(data, m, 200);
+	}
+}
+
 template<std::size_t N>
 void select_rows(uint8_t *output_matrix, const uint8_t *input_matrix, int s1, int s2,
 	                const std::bitset<N> &required_rows) {
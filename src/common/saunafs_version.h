@@ -47,3 +47,5 @@ constexpr uint32_t kFirstECVersion = saunafsVersion(3, 9, 5);
 constexpr uint32_t kACL11Version = saunafsVersion(3, 11, 0);
 constexpr uint32_t kRichACLVersion = saunafsVersion(3, 12, 0);
 constexpr uint32_t kEC2Version = saunafsVersion(3, 13, 0);
+constexpr uint32_t kReadChunksVersion = saunafsVersion(4, 7, 0);
+constexpr uint32_t kCacheNotificationsVersion = saunafsVersion(4, 7, 0);
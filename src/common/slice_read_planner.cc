@@ -24,6 +24,7 @@
 #include "common/slice_read_planner.h"
 
 #include <cmath>
+#include <limits>
 
 /*!
  * Prepares read planner for serving selected parts of a slice type.
@@ -153,8 +154,34 @@ int SliceReadPlanner::addExtraParts(SliceReadPlan *plan, int first_block, int bl
 	return buffer_offset;
 }
 
+/*!
+ * Tells whether parts are to be chosen by their score instead of reading the requested ones.
+ * It is needed if some requested part is missing. It is also done if at least as many parts
+ * as needed for recovery were requested anyway and some requested part is much slower than
+ * a part which was not requested, so the fastest parts are read instead of waiting for it.
+ */
 bool SliceReadPlanner::shouldReadPartsRequiredForRecovery() const {
-	return !required_parts_available_;
+	if (!required_parts_available_) {
+		return true;
+	}
+	if ((int)slice_parts_.size() < slice_traits::requiredPartsToRecover(slice_type_)) {
+		return false;
+	}
+
+	std::bitset<Goal::Slice::kMaxPartsCount> requested;
+	for (const auto &part : slice_parts_) {
+		requested.set(part);
+	}
+	float slowest_requested = std::numeric_limits<float>::max();
+	float fastest_other = 0;
+	for (const auto &part : weighted_parts_to_use_) {
+		if (requested[part.type.getSlicePart()]) {
+			slowest_requested = std::min(slowest_requested, part.score);
+		} else {
+			fastest_other = std::max(fastest_other, part.score);
+		}
+	}
+	return fastest_other > kSlowPartScoreRatio * slowest_requested;
 }
 
 /*!
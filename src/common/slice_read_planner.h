@@ -50,6 +50,10 @@
  *
  * If number of requested parts is near to the number of parts needed for recovery,
  * they are ale scheduled for the first wave.
+ *
+ * If at least as many parts as needed for recovery are requested and some of them are much
+ * slower to read than the other parts (their scores are lower), the parts with the best scores
+ * are read in the first wave and the slow ones are recovered.
  */
 class SliceReadPlanner {
 public:
@@ -97,6 +101,10 @@ private:
 		ChunkPartType type;
 	};
 
+	/// How many times higher score a part which was not requested must have than
+	/// some requested part to be read instead
+	static constexpr float kSlowPartScoreRatio = 2;
+
 	typedef ReadPlan::ReadOperation ReadOperation;
 	typedef small_vector<WeightedPart, Goal::Slice::kMaxPartsCount/2> WeightedPartsContainer;
 
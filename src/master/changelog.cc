@@ -22,11 +22,13 @@
 
 #include "master/changelog.h"
 
+#include <sys/stat.h>
 #include <syslog.h>
 #include <unistd.h>
 #include <cstdio>
 
-#include <common/exceptions.h>
+#include "common/changelog_file.h"
+#include "common/exceptions.h"
 #include "common/event_loop.h"
 #include "common/rotate_files.h"
 #include "config/cfg.h"
@@ -44,7 +46,15 @@ static uint32_t gMaxBackLogsNumber = 50;
 
 static uint32_t BackLogsNumber;
 static FILE *fd = nullptr;
-static bool gFlush = true;
+
+/// Format of the new changelog files, from the CHANGELOG_FORMAT config entry.
+static ChangelogFormat gFormat = ChangelogFormat::kText;
+
+/// Format of the currently open changelog file.
+static ChangelogFormat gFileFormat = ChangelogFormat::kText;
+
+/// Size of the stdio buffer of the changelog, the changes are written out in groups
+static constexpr size_t kChangelogBufferSize = 1 << 20;
 
 void changelog_rotate() {
 	if (fd) {
@@ -58,25 +68,56 @@ void changelog_rotate() {
 	}
 }
 
+static void changelog_open() {
+	struct stat st;
+	bool isNew = stat(gChangelogFilename.c_str(), &st) != 0 || st.st_size == 0;
+	fd = fopen(gChangelogFilename.c_str(), "a");
+	if (!fd) {
+		return;
+	}
+	setvbuf(fd, nullptr, _IOFBF, kChangelogBufferSize);
+	if (isNew) {
+		gFileFormat = gFormat;
+		if (gFileFormat == ChangelogFormat::kBinary && !writeBinaryChangelogHeader(fd)) {
+			fclose(fd);
+			fd = nullptr;
+		}
+	} else {
+		// Keep appending in the format of the existing file, a new one gets the
+		// configured format after the rotation
+		gFileFormat = ChangelogFileReader(gChangelogFilename).format();
+	}
+}
+
 void changelog(uint64_t version, const char* entry) {
 	if (fd==NULL) {
-		fd = fopen(gChangelogFilename.c_str(), "a");
+		changelog_open();
 		if (!fd) {
 			safs_pretty_syslog(LOG_NOTICE, "lost metadata change %" PRIu64 ": %s", version, entry);
 		}
 	}
 
 	if (fd) {
-		fprintf(fd,"%" PRIu64 ": %s\n", version, entry);
-		if (gFlush) {
-			fflush(fd);
-		}
+		writeChangelogEntry(fd, gFileFormat, version, entry);
+	}
+}
+
+static ChangelogFormat changelog_format_from_config() {
+	std::string format = cfg_getstring("CHANGELOG_FORMAT", "text");
+	if (format == "binary") {
+		return ChangelogFormat::kBinary;
+	}
+	if (format != "text") {
+		safs_pretty_syslog(LOG_WARNING, "%s: unknown CHANGELOG_FORMAT value '%s', using 'text'",
+		                   cfg_filename().c_str(), format.c_str());
 	}
+	return ChangelogFormat::kText;
 }
 
 static void changelog_reload(void) {
 	BackLogsNumber = cfg_get_minmaxvalue<uint32_t>("BACK_LOGS", 50,
 			gMinBackLogsNumber, gMaxBackLogsNumber);
+	gFormat = changelog_format_from_config();
 }
 
 void changelog_init(std::string changelogFilename,
@@ -93,6 +134,7 @@ void changelog_init(std::string changelogFilename,
 		throw InitializeException(cfg_filename() + ": BACK_LOGS value too low, "
 				"minimum allowed is " + std::to_string(gMinBackLogsNumber));
 	}
+	gFormat = changelog_format_from_config();
 	eventloop_reloadregister(changelog_reload);
 }
 
@@ -105,12 +147,3 @@ void changelog_flush(void) {
 		fflush(fd);
 	}
 }
-
-void changelog_disable_flush(void) {
-	gFlush = false;
-}
-
-void changelog_enable_flush(void) {
-	gFlush = true;
-	changelog_flush();
-}
@@ -25,7 +25,7 @@
 #include <cstdint>
 #include <string>
 
-constexpr uint32_t kMaxLogLineSize = 200000;
+#include "common/changelog_file.h"
 
 /// Initializes changelog module.
 /// \param changelogFilename - base name of changelog files, e.g. "changelog_ml.sfs"
@@ -45,11 +45,7 @@ void changelog_rotate();
 /// Format of the entry: <ts>|<COMMAND>(arg1,arg2,...)
 void changelog(uint64_t version, const char* entry);
 
-/// Flushes (fflush) the current changelog
+/// Writes out the changes stored since the last call.
+/// The master calls it after each iteration of the event loop, the metalogger once a second,
+/// so the changes are written in groups.
 void changelog_flush();
-
-/// Disables flushing the current changelog after each \p changelog call
-void changelog_disable_flush();
-
-/// Enables flushing the current changelog after each \p changelog call
-void changelog_enable_flush();
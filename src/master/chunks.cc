@@ -29,10 +29,12 @@
 #include <unistd.h>
 #include <algorithm>
 #include <cinttypes>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <deque>
+#include <limits>
 #include <unordered_map>
 
 #include "common/chunk_copies_calculator.h"
@@ -55,6 +57,7 @@
 #include "master/checksum.h"
 #include "master/chunk_goal_counters.h"
 #include "master/chunkserver_db.h"
+#include "master/dense_id_map.h"
 #include "master/filesystem.h"
 #include "master/get_servers_for_new_chunk.h"
 #include "master/goal_cache.h"
@@ -68,6 +71,7 @@
 #  include "common/random.h"
 #  include "master/matoclserv.h"
 #  include "master/matocsserv.h"
+#  include "master/metadata_reader_pool.h"
 #  include "master/topology.h"
 #endif
 
@@ -79,20 +83,14 @@
 #define MAXCHUNKSLOOPPERIOD 10000
 #define MINCHUNKSLOOPCPU    10
 #define MAXCHUNKSLOOPCPU    90
-
-constexpr uint8_t kChunkHashBits = 22;
-constexpr int32_t kChunkHashSize = (1 << kChunkHashBits);
-constexpr uint32_t kChunkHashMask = kChunkHashSize - 1;
-constexpr uint32_t chunkHashPos(uint64_t chunkid) {
-	return static_cast<uint32_t>(chunkid) & kChunkHashMask;
-}
+#define MAXCHUNKSLOOPTHREADS 64
 
 #define CHECKSUMSEED 78765491511151883ULL
 
 #ifndef METARESTORE
 
 static uint32_t gRedundancyLevel;
-static uint64_t gEndangeredChunksServingLimit;
+static double gEndangeredChunksPriority;
 static uint64_t gEndangeredChunksMaxCapacity;
 static uint64_t gDisconnectedCounter = 0;
 inline LinearAssignmentCache gLinearAssignmentCache;
@@ -202,7 +200,10 @@ static uint32_t MaxDelSoftLimit;
 static uint32_t MaxDelHardLimit;
 static double   TmpMaxDelFrac;
 static uint32_t TmpMaxDel;
-static uint32_t HashSteps;
+/// Number of chunk loop periods (ticks) in which all the chunks should be processed
+static uint64_t ChunksLoopScaledTime;
+/// Number of threads helping the main one to analyse the chunks
+static uint32_t gChunksLoopThreads;
 static uint32_t HashCPS;
 static uint32_t ChunksLoopPeriod;
 static uint32_t ChunksLoopTimeout;
@@ -232,7 +233,7 @@ public:
 
 	uint64_t chunkid;
 	uint64_t checksum;
-	Chunk *next;
+	Chunk *next; ///< next free chunk, used by chunk_malloc
 #ifndef METARESTORE
 	compact_vector<ChunkPart> parts;
 #endif
@@ -400,7 +401,7 @@ public:
 		 * 4. Chunk is endangered
 		 * 5. It is not already in queue
 		 * By checking conditions below we assert no repetitions in endangered queue. */
-		if (gEndangeredChunksServingLimit > 0
+		if (gEndangeredChunksPriority > 0
 				&& endangeredChunks.size() < gEndangeredChunksMaxCapacity
 				&& allMissingParts_ > oldAllMissingParts
 				&& allAvailabilityState_ == ChunksAvailabilityState::kEndangered
@@ -523,7 +524,8 @@ struct ChunksMetadata {
 	// chunks
 	chunk_bucket *cbhead;
 	Chunk *chfreehead;
-	Chunk *chunkhash[kChunkHashSize];
+	/// Chunk ids are handed out sequentially, so they are kept in an array indexed by them
+	DenseIdMap<uint64_t, Chunk> chunkIndex;
 	uint64_t lastchunkid;
 	Chunk *lastchunkptr;
 
@@ -531,12 +533,13 @@ struct ChunksMetadata {
 	uint64_t nextchunkid; /// serial id of the next chunk to be created
 	uint64_t chunksChecksum;
 	uint64_t chunksChecksumRecalculated;
-	uint32_t checksumRecalculationPosition;
+	/// all the chunks with lower ids are included in chunksChecksumRecalculated
+	uint64_t checksumRecalculationPosition;
 
 	ChunksMetadata() :
 			cbhead{},
 			chfreehead{},
-			chunkhash{},
+			chunkIndex{},
 			lastchunkid{},
 			lastchunkptr{},
 			nextchunkid{1},
@@ -562,8 +565,6 @@ static ChunksMetadata *gChunksMetadata;
 
 #ifndef METARESTORE
 
-static Chunk *gCurrentChunkInZombieLoop = nullptr;
-
 class ReplicationDelayInfo {
 public:
 	ReplicationDelayInfo()
@@ -638,6 +639,13 @@ void chunk_stats(uint32_t *del,uint32_t *repl) {
 	stats_replications = 0;
 }
 
+uint32_t chunk_get_loop_duration(void) {
+	if (chunksinfo_loopstart == 0) {
+		return 0;
+	}
+	return chunksinfo_loopend - chunksinfo_loopstart;
+}
+
 #endif // ! METARESTORE
 
 static uint64_t chunk_checksum(const Chunk *c) {
@@ -667,13 +675,12 @@ static void chunk_update_checksum(Chunk *ch) {
 	if (!ch) {
 		return;
 	}
-	if (chunkHashPos(ch->chunkid) <
-	    gChunksMetadata->checksumRecalculationPosition) {
+	if (ch->chunkid < gChunksMetadata->checksumRecalculationPosition) {
 		removeFromChecksum(gChunksMetadata->chunksChecksumRecalculated, ch->checksum);
 	}
 	removeFromChecksum(gChunksMetadata->chunksChecksum, ch->checksum);
 	ch->checksum = chunk_checksum(ch);
-	if (chunkHashPos(ch->chunkid) < gChunksMetadata->checksumRecalculationPosition) {
+	if (ch->chunkid < gChunksMetadata->checksumRecalculationPosition) {
 		safs::log_trace("master.fs.checksum.changing_recalculated_chunk");
 		addToChecksum(gChunksMetadata->chunksChecksumRecalculated, ch->checksum);
 	} else {
@@ -693,14 +700,12 @@ ChecksumRecalculationStatus chunks_update_checksum_a_bit(uint32_t speedLimit) {
 		gChunksMetadata->chunksChecksumRecalculated = CHECKSUMSEED;
 	}
 	uint32_t recalculated = 0;
-	while (gChunksMetadata->checksumRecalculationPosition < kChunkHashSize) {
-		Chunk *c;
-		for (c = gChunksMetadata->chunkhash[gChunksMetadata->checksumRecalculationPosition]; c; c=c->next) {
-			chunk_checksum_add_to_background(c);
-			++recalculated;
-		}
-		++gChunksMetadata->checksumRecalculationPosition;
-		if (recalculated >= speedLimit) {
+	const auto &chunkIndex = gChunksMetadata->chunkIndex;
+	for (uint64_t chunkid = chunkIndex.nextId(gChunksMetadata->checksumRecalculationPosition);
+	     chunkid < chunkIndex.idLimit(); chunkid = chunkIndex.nextId(chunkid + 1)) {
+		chunk_checksum_add_to_background(chunkIndex.find(chunkid));
+		gChunksMetadata->checksumRecalculationPosition = chunkid + 1;
+		if (++recalculated >= speedLimit) {
 			return ChecksumRecalculationStatus::kInProgress;
 		}
 	}
@@ -716,12 +721,10 @@ ChecksumRecalculationStatus chunks_update_checksum_a_bit(uint32_t speedLimit) {
 
 static void chunk_recalculate_checksum() {
 	gChunksMetadata->chunksChecksum = CHECKSUMSEED;
-	for (int i = 0; i < kChunkHashSize; ++i) {
-		for (Chunk *ch = gChunksMetadata->chunkhash[i]; ch; ch = ch->next) {
-			ch->checksum = chunk_checksum(ch);
-			addToChecksum(gChunksMetadata->chunksChecksum, ch->checksum);
-		}
-	}
+	gChunksMetadata->chunkIndex.forEach([](Chunk *ch) {
+		ch->checksum = chunk_checksum(ch);
+		addToChecksum(gChunksMetadata->chunksChecksum, ch->checksum);
+	});
 }
 
 uint64_t chunk_checksum(ChecksumMode mode) {
@@ -764,11 +767,9 @@ static inline void chunk_free(Chunk *p) {
 #endif /* METARESTORE */
 
 Chunk *chunk_new(uint64_t chunkid, uint32_t chunkversion) {
-	uint32_t chunkpos = chunkHashPos(chunkid);
 	Chunk *newchunk;
 	newchunk = chunk_malloc();
-	newchunk->next = gChunksMetadata->chunkhash[chunkpos];
-	gChunksMetadata->chunkhash[chunkpos] = newchunk;
+	gChunksMetadata->chunkIndex.insert(chunkid, newchunk);
 	newchunk->chunkid = chunkid;
 	newchunk->version = chunkversion;
 	gChunksMetadata->lastchunkid = chunkid;
@@ -828,22 +829,19 @@ void chunk_handle_disconnected_copies(Chunk *c) {
 #endif
 
 Chunk *chunk_find(uint64_t chunkid) {
-	uint32_t chunkpos = chunkHashPos(chunkid);
 	Chunk *chunkit;
 	if (gChunksMetadata->lastchunkid==chunkid) {
 		return gChunksMetadata->lastchunkptr;
 	}
-	for (chunkit = gChunksMetadata->chunkhash[chunkpos] ; chunkit ; chunkit = chunkit->next) {
-		if (chunkit->chunkid == chunkid) {
-			gChunksMetadata->lastchunkid = chunkid;
-			gChunksMetadata->lastchunkptr = chunkit;
+	chunkit = gChunksMetadata->chunkIndex.find(chunkid);
+	if (chunkit) {
+		gChunksMetadata->lastchunkid = chunkid;
+		gChunksMetadata->lastchunkptr = chunkit;
 #ifndef METARESTORE
-			chunk_handle_disconnected_copies(chunkit);
+		chunk_handle_disconnected_copies(chunkit);
 #endif // METARESTORE
-			return chunkit;
-		}
 	}
-	return NULL;
+	return chunkit;
 }
 
 #ifndef METARESTORE
@@ -852,6 +850,7 @@ void chunk_delete(Chunk *c) {
 		gChunksMetadata->lastchunkid=0;
 		gChunksMetadata->lastchunkptr=NULL;
 	}
+	gChunksMetadata->chunkIndex.erase(c->chunkid);
 	c->freeStats();
 	chunk_free(c);
 }
@@ -1649,31 +1648,26 @@ void chunk_server_label_changed(const MediaLabel &previousLabel, const MediaLabe
  */
 void chunk_clean_zombie_servers_a_bit() {
 	SignalLoopWatchdog watchdog;
-	static uint32_t current_position = kChunkHashSize;
+	// lowest chunk id not processed in the current loop, starts as finished
+	static uint64_t current_position = std::numeric_limits<uint64_t>::max();
 
 	if (gDisconnectedCounter == 0) {
 		return;
 	}
 
 	watchdog.start();
-	while (current_position < kChunkHashSize) {
-		for (; gCurrentChunkInZombieLoop; gCurrentChunkInZombieLoop = gCurrentChunkInZombieLoop->next) {
-			chunk_handle_disconnected_copies(gCurrentChunkInZombieLoop);
-			if (watchdog.expired()) {
-				eventloop_make_next_poll_nonblocking();
-				return;
-			}
-		}
-		++current_position;
-		if (current_position < kChunkHashSize) {
-			gCurrentChunkInZombieLoop = gChunksMetadata->chunkhash[current_position];
+	const auto &chunkIndex = gChunksMetadata->chunkIndex;
+	for (uint64_t chunkid = chunkIndex.nextId(current_position);
+	     chunkid < chunkIndex.idLimit(); chunkid = chunkIndex.nextId(chunkid + 1)) {
+		chunk_handle_disconnected_copies(chunkIndex.find(chunkid));
+		current_position = chunkid + 1;
+		if (watchdog.expired()) {
+			eventloop_make_next_poll_nonblocking();
+			return;
 		}
 	}
-	if (current_position >= kChunkHashSize) {
-		--gDisconnectedCounter;
-		current_position = 0;
-		gCurrentChunkInZombieLoop = gChunksMetadata->chunkhash[0];
-	}
+	--gDisconnectedCounter;
+	current_position = 0;
 	eventloop_make_next_poll_nonblocking();
 }
 
@@ -1833,19 +1827,43 @@ public:
 private:
 	using ServersWithUsage = std::vector<ServerWithUsage>;
 
+	/// Result of the read-only part of doChunkJobs, which is computed in parallel.
+	struct ChunkAnalysis {
+		Chunk *chunk;
+		ChunkCopiesCalculator calc;
+		IpCounter ip_occurrence;
+		int invalid_parts;
+		bool degenerate;
+
+		explicit ChunkAnalysis(Chunk *c)
+		    : chunk(c), calc(c->getGoal()), invalid_parts(0), degenerate(false) {}
+	};
+
+	/// Number of chunks analysed in one batch, their jobs are applied before the next yield.
+	static constexpr uint32_t kAnalysisBatchSize = 1024;
+	/// Number of chunks analysed by a single task of the pool.
+	static constexpr uint32_t kAnalysisTaskSize = 64;
+
 	struct MainLoopStack {
-		uint32_t current_bucket;
+		uint64_t current_position; ///< lowest chunk id not processed in the current loop
 		uint16_t usable_server_count;
 		uint32_t chunks_done_count;
-		uint32_t buckets_done_count;
+		uint32_t chunks_to_do;
 		std::size_t endangered_to_serve;
-		Chunk* node;
-		Chunk* prev;
 		ActiveLoopWatchdog work_limit;
 		ActiveLoopWatchdog watchdog;
 	};
 
-	bool deleteUnusedChunks();
+	bool deleteIfUnused(Chunk *c);
+
+	/// Fills the analysis of a chunk, reads only the chunk and the chunkservers.
+	static void analyzeChunk(ChunkAnalysis &analysis, LinearAssignmentCache *cache);
+	/// Emits the jobs (replications, deletions, ...) for an analysed chunk.
+	void applyChunkJobs(ChunkAnalysis &analysis);
+	/// Takes the next batch of chunks of the loop, returns false if the loop is done.
+	bool collectBatch();
+	void analyzeBatch();
+	void updateAnalysisPool();
 
 	uint32_t getMinChunkserverVersion(Chunk *c, ChunkPartType type);
 	bool tryReplication(Chunk *c, ChunkPartType type, matocsserventry *destinationServer);
@@ -1871,6 +1889,10 @@ private:
 	std::map<MediaLabel, ServersWithUsage> labeledSortedServers_;
 
 	MainLoopStack stack_;
+
+	std::vector<ChunkAnalysis> batch_;
+	std::vector<MetadataReaderPool::Task> analysisTasks_;
+	std::unique_ptr<MetadataReaderPool> analysisPool_;
 };
 
 ChunkWorker::ChunkWorker()
@@ -1879,7 +1901,7 @@ ChunkWorker::ChunkWorker()
 		  prevToDeleteCount_(0),
 		  deleteLoopCount_(0) {
 	memset(&inforec_,0,sizeof(loop_info));
-	stack_.current_bucket = 0;
+	stack_.current_position = 0;
 }
 
 void ChunkWorker::doEveryLoopTasks() {
@@ -2150,7 +2172,7 @@ bool ChunkWorker::replicateChunkPart(Chunk *c, Goal::Slice::Type slice_type, int
 		// Enqueue chunk again only if it was taken directly from endangered chunks queue
 		// to avoid repetitions. If it was taken from chunk hashmap, inEndangeredQueue bit
 		// would be still up.
-		if (gEndangeredChunksServingLimit > 0 && Chunk::endangeredChunks.size() < gEndangeredChunksMaxCapacity
+		if (gEndangeredChunksPriority > 0 && Chunk::endangeredChunks.size() < gEndangeredChunksMaxCapacity
 			&& !c->inEndangeredQueue && calc.getState() == ChunksAvailabilityState::kEndangered) {
 			c->inEndangeredQueue = 1;
 			Chunk::endangeredChunks.push_back(c);
@@ -2374,39 +2396,51 @@ void ChunkWorker::doChunkJobs(Chunk *c, uint16_t serverCount) {
 		return;
 	}
 
-	int invalid_parts = 0;
-	ChunkCopiesCalculator calc(c->getGoal());
+	ChunkAnalysis analysis(c);
+	analyzeChunk(analysis, &gLinearAssignmentCache);
+	applyChunkJobs(analysis);
+}
+
+void ChunkWorker::analyzeChunk(ChunkAnalysis &analysis, LinearAssignmentCache *cache) {
+	Chunk *c = analysis.chunk;
+	ChunkCopiesCalculator &calc = analysis.calc;
 
 	// Chunk is in degenerate state if it has more than 1 part
 	// on the same chunkserver (i.e. 1 std and 1 xor)
 	// TODO(sarna): this flat_set should be removed after
 	// 'slists' are rewritten to use sensible data structures
-	bool degenerate = false;
 	flat_set<matocsserventry *, small_vector<matocsserventry *, 64>> servers;
 
 	// step 1. calculate number of valid and invalid copies
 	for (const auto &part : c->parts) {
 		if (part.is_valid()) {
 			calc.addPart(part.type, matocsserv_get_label(part.server()));
-			if (!degenerate) {
-				degenerate = servers.count(part.server()) > 0;
+			if (!analysis.degenerate) {
+				analysis.degenerate = servers.count(part.server()) > 0;
 				servers.insert(part.server());
 			}
 		} else {
-			++invalid_parts;
+			++analysis.invalid_parts;
 		}
 	}
-	calc.optimize(gUseLinearAssignmentOptimizer, &gLinearAssignmentCache);
+	calc.optimize(gUseLinearAssignmentOptimizer, cache);
 
 	// step 1a. count number of chunk parts on servers with the same ip
-	IpCounter ip_occurrence;
 	if (gAvoidSameIpChunkservers) {
 		for (auto &part : c->parts) {
 			if (part.is_valid()) {
-				++ip_occurrence[matocsserv_get_servip(part.server())];
+				++analysis.ip_occurrence[matocsserv_get_servip(part.server())];
 			}
 		}
 	}
+}
+
+void ChunkWorker::applyChunkJobs(ChunkAnalysis &analysis) {
+	Chunk *c = analysis.chunk;
+	ChunkCopiesCalculator &calc = analysis.calc;
+	const IpCounter &ip_occurrence = analysis.ip_occurrence;
+	int invalid_parts = analysis.invalid_parts;
+	bool degenerate = analysis.degenerate;
 
 	// step 2. check number of copies
 	if (c->isLost() && invalid_parts > 0 && c->fileCount() > 0) {
@@ -2499,56 +2533,84 @@ void ChunkWorker::doChunkJobs(Chunk *c, uint16_t serverCount) {
 
 }
 
-bool ChunkWorker::deleteUnusedChunks() {
-	while (stack_.node != nullptr) {
-		chunk_handle_disconnected_copies(stack_.node);
-		if (stack_.node->fileCount() == 0 && stack_.node->parts.empty()) {
-			// If current chunk in zombie loop is to be deleted, it must be updated
-			// to the next chunk
-			if (stack_.node == gCurrentChunkInZombieLoop) {
-				gCurrentChunkInZombieLoop = gCurrentChunkInZombieLoop->next;
-			}
-			// Something could be inserted between prev and node (when we yielded)
-			// so we need to make prev valid.
-			while (stack_.prev && stack_.prev->next != stack_.node) {
-				stack_.prev = stack_.prev->next;
-			}
-
-			assert((!stack_.prev && gChunksMetadata->chunkhash[stack_.current_bucket] == stack_.node) ||
-			       (stack_.prev && stack_.prev->next == stack_.node));
+bool ChunkWorker::deleteIfUnused(Chunk *c) {
+	chunk_handle_disconnected_copies(c);
+	if (c->fileCount() == 0 && c->parts.empty()) {
+		chunk_delete(c);
+		return true;
+	}
+	return false;
+}
 
-			if (stack_.prev) {
-				stack_.prev->next = stack_.node->next;
-			} else {
-				gChunksMetadata->chunkhash[stack_.current_bucket] =
-				        stack_.node->next;
-			}
+bool ChunkWorker::collectBatch() {
+	const auto &chunkIndex = gChunksMetadata->chunkIndex;
+	batch_.clear();
+	while (batch_.size() < kAnalysisBatchSize &&
+	       stack_.chunks_done_count < stack_.chunks_to_do) {
+		uint64_t chunkid = chunkIndex.nextId(stack_.current_position);
+		if (chunkid >= chunkIndex.idLimit()) {
+			stack_.current_position = 0;
+			return false;
+		}
+		stack_.current_position = chunkid + 1;
+		++stack_.chunks_done_count;
 
-			Chunk *tmp = stack_.node->next;
-			chunk_delete(stack_.node);
-			stack_.node = tmp;
-		} else {
-			stack_.prev = stack_.node;
-			stack_.node = stack_.node->next;
+		Chunk *c = chunkIndex.find(chunkid);
+		if (deleteIfUnused(c)) {
+			continue;
+		}
+		// step 0 of doChunkJobs, disconnected copies are already handled by deleteIfUnused
+		c->updateStats();
+		if (stack_.usable_server_count > 0) {
+			batch_.emplace_back(c);
 		}
+	}
+	return true;
+}
 
-		if (stack_.watchdog.expired()) {
-			return false;
+void ChunkWorker::analyzeBatch() {
+	if (!analysisPool_) {
+		for (auto &analysis : batch_) {
+			analyzeChunk(analysis, &gLinearAssignmentCache);
 		}
+		return;
 	}
 
-	return true;
+	analysisTasks_.clear();
+	for (size_t first = 0; first < batch_.size(); first += kAnalysisTaskSize) {
+		size_t last = std::min<size_t>(first + kAnalysisTaskSize, batch_.size());
+		analysisTasks_.emplace_back([this, first, last]() {
+			// The cache is not thread safe, each thread of the pool has its own
+			static thread_local LinearAssignmentCache cache;
+			for (size_t i = first; i < last; ++i) {
+				analyzeChunk(batch_[i], &cache);
+			}
+		});
+	}
+	analysisPool_->run(analysisTasks_);
+}
+
+void ChunkWorker::updateAnalysisPool() {
+	if (gChunksLoopThreads == 0) {
+		analysisPool_.reset();
+	} else if (!analysisPool_ || analysisPool_->threads() != gChunksLoopThreads) {
+		analysisPool_.reset();
+		analysisPool_ = std::make_unique<MetadataReaderPool>(gChunksLoopThreads, "chunkLoop");
+	}
 }
 
 void ChunkWorker::mainLoop() {
 	Chunk *c;
+	bool loopDone;
 
 	reenter(this) {
+		updateAnalysisPool();
 		stack_.work_limit.setMaxDuration(std::chrono::milliseconds(ChunksLoopTimeout));
 		stack_.work_limit.start();
 		stack_.watchdog.start();
 		stack_.chunks_done_count = 0;
-		stack_.buckets_done_count = 0;
+		stack_.chunks_to_do = std::min<uint64_t>(
+		        HashCPS, 1 + gChunksMetadata->chunkIndex.size() / ChunksLoopScaledTime);
 
 		if (starttime + gOperationsDelayInit > eventloop_time()) {
 			return;
@@ -2565,7 +2627,8 @@ void ChunkWorker::mainLoop() {
 		doEverySecondTasks();
 
 		if (jobsnorepbefore < eventloop_time()) {
-			stack_.endangered_to_serve = gEndangeredChunksServingLimit;
+			stack_.endangered_to_serve =
+			        std::ceil(stack_.chunks_to_do * gEndangeredChunksPriority);
 			while (stack_.endangered_to_serve > 0 && !Chunk::endangeredChunks.empty()) {
 				c = Chunk::endangeredChunks.front();
 				Chunk::endangeredChunks.pop_front();
@@ -2584,51 +2647,32 @@ void ChunkWorker::mainLoop() {
 			}
 		}
 
-		while (stack_.buckets_done_count < HashSteps &&
-		       stack_.chunks_done_count < HashCPS) {
-			if (stack_.current_bucket == 0) {
+		// Chunks are visited in the order of their ids, which is also the order of the index in
+		// memory; the position is an id, so it stays valid when chunks are deleted meanwhile.
+		// Chunks are taken in batches: the read-only analysis of a batch runs on the pool, then
+		// the jobs are emitted here. Nothing else runs in between (there is no yield), so the
+		// analysis is still valid when the jobs are emitted.
+		while (stack_.chunks_done_count < stack_.chunks_to_do) {
+			if (stack_.current_position == 0) {
 				doEveryLoopTasks();
 			}
 
 			if (stack_.watchdog.expired()) {
 				yield;
 				stack_.watchdog.start();
+				matocsserv_usagedifference(nullptr, nullptr, &stack_.usable_server_count,
+				                           nullptr);
 			}
 
-			// delete unused chunks
-			stack_.prev = nullptr;
-			stack_.node = gChunksMetadata->chunkhash[stack_.current_bucket];
-			while (!deleteUnusedChunks()) {
-				yield;
-				stack_.watchdog.start();
-			}
-
-			// regenerate usable_server_count
-			matocsserv_usagedifference(nullptr, nullptr, &stack_.usable_server_count,
-			                           nullptr);
-
-			stack_.node = gChunksMetadata->chunkhash[stack_.current_bucket];
-			while (stack_.node) {
-				doChunkJobs(stack_.node, stack_.usable_server_count);
-				++stack_.chunks_done_count;
-				stack_.node = stack_.node->next;
-
-				if (stack_.watchdog.expired()) {
-					yield;
-					stack_.watchdog.start();
-					matocsserv_usagedifference(nullptr, nullptr,
-					                           &stack_.usable_server_count,
-					                           nullptr);
-				}
+			loopDone = !collectBatch();
+			analyzeBatch();
+			for (auto &analysis : batch_) {
+				applyChunkJobs(analysis);
 			}
+			batch_.clear();
 
-			stack_.current_bucket +=
-			        123;  // if HASHSIZE is any power of 2 then any odd number is
-			              // good here
-			stack_.current_bucket %= kChunkHashSize;
-			++stack_.buckets_done_count;
-
-			if (stack_.work_limit.expired()) {
+			// the next loop starts with the next call
+			if (loopDone || stack_.work_limit.expired()) {
 				break;
 			}
 		}
@@ -2661,14 +2705,9 @@ constexpr uint32_t kSerializedChunkSizeWithLockId = 20;
 #ifdef METARESTORE
 
 void chunk_dump(void) {
-	Chunk *c;
-	uint32_t i;
-
-	for (i=0 ; i<kChunkHashSize ; i++) {
-		for (c=gChunksMetadata->chunkhash[i] ; c ; c=c->next) {
-			printf("*|i:%016" PRIX64 "|v:%08" PRIX32 "|g:%" PRIu8 "|t:%10" PRIu32 "\n",c->chunkid,c->version,c->highestIdGoal(),c->lockedto);
-		}
-	}
+	gChunksMetadata->chunkIndex.forEach([](Chunk *c) {
+		printf("*|i:%016" PRIX64 "|v:%08" PRIX32 "|g:%" PRIu8 "|t:%10" PRIu32 "\n",c->chunkid,c->version,c->highestIdGoal(),c->lockedto);
+	});
 }
 
 #endif
@@ -2687,6 +2726,11 @@ bool chunksLoadFromFile(MetadataLoader::Options options) {
 			lockId = get32bit(&ptr);
 		}
 		if (chunkId > 0) {
+			if (gChunksMetadata->chunkIndex.find(chunkId)) {
+				safs_pretty_syslog(LOG_ERR, "loading chunks: duplicated chunk: %016" PRIX64,
+				                   chunkId);
+				return false;
+			}
 			Chunk * chunk = chunk_new(chunkId, version);
 			chunk->lockedto = lockedTo;
 			chunk->lockid = lockId;
@@ -2702,7 +2746,7 @@ void chunk_store(FILE *fd) {
 	uint8_t hdr[8];
 	uint8_t storebuff[kSerializedChunkSizeWithLockId * CHUNKCNT];
 	uint8_t *ptr;
-	uint32_t i,j;
+	uint32_t j;
 	Chunk *c;
 // chunkdata
 	uint64_t chunkid;
@@ -2715,28 +2759,28 @@ void chunk_store(FILE *fd) {
 	}
 	j=0;
 	ptr = storebuff;
-	for (i=0 ; i<kChunkHashSize ; i++) {
-		for (c=gChunksMetadata->chunkhash[i] ; c ; c=c->next) {
+	const auto &chunkIndex = gChunksMetadata->chunkIndex;
+	for (uint64_t id = chunkIndex.nextId(0); id < chunkIndex.idLimit(); id = chunkIndex.nextId(id + 1)) {
+		c = chunkIndex.find(id);
 #ifndef METARESTORE
-			chunk_handle_disconnected_copies(c);
+		chunk_handle_disconnected_copies(c);
 #endif
-			chunkid = c->chunkid;
-			put64bit(&ptr,chunkid);
-			version = c->version;
-			put32bit(&ptr,version);
-			lockedto = c->lockedto;
-			lockid = c->lockid;
-			put32bit(&ptr,lockedto);
-			put32bit(&ptr,lockid);
-			j++;
-			if (j==CHUNKCNT) {
-				size_t writtenBlockSize = kSerializedChunkSizeWithLockId * CHUNKCNT;
-				if (fwrite(storebuff, 1, writtenBlockSize, fd) != writtenBlockSize) {
-					return;
-				}
-				j=0;
-				ptr = storebuff;
+		chunkid = c->chunkid;
+		put64bit(&ptr,chunkid);
+		version = c->version;
+		put32bit(&ptr,version);
+		lockedto = c->lockedto;
+		lockid = c->lockid;
+		put32bit(&ptr,lockedto);
+		put32bit(&ptr,lockid);
+		j++;
+		if (j==CHUNKCNT) {
+			size_t writtenBlockSize = kSerializedChunkSizeWithLockId * CHUNKCNT;
+			if (fwrite(storebuff, 1, writtenBlockSize, fd) != writtenBlockSize) {
+				return;
 			}
+			j=0;
+			ptr = storebuff;
 		}
 	}
 	memset(ptr, 0, kSerializedChunkSizeWithLockId);
@@ -2834,21 +2878,19 @@ void chunk_reload(void) {
 
 	repl = cfg_get_minmaxvalue<uint32_t>("CHUNKS_LOOP_MAX_CPU", 60, MINCHUNKSLOOPCPU, MAXCHUNKSLOOPCPU);
 	ChunksLoopTimeout = repl * ChunksLoopPeriod / 100;
+	gChunksLoopThreads = cfg_get_maxvalue<uint32_t>("CHUNKS_LOOP_THREADS", 0, MAXCHUNKSLOOPTHREADS);
 
 	if (cfg_isdefined("CHUNKS_LOOP_TIME")) {
 		looptime = cfg_get_minmaxvalue<uint32_t>("CHUNKS_LOOP_TIME", 300, MINLOOPTIME, MAXLOOPTIME);
-		uint64_t scaled_looptime = std::max((uint64_t)1000 * looptime / ChunksLoopPeriod, (uint64_t)1);
-		HashSteps = 1 + ((kChunkHashSize) / scaled_looptime);
+		ChunksLoopScaledTime = std::max((uint64_t)1000 * looptime / ChunksLoopPeriod, (uint64_t)1);
 		HashCPS   = 0xFFFFFFFF;
 	} else {
 		looptime = cfg_get_minmaxvalue<uint32_t>("CHUNKS_LOOP_MIN_TIME", 300, MINLOOPTIME, MAXLOOPTIME);
 		HashCPS = cfg_get_minmaxvalue<uint32_t>("CHUNKS_LOOP_MAX_CPS", 100000, MINCPS, MAXCPS);
-		uint64_t scaled_looptime = std::max((uint64_t)1000 * looptime / ChunksLoopPeriod, (uint64_t)1);
-		HashSteps = 1 + ((kChunkHashSize) / scaled_looptime);
+		ChunksLoopScaledTime = std::max((uint64_t)1000 * looptime / ChunksLoopPeriod, (uint64_t)1);
 		HashCPS   = (uint64_t)ChunksLoopPeriod * HashCPS / 1000;
 	}
-	double endangeredChunksPriority = cfg_ranged_get("ENDANGERED_CHUNKS_PRIORITY", 0.0, 0.0, 1.0);
-	gEndangeredChunksServingLimit = HashSteps * endangeredChunksPriority;
+	gEndangeredChunksPriority = cfg_ranged_get("ENDANGERED_CHUNKS_PRIORITY", 0.0, 0.0, 1.0);
 	gEndangeredChunksMaxCapacity = cfg_get("ENDANGERED_CHUNKS_MAX_CAPACITY", static_cast<uint64_t>(1024*1024UL));
 	gAcceptableDifference = cfg_ranged_get("ACCEPTABLE_DIFFERENCE",0.1, 0.001, 10.0);
 	RebalancingBetweenLabels = cfg_getuint32("CHUNKS_REBALANCING_BETWEEN_LABELS", 0) == 1;
@@ -2910,6 +2952,7 @@ int chunk_strinit(void) {
 	ChunksLoopPeriod  = cfg_get_minmaxvalue<uint32_t>("CHUNKS_LOOP_PERIOD", 1000, MINCHUNKSLOOPPERIOD, MAXCHUNKSLOOPPERIOD);
 	uint32_t repl = cfg_get_minmaxvalue<uint32_t>("CHUNKS_LOOP_MAX_CPU", 60, MINCHUNKSLOOPCPU, MAXCHUNKSLOOPCPU);
 	ChunksLoopTimeout = repl * ChunksLoopPeriod / 100;
+	gChunksLoopThreads = cfg_get_maxvalue<uint32_t>("CHUNKS_LOOP_THREADS", 0, MAXCHUNKSLOOPTHREADS);
 
 	uint32_t looptime;
 	if (cfg_isdefined("CHUNKS_LOOP_TIME")) {
@@ -2918,18 +2961,15 @@ int chunk_strinit(void) {
 				"deprecated - use CHUNKS_LOOP_MAX_CPS and CHUNKS_LOOP_MIN_TIME",
 				cfg_filename().c_str());
 		looptime = cfg_get_minmaxvalue<uint32_t>("CHUNKS_LOOP_TIME", 300, MINLOOPTIME, MAXLOOPTIME);
-		uint64_t scaled_looptime = std::max((uint64_t)1000 * looptime / ChunksLoopPeriod, (uint64_t)1);
-		HashSteps = 1 + ((kChunkHashSize) / scaled_looptime);
+		ChunksLoopScaledTime = std::max((uint64_t)1000 * looptime / ChunksLoopPeriod, (uint64_t)1);
 		HashCPS   = 0xFFFFFFFF;
 	} else {
 		looptime = cfg_get_minmaxvalue<uint32_t>("CHUNKS_LOOP_MIN_TIME", 300, MINLOOPTIME, MAXLOOPTIME);
 		HashCPS = cfg_get_minmaxvalue<uint32_t>("CHUNKS_LOOP_MAX_CPS", 100000, MINCPS, MAXCPS);
-		uint64_t scaled_looptime = std::max((uint64_t)1000 * looptime / ChunksLoopPeriod, (uint64_t)1);
-		HashSteps = 1 + ((kChunkHashSize) / scaled_looptime);
+		ChunksLoopScaledTime = std::max((uint64_t)1000 * looptime / ChunksLoopPeriod, (uint64_t)1);
 		HashCPS   = (uint64_t)ChunksLoopPeriod * HashCPS / 1000;
 	}
-	double endangeredChunksPriority = cfg_ranged_get("ENDANGERED_CHUNKS_PRIORITY", 0.0, 0.0, 1.0);
-	gEndangeredChunksServingLimit = HashSteps * endangeredChunksPriority;
+	gEndangeredChunksPriority = cfg_ranged_get("ENDANGERED_CHUNKS_PRIORITY", 0.0, 0.0, 1.0);
 	gEndangeredChunksMaxCapacity = cfg_get("ENDANGERED_CHUNKS_MAX_CAPACITY", static_cast<uint64_t>(1024*1024UL));
 	gAcceptableDifference = cfg_ranged_get("ACCEPTABLE_DIFFERENCE", 0.1, 0.001, 10.0);
 	RebalancingBetweenLabels = cfg_getuint32("CHUNKS_REBALANCING_BETWEEN_LABELS", 0) == 1;
@@ -0,0 +1,156 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/*! \brief Map from ids to pointers, kept in an array indexed by the id.
+ *
+ * Meant for ids handed out densely from a pool (like inodes from IdPoolDetainer),
+ * for which a hash table only adds collision chains and a pointer per element.
+ * Slots are grouped in pages allocated on first use and freed when they become
+ * empty, so a lookup is two dependent loads: the page directory (small enough to
+ * stay in cache) and the slot. Iteration goes in the id order, which is also
+ * the memory order.
+ */
+template <typename IdType, typename T>
+class DenseIdMap {
+	static_assert(std::is_unsigned_v<IdType>);
+
+public:
+	static constexpr unsigned kPageBits = 14;
+	static constexpr uint64_t kPageSize = uint64_t(1) << kPageBits;
+
+	DenseIdMap() = default;
+	DenseIdMap(const DenseIdMap &) = delete;
+	DenseIdMap &operator=(const DenseIdMap &) = delete;
+	DenseIdMap(DenseIdMap &&) noexcept = default;
+	DenseIdMap &operator=(DenseIdMap &&) noexcept = default;
+
+	/// Returns the element with the given id or nullptr.
+	T *find(IdType id) const {
+		uint64_t pageIndex = uint64_t(id) >> kPageBits;
+		if (pageIndex >= pages_.size()) { return nullptr; }
+		const Page *page = pages_[pageIndex].get();
+		return page ? page->slots[id & (kPageSize - 1)] : nullptr;
+	}
+
+	/// Hints the CPU to fetch the slot of \a id, for batches of lookups.
+	void prefetch(IdType id) const {
+		uint64_t pageIndex = uint64_t(id) >> kPageBits;
+		if (pageIndex < pages_.size() && pages_[pageIndex]) {
+			__builtin_prefetch(&pages_[pageIndex]->slots[id & (kPageSize - 1)]);
+		}
+	}
+
+	/// Inserts \a value under \a id, returns false if the id is already used.
+	bool insert(IdType id, T *value) {
+		assert(value != nullptr);
+		uint64_t pageIndex = uint64_t(id) >> kPageBits;
+		if (pageIndex >= pages_.size()) { pages_.resize(pageIndex + 1); }
+		auto &page = pages_[pageIndex];
+		if (!page) { page = std::make_unique<Page>(); }
+		T *&slot = page->slots[id & (kPageSize - 1)];
+		if (slot != nullptr) { return false; }
+		slot = value;
+		++page->count;
+		++size_;
+		return true;
+	}
+
+	/// Removes the element with the given id, returns it or nullptr.
+	T *erase(IdType id) {
+		uint64_t pageIndex = uint64_t(id) >> kPageBits;
+		if (pageIndex >= pages_.size() || !pages_[pageIndex]) { return nullptr; }
+		auto &page = pages_[pageIndex];
+		T *value = page->slots[id & (kPageSize - 1)];
+		if (value == nullptr) { return nullptr; }
+		page->slots[id & (kPageSize - 1)] = nullptr;
+		--size_;
+		if (--page->count == 0) { page.reset(); }
+		return value;
+	}
+
+	/// Returns the lowest used id not lower than \a from, or idLimit() if there is none.
+	uint64_t nextId(uint64_t from) const {
+		for (uint64_t pageIndex = from >> kPageBits; pageIndex < pages_.size();
+		     ++pageIndex) {
+			const Page *page = pages_[pageIndex].get();
+			if (!page) { continue; }
+			uint64_t base = pageIndex << kPageBits;
+			for (uint64_t slot = from > base ? from - base : 0; slot < kPageSize; ++slot) {
+				if (page->slots[slot]) { return base + slot; }
+			}
+		}
+		return idLimit();
+	}
+
+	/// All the used ids are lower than this.
+	uint64_t idLimit() const { return uint64_t(pages_.size()) << kPageBits; }
+
+	/*! \brief Calls \a func for each element in the id order.
+	 *
+	 * \a func must not insert or erase elements, use nextId() for loops which do.
+	 */
+	template <typename Func>
+	void forEach(Func func) const {
+		for (const auto &page : pages_) {
+			if (!page) { continue; }
+			for (T *value : page->slots) {
+				if (value) { func(value); }
+			}
+		}
+	}
+
+	size_t size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	/// Removes all the elements (without destroying them).
+	void clear() {
+		pages_.clear();
+		pages_.shrink_to_fit();
+		size_ = 0;
+	}
+
+	/// Bytes used by the map itself.
+	size_t memoryUsage() const {
+		size_t usage = pages_.capacity() * sizeof(pages_[0]);
+		for (const auto &page : pages_) {
+			if (page) { usage += sizeof(Page); }
+		}
+		return usage;
+	}
+
+private:
+	struct Page {
+		std::array<T *, kPageSize> slots{};
+		uint32_t count = 0;
+	};
+
+	std::vector<std::unique_ptr<Page>> pages_;
+	size_t size_ = 0;
+};
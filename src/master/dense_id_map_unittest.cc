@@ -0,0 +1,97 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "master/dense_id_map.h"
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using Map = DenseIdMap<uint32_t, int>;
+
+TEST(DenseIdMapTests, InsertFindErase) {
+	Map map;
+	int a = 1, b = 2;
+
+	EXPECT_EQ(map.find(7), nullptr);
+	EXPECT_TRUE(map.insert(7, &a));
+	EXPECT_FALSE(map.insert(7, &b));
+	EXPECT_TRUE(map.insert(0xFFFFFFF0U, &b));
+	EXPECT_EQ(map.size(), 2U);
+	EXPECT_EQ(map.find(7), &a);
+	EXPECT_EQ(map.find(0xFFFFFFF0U), &b);
+	EXPECT_EQ(map.find(8), nullptr);
+	EXPECT_EQ(map.idLimit(), uint64_t(1) << 32);
+
+	EXPECT_EQ(map.erase(7), &a);
+	EXPECT_EQ(map.erase(7), nullptr);
+	EXPECT_EQ(map.find(7), nullptr);
+	EXPECT_EQ(map.size(), 1U);
+
+	map.clear();
+	EXPECT_TRUE(map.empty());
+	EXPECT_EQ(map.find(0xFFFFFFF0U), nullptr);
+}
+
+TEST(DenseIdMapTests, IterationInIdOrder) {
+	Map map;
+	std::vector<int> values(5);
+	std::vector<uint32_t> ids = {3 * Map::kPageSize + 5, 1, 2, Map::kPageSize - 1,
+	                             Map::kPageSize};
+	for (size_t i = 0; i < ids.size(); ++i) {
+		values[i] = ids[i];
+		ASSERT_TRUE(map.insert(ids[i], &values[i]));
+	}
+
+	std::vector<int> visited;
+	map.forEach([&visited](int *value) { visited.push_back(*value); });
+	std::vector<int> expected = {1, 2, Map::kPageSize - 1, Map::kPageSize,
+	                             3 * Map::kPageSize + 5};
+	EXPECT_EQ(visited, expected);
+
+	visited.clear();
+	for (uint64_t id = map.nextId(0); id < map.idLimit(); id = map.nextId(id + 1)) {
+		visited.push_back(*map.find(id));
+	}
+	EXPECT_EQ(visited, expected);
+	EXPECT_EQ(map.nextId(3), Map::kPageSize - 1);
+	EXPECT_EQ(map.nextId(3 * Map::kPageSize + 6), map.idLimit());
+}
+
+TEST(DenseIdMapTests, EmptyPagesAreReleased) {
+	Map map;
+	std::vector<int> values(2 * Map::kPageSize);
+	size_t emptyUsage = map.memoryUsage();
+
+	for (uint32_t id = 0; id < values.size(); ++id) {
+		ASSERT_TRUE(map.insert(id, &values[id]));
+	}
+	size_t fullUsage = map.memoryUsage();
+	EXPECT_GE(fullUsage, values.size() * sizeof(int *));
+
+	// Removing the whole first page frees it, the iteration skips it
+	for (uint32_t id = 0; id < Map::kPageSize; ++id) {
+		ASSERT_EQ(map.erase(id), &values[id]);
+	}
+	EXPECT_LT(map.memoryUsage(), fullUsage);
+	EXPECT_GT(map.memoryUsage(), emptyUsage);
+	EXPECT_EQ(map.nextId(0), Map::kPageSize);
+	EXPECT_EQ(map.size(), Map::kPageSize);
+}
@@ -0,0 +1,460 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "master/directory_entries.h"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+DirectoryEntries::Leaf *DirectoryEntries::Leaf::create(uint32_t capacity) {
+	assert(capacity > 0 && capacity <= kLeafCapacity);
+	std::size_t bytes =
+	    sizeof(Leaf) + capacity * (sizeof(Key) + sizeof(value_type) + sizeof(uint16_t));
+	return new (::operator new(bytes)) Leaf{nullptr, 0, static_cast<uint16_t>(capacity)};
+}
+
+void DirectoryEntries::Leaf::destroy(Leaf *leaf) {
+	leaf->~Leaf();
+	::operator delete(leaf);
+}
+
+void DirectoryEntries::Leaf::moveEntries(Leaf *src, uint32_t from, Leaf *dst, uint32_t to,
+		uint32_t count) {
+	if (src == dst && to > from) {
+		std::copy_backward(src->keys() + from, src->keys() + from + count,
+		                   dst->keys() + to + count);
+		std::copy_backward(src->values() + from, src->values() + from + count,
+		                   dst->values() + to + count);
+		std::copy_backward(src->fingerprints() + from, src->fingerprints() + from + count,
+		                   dst->fingerprints() + to + count);
+	} else {
+		std::copy(src->keys() + from, src->keys() + from + count, dst->keys() + to);
+		std::copy(src->values() + from, src->values() + from + count, dst->values() + to);
+		std::copy(src->fingerprints() + from, src->fingerprints() + from + count,
+		          dst->fingerprints() + to);
+	}
+}
+
+void DirectoryEntries::Inner::moveChildren(Inner *src, uint32_t from, Inner *dst, uint32_t to,
+		uint32_t count) {
+	if (src == dst && to > from) {
+		std::copy_backward(src->mins + from, src->mins + from + count, dst->mins + to + count);
+		std::copy_backward(src->sizes + from, src->sizes + from + count, dst->sizes + to + count);
+		std::copy_backward(src->children + from, src->children + from + count,
+		                   dst->children + to + count);
+	} else {
+		std::copy(src->mins + from, src->mins + from + count, dst->mins + to);
+		std::copy(src->sizes + from, src->sizes + from + count, dst->sizes + to);
+		std::copy(src->children + from, src->children + from + count, dst->children + to);
+	}
+}
+
+DirectoryEntries::DirectoryEntries(DirectoryEntries &&other) noexcept
+	: root_(other.root_), size_(other.size_), height_(other.height_) {
+	other.root_ = nullptr;
+	other.size_ = 0;
+	other.height_ = 0;
+}
+
+DirectoryEntries &DirectoryEntries::operator=(DirectoryEntries &&other) noexcept {
+	if (this != &other) {
+		clear();
+		std::swap(root_, other.root_);
+		std::swap(size_, other.size_);
+		std::swap(height_, other.height_);
+	}
+	return *this;
+}
+
+DirectoryEntries::~DirectoryEntries() {
+	clear();
+}
+
+void DirectoryEntries::clear() {
+	if (root_) {
+		destroy(root_, height_);
+	}
+	root_ = nullptr;
+	size_ = 0;
+	height_ = 0;
+}
+
+void DirectoryEntries::destroy(void *node, uint32_t height) {
+	if (height == 0) {
+		Leaf::destroy(static_cast<Leaf *>(node));
+		return;
+	}
+	Inner *inner = static_cast<Inner *>(node);
+	for (uint32_t i = 0; i < inner->count; ++i) {
+		destroy(inner->children[i], height - 1);
+	}
+	delete inner;
+}
+
+DirectoryEntries::Key DirectoryEntries::minKey(void *node, uint32_t height) {
+	if (height == 0) {
+		return static_cast<Leaf *>(node)->keys()[0];
+	}
+	return static_cast<Inner *>(node)->mins[0];
+}
+
+uint32_t DirectoryEntries::subtreeSize(void *node, uint32_t height) {
+	if (height == 0) {
+		return static_cast<Leaf *>(node)->count;
+	}
+	Inner *inner = static_cast<Inner *>(node);
+	uint32_t size = 0;
+	for (uint32_t i = 0; i < inner->count; ++i) {
+		size += inner->sizes[i];
+	}
+	return size;
+}
+
+DirectoryEntries::iterator DirectoryEntries::begin() const {
+	if (!root_) {
+		return end();
+	}
+	void *node = root_;
+	for (uint32_t height = height_; height > 0; --height) {
+		node = static_cast<Inner *>(node)->children[0];
+	}
+	return iterator(static_cast<Leaf *>(node), 0);
+}
+
+DirectoryEntries::iterator DirectoryEntries::lower_bound(Key key) const {
+	if (!root_) {
+		return end();
+	}
+	void *node = root_;
+	for (uint32_t height = height_; height > 0; --height) {
+		Inner *inner = static_cast<Inner *>(node);
+		// The last subtree starting below the key, the entry may also be the first one
+		// of the next subtree, which is reached by iterating over the leaves
+		uint32_t i = std::lower_bound(inner->mins, inner->mins + inner->count, key) - inner->mins;
+		node = inner->children[i > 0 ? i - 1 : 0];
+	}
+	Leaf *leaf = static_cast<Leaf *>(node);
+	uint32_t i = std::lower_bound(leaf->keys(), leaf->keys() + leaf->count, key) - leaf->keys();
+	if (i == leaf->count) {
+		return iterator(leaf->next, 0);
+	}
+	return iterator(leaf, i);
+}
+
+DirectoryEntries::iterator DirectoryEntries::find(const HString &name) const {
+	auto handle_hash = static_cast<hstorage::Handle::HashType>(name.hash());
+	uint16_t fp = fingerprint(name.hash());
+	for (iterator it = lower_bound(static_cast<Key>(handle_hash) << hstorage::Handle::kHashShift);
+	     it != end(); ++it) {
+		if ((it.leaf_->keys()[it.index_] >> hstorage::Handle::kHashShift) != handle_hash) {
+			break;
+		}
+		if (it.leaf_->fingerprints()[it.index_] == fp && *it->first == name) {
+			return it;
+		}
+	}
+	return end();
+}
+
+DirectoryEntries::iterator DirectoryEntries::find_by_order(size_type nth) const {
+	if (nth >= size_) {
+		return end();
+	}
+	void *node = root_;
+	for (uint32_t height = height_; height > 0; --height) {
+		Inner *inner = static_cast<Inner *>(node);
+		uint32_t i = 0;
+		while (nth >= inner->sizes[i]) {
+			nth -= inner->sizes[i++];
+		}
+		node = inner->children[i];
+	}
+	return iterator(static_cast<Leaf *>(node), nth);
+}
+
+std::pair<DirectoryEntries::iterator, bool> DirectoryEntries::insert(const value_type &value,
+		HString::HashType name_hash) {
+	Key key = value.first->data();
+	if (!root_) {
+		root_ = Leaf::create(1);
+		height_ = 0;
+	} else if (height_ == 0) {
+		// A small directory has a single leaf, which grows until it becomes a regular one
+		Leaf *leaf = static_cast<Leaf *>(root_);
+		if (leaf->count == leaf->capacity && leaf->capacity < kLeafCapacity) {
+			Leaf *grown = Leaf::create(std::min<uint32_t>(2 * leaf->capacity, kLeafCapacity));
+			Leaf::moveEntries(leaf, 0, grown, 0, leaf->count);
+			grown->count = leaf->count;
+			Leaf::destroy(leaf);
+			root_ = grown;
+		}
+	}
+
+	Split split;
+	auto result = insertInto(root_, height_, key, fingerprint(name_hash), value, split);
+	if (!result.second) {
+		return result;
+	}
+	size_++;
+	if (split.node) {
+		Inner *inner = new Inner;
+		inner->count = 2;
+		inner->children[0] = root_;
+		inner->mins[0] = minKey(root_, height_);
+		inner->sizes[0] = size_ - split.size;
+		inner->children[1] = split.node;
+		inner->mins[1] = split.min;
+		inner->sizes[1] = split.size;
+		root_ = inner;
+		height_++;
+	}
+	return result;
+}
+
+std::pair<DirectoryEntries::iterator, bool> DirectoryEntries::insertInto(void *node,
+		uint32_t height, Key key, uint16_t fp, const value_type &value, Split &split) {
+	if (height == 0) {
+		return insertIntoLeaf(static_cast<Leaf *>(node), key, fp, value, split);
+	}
+
+	Inner *inner = static_cast<Inner *>(node);
+	uint32_t i = std::upper_bound(inner->mins, inner->mins + inner->count, key) - inner->mins;
+	i = i > 0 ? i - 1 : 0;
+	Split child_split;
+	auto result = insertInto(inner->children[i], height - 1, key, fp, value, child_split);
+	if (!result.second) {
+		return result;
+	}
+	inner->sizes[i]++;
+	inner->mins[i] = std::min(inner->mins[i], key);
+	if (child_split.node) {
+		inner->sizes[i] -= child_split.size;
+		insertChild(inner, i + 1, child_split, split);
+	}
+	return result;
+}
+
+std::pair<DirectoryEntries::iterator, bool> DirectoryEntries::insertIntoLeaf(Leaf *leaf, Key key,
+		uint16_t fp, const value_type &value, Split &split) {
+	uint32_t i = std::lower_bound(leaf->keys(), leaf->keys() + leaf->count, key) - leaf->keys();
+	if (i < leaf->count && leaf->keys()[i] == key) {
+		return {iterator(leaf, i), false};
+	}
+
+	Leaf *right = nullptr;
+	if (leaf->count == leaf->capacity) {
+		assert(leaf->capacity == kLeafCapacity);
+		right = Leaf::create(kLeafCapacity);
+		uint32_t half = leaf->count / 2;
+		Leaf::moveEntries(leaf, half, right, 0, leaf->count - half);
+		right->count = leaf->count - half;
+		leaf->count = half;
+		right->next = leaf->next;
+		leaf->next = right;
+		if (i > half) {
+			leaf = right;
+			i -= half;
+		}
+	}
+
+	Leaf::moveEntries(leaf, i, leaf, i + 1, leaf->count - i);
+	leaf->keys()[i] = key;
+	leaf->values()[i] = value;
+	leaf->fingerprints()[i] = fp;
+	leaf->count++;
+
+	if (right) {
+		split.node = right;
+		split.min = right->keys()[0];
+		split.size = right->count;
+	}
+	return {iterator(leaf, i), true};
+}
+
+void DirectoryEntries::insertChild(Inner *inner, uint32_t position, const Split &child,
+		Split &split) {
+	if (inner->count == kInnerCapacity) {
+		Inner *right = new Inner;
+		uint32_t half = inner->count / 2;
+		right->count = inner->count - half;
+		Inner::moveChildren(inner, half, right, 0, right->count);
+		inner->count = half;
+		Split unused;
+		if (position > half) {
+			insertChild(right, position - half, child, unused);
+		} else {
+			insertChild(inner, position, child, unused);
+		}
+		split.node = right;
+		split.min = right->mins[0];
+		split.size = subtreeSize(right, 1);
+		return;
+	}
+
+	Inner::moveChildren(inner, position, inner, position + 1, inner->count - position);
+	inner->children[position] = child.node;
+	inner->mins[position] = child.min;
+	inner->sizes[position] = child.size;
+	inner->count++;
+}
+
+void DirectoryEntries::erase(iterator it) {
+	assert(it != end());
+	eraseFrom(root_, height_, it.leaf_->keys()[it.index_]);
+	size_--;
+	while (height_ > 0 && static_cast<Inner *>(root_)->count == 1) {
+		Inner *inner = static_cast<Inner *>(root_);
+		root_ = inner->children[0];
+		delete inner;
+		height_--;
+	}
+	if (height_ == 0) {
+		shrinkRootLeaf();
+	}
+}
+
+void DirectoryEntries::eraseFrom(void *node, uint32_t height, Key key) {
+	if (height == 0) {
+		Leaf *leaf = static_cast<Leaf *>(node);
+		uint32_t i =
+		    std::lower_bound(leaf->keys(), leaf->keys() + leaf->count, key) - leaf->keys();
+		assert(i < leaf->count && leaf->keys()[i] == key);
+		Leaf::moveEntries(leaf, i + 1, leaf, i, leaf->count - i - 1);
+		leaf->count--;
+		return;
+	}
+
+	Inner *inner = static_cast<Inner *>(node);
+	uint32_t i = std::upper_bound(inner->mins, inner->mins + inner->count, key) - inner->mins;
+	i = i > 0 ? i - 1 : 0;
+	eraseFrom(inner->children[i], height - 1, key);
+	inner->sizes[i]--;
+	if (inner->sizes[i] > 0) {
+		inner->mins[i] = minKey(inner->children[i], height - 1);
+	}
+	rebalance(inner, i, height - 1);
+}
+
+/// Merges a child which became small with its sibling or moves some entries to it from
+/// the sibling, so the nodes stay at least a quarter full and nodes are not split again
+/// right after a merge.
+void DirectoryEntries::rebalance(Inner *parent, uint32_t index, uint32_t child_height) {
+	void *child = parent->children[index];
+	uint32_t count = child_height == 0 ? static_cast<Leaf *>(child)->count
+	                                   : static_cast<Inner *>(child)->count;
+	uint32_t capacity = child_height == 0 ? kLeafCapacity : kInnerCapacity;
+	if (count >= capacity / 4 || parent->count < 2) {
+		return;
+	}
+	uint32_t left = index + 1 < parent->count ? index : index - 1;
+	if (child_height == 0) {
+		rebalanceLeaves(parent, left);
+	} else {
+		rebalanceInners(parent, left);
+	}
+}
+
+void DirectoryEntries::removeChild(Inner *parent, uint32_t index) {
+	Inner::moveChildren(parent, index + 1, parent, index, parent->count - index - 1);
+	parent->count--;
+}
+
+void DirectoryEntries::rebalanceLeaves(Inner *parent, uint32_t left) {
+	Leaf *l = static_cast<Leaf *>(parent->children[left]);
+	Leaf *r = static_cast<Leaf *>(parent->children[left + 1]);
+	uint32_t total = l->count + r->count;
+
+	if (total <= kLeafCapacity * 3 / 4) {
+		Leaf::moveEntries(r, 0, l, l->count, r->count);
+		l->count = total;
+		l->next = r->next;
+		Leaf::destroy(r);
+		removeChild(parent, left + 1);
+		r = nullptr;
+	} else if (l->count > total / 2) {
+		uint32_t moved = l->count - total / 2;
+		Leaf::moveEntries(r, 0, r, moved, r->count);
+		Leaf::moveEntries(l, l->count - moved, r, 0, moved);
+		l->count -= moved;
+		r->count += moved;
+	} else {
+		uint32_t moved = total / 2 - l->count;
+		Leaf::moveEntries(r, 0, l, l->count, moved);
+		Leaf::moveEntries(r, moved, r, 0, r->count - moved);
+		l->count += moved;
+		r->count -= moved;
+	}
+
+	parent->mins[left] = l->keys()[0];
+	parent->sizes[left] = l->count;
+	if (r) {
+		parent->mins[left + 1] = r->keys()[0];
+		parent->sizes[left + 1] = r->count;
+	}
+}
+
+void DirectoryEntries::rebalanceInners(Inner *parent, uint32_t left) {
+	Inner *l = static_cast<Inner *>(parent->children[left]);
+	Inner *r = static_cast<Inner *>(parent->children[left + 1]);
+	uint32_t total = l->count + r->count;
+
+	if (total <= kInnerCapacity * 3 / 4) {
+		Inner::moveChildren(r, 0, l, l->count, r->count);
+		l->count = total;
+		delete r;
+		removeChild(parent, left + 1);
+		r = nullptr;
+	} else if (l->count > total / 2) {
+		uint32_t moved = l->count - total / 2;
+		Inner::moveChildren(r, 0, r, moved, r->count);
+		Inner::moveChildren(l, l->count - moved, r, 0, moved);
+		l->count -= moved;
+		r->count += moved;
+	} else {
+		uint32_t moved = total / 2 - l->count;
+		Inner::moveChildren(r, 0, l, l->count, moved);
+		Inner::moveChildren(r, moved, r, 0, r->count - moved);
+		l->count += moved;
+		r->count -= moved;
+	}
+
+	parent->mins[left] = l->mins[0];
+	parent->sizes[left] = subtreeSize(l, 1);
+	if (r) {
+		parent->mins[left + 1] = r->mins[0];
+		parent->sizes[left + 1] = subtreeSize(r, 1);
+	}
+}
+
+void DirectoryEntries::shrinkRootLeaf() {
+	Leaf *leaf = static_cast<Leaf *>(root_);
+	if (leaf->count == 0) {
+		Leaf::destroy(leaf);
+		root_ = nullptr;
+		return;
+	}
+	if (leaf->count <= leaf->capacity / 4) {
+		Leaf *shrunk = Leaf::create(leaf->capacity / 2);
+		Leaf::moveEntries(leaf, 0, shrunk, 0, leaf->count);
+		shrunk->count = leaf->count;
+		Leaf::destroy(leaf);
+		root_ = shrunk;
+	}
+}
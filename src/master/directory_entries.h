@@ -0,0 +1,219 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+#include "master/hstring.h"
+#include "master/hstring_storage.h"
+
+struct FSNode;
+
+/*! \brief Entries of a directory (name handle + child node), ordered by the handle data.
+ *
+ * The handle data starts with a hash of the name, so this is the order of readdir cookies.
+ * Entries can also be accessed by their position, which older clients use as readdir offsets.
+ *
+ * Entries are kept in sorted arrays. A small directory has a single array which grows with
+ * it. Above kLeafCapacity entries the arrays become leaves of a B+-tree, which inner nodes
+ * keep the smallest key and the number of entries of each subtree. Next to each entry its
+ * handle data and 16 more bits of the name hash are kept, so looking for a name touches a few
+ * contiguous nodes and compares names only when the 32-bit hashes match, even in directories
+ * with millions of entries sharing each 16-bit hash of the handles.
+ *
+ * Handle data has to be unique within the container, which holds as each entry has
+ * its own handle. Inserting and erasing entries invalidates iterators.
+ */
+class DirectoryEntries {
+	struct Leaf;
+
+public:
+	using value_type = std::pair<hstorage::Handle *, FSNode *>;
+	using size_type = std::size_t;
+	using Key = hstorage::Handle::ValueType;
+
+	static constexpr uint32_t kLeafCapacity = 64;
+	static constexpr uint32_t kInnerCapacity = 64;
+
+	class iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = DirectoryEntries::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const value_type *;
+		using reference = const value_type &;
+
+		iterator() = default;
+
+		reference operator*() const;
+		pointer operator->() const {
+			return &operator*();
+		}
+
+		iterator &operator++();
+		iterator operator++(int) {
+			iterator result = *this;
+			++*this;
+			return result;
+		}
+
+		bool operator==(const iterator &other) const {
+			return leaf_ == other.leaf_ && index_ == other.index_;
+		}
+		bool operator!=(const iterator &other) const {
+			return !(*this == other);
+		}
+
+	private:
+		friend class DirectoryEntries;
+
+		iterator(Leaf *leaf, uint32_t index) : leaf_(leaf), index_(index) {
+		}
+
+		Leaf *leaf_ = nullptr;
+		uint32_t index_ = 0;
+	};
+
+	using const_iterator = iterator;
+
+	DirectoryEntries() = default;
+	DirectoryEntries(const DirectoryEntries &) = delete;
+	DirectoryEntries(DirectoryEntries &&other) noexcept;
+	DirectoryEntries &operator=(const DirectoryEntries &) = delete;
+	DirectoryEntries &operator=(DirectoryEntries &&other) noexcept;
+	~DirectoryEntries();
+
+	size_type size() const {
+		return size_;
+	}
+
+	bool empty() const {
+		return size_ == 0;
+	}
+
+	iterator begin() const;
+	iterator end() const {
+		return iterator();
+	}
+
+	/*! \brief Inserts an entry.
+	 *
+	 * \param value Entry to insert.
+	 * \param name_hash HString hash of the name bound to value.first.
+	 * \return Iterator to the entry with the same handle data and whether it was inserted.
+	 */
+	std::pair<iterator, bool> insert(const value_type &value, HString::HashType name_hash);
+
+	/*! \brief Removes the entry pointed by \a it. */
+	void erase(iterator it);
+
+	void clear();
+
+	/*! \brief Returns the first entry which handle data is not less than \a key. */
+	iterator lower_bound(Key key) const;
+
+	/*! \brief Returns the entry with the given name or end(). */
+	iterator find(const HString &name) const;
+
+	/*! \brief Returns the entry at position \a nth or end(). */
+	iterator find_by_order(size_type nth) const;
+
+private:
+	struct Leaf {
+		Leaf *next;
+		uint16_t count;
+		uint16_t capacity;
+
+		// The arrays of keys, values and fingerprints of the given capacity follow the header
+		Key *keys() {
+			return reinterpret_cast<Key *>(this + 1);
+		}
+		value_type *values() {
+			return reinterpret_cast<value_type *>(keys() + capacity);
+		}
+		uint16_t *fingerprints() {
+			return reinterpret_cast<uint16_t *>(values() + capacity);
+		}
+
+		static Leaf *create(uint32_t capacity);
+		static void destroy(Leaf *leaf);
+		/// Moves \a count entries, the ranges may overlap
+		static void moveEntries(Leaf *src, uint32_t from, Leaf *dst, uint32_t to, uint32_t count);
+	};
+
+	struct Inner {
+		uint32_t count;
+		Key mins[kInnerCapacity];        ///< Smallest key in each subtree
+		uint32_t sizes[kInnerCapacity];  ///< Number of entries in each subtree
+		void *children[kInnerCapacity];
+
+		/// Moves \a count children, the ranges may overlap
+		static void moveChildren(Inner *src, uint32_t from, Inner *dst, uint32_t to,
+		                         uint32_t count);
+	};
+
+	/// Node added to the right of a node which was split while inserting.
+	struct Split {
+		void *node = nullptr;
+		Key min = 0;
+		uint32_t size = 0;
+	};
+
+	static uint16_t fingerprint(HString::HashType name_hash) {
+		return name_hash >> 16;
+	}
+
+	static Key minKey(void *node, uint32_t height);
+	static uint32_t subtreeSize(void *node, uint32_t height);
+	static void destroy(void *node, uint32_t height);
+
+	std::pair<iterator, bool> insertIntoLeaf(Leaf *leaf, Key key, uint16_t fp,
+	                                         const value_type &value, Split &split);
+	std::pair<iterator, bool> insertInto(void *node, uint32_t height, Key key, uint16_t fp,
+	                                     const value_type &value, Split &split);
+	void insertChild(Inner *inner, uint32_t position, const Split &child, Split &split);
+
+	void eraseFrom(void *node, uint32_t height, Key key);
+	static void rebalance(Inner *parent, uint32_t index, uint32_t child_height);
+	static void rebalanceLeaves(Inner *parent, uint32_t left);
+	static void rebalanceInners(Inner *parent, uint32_t left);
+	static void removeChild(Inner *parent, uint32_t index);
+	void shrinkRootLeaf();
+
+	void *root_ = nullptr;
+	uint32_t size_ = 0;
+	uint32_t height_ = 0;  ///< Number of inner node levels, 0 if the root is a leaf
+};
+
+inline DirectoryEntries::iterator::reference DirectoryEntries::iterator::operator*() const {
+	return leaf_->values()[index_];
+}
+
+inline DirectoryEntries::iterator &DirectoryEntries::iterator::operator++() {
+	if (++index_ == leaf_->count) {
+		leaf_ = leaf_->next;
+		index_ = 0;
+	}
+	return *this;
+}
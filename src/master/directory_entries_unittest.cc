@@ -0,0 +1,205 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "master/directory_entries.h"
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/time_utils.h"
+#include "master/hstring_memstorage.h"
+
+using namespace hstorage;
+
+namespace {
+
+/// Directory entries together with the handles they point to.
+class TestDirectory {
+public:
+	/// Adds an entry named after the id, unless the directory has it already.
+	bool link(uint32_t id) {
+		if (handles.count(id)) {
+			return false;
+		}
+		HString name(std::to_string(id));
+		auto handle = std::make_unique<Handle>(name);
+		auto result = entries.insert({handle.get(), node(id)}, name.hash());
+		if (result.second) {
+			EXPECT_EQ((*result.first).first, handle.get());
+			expected[handle->data()] = id;
+			handles[id] = std::move(handle);
+		}
+		return result.second;
+	}
+
+	void unlink(uint32_t id) {
+		auto it = entries.find(HString(std::to_string(id)));
+		ASSERT_NE(it, entries.end());
+		expected.erase(it->first->data());
+		entries.erase(it);
+		handles.erase(id);
+	}
+
+	void verify() const {
+		ASSERT_EQ(entries.size(), expected.size());
+		auto it = entries.begin();
+		size_t position = 0;
+		for (const auto &[key, id] : expected) {
+			ASSERT_NE(it, entries.end());
+			EXPECT_EQ(it->first->data(), key);
+			EXPECT_EQ(it->second, node(id));
+			if (position % 97 == 0) {
+				EXPECT_EQ(entries.find_by_order(position), it);
+				EXPECT_EQ(entries.lower_bound(key), it);
+				EXPECT_EQ(entries.find(HString(std::to_string(id))), it);
+			}
+			++it;
+			++position;
+		}
+		EXPECT_EQ(it, entries.end());
+		EXPECT_EQ(entries.find_by_order(position), entries.end());
+	}
+
+	static FSNode *node(uint32_t id) {
+		return reinterpret_cast<FSNode *>(static_cast<uintptr_t>(id) * 8 + 8);
+	}
+
+	DirectoryEntries entries;
+	std::map<DirectoryEntries::Key, uint32_t> expected;
+	std::map<uint32_t, std::unique_ptr<Handle>> handles;
+};
+
+} // anonymous namespace
+
+TEST(DirectoryEntriesTests, SmallDirectory) {
+	Storage::reset(new MemStorage());
+	TestDirectory dir;
+	EXPECT_TRUE(dir.entries.empty());
+	EXPECT_EQ(dir.entries.begin(), dir.entries.end());
+	EXPECT_EQ(dir.entries.find(HString("1")), dir.entries.end());
+
+	for (uint32_t id = 1; id <= 10; ++id) {
+		EXPECT_TRUE(dir.link(id));
+	}
+	dir.verify();
+	EXPECT_EQ(dir.entries.find(HString("11")), dir.entries.end());
+
+	Handle &handle = *dir.handles[3];
+	EXPECT_FALSE(dir.entries.insert({&handle, TestDirectory::node(3)}, HString("3").hash()).second);
+
+	for (uint32_t id = 1; id <= 10; ++id) {
+		dir.unlink(id);
+	}
+	dir.verify();
+	EXPECT_TRUE(dir.entries.empty());
+}
+
+TEST(DirectoryEntriesTests, RandomOperations) {
+	Storage::reset(new MemStorage());
+	TestDirectory dir;
+	std::mt19937 random(1234);
+
+	// Grow to a tree of a few levels, then shrink back, checking on the way
+	for (uint32_t round = 0; round < 4; ++round) {
+		for (uint32_t i = 0; i < 20000; ++i) {
+			dir.link(random() % 50000);
+		}
+		dir.verify();
+		std::vector<uint32_t> ids;
+		for (const auto &[id, handle] : dir.handles) {
+			if (random() % 4 != 0) {
+				ids.push_back(id);
+			}
+		}
+		std::shuffle(ids.begin(), ids.end(), random);
+		for (uint32_t id : ids) {
+			dir.unlink(id);
+		}
+		dir.verify();
+	}
+	std::vector<uint32_t> ids;
+	for (const auto &[id, handle] : dir.handles) {
+		ids.push_back(id);
+	}
+	for (uint32_t id : ids) {
+		dir.unlink(id);
+	}
+	dir.verify();
+	EXPECT_TRUE(dir.entries.empty());
+}
+
+TEST(DirectoryEntriesTests, LowerBoundBetweenKeys) {
+	Storage::reset(new MemStorage());
+	TestDirectory dir;
+	for (uint32_t id = 0; id < 5000; ++id) {
+		dir.link(id);
+	}
+	for (auto it = dir.expected.begin(); it != dir.expected.end(); ++it) {
+		auto next = std::next(it);
+		auto found = dir.entries.lower_bound(it->first + 1);
+		if (next == dir.expected.end()) {
+			EXPECT_EQ(found, dir.entries.end());
+		} else {
+			ASSERT_NE(found, dir.entries.end());
+			EXPECT_EQ(found->first->data(), next->first);
+		}
+	}
+}
+
+TEST(DirectoryEntriesTests, Benchmark) {
+	Storage::reset(new MemStorage());
+	constexpr uint32_t kEntries = 1000000;
+	std::vector<HString> names;
+	std::vector<std::unique_ptr<Handle>> handles;
+	names.reserve(kEntries);
+	handles.reserve(kEntries);
+	for (uint32_t i = 0; i < kEntries; ++i) {
+		names.emplace_back("file_" + std::to_string(i));
+		handles.push_back(std::make_unique<Handle>(names.back()));
+	}
+
+	DirectoryEntries entries;
+	Timer timer;
+	for (uint32_t i = 0; i < kEntries; ++i) {
+		entries.insert({handles[i].get(), TestDirectory::node(i)}, names[i].hash());
+	}
+	int64_t insert_us = timer.lap_us();
+	size_t found = 0;
+	for (uint32_t i = 0; i < kEntries; ++i) {
+		found += entries.find(names[(i * 7919ULL) % kEntries]) != entries.end();
+	}
+	int64_t lookup_us = timer.lap_us();
+	size_t listed = 0;
+	for (auto it = entries.find_by_order(0); it != entries.end(); ++it) {
+		listed += it->second != nullptr;
+	}
+	int64_t readdir_us = timer.lap_us();
+	EXPECT_EQ(found, kEntries);
+	EXPECT_EQ(listed, kEntries);
+
+	std::cout << kEntries << " entries: insert " << insert_us * 1000 / kEntries
+	          << " ns, lookup " << lookup_us * 1000 / kEntries << " ns, readdir "
+	          << readdir_us * 1000 / kEntries << " ns per entry" << std::endl;
+	entries.clear();
+}
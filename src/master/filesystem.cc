@@ -412,6 +412,9 @@ int fs_init(bool doLoad) {
 		}
 	}
 	changelog_init(kChangelogFilename, 0, 50);
+	// Group commit: all the changes made in one iteration of the event loop are
+	// written out together, before any reply to them is sent
+	eventloop_eachloopregister(changelog_flush);
 
 	if (doLoad || (metadataserver::isMaster())) {
 		fs_loadall();
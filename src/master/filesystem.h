@@ -203,6 +203,9 @@ void fs_getdirpath_data(uint32_t inode,uint8_t *buff,uint32_t size);
 uint8_t fs_getrootinode(uint32_t *rootinode,const uint8_t *path);
 uint8_t fs_end_setlength(uint64_t chunkid);
 uint8_t fs_readchunk(uint32_t inode,uint32_t indx,uint64_t *chunkid,uint64_t *length);
+/// Like fs_readchunk, for \a count chunks from \a indx on (fewer if the file has fewer).
+uint8_t fs_readchunks(uint32_t inode, uint32_t indx, uint32_t count,
+		std::vector<uint64_t> &chunkids, uint64_t *length);
 uint8_t fs_writeend(uint32_t inode,uint64_t length,uint64_t chunkid, uint32_t lockid);
 void fs_gettrashtime_store(TrashtimeMap &fileTrashtimes, TrashtimeMap &dirTrashtimes,uint8_t *buff);
 void fs_listxattr_data(void *xanode,uint8_t *xabuff);
@@ -29,6 +29,9 @@
 #include "master/chunks.h"
 #include "master/filesystem_metadata.h"
 #include "master/filesystem_xattr.h"
+#ifndef METARESTORE
+#  include "master/matoclserv.h"
+#endif
 
 static uint64_t fsnodes_checksum(FSNode *node, bool full_update = false) {
 	if (!node) {
@@ -113,17 +116,26 @@ void fsnodes_update_checksum(FSNode *node) {
 	if (gChecksumBackgroundUpdater.isNodeIncluded(node)) {
 		addToChecksum(gChecksumBackgroundUpdater.fsNodesChecksum, node->checksum);
 	}
+#ifndef METARESTORE
+	// Every change of a node passes here, so this is where mounts caching it learn about it
+	if (matoclserv_has_cache_subscribers()) {
+		std::vector<uint32_t> parents;
+		parents.reserve(node->parent.size());
+		for (const auto &parent : node->parent) {
+			parents.push_back(parent.first);
+		}
+		matoclserv_notify_inode_changed(node->id, parents);
+	}
+#endif
 }
 
 static void fsnodes_recalculate_checksum() {
 	gMetadata->fsNodesChecksum = NODECHECKSUMSEED;  // arbitrary number
 	// nodes
-	for (uint32_t i = 0; i < NODEHASHSIZE; i++) {
-		for (FSNode *node = gMetadata->nodehash[i]; node; node = node->next) {
-			node->checksum = fsnodes_checksum(node, true);
-			addToChecksum(gMetadata->fsNodesChecksum, node->checksum);
-		}
-	}
+	gMetadata->node_index.forEach([](FSNode *node) {
+		node->checksum = fsnodes_checksum(node, true);
+		addToChecksum(gMetadata->fsNodesChecksum, node->checksum);
+	});
 }
 
 uint64_t fs_checksum(ChecksumMode mode) {
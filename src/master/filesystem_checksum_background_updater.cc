@@ -58,10 +58,14 @@ void ChecksumBackgroundUpdater::incStep() {
 	position_ = 0;
 }
 
-int32_t ChecksumBackgroundUpdater::getPosition() {
+uint32_t ChecksumBackgroundUpdater::getPosition() {
 	return position_;
 }
 
+void ChecksumBackgroundUpdater::setPosition(uint32_t position) {
+	position_ = position;
+}
+
 void ChecksumBackgroundUpdater::incPosition() {
 	++position_;
 }
@@ -71,7 +75,7 @@ bool ChecksumBackgroundUpdater::isNodeIncluded(FSNode *node) {
 	if (step_ > ChecksumRecalculatingStep::kNodes) {
 		ret = true;
 	}
-	if (step_ == ChecksumRecalculatingStep::kNodes && NODEHASHPOS(node->id) < position_) {
+	if (step_ == ChecksumRecalculatingStep::kNodes && node->id < position_) {
 		ret = true;
 	}
 	if (ret) {
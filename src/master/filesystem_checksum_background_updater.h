@@ -72,7 +72,8 @@ public:
 	// go to next step of recalculating, resets position
 	void incStep();
 
-	int32_t getPosition();
+	uint32_t getPosition();
+	void setPosition(uint32_t position);
 	void incPosition();
 
 	// is node already included in the background checksum?
@@ -119,13 +119,7 @@ void fs_dumpnode(FSNode *f) {
 }
 
 void fs_dumpnodes() {
-	uint32_t i;
-	FSNode *p;
-	for (i = 0; i < NODEHASHSIZE; i++) {
-		for (p = gMetadata->nodehash[i]; p; p = p->next) {
-			fs_dumpnode(p);
-		}
-	}
+	gMetadata->node_index.forEach(fs_dumpnode);
 }
 
 void fs_dumpedgelist(FSNodeDirectory *parent) {
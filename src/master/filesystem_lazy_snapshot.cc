@@ -0,0 +1,250 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "common/platform.h"
+
+#include "master/filesystem_lazy_snapshot.h"
+
+#include <vector>
+
+#include "slogger/slogger.h"
+#include "errors/saunafs_error_codes.h"
+#include "master/filesystem_checksum.h"
+#include "master/filesystem_metadata.h"
+#include "master/filesystem_node.h"
+#include "master/filesystem_operations.h"
+#include "master/snapshot_task.h"
+
+#ifndef METARESTORE
+  #include "common/event_loop.h"
+  #include "master/personality.h"
+#endif
+
+void fsnodes_lazy_snapshot_register(FSNodeDirectory *copy, FSNodeDirectory *source) {
+	LazySnapshots &lazy = gMetadata->lazy_snapshots;
+	assert(lazy.copies.count(copy->id) == 0);
+	assert(lazy.copies.count(source->id) == 0);
+	LazySnapshots::Copy entry{source->id, source->stats};
+	lazy.copies.emplace(copy->id, entry);
+	lazy.sources.emplace(source->id, copy->id);
+	fsnodes_add_stats(copy, &entry.stats);
+}
+
+void fsnodes_lazy_snapshot_unregister(FSNodeDirectory *copy) {
+	LazySnapshots &lazy = gMetadata->lazy_snapshots;
+	auto it = lazy.copies.find(copy->id);
+	if (it == lazy.copies.end()) {
+		return;
+	}
+	statsrecord sr = it->second.stats;
+	auto range = lazy.sources.equal_range(it->second.source);
+	for (auto source_it = range.first; source_it != range.second; ++source_it) {
+		if (source_it->second == copy->id) {
+			lazy.sources.erase(source_it);
+			break;
+		}
+	}
+	lazy.copies.erase(it);
+	fsnodes_sub_stats(copy, &sr);
+}
+
+FSNodeDirectory *fsnodes_lazy_snapshot_source(const FSNodeDirectory *dir) {
+	const LazySnapshots &lazy = gMetadata->lazy_snapshots;
+	if (lazy.empty()) {
+		return nullptr;
+	}
+	auto it = lazy.copies.find(dir->id);
+	if (it == lazy.copies.end()) {
+		return nullptr;
+	}
+	return fsnodes_id_to_node_verify<FSNodeDirectory>(it->second.source);
+}
+
+const FSNodeDirectory *fsnodes_lazy_snapshot_contents(const FSNodeDirectory *dir) {
+	const FSNodeDirectory *source = fsnodes_lazy_snapshot_source(dir);
+	return source ? source : dir;
+}
+
+#ifndef METARESTORE
+
+static bool fsnodes_lazy_snapshot_hooks_active() {
+	const LazySnapshots &lazy = gMetadata->lazy_snapshots;
+	return !lazy.empty() && !lazy.materializing && metadataserver::isMaster();
+}
+
+/*! \brief Copy the entries of the source into a lazy copy.
+ *
+ * The subdirectories of the source become lazy copies themselves, so only one level
+ * of the tree is copied at a time. The mtime of the copy is kept.
+ */
+static void fsnodes_lazy_snapshot_materialize(uint32_t ts, FSNodeDirectory *copy) {
+	LazySnapshots &lazy = gMetadata->lazy_snapshots;
+	FSNodeDirectory *source = fsnodes_lazy_snapshot_source(copy);
+	assert(source);
+	uint32_t mtime = copy->mtime;
+
+	lazy.materializing = true;
+	fsnodes_lazy_snapshot_unregister(copy);
+	fs_changelog(ts, "MATERIALIZE(%" PRIu32 ")", copy->id);
+	for (const auto &entry : source->entries) {
+		HString name = static_cast<HString>(*entry.first);
+		SnapshotTask task({{entry.second->id, name}}, 0, copy->id, 0, 0, 0, true, false,
+		                  false);
+		int status = task.cloneNode(ts);
+		if (status != SAUNAFS_STATUS_OK) {
+			safs_pretty_syslog(LOG_ERR,
+			                   "materializing snapshot: can't copy inode %" PRIu32
+			                   " into inode %" PRIu32 ": %s",
+			                   entry.second->id, copy->id, saunafs_error_string(status));
+			continue;
+		}
+		if (entry.second->type == FSNode::kDirectory) {
+			auto child = static_cast<FSNodeDirectory *>(entry.second);
+			auto child_source = fsnodes_lazy_snapshot_source(child);
+			if (child_source) {
+				child = child_source;
+			}
+			auto child_copy = static_cast<FSNodeDirectory *>(fsnodes_lookup(copy, name));
+			fsnodes_lazy_snapshot_register(child_copy, child);
+			fs_changelog(ts, "LAZYSNAPSHOT(%" PRIu32 ",%" PRIu32 ")", child_copy->id,
+			             child->id);
+		}
+	}
+	if (copy->mtime != mtime) {
+		copy->mtime = mtime;
+		fsnodes_update_ctime(copy, ts);
+		fsnodes_update_checksum(copy);
+		fs_changelog(ts, "ATTR(%" PRIu32 ",%d,%" PRIu32 ",%" PRIu32 ",%" PRIu32 ",%" PRIu32 ")",
+		             copy->id, copy->mode & 07777, copy->uid, copy->gid, copy->atime,
+		             copy->mtime);
+	}
+	lazy.materializing = false;
+}
+
+/*! \brief Materialize the copies of \a dir and of all its ancestors.
+ *
+ * It goes from the root down, as materializing a copy of a directory creates lazy copies
+ * of its subdirectories, one of which may be the next directory on the way to \a dir.
+ */
+static void fsnodes_lazy_snapshot_materialize_copies_of_path(uint32_t ts, FSNodeDirectory *dir) {
+	LazySnapshots &lazy = gMetadata->lazy_snapshots;
+	std::vector<FSNodeDirectory *> path;
+	for (FSNodeDirectory *node = dir;; node = fsnodes_get_first_parent(node)) {
+		path.push_back(node);
+		if (node == gMetadata->root || node->parent.empty()) {
+			break;
+		}
+	}
+	for (auto it = path.rbegin(); it != path.rend(); ++it) {
+		for (auto copy_it = lazy.sources.find((*it)->id); copy_it != lazy.sources.end();
+		     copy_it = lazy.sources.find((*it)->id)) {
+			fsnodes_lazy_snapshot_materialize(
+			    ts, fsnodes_id_to_node_verify<FSNodeDirectory>(copy_it->second));
+		}
+	}
+}
+
+void fsnodes_lazy_snapshot_before_read(FSNodeDirectory *dir) {
+	if (!fsnodes_lazy_snapshot_hooks_active()) {
+		return;
+	}
+	if (gMetadata->lazy_snapshots.copies.count(dir->id) > 0) {
+		fsnodes_lazy_snapshot_materialize(eventloop_time(), dir);
+	}
+}
+
+void fsnodes_lazy_snapshot_before_change(FSNode *node) {
+	if (!fsnodes_lazy_snapshot_hooks_active()) {
+		return;
+	}
+	uint32_t ts = eventloop_time();
+	std::vector<uint32_t> parents;
+	for (const auto &parent : node->parent) {
+		parents.push_back(parent.first);
+	}
+	for (uint32_t parent : parents) {
+		fsnodes_lazy_snapshot_materialize_copies_of_path(
+		    ts, fsnodes_id_to_node_verify<FSNodeDirectory>(parent));
+	}
+}
+
+void fsnodes_lazy_snapshot_before_entries_change(FSNodeDirectory *dir) {
+	if (!fsnodes_lazy_snapshot_hooks_active()) {
+		return;
+	}
+	uint32_t ts = eventloop_time();
+	fsnodes_lazy_snapshot_materialize_copies_of_path(ts, dir);
+	if (gMetadata->lazy_snapshots.copies.count(dir->id) > 0) {
+		fsnodes_lazy_snapshot_materialize(ts, dir);
+	}
+}
+
+#else
+
+void fsnodes_lazy_snapshot_before_read(FSNodeDirectory *) {
+}
+
+void fsnodes_lazy_snapshot_before_change(FSNode *) {
+}
+
+void fsnodes_lazy_snapshot_before_entries_change(FSNodeDirectory *) {
+}
+
+#endif
+
+void fsnodes_lazy_snapshot_forget(FSNodeDirectory *dir) {
+	LazySnapshots &lazy = gMetadata->lazy_snapshots;
+	if (lazy.empty()) {
+		return;
+	}
+	fsnodes_lazy_snapshot_unregister(dir);
+	for (auto it = lazy.sources.find(dir->id); it != lazy.sources.end();
+	     it = lazy.sources.find(dir->id)) {
+		safs_pretty_syslog(LOG_ERR,
+		                   "structure error - removing inode %" PRIu32
+		                   " which is the source of a snapshot (inode: %" PRIu32 ")",
+		                   dir->id, it->second);
+		fsnodes_lazy_snapshot_unregister(
+		    fsnodes_id_to_node_verify<FSNodeDirectory>(it->second));
+	}
+}
+
+void fsnodes_lazy_snapshot_restore_stats() {
+	LazySnapshots &lazy = gMetadata->lazy_snapshots;
+	for (auto it = lazy.copies.begin(); it != lazy.copies.end();) {
+		auto copy = fsnodes_id_to_node<FSNodeDirectory>(it->first);
+		auto source = fsnodes_id_to_node<FSNodeDirectory>(it->second.source);
+		if (!copy || copy->type != FSNode::kDirectory || !source ||
+		    source->type != FSNode::kDirectory) {
+			safs_pretty_syslog(LOG_ERR,
+			                   "loading snapshots: wrong copy %" PRIu32 " of inode %" PRIu32,
+			                   it->first, it->second.source);
+			auto range = lazy.sources.equal_range(it->second.source);
+			for (auto source_it = range.first; source_it != range.second; ++source_it) {
+				if (source_it->second == it->first) {
+					lazy.sources.erase(source_it);
+					break;
+				}
+			}
+			it = lazy.copies.erase(it);
+			continue;
+		}
+		fsnodes_add_stats(copy, &it->second.stats);
+		++it;
+	}
+}
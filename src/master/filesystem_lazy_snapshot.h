@@ -0,0 +1,90 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <unordered_map>
+
+#include "master/filesystem_node_types.h"
+
+/*! \brief Directories of copy-on-write snapshots which were not copied yet.
+ *
+ * A lazy copy is a directory which has no entries of its own, but shows the entries of
+ * its source directory. The master copies (materializes) it one level at a time: the
+ * entries of the source are cloned into the copy and the directories among them become
+ * lazy copies of the source subdirectories. This is done before the source or the copy
+ * is changed and before the entries of the copy are read, so a snapshot of a big tree
+ * costs a single node until somebody looks into it or changes the source.
+ *
+ * The copies keep the stats of their sources (so directory quotas and sizes are right),
+ * all the other counters (nodes, uid/gid quotas) count only the copied part.
+ */
+struct LazySnapshots {
+	struct Copy {
+		uint32_t source;   /*!< Directory whose entries are shown by the copy. */
+		statsrecord stats; /*!< Stats of the source added to the copy. */
+	};
+
+	std::unordered_map<uint32_t, Copy> copies;           /*!< copy -> source */
+	std::unordered_multimap<uint32_t, uint32_t> sources; /*!< source -> copies */
+	bool materializing = false; /*!< Set while a copy is materialized. */
+
+	bool empty() const {
+		return copies.empty();
+	}
+
+	void clear() {
+		copies.clear();
+		sources.clear();
+	}
+};
+
+/*! \brief Make \a copy a lazy copy of \a source, add the stats of the source to it. */
+void fsnodes_lazy_snapshot_register(FSNodeDirectory *copy, FSNodeDirectory *source);
+
+/*! \brief Stop tracking a lazy copy, subtract the stats added to it. */
+void fsnodes_lazy_snapshot_unregister(FSNodeDirectory *copy);
+
+/*! \brief Returns the source of \a dir if it is a lazy copy, nullptr otherwise. */
+FSNodeDirectory *fsnodes_lazy_snapshot_source(const FSNodeDirectory *dir);
+
+/*! \brief Returns the directory whose entries are the entries of \a dir.
+ *
+ * It is the source of a lazy copy and \a dir itself otherwise. It is meant for read-only
+ * walks over a tree, which don't have to materialize the copies.
+ */
+const FSNodeDirectory *fsnodes_lazy_snapshot_contents(const FSNodeDirectory *dir);
+
+/*! \brief Materialize \a dir if it is a lazy copy (before reading its entries). */
+void fsnodes_lazy_snapshot_before_read(FSNodeDirectory *dir);
+
+/*! \brief Materialize the lazy copies containing \a node (before changing it). */
+void fsnodes_lazy_snapshot_before_change(FSNode *node);
+
+/*! \brief Materialize \a dir and the lazy copies containing it (before adding or removing
+ * its entries).
+ */
+void fsnodes_lazy_snapshot_before_entries_change(FSNodeDirectory *dir);
+
+/*! \brief Forget \a dir, which is being removed. */
+void fsnodes_lazy_snapshot_forget(FSNodeDirectory *dir);
+
+/*! \brief Add the stats of the loaded lazy copies, after the whole metadata is loaded. */
+void fsnodes_lazy_snapshot_restore_stats();
@@ -26,7 +26,9 @@
 
 #include "common/special_inode_defs.h"
 #include "master/acl_storage.h"
+#include "master/dense_id_map.h"
 #include "master/filesystem_checksum_background_updater.h"
+#include "master/filesystem_lazy_snapshot.h"
 #include "master/filesystem_node_types.h"
 #include "master/filesystem_xattr.h"
 #include "master/id_pool_detainer.h"
@@ -47,7 +49,7 @@ public:
 	TrashPathContainer trash;
 	ReservedPathContainer reserved;
 	FSNodeDirectory *root;
-	FSNode *nodehash[NODEHASHSIZE];
+	DenseIdMap<uint32_t, FSNode> node_index;
 	TaskManager task_manager;
 	FileLocks flock_locks;
 	FileLocks posix_locks;
@@ -65,6 +67,7 @@ public:
 	uint32_t linknodes;
 
 	QuotaDatabase quota_database;
+	LazySnapshots lazy_snapshots;
 
 	uint64_t fsNodesChecksum;
 	uint64_t xattrChecksum;
@@ -79,7 +82,7 @@ public:
 	      trash{},
 	      reserved{},
 	      root{},
-	      nodehash{},
+	      node_index{},
 	      task_manager{},
 	      flock_locks{},
 	      posix_locks{},
@@ -95,6 +98,7 @@ public:
 	      dirnodes{},
 	      linknodes{},
 	      quota_database{},
+	      lazy_snapshots{},
 	      fsNodesChecksum{},
 	      xattrChecksum{},
 	      quota_checksum{quota_database.checksum()} {
@@ -111,15 +115,9 @@ public:
 			deleteListConnectedUsingNext(xattr_data_hash[i]);
 		}
 
-		// Free memory allocated in nodehash hashmap
-		for (uint32_t i = 0; i < NODEHASHSIZE; ++i) {
-			FSNode *node = nodehash[i];
-			while (node != nullptr) {
-				FSNode *next = node->next;
-				FSNode::destroy(node);
-				node = next;
-			}
-		}
+		// Free memory allocated for nodes
+		node_index.forEach([](FSNode *node) { FSNode::destroy(node); });
+		node_index.clear();
 	}
 
 private:
@@ -39,6 +39,9 @@
 #include "master/filesystem_periodic.h"
 #include "master/filesystem_quota.h"
 #include "master/fs_context.h"
+#ifndef METARESTORE
+#  include "master/matoclserv.h"
+#endif
 
 #ifndef NDEBUG
   #include "master/personality.h"
@@ -324,7 +327,7 @@ FSNodeDirectory *fsnodes_get_first_parent(FSNode *node) {
 	return parent;
 }
 
-static inline void fsnodes_sub_stats(FSNodeDirectory *parent, statsrecord *sr) {
+void fsnodes_sub_stats(FSNodeDirectory *parent, statsrecord *sr) {
 	statsrecord *psr;
 	if (parent) {
 		psr = &parent->stats;
@@ -492,6 +495,11 @@ void fsnodes_fill_attr(const FsContext &context, FSNode *node, FSNode *parent, A
 
 void fsnodes_remove_edge(uint32_t ts, FSNodeDirectory *parent, const HString &name, FSNode *node) {
 	assert(parent);
+#ifndef METARESTORE
+	if (matoclserv_has_cache_subscribers()) {
+		matoclserv_notify_entry_changed(parent->id, name);
+	}
+#endif
 
 	auto dir_it = parent->find(name);
 	assert(dir_it != parent->end());
@@ -551,7 +559,7 @@ void fsnodes_remove_edge(uint32_t ts, FSNodeDirectory *parent, const HString &na
 void fsnodes_link(uint32_t ts, FSNodeDirectory *parent, FSNode *child, const HString &name) {
 	// Needs to be freed in fsnodes_remove_edge
 	hstorage::Handle *handlePtr = new hstorage::Handle(name);
-	parent->entries.insert({handlePtr, child});
+	parent->entries.insert({handlePtr, child}, name.hash());
 	parent->entries_hash ^= name.hash();
 
 	if (parent->case_insensitive) {
@@ -559,11 +567,16 @@ void fsnodes_link(uint32_t ts, FSNodeDirectory *parent, FSNode *child, const HSt
 		// Needs to be freed in fsnodes_remove_edge
 		auto lowercaseHandlePtr =
 		    new hstorage::Handle(std::string(lowerCaseName.c_str()));
-		parent->lowerCaseEntries.insert({lowercaseHandlePtr, child});
+		parent->lowerCaseEntries.insert({lowercaseHandlePtr, child}, lowerCaseName.hash());
 		parent->lowerCaseEntriesHash ^= lowerCaseName.hash();
 	}
 
 	child->parent.push_back({parent->id, handlePtr});
+#ifndef METARESTORE
+	if (matoclserv_has_cache_subscribers()) {
+		matoclserv_notify_entry_changed(parent->id, name);
+	}
+#endif
 
 	if (child->type == FSNode::kDirectory) {
 		parent->nlink++;
@@ -637,9 +650,7 @@ FSNode *fsnodes_create_node(uint32_t ts, FSNodeDirectory *parent, const HString
 	} else {
 		node->gid = gid;
 	}
-	uint32_t nodepos = NODEHASHPOS(node->id);
-	node->next = gMetadata->nodehash[nodepos];
-	gMetadata->nodehash[nodepos] = node;
+	gMetadata->node_index.insert(node->id, node);
 	fsnodes_update_checksum(node);
 	fsnodes_link(ts, parent, node, name);
 	fsnodes_quota_update(node, {{QuotaResource::kInodes, +1}});
@@ -1083,29 +1094,20 @@ void fsnodes_getdir(uint32_t rootinode, uint32_t uid, uint32_t gid, uint32_t aui
 	}
 
 	std::string name;
-	hstorage::Handle first_index(first_entry);
 
 	// We're trying to find the first entry in the directory that has index
-	// equal to first_entry. We don't know the second part of the pair, so we
-	// use kUnknownNode as a placeholder, and it is also the minimum possible.
-	auto pair_to_find = std::make_pair(&first_index, kUnknownNode);
-	auto it = p->entries.lower_bound(pair_to_find);
+	// equal to first_entry.
+	auto it = p->entries.lower_bound(first_entry);
 	if (it != p->entries.end() && (*it).first->data() != first_entry) {
 		// We assume that we received hash that had its most significant bit
 		// stripped so we try new find with this supposedly stripped bit set
 		// again.
-		first_index.unlink();  // do not try to unbind the resource under this
-		                       // possibly-fake handle in destructor
-		first_index = hstorage::Handle(first_entry | SIGN_BIT_64);
-		pair_to_find = std::make_pair(&first_index, kUnknownNode);
-		it = p->entries.lower_bound(pair_to_find);
+		it = p->entries.lower_bound(first_entry | SIGN_BIT_64);
 		if (it != p->entries.end() &&
 		    (*it).first->data() != (first_entry | SIGN_BIT_64)) {
 			it = p->entries.end();
 		}
 	}
-	pair_to_find.first->unlink();
-	first_index.unlink(); // do not try to unbind the resource under this possibly-fake handle in destructor
 	while (it != p->entries.end() && number_of_entries > 0) {
 		name = static_cast<std::string>(*(*it).first);
 		inode = (*it).second->id;
@@ -1279,16 +1281,7 @@ static inline void fsnodes_remove_node(uint32_t ts, FSNode *toremove) {
 	if (!toremove->parent.empty()) {
 		return;
 	}
-	// remove from idhash
-	uint32_t nodepos = NODEHASHPOS(toremove->id);
-	FSNode **ptr = &(gMetadata->nodehash[nodepos]);
-	while (*ptr) {
-		if (*ptr == toremove) {
-			*ptr = toremove->next;
-			break;
-		}
-		ptr = &((*ptr)->next);
-	}
+	gMetadata->node_index.erase(toremove->id);
 	if (gChecksumBackgroundUpdater.isNodeIncluded(toremove)) {
 		removeFromChecksum(gChecksumBackgroundUpdater.fsNodesChecksum, toremove->checksum);
 	}
@@ -1297,6 +1290,7 @@ static inline void fsnodes_remove_node(uint32_t ts, FSNode *toremove) {
 	gMetadata->nodes--;
 	gMetadata->acl_storage.erase(toremove->id);
 	if (toremove->type == FSNode::kDirectory) {
+		fsnodes_lazy_snapshot_forget(static_cast<FSNodeDirectory *>(toremove));
 		gMetadata->dirnodes--;
 	}
 	if (toremove->type == FSNode::kFile || toremove->type == FSNode::kTrash ||
@@ -1492,6 +1486,7 @@ uint8_t fsnodes_undel(uint32_t ts, FSNodeFile *node) {
 				gMetadata->reserved.erase(node->id);
 			}
 
+			fsnodes_lazy_snapshot_before_entries_change(p);
 			node->type = FSNode::kFile;
 			node->ctime = ts;
 			fsnodes_update_checksum(node);
@@ -1511,6 +1506,7 @@ uint8_t fsnodes_undel(uint32_t ts, FSNodeFile *node) {
 				}
 			}
 			if (is_new == 1) {
+				fsnodes_lazy_snapshot_before_entries_change(p);
 				n = fsnodes_create_node(ts, p, name, FSNode::kDirectory, 0755,
 				                        0, 0, 0, 0,
 				                        AclInheritance::kDontInheritAcl);
@@ -1552,7 +1548,8 @@ void fsnodes_getgoal_recursive(FSNode *node, uint8_t gmode, GoalStatistics &fgta
 		}
 		dgtab[node->goal]++;
 		if (gmode == GMODE_RECURSIVE) {
-			const FSNodeDirectory *dir_node = static_cast<const FSNodeDirectory*>(node);
+			const FSNodeDirectory *dir_node = fsnodes_lazy_snapshot_contents(
+			        static_cast<const FSNodeDirectory*>(node));
 			for (const auto &entry : dir_node->entries) {
 				fsnodes_getgoal_recursive(entry.second, gmode, fgtab, dgtab);
 			}
@@ -1568,7 +1565,8 @@ void fsnodes_gettrashtime_recursive(FSNode *node, uint8_t gmode,
 	} else if (node->type == FSNode::kDirectory) {
 		dirTrashtimes[node->trashtime] += 1;
 		if (gmode == GMODE_RECURSIVE) {
-			const FSNodeDirectory *dir_node = static_cast<const FSNodeDirectory*>(node);
+			const FSNodeDirectory *dir_node = fsnodes_lazy_snapshot_contents(
+			        static_cast<const FSNodeDirectory*>(node));
 			for (const auto &entry : dir_node->entries) {
 				fsnodes_gettrashtime_recursive(entry.second, gmode, fileTrashtimes, dirTrashtimes);
 			}
@@ -1585,7 +1583,8 @@ void fsnodes_geteattr_recursive(FSNode *node, uint8_t gmode, uint32_t feattrtab[
 	} else {
 		deattrtab[(node->mode >> 12)]++;
 		if (gmode == GMODE_RECURSIVE) {
-			const FSNodeDirectory *dir_node = static_cast<const FSNodeDirectory*>(node);
+			const FSNodeDirectory *dir_node = fsnodes_lazy_snapshot_contents(
+			        static_cast<const FSNodeDirectory*>(node));
 			for (const auto &entry : dir_node->entries) {
 				fsnodes_geteattr_recursive(entry.second, gmode, feattrtab, deattrtab);
 			}
@@ -1599,6 +1598,7 @@ void fsnodes_setgoal_recursive(FSNode *node, uint32_t ts, uint32_t uid, uint8_t
 
 	if (node->type == FSNode::kFile || node->type == FSNode::kDirectory || node->type == FSNode::kTrash ||
 	    node->type == FSNode::kReserved) {
+		fsnodes_lazy_snapshot_before_change(node);
 		if ((node->mode & (EATTR_NOOWNER << 12)) == 0 && uid != 0 && node->uid != uid) {
 			(*nsinodes)++;
 		} else {
@@ -1617,6 +1617,7 @@ void fsnodes_setgoal_recursive(FSNode *node, uint32_t ts, uint32_t uid, uint8_t
 			}
 		}
 		if (node->type == FSNode::kDirectory && (smode & SMODE_RMASK)) {
+			fsnodes_lazy_snapshot_before_read(static_cast<FSNodeDirectory*>(node));
 			for (const auto &entry : static_cast<const FSNodeDirectory*>(node)->entries) {
 				fsnodes_setgoal_recursive(entry.second, ts, uid, goal, smode, sinodes,
 				                          ncinodes, nsinodes);
@@ -1632,6 +1633,7 @@ void fsnodes_settrashtime_recursive(FSNode *node, uint32_t ts, uint32_t uid, uin
 
 	if (node->type == FSNode::kFile || node->type == FSNode::kDirectory || node->type == FSNode::kTrash ||
 	    node->type == FSNode::kReserved) {
+		fsnodes_lazy_snapshot_before_change(node);
 		if ((node->mode & (EATTR_NOOWNER << 12)) == 0 && uid != 0 && node->uid != uid) {
 			(*nsinodes)++;
 		} else {
@@ -1671,6 +1673,7 @@ void fsnodes_settrashtime_recursive(FSNode *node, uint32_t ts, uint32_t uid, uin
 			}
 		}
 		if (node->type == FSNode::kDirectory && (smode & SMODE_RMASK)) {
+			fsnodes_lazy_snapshot_before_read(static_cast<FSNodeDirectory*>(node));
 			for(const auto &entry : static_cast<const FSNodeDirectory*>(node)->entries) {
 				fsnodes_settrashtime_recursive(entry.second, ts, uid, trashtime, smode,
 				                               sinodes, ncinodes, nsinodes);
@@ -1684,6 +1687,7 @@ void fsnodes_seteattr_recursive(FSNode *node, uint32_t ts, uint32_t uid, uint8_t
 				uint32_t *nsinodes) {
 	uint8_t neweattr, seattr;
 
+	fsnodes_lazy_snapshot_before_change(node);
 	if ((node->mode & (EATTR_NOOWNER << 12)) == 0 && uid != 0 && node->uid != uid) {
 		(*nsinodes)++;
 	} else {
@@ -1717,6 +1721,7 @@ void fsnodes_seteattr_recursive(FSNode *node, uint32_t ts, uint32_t uid, uint8_t
 		}
 	}
 	if (node->type == FSNode::kDirectory && (smode & SMODE_RMASK)) {
+		fsnodes_lazy_snapshot_before_read(static_cast<FSNodeDirectory*>(node));
 		const FSNodeDirectory *dir_node = static_cast<const FSNodeDirectory*>(node);
 		for (const auto &entry : dir_node->entries) {
 			fsnodes_seteattr_recursive(entry.second, ts, uid, eattr, smode, sinodes,
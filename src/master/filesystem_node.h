@@ -39,14 +39,7 @@ inline uint32_t fsnodes_hash(uint32_t parentid, const HString &name) {
 namespace detail {
 
 inline FSNode *fsnodes_id_to_node_internal(uint32_t id) {
-	FSNode *p;
-	uint32_t nodepos = NODEHASHPOS(id);
-	for (p = gMetadata->nodehash[nodepos]; p; p = p->next) {
-		if (p->id == id) {
-			return p;
-		}
-	}
-	return nullptr;
+	return gMetadata->node_index.find(id);
 }
 
 template<class NodeType>
@@ -83,6 +76,7 @@ inline void fsnodes_check_node_type(const FSNodeDevice *node) {
 
 /// searches for an edge with given name (`name`) in given directory (`node`)
 inline FSNode *fsnodes_lookup(FSNodeDirectory *node, const HString &name) {
+	fsnodes_lazy_snapshot_before_read(node);
 	auto it = node->find(name);
 	if (it != node->end()) {
 		return (*it).second;
@@ -153,6 +147,7 @@ FSNode *fsnodes_create_node(uint32_t ts, FSNodeDirectory *node, const HString &n
 			uint8_t copysgid, AclInheritance inheritacl, uint32_t req_inode=0);
 
 void fsnodes_add_stats(FSNodeDirectory *parent, statsrecord *sr);
+void fsnodes_sub_stats(FSNodeDirectory *parent, statsrecord *sr);
 int fsnodes_sticky_access(FSNode *parent, FSNode *node, uint32_t uid);
 void fsnodes_unlink(uint32_t ts, FSNodeDirectory *parent, const HString &node_name, FSNode *node);
 bool fsnodes_isancestor(FSNodeDirectory *f, FSNode *p);
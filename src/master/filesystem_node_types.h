@@ -41,14 +41,9 @@
 #include <map>
 #endif
 
-#include <ext/pb_ds/assoc_container.hpp>
-#include <ext/pb_ds/tree_policy.hpp>
-
+#include "master/directory_entries.h"
 #include "master/hstring_storage.h"
 
-#define NODEHASHBITS (22)
-#define NODEHASHSIZE (1 << NODEHASHBITS)
-#define NODEHASHPOS(nodeid) ((nodeid) & (NODEHASHSIZE - 1))
 #define NODECHECKSUMSEED 12345
 
 #define EDGEHASHBITS (22)
@@ -122,12 +117,10 @@ struct FSNode {
 	               To reduce memory usage ids are stored instead of pointers to
 	               FSNode. */
 
-	FSNode   *next; /*!< Next field used for storing FSNode in hash map. */
 	uint64_t checksum; /*!< Node checksum. */
 
 	FSNode(uint8_t t) {
 		type = t;
-		next = nullptr;
 		checksum = 0;
 	}
 
@@ -145,8 +138,6 @@ struct FSNode {
 	static void destroy(FSNode *node);
 };
 
-constexpr FSNode* kUnknownNode = nullptr;
-
 /*! \brief Node used for storing file object.
  *
  * Node size = 64B + 40B + 8 * chunks_count + 4 * session_count
@@ -197,24 +188,11 @@ struct FSNodeDevice : public FSNode {
 
 /*! \brief Node used for storing directory.
  *
- * Node size = 64 + 56 + 16 * entries_count
- * Avg size (10 files) ~ 280B (28B per file)
+ * Node size = 56 + 96 + 26 * entries_count (plus free space and 16B header per array of entries)
+ * Avg size (10 files) ~ 580B (58B per file)
  */
 struct FSNodeDirectory : public FSNode {
-	struct HandleCompare {
-		bool operator()(const std::pair<hstorage::Handle *, FSNode *> &a,
-		                const std::pair<hstorage::Handle *, FSNode *> &b) const {
-			return std::make_pair(a.first->data(), a.second) <
-			       std::make_pair(b.first->data(), b.second);
-		}
-	};
-
-	using EntriesContainer =
-	    __gnu_pbds::tree<std::pair<hstorage::Handle *, FSNode *>,
-	                     __gnu_pbds::null_type, HandleCompare,
-	                     __gnu_pbds::rb_tree_tag,
-	                     __gnu_pbds::tree_order_statistics_node_update>;
-
+	using EntriesContainer = DirectoryEntries;
 	using iterator = EntriesContainer::iterator;
 	using const_iterator = EntriesContainer::const_iterator;
 
@@ -246,65 +224,20 @@ struct FSNodeDirectory : public FSNode {
 	 *         otherwise entries.end().
 	 */
 	iterator find(const HString& name) {
-		uint64_t name_hash = (hstorage::Handle::HashType)name.hash();
-
 		if (case_insensitive) {
-			HString lowerCaseNameHandle = HString::hstringToLowerCase(name);
-			name_hash = (hstorage::Handle::HashType)lowerCaseNameHandle.hash();
-			auto tmp_handle =
-			    hstorage::Handle(name_hash << hstorage::Handle::kHashShift);
-			auto pair_to_find = std::make_pair(&tmp_handle, kUnknownNode);
-			auto lowerCaseIt = lowerCaseEntries.lower_bound(pair_to_find);
-
-			for (; lowerCaseIt != lowerCaseEntries.end(); ++lowerCaseIt) {
-				if ((*lowerCaseIt).first->hash() != name_hash) {
-					break;
-				}
-				if (*((*lowerCaseIt).first) == lowerCaseNameHandle) {
-					auto it = find((*lowerCaseIt).second);
-					return it;
-				}
-			}
-		} else {
-			auto tmp_handle =
-			    hstorage::Handle(name_hash << hstorage::Handle::kHashShift);
-			auto pair_to_find = std::make_pair(&tmp_handle, kUnknownNode);
-			auto it = entries.lower_bound(pair_to_find);
-
-			for (; it != entries.end(); ++it) {
-				if ((*it).first->hash() != name_hash) {
-					break;
-				}
-				if (*((*it).first) == name) {
-					return it;
-				}
+			auto lowerCaseIt = lowerCaseEntries.find(HString::hstringToLowerCase(name));
+			if (lowerCaseIt != lowerCaseEntries.end()) {
+				return find((*lowerCaseIt).second);
 			}
+			return entries.end();
 		}
-
-		return entries.end();
+		return entries.find(name);
 	}
 
 	iterator find_lowercase_container(const HString &name) {
-		uint64_t name_hash = (hstorage::Handle::HashType)name.hash();
-
 		if (case_insensitive) {
-			HString lowerCaseNameHandle = HString::hstringToLowerCase(name);
-			name_hash = (hstorage::Handle::HashType)lowerCaseNameHandle.hash();
-			auto tmp_handle =
-			    hstorage::Handle(name_hash << hstorage::Handle::kHashShift);
-			auto pair_to_find = std::make_pair(&tmp_handle, kUnknownNode);
-			auto lowerCaseIt = lowerCaseEntries.lower_bound(pair_to_find);
-
-			for (; lowerCaseIt != lowerCaseEntries.end(); ++lowerCaseIt) {
-				if ((*lowerCaseIt).first->hash() != name_hash) {
-					break;
-				}
-				if (*((*lowerCaseIt).first) == lowerCaseNameHandle) {
-					return lowerCaseIt;
-				}
-			}
+			return lowerCaseEntries.find(HString::hstringToLowerCase(name));
 		}
-
 		return lowerCaseEntries.end();
 	}
 
@@ -315,21 +248,7 @@ struct FSNodeDirectory : public FSNode {
 	 *         otherwise entries.end().
 	 */
 	iterator find(const FSNode *node) {
-		HString name = HString(getChildName(node));
-		uint64_t name_hash = (hstorage::Handle::HashType)name.hash();
-		auto tmp_handle =
-		    hstorage::Handle(name_hash << hstorage::Handle::kHashShift);
-		auto pair_to_find = std::make_pair(&tmp_handle, kUnknownNode);
-		auto it = entries.lower_bound(pair_to_find);
-		for (; it != entries.end(); ++it) {
-			if ((*it).first->hash() != name_hash) {
-				break;
-			}
-			if (*((*it).first) == name) {
-				return it;
-			}
-		}
-		return entries.end();
+		return entries.find(HString(getChildName(node)));
 	}
 
 	iterator find_nth(EntriesContainer::size_type nth) {
@@ -45,13 +45,14 @@
 #include "master/task_manager.h"
 #include "protocol/matocl.h"
 
-std::array<uint32_t, FsStats::Size> gFsStatsArray = {{}};
+std::array<std::atomic<uint32_t>, FsStats::Size> gFsStatsArray{};
 
 [[maybe_unused]] static const char kAclXattrs[] = "system.richacl";
 
 void fs_retrieve_stats(std::array<uint32_t, FsStats::Size> &output_stats) {
-	output_stats = gFsStatsArray;
-	gFsStatsArray.fill(0);
+	for (size_t i = 0; i < FsStats::Size; ++i) {
+		output_stats[i] = gFsStatsArray[i].exchange(0);
+	}
 }
 
 static const int kInitialTaskBatchSize = 1000;
@@ -550,6 +551,7 @@ uint8_t fs_try_setlength(const FsContext &context, uint32_t inode, uint8_t opene
 
 	FSNodeFile *node_file = static_cast<FSNodeFile*>(p);
 
+	fsnodes_lazy_snapshot_before_change(p);
 	if (length & SFSCHUNKMASK) {
 		uint32_t indx = (length >> SFSCHUNKBITS);
 		if (indx < node_file->chunks.size()) {
@@ -662,6 +664,7 @@ uint8_t fs_do_setlength(const FsContext &context, uint32_t inode, uint64_t lengt
 		return status;
 	}
 
+	fsnodes_lazy_snapshot_before_change(p);
 	fsnodes_setlength(static_cast<FSNodeFile*>(p), length);
 	fs_changelog(ts, "LENGTH(%" PRIu32 ",%" PRIu64 ")", inode, static_cast<FSNodeFile*>(p)->length);
 	p->mtime = ts;
@@ -718,6 +721,7 @@ uint8_t fs_setattr(const FsContext &context, uint32_t inode, uint8_t setmask, ui
 			return SAUNAFS_ERROR_EPERM;
 		}
 	}
+	fsnodes_lazy_snapshot_before_change(p);
 	// first ignore sugid clears done by kernel
 	if ((setmask & (SET_UID_FLAG | SET_GID_FLAG)) &&
 	    (setmask & SET_MODE_FLAG)) {  // chown+chmod = chown with sugid clears
@@ -914,6 +918,7 @@ uint8_t fs_symlink(const FsContext &context, uint32_t parent, const HString &nam
 	     fsnodes_quota_exceeded_dir(wd, {{QuotaResource::kInodes, 1}}))) {
 		return SAUNAFS_ERROR_QUOTA;
 	}
+	fsnodes_lazy_snapshot_before_entries_change(static_cast<FSNodeDirectory *>(wd));
 	FSNodeSymlink *p = static_cast<FSNodeSymlink *>(fsnodes_create_node(
 	    context.ts(), static_cast<FSNodeDirectory *>(wd), name, FSNode::kSymlink, 0777, 0,
 	    context.uid(), context.gid(), 0, AclInheritance::kDontInheritAcl, *inode));
@@ -981,6 +986,7 @@ uint8_t fs_mknod(const FsContext &context, uint32_t parent, const HString &name,
 	    fsnodes_quota_exceeded_dir(wd, {{QuotaResource::kInodes, 1}})) {
 		return SAUNAFS_ERROR_QUOTA;
 	}
+	fsnodes_lazy_snapshot_before_entries_change(static_cast<FSNodeDirectory *>(wd));
 	static_cast<FSNodeDirectory *>(wd)->case_insensitive =
 	    context.sesflags() & SESFLAG_CASEINSENSITIVE;
 	p = fsnodes_create_node(ts, static_cast<FSNodeDirectory*>(wd), name, type, mode, umask, context.uid(), context.gid(), 0,
@@ -1028,6 +1034,7 @@ uint8_t fs_mkdir(const FsContext &context, uint32_t parent, const HString &name,
 	    fsnodes_quota_exceeded_dir(wd, {{QuotaResource::kInodes, 1}})) {
 		return SAUNAFS_ERROR_QUOTA;
 	}
+	fsnodes_lazy_snapshot_before_entries_change(static_cast<FSNodeDirectory *>(wd));
 	static_cast<FSNodeDirectory *>(wd)->case_insensitive =
 	    context.sesflags() & SESFLAG_CASEINSENSITIVE;
 	p = fsnodes_create_node(ts, static_cast<FSNodeDirectory *>(wd), name, FSNode::kDirectory, mode,
@@ -1105,6 +1112,7 @@ uint8_t fs_unlink(const FsContext &context, uint32_t parent, const HString &name
 	if (child->type == FSNode::kDirectory) {
 		return SAUNAFS_ERROR_EPERM;
 	}
+	fsnodes_lazy_snapshot_before_entries_change(static_cast<FSNodeDirectory*>(wd));
 	fs_changelog(ts, "UNLINK(%" PRIu32 ",%s):%" PRIu32, wd->id,
 	             fsnodes_escape_name(name).c_str(), child->id);
 	fsnodes_unlink(ts, static_cast<FSNodeDirectory*>(wd), name, child);
@@ -1173,6 +1181,7 @@ uint8_t fs_rmdir(const FsContext &context, uint32_t parent, const HString &name)
 	if (child->type != FSNode::kDirectory) {
 		return SAUNAFS_ERROR_ENOTDIR;
 	}
+	fsnodes_lazy_snapshot_before_entries_change(static_cast<FSNodeDirectory*>(child));
 	if (!static_cast<FSNodeDirectory*>(child)->entries.empty()) {
 		return SAUNAFS_ERROR_ENOTEMPTY;
 	}
@@ -1263,6 +1272,12 @@ uint8_t fs_rename(const FsContext &context, uint32_t parent_src, const HString &
 		return SAUNAFS_STATUS_OK;
 	}
 
+	fsnodes_lazy_snapshot_before_entries_change(static_cast<FSNodeDirectory*>(swd));
+	fsnodes_lazy_snapshot_before_entries_change(static_cast<FSNodeDirectory*>(dwd));
+	if (de_child && de_child->type == FSNode::kDirectory) {
+		fsnodes_lazy_snapshot_before_entries_change(static_cast<FSNodeDirectory*>(de_child));
+	}
+
 	if (de_child) {
 		if (de_child->type == FSNode::kDirectory && !static_cast<FSNodeDirectory*>(de_child)->entries.empty()) {
 			return SAUNAFS_ERROR_ENOTEMPTY;
@@ -1340,6 +1355,7 @@ uint8_t fs_link(const FsContext &context, uint32_t inode_src, uint32_t parent_ds
 	if (fsnodes_nameisused(static_cast<FSNodeDirectory*>(dwd), name_dst)) {
 		return SAUNAFS_ERROR_EEXIST;
 	}
+	fsnodes_lazy_snapshot_before_entries_change(static_cast<FSNodeDirectory*>(dwd));
 	fsnodes_link(context.ts(), static_cast<FSNodeDirectory*>(dwd), sp, name_dst);
 	if (inode) {
 		*inode = inode_src;
@@ -1382,6 +1398,7 @@ uint8_t fs_append(const FsContext &context, uint32_t inode, uint32_t inode_src)
 	if (context.isPersonalityMaster() && fsnodes_quota_exceeded(p, {{QuotaResource::kSize, 1}})) {
 		return SAUNAFS_ERROR_QUOTA;
 	}
+	fsnodes_lazy_snapshot_before_change(p);
 	status = fsnodes_appendchunks(context.ts(), static_cast<FSNodeFile*>(p), static_cast<FSNodeFile*>(sp));
 	if (status != SAUNAFS_STATUS_OK) {
 		return status;
@@ -1695,16 +1712,21 @@ uint8_t fs_readdir_size(const FsContext &context, uint32_t inode, uint8_t flags,
 		return status;
 	}
 
+	fsnodes_lazy_snapshot_before_read(static_cast<FSNodeDirectory*>(p));
 	*dnode = p;
 	*dbuffsize = fsnodes_getdirsize(static_cast<FSNodeDirectory*>(p), flags & GETDIR_FLAG_WITHATTR);
 	return SAUNAFS_STATUS_OK;
 }
 
 void fs_readdir_data(const FsContext &context, uint8_t flags, void *dnode, uint8_t *dbuff) {
-	uint32_t ts = eventloop_time();
-	ChecksumUpdater cu(ts);
 	FSNode *p = (FSNode *)dnode;
-	fs_update_atime(p, ts);
+	// Without atime updates, reading a directory does not modify the metadata
+	// and may be run by the metadata reader threads (see matoclserv)
+	if (!gAtimeDisabled) {
+		uint32_t ts = eventloop_time();
+		ChecksumUpdater cu(ts);
+		fs_update_atime(p, ts);
+	}
 	fsnodes_getdirdata(context.rootinode(), context.uid(), context.gid(), context.auid(), context.agid(),
 					   context.sesflags(), static_cast<FSNodeDirectory*>(p), dbuff,
 	                   flags & GETDIR_FLAG_WITHATTR);
@@ -1726,10 +1748,13 @@ uint8_t fs_readdir(const FsContext &context, uint32_t inode, uint64_t first_entr
 		return status;
 	}
 
-	uint32_t ts = eventloop_time();
-	ChecksumUpdater cu(ts);
-
-	fs_update_atime(dir, ts);
+	fsnodes_lazy_snapshot_before_read(static_cast<FSNodeDirectory*>(dir));
+	// See fs_readdir_data
+	if (!gAtimeDisabled) {
+		uint32_t ts = eventloop_time();
+		ChecksumUpdater cu(ts);
+		fs_update_atime(dir, ts);
+	}
 
 	using legacy::fsnodes_getdir;
 	fsnodes_getdir(context.rootinode(),
@@ -1925,6 +1950,43 @@ uint8_t fs_readchunk(uint32_t inode, uint32_t indx, uint64_t *chunkid, uint64_t
 	++gFsStatsArray[FsStats::Read];
 	return SAUNAFS_STATUS_OK;
 }
+
+uint8_t fs_readchunks(uint32_t inode, uint32_t indx, uint32_t count,
+		std::vector<uint64_t> &chunkids, uint64_t *length) {
+	uint32_t ts = eventloop_time();
+	ChecksumUpdater cu(ts);
+	FSNodeFile *p;
+
+	chunkids.clear();
+	*length = 0;
+	p = fsnodes_id_to_node<FSNodeFile>(inode);
+	if (!p) {
+		return SAUNAFS_ERROR_ENOENT;
+	}
+	if (p->type != FSNode::kFile && p->type != FSNode::kTrash && p->type != FSNode::kReserved) {
+		return SAUNAFS_ERROR_EPERM;
+	}
+	if (indx > MAX_INDEX) {
+		return SAUNAFS_ERROR_INDEXTOOBIG;
+	}
+	uint32_t end = std::min<uint64_t>(static_cast<uint64_t>(indx) + count, static_cast<uint64_t>(MAX_INDEX) + 1);
+	end = std::min<uint32_t>(end, p->chunks.size());
+#ifndef METARESTORE
+	if (gMagicAutoFileRepair) {
+		for (uint32_t i = indx; i < end; ++i) {
+			fs_auto_repair_if_needed(p, i);
+		}
+		end = std::min<uint32_t>(end, p->chunks.size());
+	}
+#endif
+	for (uint32_t i = indx; i < end; ++i) {
+		chunkids.push_back(p->chunks[i]);
+	}
+	*length = p->length;
+	fs_update_atime(p, ts);
+	++gFsStatsArray[FsStats::Read];
+	return SAUNAFS_STATUS_OK;
+}
 #endif
 
 uint8_t fs_writechunk(const FsContext &context, uint32_t inode, uint32_t indx, bool usedummylockid,
@@ -1948,6 +2010,7 @@ uint8_t fs_writechunk(const FsContext &context, uint32_t inode, uint32_t indx, b
 	if (indx > MAX_INDEX) {
 		return SAUNAFS_ERROR_INDEXTOOBIG;
 	}
+	fsnodes_lazy_snapshot_before_change(p);
 #ifndef METARESTORE
 	if (gMagicAutoFileRepair && context.isPersonalityMaster()) {
 		fs_auto_repair_if_needed(p, indx);
@@ -2045,6 +2108,7 @@ uint8_t fs_writeend(uint32_t inode, uint64_t length, uint64_t chunkid, uint32_t
 			return SAUNAFS_ERROR_EPERM;
 		}
 		if (length > p->length) {
+			fsnodes_lazy_snapshot_before_change(p);
 			fsnodes_setlength(p, length);
 			p->mtime = ts;
 			fsnodes_update_ctime(p, ts);
@@ -2093,6 +2157,7 @@ uint8_t fs_repair(const FsContext &context, uint32_t inode,
 	}
 
 	FSNodeFile *node_file = static_cast<FSNodeFile*>(p);
+	fsnodes_lazy_snapshot_before_change(p);
 	fsnodes_get_stats(p, &psr);
 	for (indx = 0; indx < node_file->chunks.size(); indx++) {
 		if (chunk_repair(p->goal, node_file->chunks[indx], &nversion, correct_only)) {
@@ -2659,6 +2724,7 @@ uint8_t fs_deleteacl(const FsContext &context, uint32_t inode, AclType type) {
 	if (status != SAUNAFS_STATUS_OK) {
 		return status;
 	}
+	fsnodes_lazy_snapshot_before_change(p);
 	status = fsnodes_deleteacl(p, type, context.ts());
 	if (context.isPersonalityMaster()) {
 		if (status == SAUNAFS_STATUS_OK) {
@@ -2691,6 +2757,7 @@ uint8_t fs_setacl(const FsContext &context, uint32_t inode, const RichACL &acl)
 		return status;
 	}
 	std::string acl_string = acl.toString();
+	fsnodes_lazy_snapshot_before_change(p);
 	status = fsnodes_setacl(p, acl, context.ts());
 	if (context.isPersonalityMaster()) {
 		if (status == SAUNAFS_STATUS_OK) {
@@ -2715,6 +2782,7 @@ uint8_t fs_setacl(const FsContext &context, uint32_t inode, AclType type, const
 		return status;
 	}
 	std::string acl_string = acl.toString();
+	fsnodes_lazy_snapshot_before_change(p);
 	status = fsnodes_setacl(p, type, acl, context.ts());
 	if (context.isPersonalityMaster()) {
 		if (status == SAUNAFS_STATUS_OK) {
@@ -2889,19 +2957,16 @@ uint8_t fs_get_chunkid(const FsContext &context, uint32_t inode, uint32_t index,
 #endif
 
 void fs_add_files_to_chunks() {
-	FSNode *f;
-	for (uint32_t i = 0; i < NODEHASHSIZE; i++) {
-		for (f = gMetadata->nodehash[i]; f; f = f->next) {
-			if (f->type == FSNode::kFile || f->type == FSNode::kTrash ||
-			    f->type == FSNode::kReserved) {
-				for (const auto &chunkid : static_cast<FSNodeFile*>(f)->chunks) {
-					if (chunkid > 0) {
-						chunk_add_file(chunkid, f->goal);
-					}
+	gMetadata->node_index.forEach([](FSNode *f) {
+		if (f->type == FSNode::kFile || f->type == FSNode::kTrash ||
+		    f->type == FSNode::kReserved) {
+			for (const auto &chunkid : static_cast<FSNodeFile*>(f)->chunks) {
+				if (chunkid > 0) {
+					chunk_add_file(chunkid, f->goal);
 				}
 			}
 		}
-	}
+	});
 }
 
 uint64_t fs_getversion() {
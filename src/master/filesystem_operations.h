@@ -22,6 +22,8 @@
 
 #include "common/platform.h"
 
+#include <array>
+#include <atomic>
 #include <map>
 
 #include "common/goal.h"
@@ -54,7 +56,8 @@ enum {
 };
 }
 
-extern std::array<uint32_t, FsStats::Size> gFsStatsArray;
+// Atomic, as the read-only operations may be run by the metadata reader threads
+extern std::array<std::atomic<uint32_t>, FsStats::Size> gFsStatsArray;
 
 void fs_retrieve_stats(std::array<uint32_t, FsStats::Size> &output_stats);
 
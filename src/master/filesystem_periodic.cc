@@ -64,8 +64,8 @@ static uint32_t fsinfo_unavailreservedfiles = 0;
 static int gTasksBatchSize = 1000;
 
 static int gFileTestLoopTime = 300;
-static int gFileTestLoopIndex = 0;
-static unsigned gFileTestLoopBucketLimit = 0;
+static uint64_t gFileTestLoopIndex = 0;
+static unsigned gFileTestLoopNodeLimit = 0;
 
 enum NodeErrorFlag {
 	kChunkUnavailable = 1,
@@ -273,22 +273,21 @@ void fs_background_checksum_recalculation_a_bit() {
 	case ChecksumRecalculatingStep::kNone:  // Recalculation not in progress.
 		return;
 	case ChecksumRecalculatingStep::kNodes:
-		// Nodes are in a hashtable, therefore they can be recalculated in multiple steps.
-		while (gChecksumBackgroundUpdater.getPosition() < NODEHASHSIZE) {
-			for (FSNode *node =
-			             gMetadata->nodehash[gChecksumBackgroundUpdater.getPosition()];
-			     node; node = node->next) {
-				fsnodes_checksum_add_to_background(node);
-				++recalculated;
+		// Nodes are indexed by id, therefore they can be recalculated in multiple steps.
+		while (true) {
+			const auto &nodeIndex = gMetadata->node_index;
+			uint64_t id = nodeIndex.nextId(gChecksumBackgroundUpdater.getPosition());
+			if (id >= nodeIndex.idLimit()) {
+				gChecksumBackgroundUpdater.incStep();
+				break;
 			}
-			gChecksumBackgroundUpdater.incPosition();
+			fsnodes_checksum_add_to_background(nodeIndex.find(id));
+			++recalculated;
+			gChecksumBackgroundUpdater.setPosition(id + 1);
 			if (recalculated >= gChecksumBackgroundUpdater.getSpeedLimit()) {
 				break;
 			}
 		}
-		if (gChecksumBackgroundUpdater.getPosition() == NODEHASHSIZE) {
-			gChecksumBackgroundUpdater.incStep();
-		}
 		break;
 	case ChecksumRecalculatingStep::kXattrs:
 		// Xattrs are in a hashtable, therefore they can be recalculated in multiple steps.
@@ -372,142 +371,147 @@ void fs_process_file_test() {
 	}
 
 	watchdog.start();
-	for (k = 0; k < gFileTestLoopBucketLimit && gFileTestLoopIndex < NODEHASHSIZE;
-	     k++, gFileTestLoopIndex++) {
+	const auto &nodeIndex = gMetadata->node_index;
+	for (k = 0; k < gFileTestLoopNodeLimit; k++) {
 		if (k > 0 && watchdog.expired()) {
-			gFileTestLoopBucketLimit -= k;
+			gFileTestLoopNodeLimit -= k;
 			return;
 		}
 
-		for (f = gMetadata->nodehash[gFileTestLoopIndex]; f; f = f->next) {
-			node_error_flag = 0;
+		uint64_t id = nodeIndex.nextId(gFileTestLoopIndex);
+		if (id >= nodeIndex.idLimit()) {
+			// The loop is done, the next one starts with the next period
+			gFileTestLoopIndex = 0;
+			gFileTestLoopNodeLimit = 0;
+			return;
+		}
+		gFileTestLoopIndex = id + 1;
 
-			if (f->type == FSNode::kFile || f->type == FSNode::kTrash ||
-			    f->type == FSNode::kReserved) {
-				for (const auto &chunkid : static_cast<FSNodeFile *>(f)->chunks) {
-					if (chunkid == 0) {
-						continue;
-					}
+		f = nodeIndex.find(id);
+		node_error_flag = 0;
 
-					if (chunk_get_fullcopies(chunkid, &vc) !=
-					    SAUNAFS_STATUS_OK) {
-						node_error_flag |=
-						        static_cast<int>(kChunkUnavailable);
-						notfoundchunks++;
-						mchunks++;
-					} else if (vc == 0) {
+		if (f->type == FSNode::kFile || f->type == FSNode::kTrash ||
+		    f->type == FSNode::kReserved) {
+			for (const auto &chunkid : static_cast<FSNodeFile *>(f)->chunks) {
+				if (chunkid == 0) {
+					continue;
+				}
+
+				if (chunk_get_fullcopies(chunkid, &vc) !=
+				    SAUNAFS_STATUS_OK) {
+					node_error_flag |=
+					        static_cast<int>(kChunkUnavailable);
+					notfoundchunks++;
+					mchunks++;
+				} else if (vc == 0) {
+					node_error_flag |=
+					        static_cast<int>(kChunkUnavailable);
+					unavailchunks++;
+					mchunks++;
+				} else {
+					int recover, remove;
+					chunk_get_partstomodify(chunkid, recover, remove);
+					if (recover > 0) {
 						node_error_flag |=
-						        static_cast<int>(kChunkUnavailable);
-						unavailchunks++;
-						mchunks++;
-					} else {
-						int recover, remove;
-						chunk_get_partstomodify(chunkid, recover, remove);
-						if (recover > 0) {
-							node_error_flag |=
-							        static_cast<int>(kChunkUnderGoal);
-							ugchunks++;
-						}
+						        static_cast<int>(kChunkUnderGoal);
+						ugchunks++;
 					}
-					chunks++;
 				}
+				chunks++;
 			}
+		}
 
-			if (f->type == FSNode::kDirectory) {
-				for (const auto &entry :
-				     static_cast<FSNodeDirectory *>(f)->entries) {
-					FSNode *node = entry.second;
+		if (f->type == FSNode::kDirectory) {
+			for (const auto &entry :
+			     static_cast<FSNodeDirectory *>(f)->entries) {
+				FSNode *node = entry.second;
 
-					if (!node) {
-						// the node points to invalid memory
+				if (!node) {
+					// the node points to invalid memory
+					node_error_flag |=
+					        static_cast<int>(kStructureError);
+				} else {
+					auto parentInChildPtr = std::find_if(
+					    node->parent.begin(), node->parent.end(),
+					    [f](const std::pair<uint32_t,
+					                        const hstorage::Handle *> &p) {
+						    return p.first == f->id;
+					    });
+					// the node doesn't have a parent entry pointing to the
+					// current directory
+					if (parentInChildPtr == node->parent.end()) {
 						node_error_flag |=
-						        static_cast<int>(kStructureError);
-					} else {
-						auto parentInChildPtr = std::find_if(
-						    node->parent.begin(), node->parent.end(),
-						    [f](const std::pair<uint32_t,
-						                        const hstorage::Handle *> &p) {
-							    return p.first == f->id;
-						    });
-						// the node doesn't have a parent entry pointing to the
-						// current directory
-						if (parentInChildPtr == node->parent.end()) {
-							node_error_flag |=
-							    static_cast<int>(kStructureError);
-						}
+						    static_cast<int>(kStructureError);
 					}
 				}
 			}
+		}
 
-			if (node_error_flag == 0) {
-				auto it = gDefectiveNodes.find(f->id);
-				if (it != gDefectiveNodes.end()) {
-					gDefectiveNodes.erase(it);
-				}
-				continue;
+		if (node_error_flag == 0) {
+			auto it = gDefectiveNodes.find(f->id);
+			if (it != gDefectiveNodes.end()) {
+				gDefectiveNodes.erase(it);
 			}
+			continue;
+		}
 
-			if (node_error_flag & kChunkUnavailable) {
-				if (f->type == FSNode::kTrash) {
-					unavailtrashfiles++;
-				} else if (f->type == FSNode::kReserved) {
-					unavailreservedfiles++;
-				} else {
-					unavailfiles += f->parent.size();
-				}
-
-				auto it = gDefectiveNodes.find(f->id);
-				if (it == gDefectiveNodes.end()) {
-					std::string name = get_node_info(f);
-					safs_pretty_syslog(LOG_ERR, "Chunks unavailable in %s",
-					                   name.c_str());
-				}
+		if (node_error_flag & kChunkUnavailable) {
+			if (f->type == FSNode::kTrash) {
+				unavailtrashfiles++;
+			} else if (f->type == FSNode::kReserved) {
+				unavailreservedfiles++;
+			} else {
+				unavailfiles += f->parent.size();
 			}
-			if (node_error_flag & kChunkUnderGoal) {
-				ugfiles++;
+
+			auto it = gDefectiveNodes.find(f->id);
+			if (it == gDefectiveNodes.end()) {
+				std::string name = get_node_info(f);
+				safs_pretty_syslog(LOG_ERR, "Chunks unavailable in %s",
+				                   name.c_str());
 			}
-			if (node_error_flag & kStructureError) {
-				auto it = gDefectiveNodes.find(f->id);
-				if (it == gDefectiveNodes.end()) {
-					std::string name = get_node_info(f);
-					safs_pretty_syslog(LOG_ERR, "Structure error in %s",
-					                   name.c_str());
-				}
+		}
+		if (node_error_flag & kChunkUnderGoal) {
+			ugfiles++;
+		}
+		if (node_error_flag & kStructureError) {
+			auto it = gDefectiveNodes.find(f->id);
+			if (it == gDefectiveNodes.end()) {
+				std::string name = get_node_info(f);
+				safs_pretty_syslog(LOG_ERR, "Structure error in %s",
+				                   name.c_str());
 			}
+		}
 
-			if (gDefectiveNodes.size() < kMaxNodeEntries) {
-				gDefectiveNodes[f->id] = node_error_flag;
-			} else {
-				auto it = gDefectiveNodes.find(f->id);
-				if (it != gDefectiveNodes.end()) {
-					(*it).second = node_error_flag;
-				}
+		if (gDefectiveNodes.size() < kMaxNodeEntries) {
+			gDefectiveNodes[f->id] = node_error_flag;
+		} else {
+			auto it = gDefectiveNodes.find(f->id);
+			if (it != gDefectiveNodes.end()) {
+				(*it).second = node_error_flag;
 			}
 		}
 	}
 
-	gFileTestLoopBucketLimit -= k;
-	if (gFileTestLoopIndex >= NODEHASHSIZE) {
-		gFileTestLoopIndex = 0;
-	}
+	gFileTestLoopNodeLimit -= k;
 }
 
 void fs_periodic_file_test() {
 	if (eventloop_time() <= gTestStartTime) {
-		gFileTestLoopBucketLimit = 0;
+		gFileTestLoopNodeLimit = 0;
 		return;
 	}
 
-	if (gFileTestLoopBucketLimit == 0) {
-		gFileTestLoopBucketLimit = NODEHASHSIZE / gFileTestLoopTime;
+	if (gFileTestLoopNodeLimit == 0) {
+		gFileTestLoopNodeLimit = gMetadata->nodes / gFileTestLoopTime + 1;
 		fs_process_file_test();
 	}
 }
 
 void fs_background_file_test(void) {
-	if (gFileTestLoopBucketLimit > 0) {
+	if (gFileTestLoopNodeLimit > 0) {
 		fs_process_file_test();
-		if (gFileTestLoopBucketLimit > 0) {
+		if (gFileTestLoopNodeLimit > 0) {
 			eventloop_make_next_poll_nonblocking();
 		}
 	}
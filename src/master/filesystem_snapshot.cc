@@ -23,15 +23,48 @@
 #include "master/filesystem_checksum_updater.h"
 #include "master/filesystem_metadata.h"
 #include "master/filesystem_node.h"
+#include "master/filesystem_operations.h"
+#include "master/filesystem_quota.h"
 #include "master/snapshot_task.h"
 #include "master/task_manager.h"
 
 static uint32_t gInitialSnapshotTaskBatch;
 static uint32_t gSnapshotTaskBatchLimit;
+static bool gSnapshotCopyOnWrite;
 
 void fs_read_snapshot_config_file() {
 	gInitialSnapshotTaskBatch = cfg_getuint32("SNAPSHOT_INITIAL_BATCH_SIZE", 1000);
 	gSnapshotTaskBatchLimit = cfg_getuint32("SNAPSHOT_INITIAL_BATCH_SIZE_LIMIT", 10000);
+	gSnapshotCopyOnWrite = cfg_getuint32("SNAPSHOT_COPY_ON_WRITE", 0);
+}
+
+/*! \brief Snapshot a directory by creating a lazy copy of it.
+ *
+ * Only the top directory is created, its contents are copied later, when the source or
+ * the copy is changed (see filesystem_lazy_snapshot.h).
+ */
+static uint8_t fs_lazy_snapshot(uint32_t ts, FSNodeDirectory *src_node,
+                                FSNodeDirectory *dst_parent, const HString &name_dst) {
+	if (fsnodes_quota_exceeded_ug(src_node, {{QuotaResource::kInodes, 1}}) ||
+	    fsnodes_quota_exceeded_dir(dst_parent,
+	                               {{QuotaResource::kInodes, src_node->stats.inodes + 1},
+	                                {QuotaResource::kSize, (int64_t)src_node->stats.size}})) {
+		return SAUNAFS_ERROR_QUOTA;
+	}
+	SnapshotTask task({{src_node->id, name_dst}}, src_node->id, dst_parent->id, 0, 0, 0, true,
+	                  false, false);
+	uint8_t status = task.cloneNode(ts);
+	if (status != SAUNAFS_STATUS_OK) {
+		return status;
+	}
+	auto copy = static_cast<FSNodeDirectory *>(fsnodes_lookup(dst_parent, name_dst));
+	FSNodeDirectory *source = fsnodes_lazy_snapshot_source(src_node);
+	if (!source) {
+		source = src_node;
+	}
+	fsnodes_lazy_snapshot_register(copy, source);
+	fs_changelog(ts, "LAZYSNAPSHOT(%" PRIu32 ",%" PRIu32 ")", copy->id, source->id);
+	return SAUNAFS_STATUS_OK;
 }
 
 uint8_t fs_snapshot(const FsContext &context, uint32_t inode_src, uint32_t parent_dst,
@@ -63,6 +96,12 @@ uint8_t fs_snapshot(const FsContext &context, uint32_t inode_src, uint32_t paren
 
 	assert(context.isPersonalityMaster());
 
+	if (gSnapshotCopyOnWrite && src_node->type == FSNode::kDirectory &&
+	    !fsnodes_lookup(static_cast<FSNodeDirectory *>(dst_parent_node), name_dst)) {
+		return fs_lazy_snapshot(context.ts(), static_cast<FSNodeDirectory *>(src_node),
+		                        static_cast<FSNodeDirectory *>(dst_parent_node), name_dst);
+	}
+
 	auto task = new SnapshotTask({{src_node->id, name_dst}}, src_node->id,
 	                                   static_cast<FSNodeDirectory *>(dst_parent_node)->id,
 	                                   0, can_overwrite, ignore_missing_src, true, true);
@@ -90,7 +129,38 @@ uint8_t fs_clone_node(const FsContext &context, uint32_t inode_src, uint32_t par
 			uint32_t inode_dst, const HString &name_dst, uint8_t can_overwrite) {
 
 	SnapshotTask task({{inode_src, name_dst}}, 0, parent_dst, inode_dst, can_overwrite,
-			  0, false, false);
+			  0, false, false, false);
 
 	return task.cloneNode(context.ts());
 }
+
+uint8_t fs_apply_lazysnapshot(uint32_t inode, uint32_t inode_src) {
+	FSNodeDirectory *copy = fsnodes_id_to_node<FSNodeDirectory>(inode);
+	FSNodeDirectory *source = fsnodes_id_to_node<FSNodeDirectory>(inode_src);
+	if (!copy || !source) {
+		return SAUNAFS_ERROR_ENOENT;
+	}
+	if (copy->type != FSNode::kDirectory || source->type != FSNode::kDirectory) {
+		return SAUNAFS_ERROR_ENOTDIR;
+	}
+	if (!copy->entries.empty() || fsnodes_lazy_snapshot_source(copy) ||
+	    fsnodes_lazy_snapshot_source(source)) {
+		return SAUNAFS_ERROR_EINVAL;
+	}
+	fsnodes_lazy_snapshot_register(copy, source);
+	gMetadata->metaversion++;
+	return SAUNAFS_STATUS_OK;
+}
+
+uint8_t fs_apply_materialize(uint32_t inode) {
+	FSNodeDirectory *copy = fsnodes_id_to_node<FSNodeDirectory>(inode);
+	if (!copy) {
+		return SAUNAFS_ERROR_ENOENT;
+	}
+	if (copy->type != FSNode::kDirectory || !fsnodes_lazy_snapshot_source(copy)) {
+		return SAUNAFS_ERROR_EINVAL;
+	}
+	fsnodes_lazy_snapshot_unregister(copy);
+	gMetadata->metaversion++;
+	return SAUNAFS_STATUS_OK;
+}
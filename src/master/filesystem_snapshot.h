@@ -52,3 +52,16 @@ uint8_t fs_snapshot(const FsContext &context, uint32_t inode_src, uint32_t paren
 uint8_t fs_clone_node(const FsContext &context, uint32_t inode_src, uint32_t parent_dst,
 		uint32_t inode_dst, const HString &name_dst,
 		uint8_t can_overwrite);
+
+/*! \brief Make a directory a lazy copy of another one (see filesystem_lazy_snapshot.h).
+ *
+ * \param inode number of inode of the (empty) copy.
+ * \param inode_src number of inode of the directory whose entries the copy shows.
+ */
+uint8_t fs_apply_lazysnapshot(uint32_t inode, uint32_t inode_src);
+
+/*! \brief Stop treating a directory as a lazy copy, its entries are cloned next.
+ *
+ * \param inode number of inode of the copy.
+ */
+uint8_t fs_apply_materialize(uint32_t inode);
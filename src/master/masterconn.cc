@@ -1215,7 +1215,6 @@ int masterconn_init(void) {
 
 #ifdef METALOGGER
 	changelog_init(kChangelogMlFilename, 5, 1000); // may throw
-	changelog_disable_flush(); // metalogger does it once a second
 	uint32_t metadataDownloadFreq;
 	metadataDownloadFreq = cfg_getuint32("META_DOWNLOAD_FREQ",24);
 	if (metadataDownloadFreq > (changelog_get_back_logs_config_value() / 2)) {
@@ -39,6 +39,8 @@
 #include <cstdint>
 #include <fstream>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "common/charts.h"
 #include "common/chunk_type_with_address.h"
@@ -72,6 +74,7 @@
 #include "master/datacachemgr.h"
 #include "master/exports.h"
 #include "master/filesystem.h"
+#include "master/filesystem_metadata.h"
 #include "master/filesystem_node.h"
 #include "master/filesystem_operations.h"
 #include "master/filesystem_periodic.h"
@@ -81,7 +84,9 @@
 #include "master/matomlserv.h"
 #include "master/metadata_backend_common.h"
 #include "master/metadata_backend_interface.h"
+#include "master/metadata_reader_pool.h"
 #include "master/personality.h"
+#include "master/session_cache_tracker.h"
 #include "master/settrashtime_task.h"
 #include "metrics/metrics.h"
 #include "protocol/SFSCommunication.h"
@@ -152,6 +157,9 @@ struct session {
 	std::array<uint32_t,SESSION_STATS> lasthouropstats;
 	GroupCache group_cache;
 	OpenedFilesSet openedfiles;
+	// Nodes cached by the mount, if it subscribed to cache invalidation notices
+	std::unique_ptr<SessionCacheTracker> cacheTracker;
+	struct matoclserventry *cacheConnection;  // connection the notices are sent on
 	struct session *next;
 
 	session()
@@ -175,6 +183,8 @@ struct session {
 	      lasthouropstats(),
 	      group_cache(),
 	      openedfiles(),
+	      cacheTracker(),
+	      cacheConnection(),
 	      next() {
 	}
 };
@@ -219,7 +229,7 @@ struct matoclserventry {
 	uint8_t mode;                           //0 - not active, 1 - read header, 2 - read packet
 	bool iolimits;
 	int sock;                               //socket number
-	int32_t pdescpos;
+	bool flushqueued;                       //queued in matoclservflushqueue
 	uint32_t lastread,lastwrite;            //time of last activity
 	uint32_t version;
 	uint32_t peerip;
@@ -239,10 +249,35 @@ struct matoclserventry {
 
 static session *sessionshead=NULL;
 static matoclserventry *matoclservhead=NULL;
+static std::vector<session*> matoclservcachesessions;  // sessions with a cacheTracker
 static int lsock;
 static int32_t lsockpdescpos;
 static int exiting,starting;
 
+// Client sockets are registered in the event loop for their whole life (see
+// eventloop_fdregister), so a loop costs only as much as the ready sockets.
+// Entries with new output and entries to be closed are tracked separately;
+// connections killed outside of the socket handlers are found by the once a
+// second timeout scan at the latest.
+static std::vector<matoclserventry*> matoclservflushqueue;
+static bool matoclservkillpending = false;
+static uint32_t matoclservlastcheck = 0;
+
+// Read-only requests of mounts are queued and then served in batches by the
+// metadata reader threads (METADATA_READER_THREADS), see
+// matoclserv_run_read_batch. Their replies are captured by the serving thread
+// and attached to the connections afterwards, by the main thread.
+struct matoclservreadrequest {
+	matoclserventry *eptr;
+	uint32_t type;
+	std::vector<uint8_t> data;
+	packetstruct *outputhead;
+	packetstruct **outputtail;
+};
+static std::unique_ptr<MetadataReaderPool> matoclservreaderpool;
+static std::vector<matoclservreadrequest> matoclservreadbatch;
+static thread_local matoclservreadrequest *matoclservreadcapture = nullptr;
+
 // from config
 static char *ListenHost;
 static char *ListenPort;
@@ -880,6 +915,28 @@ void matoclserv_reset_session_timeouts() {
 	}
 }
 
+/// Schedules sending the output of eptr at the end of the current loop
+static void matoclserv_queue_flush(matoclserventry *eptr) {
+	if (!eptr->flushqueued) {
+		eptr->flushqueued = true;
+		matoclservflushqueue.push_back(eptr);
+	}
+}
+
+/// Appends the packet to the output of eptr, or to the captured output of the
+/// read request being served by the current thread
+static void matoclserv_attachpacket(matoclserventry *eptr, packetstruct *outpacket) {
+	if (matoclservreadcapture != nullptr) {
+		sassert(matoclservreadcapture->eptr == eptr);
+		*(matoclservreadcapture->outputtail) = outpacket;
+		matoclservreadcapture->outputtail = &(outpacket->next);
+		return;
+	}
+	*(eptr->outputtail) = outpacket;
+	eptr->outputtail = &(outpacket->next);
+	matoclserv_queue_flush(eptr);
+}
+
 uint8_t* matoclserv_createpacket(matoclserventry *eptr,uint32_t type,uint32_t size) {
 	packetstruct *outpacket;
 	uint8_t *ptr;
@@ -896,8 +953,7 @@ uint8_t* matoclserv_createpacket(matoclserventry *eptr,uint32_t type,uint32_t si
 	put32bit(&ptr,size);
 	outpacket->startptr = (uint8_t*)(outpacket->packet);
 	outpacket->next = NULL;
-	*(eptr->outputtail) = outpacket;
-	eptr->outputtail = &(outpacket->next);
+	matoclserv_attachpacket(eptr, outpacket);
 	return ptr;
 }
 
@@ -911,8 +967,7 @@ void matoclserv_createpacket(matoclserventry *eptr, const MessageBuffer& buffer)
 	memcpy(outpacket->packet, buffer.data(), buffer.size());
 	outpacket->startptr = outpacket->packet;
 	outpacket->next = NULL;
-	*(eptr->outputtail) = outpacket;
-	eptr->outputtail = &(outpacket->next);
+	matoclserv_attachpacket(eptr, outpacket);
 }
 
 static inline bool matoclserv_ugid_remap_required(matoclserventry *eptr, uint32_t uid) {
@@ -1905,6 +1960,76 @@ void matoclserv_register_config(matoclserventry *eptr, const uint8_t *data,
 	cltoma::registerConfig::deserialize(data, length, eptr->sesdata->config);
 }
 
+void matoclserv_fuse_cache_notifications(matoclserventry *eptr, const uint8_t *data,
+		uint32_t length) {
+	cltoma::fuseCacheNotifications::deserialize(data, length);
+	session *sesdata = eptr->sesdata;
+	if (sesdata == nullptr) {
+		return;
+	}
+	if (sesdata->cacheConnection == nullptr) {
+		matoclservcachesessions.push_back(sesdata);
+	}
+	// The mount drops its cache first, it might have been filled without notices
+	sesdata->cacheTracker = std::make_unique<SessionCacheTracker>();
+	sesdata->cacheConnection = eptr;
+}
+
+static void matoclserv_cache_unsubscribe(session *sesdata) {
+	std::erase(matoclservcachesessions, sesdata);
+	sesdata->cacheTracker.reset();
+	sesdata->cacheConnection = nullptr;
+}
+
+/// Remembers that the mount caches the node (as seen by the mount) if it gets notices
+static void matoclserv_cache_track(matoclserventry *eptr, uint32_t inode) {
+	session *sesdata = eptr->sesdata;
+	if (sesdata != nullptr && sesdata->cacheTracker) {
+		sesdata->cacheTracker->track(inode == SPECIAL_INODE_ROOT ? sesdata->rootinode : inode);
+	}
+}
+
+bool matoclserv_has_cache_subscribers() {
+	return !matoclservcachesessions.empty();
+}
+
+void matoclserv_notify_inode_changed(uint32_t inode, const std::vector<uint32_t> &parents) {
+	for (session *sesdata : matoclservcachesessions) {
+		sesdata->cacheTracker->inodeChanged(inode, parents);
+	}
+}
+
+void matoclserv_notify_entry_changed(uint32_t parent, const std::string &name) {
+	for (session *sesdata : matoclservcachesessions) {
+		sesdata->cacheTracker->entryChanged(parent, name);
+	}
+}
+
+/// Sends the changes collected since the previous loop to the subscribed mounts
+static void matoclserv_send_cache_notifications() {
+	bool all;
+	std::vector<uint32_t> inodes;
+	std::vector<SessionCacheTracker::Entry> entries;
+	for (session *sesdata : matoclservcachesessions) {
+		if (!sesdata->cacheTracker->hasPending()) {
+			continue;
+		}
+		sesdata->cacheTracker->takePending(all, inodes, entries);
+		for (uint32_t &inode : inodes) {
+			if (inode == sesdata->rootinode) {
+				inode = SPECIAL_INODE_ROOT;
+			}
+		}
+		for (auto &entry : entries) {
+			if (entry.first == sesdata->rootinode) {
+				entry.first = SPECIAL_INODE_ROOT;
+			}
+		}
+		matoclserv_createpacket(sesdata->cacheConnection,
+				matocl::fuseInvalidate::build(all, inodes, entries));
+	}
+}
+
 void matoclserv_fuse_reserved_inodes(matoclserventry *eptr,const uint8_t *data,uint32_t length) {
 	const uint8_t *ptr;
 
@@ -1924,7 +2049,6 @@ void matoclserv_fuse_reserved_inodes(matoclserventry *eptr,const uint8_t *data,u
 	}
 
 	FsContext context = FsContext::getForMaster(eventloop_time());
-	changelog_disable_flush();
 	auto it = eptr->sesdata->openedfiles.begin();
 	while (it != eptr->sesdata->openedfiles.end()) {
 		uint32_t openFileIno = *it;
@@ -1947,7 +2071,6 @@ void matoclserv_fuse_reserved_inodes(matoclserventry *eptr,const uint8_t *data,u
 			eptr->sesdata->openedfiles.insert(inode_to_reserve);
 		}
 	}
-	changelog_enable_flush();
 }
 
 void matoclserv_fuse_statfs(matoclserventry *eptr,const uint8_t *data,uint32_t length) {
@@ -2020,6 +2143,8 @@ void matoclserv_sau_whole_path_lookup(matoclserventry *eptr, const uint8_t *data
 	if (status != SAUNAFS_STATUS_OK) {
 		matoclserv_createpacket(eptr, matocl::wholePathLookup::build(msgid, status));
 	} else {
+		matoclserv_cache_track(eptr, inode);
+		matoclserv_cache_track(eptr, found_inode);
 		matoclserv_createpacket(eptr, matocl::wholePathLookup::build(msgid, found_inode, attr));
 	}
 	eptr->sesdata->currentopstats[3]++;
@@ -2084,6 +2209,8 @@ void matoclserv_fuse_lookup(matoclserventry *eptr,const uint8_t *data,uint32_t l
 	if (status!=SAUNAFS_STATUS_OK) {
 		put8bit(&ptr,status);
 	} else {
+		matoclserv_cache_track(eptr, inode);
+		matoclserv_cache_track(eptr, newinode);
 		put32bit(&ptr,newinode);
 		memcpy(ptr, attr.data(), attr.size());
 	}
@@ -2115,6 +2242,7 @@ void matoclserv_fuse_getattr(matoclserventry *eptr,const uint8_t *data,uint32_t
 	if (status!=SAUNAFS_STATUS_OK) {
 		put8bit(&ptr,status);
 	} else {
+		matoclserv_cache_track(eptr, inode);
 		memcpy(ptr, attr.data(), attr.size());
 	}
 	if (eptr->sesdata) {
@@ -2311,6 +2439,7 @@ void matoclserv_fuse_readlink(matoclserventry *eptr,const uint8_t *data,uint32_t
 	if (status != SAUNAFS_STATUS_OK) {
 		put8bit(&ptr, status);
 	} else {
+		matoclserv_cache_track(eptr, inode);
 		put32bit(&ptr, path.length() + 1);
 		if (path.length() > 0) {
 			memcpy(ptr, path.c_str(), path.length());
@@ -2718,6 +2847,7 @@ void matoclserv_fuse_getdir(matoclserventry *eptr,const PacketHeader &header, co
 			if (status != SAUNAFS_STATUS_OK) {
 				matocl::fuseGetDir::serialize(buffer, message_id, status);
 			} else {
+				matoclserv_cache_track(eptr, inode);
 				matocl::fuseGetDir::serialize(buffer, message_id, first_entry, dir_entries);
 			}
 		} else if (packet_version == cltoma::fuseGetDirLegacy::kLegacyClient) {
@@ -2727,6 +2857,7 @@ void matoclserv_fuse_getdir(matoclserventry *eptr,const PacketHeader &header, co
 			if (status != SAUNAFS_STATUS_OK) {
 				matocl::fuseGetDir::serialize(buffer, message_id, status);
 			} else {
+				matoclserv_cache_track(eptr, inode);
 				matocl::fuseGetDirLegacy::serialize(buffer, message_id, first_entry, dir_entries);
 			}
 		} else {
@@ -2780,6 +2911,7 @@ void matoclserv_fuse_getdir(matoclserventry *eptr,const uint8_t *data,uint32_t l
 	if (status!=SAUNAFS_STATUS_OK) {
 		put8bit(&ptr,status);
 	} else {
+		matoclserv_cache_track(eptr, inode);
 		fs_readdir_data(context,flags,custom,ptr);
 	}
 
@@ -2876,6 +3008,42 @@ void matoclserv_fuse_read_chunk(matoclserventry *eptr, PacketHeader header, cons
 	}
 }
 
+void matoclserv_fuse_read_chunks(matoclserventry *eptr, const uint8_t *data, uint32_t length) {
+	uint32_t messageId, inode, index, count;
+	cltoma::fuseReadChunks::deserialize(data, length, messageId, inode, index, count);
+	count = std::min(count, matocl::fuseReadChunks::kMaxNumberOfResultEntries);
+
+	uint64_t fileLength;
+	std::vector<uint64_t> chunkIds;
+	uint8_t status = fs_readchunks(inode, index, count, chunkIds, &fileLength);
+	std::vector<ChunkWithVersionAndLocations> chunks;
+	chunks.reserve(chunkIds.size());
+	for (uint64_t chunkId : chunkIds) {
+		ChunkWithVersionAndLocations &chunk = chunks.emplace_back();
+		chunk.chunk_id = chunkId;
+		chunk.chunk_version = 0;
+		if (chunkId > 0) {
+			status = chunk_getversionandlocations(chunkId, eptr->peerip, chunk.chunk_version,
+					kMaxNumberOfChunkCopies, chunk.locations);
+			if (status != SAUNAFS_STATUS_OK) {
+				break;
+			}
+		}
+	}
+
+	if (status != SAUNAFS_STATUS_OK) {
+		matoclserv_createpacket(eptr, matocl::fuseReadChunks::build(messageId, status));
+		return;
+	}
+
+	dcm_access(inode, eptr->sesdata->sessionid);
+	matoclserv_createpacket(eptr, matocl::fuseReadChunks::build(messageId, fileLength, chunks));
+
+	if (eptr->sesdata) {
+		eptr->sesdata->currentopstats[14]++;
+	}
+}
+
 void matoclserv_chunks_info(matoclserventry *eptr, const uint8_t *data, uint32_t length) {
 	uint32_t message_id{0}, inode, chunk_index, chunk_count, uid, gid;
 	PacketVersion version;
@@ -4726,6 +4894,9 @@ void matocl_beforedisconnect(matoclserventry *eptr) {
 	}
 	eptr->chunkdelayedops=NULL;
 	if (eptr->sesdata) {
+		if (eptr->sesdata->cacheConnection == eptr) {
+			matoclserv_cache_unsubscribe(eptr->sesdata);
+		}
 		if (eptr->sesdata->nsocks>0) {
 			eptr->sesdata->nsocks--;
 		}
@@ -4735,6 +4906,35 @@ void matocl_beforedisconnect(matoclserventry *eptr) {
 	}
 }
 
+/// Tells if the request can be served by the metadata reader threads: it
+/// must not modify the metadata nor any state shared between sessions.
+static bool matoclserv_is_read_request(matoclserventry *eptr, uint32_t type) {
+	if (!matoclservreaderpool || eptr->registered != ClientState::kRegistered
+			|| eptr->sesdata == NULL || !metadataserver::isMaster()) {
+		return false;
+	}
+	switch (type) {
+		case CLTOMA_FUSE_STATFS:
+		case CLTOMA_FUSE_ACCESS:
+		case CLTOMA_FUSE_LOOKUP:
+		case CLTOMA_FUSE_GETATTR:
+		case CLTOMA_FUSE_GETXATTR:
+		case SAU_CLTOMA_WHOLE_PATH_LOOKUP:
+		case SAU_CLTOMA_FULL_PATH_BY_INODE:
+			return true;
+		case CLTOMA_FUSE_GETDIR:
+		case SAU_CLTOMA_FUSE_GETDIR:
+			// Reading a directory updates its atime otherwise
+			return gAtimeDisabled;
+		default:
+			// Chunk location queries use the shared random generator and
+			// update the data cache manager, so they stay on the main thread
+			return false;
+	}
+}
+
+static void matoclserv_run_read_batch();
+
 void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *data,uint32_t length) {
 	if (type==ANTOAN_NOP) {
 		return;
@@ -4749,6 +4949,16 @@ void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *dat
 		matoclserv_ping(eptr,data,length);
 		return;
 	}
+	if (matoclservreadcapture == nullptr) {
+		if (matoclserv_is_read_request(eptr,type)) {
+			matoclservreadbatch.push_back({eptr, type, std::vector<uint8_t>(data, data + length),
+					nullptr, nullptr});
+			return;
+		}
+		// Any other request may modify the metadata, so the reads received
+		// before it are served first - as if they were served one by one
+		matoclserv_run_read_batch();
+	}
 	try {
 		if (!metadataserver::isMaster()) {     // shadow
 			switch (type) {
@@ -4902,6 +5112,9 @@ void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *dat
 				case SAU_CLTOMA_REGISTER_CONFIG:
 					matoclserv_register_config(eptr,data,length);
 					break;
+				case SAU_CLTOMA_FUSE_CACHE_NOTIFICATIONS:
+					matoclserv_fuse_cache_notifications(eptr,data,length);
+					break;
 				case CLTOMA_FUSE_RESERVED_INODES:
 					matoclserv_fuse_reserved_inodes(eptr,data,length);
 					break;
@@ -4959,6 +5172,9 @@ void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *dat
 				case CLTOMA_FUSE_READ_CHUNK:
 					matoclserv_fuse_read_chunk(eptr, PacketHeader(type, length), data);
 					break;
+				case SAU_CLTOMA_FUSE_READ_CHUNKS:
+					matoclserv_fuse_read_chunks(eptr, data, length);
+					break;
 				case SAU_CLTOMA_CHUNKS_INFO:
 					matoclserv_chunks_info(eptr, data, length);
 					break;
@@ -5205,6 +5421,93 @@ void matoclserv_gotpacket(matoclserventry *eptr,uint32_t type,const uint8_t *dat
 	}
 }
 
+/// Serves a read request in a metadata reader thread, capturing its replies
+static void matoclserv_serve_read_request(matoclservreadrequest &request) {
+	matoclservreadcapture = &request;
+	try {
+		matoclserv_gotpacket(request.eptr, request.type, request.data.data(),
+				request.data.size());
+	} catch (std::exception &e) {
+		// Exceptions can't be passed to the main thread, close the connection
+		safs_pretty_syslog(LOG_NOTICE,
+				"main master server module: can't serve read request (type:%" PRIu32 "), %s",
+				request.type, e.what());
+		request.eptr->mode = KILL;
+	}
+	matoclservreadcapture = nullptr;
+}
+
+/// Serves the queued read requests with the metadata reader threads. The
+/// main thread waits (and helps) meanwhile, so the metadata does not change.
+static void matoclserv_run_read_batch() {
+	if (matoclservreadbatch.empty()) {
+		return;
+	}
+
+	// Requests of a session share its data (statistics, group cache), so they
+	// are served in order by a single task
+	std::unordered_map<session*, std::vector<matoclservreadrequest*>> sessionrequests;
+	for (auto &request : matoclservreadbatch) {
+		request.outputhead = nullptr;
+		request.outputtail = &request.outputhead;
+		if (request.eptr->mode != KILL) {
+			sessionrequests[request.eptr->sesdata].push_back(&request);
+		}
+	}
+	std::vector<MetadataReaderPool::Task> tasks;
+	tasks.reserve(sessionrequests.size());
+	for (auto &[sesdata, requests] : sessionrequests) {
+		tasks.emplace_back([&requests = requests]() {
+			for (matoclservreadrequest *request : requests) {
+				if (request->eptr->mode != KILL) {
+					matoclserv_serve_read_request(*request);
+				}
+			}
+		});
+	}
+	if (gMetadata->lazy_snapshots.empty()) {
+		matoclservreaderpool->run(tasks);
+	} else {
+		// Looking into a lazy snapshot copy materializes it, which modifies the metadata
+		for (auto &task : tasks) {
+			task();
+		}
+	}
+
+	for (auto &request : matoclservreadbatch) {
+		matoclserventry *eptr = request.eptr;
+		if (request.outputhead != nullptr) {
+			*(eptr->outputtail) = request.outputhead;
+			eptr->outputtail = request.outputtail;
+			matoclserv_queue_flush(eptr);
+		}
+		if (eptr->mode == KILL) {
+			matoclservkillpending = true;
+		}
+	}
+	matoclservreadbatch.clear();
+}
+
+/// Starts (or stops) the metadata reader threads according to the config
+static void matoclserv_reader_pool_reload() {
+	uint32_t threads = cfg_getuint32("METADATA_READER_THREADS", 0);
+	if (threads > 0 && cfg_getuint8("USE_BDB_FOR_NAME_STORAGE", 0) != 0) {
+		safs_pretty_syslog(LOG_WARNING, "METADATA_READER_THREADS can't be used together with "
+				"USE_BDB_FOR_NAME_STORAGE - serving all requests in the main thread");
+		threads = 0;
+	}
+	if (threads == (matoclservreaderpool ? matoclservreaderpool->threads() : 0)) {
+		return;
+	}
+	matoclserv_run_read_batch();
+	matoclservreaderpool.reset();
+	if (threads > 0) {
+		matoclservreaderpool = std::make_unique<MetadataReaderPool>(threads);
+	}
+	safs_pretty_syslog(LOG_NOTICE, "main master server module: %" PRIu32 " metadata reader threads",
+			threads);
+}
+
 void matoclserv_term(void) {
 	matoclserventry *eptr,*eptrn;
 	packetstruct *pptr,*pptrn;
@@ -5212,6 +5515,8 @@ void matoclserv_term(void) {
 
 	safs_pretty_syslog(LOG_NOTICE,"main master server module: closing %s:%s",ListenHost,ListenPort);
 	tcpclose(lsock);
+	matoclservreadbatch.clear();
+	matoclservreaderpool.reset();
 
 	for (eptr = matoclservhead ; eptr ; eptr = eptrn) {
 		eptrn = eptr->next;
@@ -5323,6 +5628,8 @@ void matoclserv_write(matoclserventry *eptr) {
 	packetstruct *pack;
 	int32_t i;
 
+	// The changes have to be stored before the replies to them are sent
+	changelog_flush();
 	watchdog.start();
 	for (;;) {
 		pack = eptr->outputhead;
@@ -5358,8 +5665,23 @@ void matoclserv_write(matoclserventry *eptr) {
 	}
 }
 
+/// Updates the events waited for on the client socket
+static void matoclserv_update_events(matoclserventry *eptr) {
+	short events = 0;
+	if (exiting==0) {
+		events |= POLLIN;
+	}
+	if (eptr->outputhead!=NULL) {
+		events |= POLLOUT;
+	}
+	eventloop_fdmodify(eptr->sock,events);
+}
+
 void matoclserv_wantexit(void) {
 	exiting=1;
+	for (matoclserventry *eptr=matoclservhead ; eptr ; eptr=eptr->next) {
+		matoclserv_update_events(eptr);
+	}
 }
 
 int matoclserv_canexit(void) {
@@ -5398,31 +5720,41 @@ int matoclserv_canexit(void) {
 }
 
 void matoclserv_desc(std::vector<pollfd> &pdesc) {
-	matoclserventry *eptr;
-
 	if (exiting==0) {
 		pdesc.push_back({lsock,POLLIN,0});
 		lsockpdescpos = pdesc.size() - 1;
 	} else {
 		lsockpdescpos = -1;
 	}
-	for (eptr=matoclservhead ; eptr ; eptr=eptr->next) {
-		pdesc.push_back({eptr->sock,0,0});
-		eptr->pdescpos = pdesc.size() - 1;
-		if (exiting==0) {
-			pdesc.back().events |= POLLIN;
-		}
-		if (eptr->outputhead!=NULL) {
-			pdesc.back().events |= POLLOUT;
-		}
-	}
 }
 
+/// Serves the events of a client socket registered in the event loop
+void matoclserv_fdserve(void *data, short revents) {
+	matoclserventry *eptr = static_cast<matoclserventry*>(data);
+	uint32_t now=eventloop_time();
+
+	if (revents & (POLLERR|POLLHUP)) {
+		eptr->mode = KILL;
+	}
+	if ((revents & POLLIN) && eptr->mode!=KILL) {
+		eptr->lastread = now;
+		matoclserv_read(eptr);
+	}
+	if ((revents & POLLOUT) && eptr->mode!=KILL) {
+		eptr->lastwrite = now;
+		matoclserv_write(eptr);
+	}
+	if (eptr->mode==KILL) {
+		eventloop_fdmodify(eptr->sock,0);
+		matoclservkillpending = true;
+	} else {
+		matoclserv_update_events(eptr);
+	}
+}
 
 void matoclserv_serve(const std::vector<pollfd> &pdesc) {
 	uint32_t now=eventloop_time();
-	matoclserventry *eptr,**kptr;
-	packetstruct *pptr,*paptr;
+	matoclserventry *eptr;
 	int ns;
 
 	if (lsockpdescpos>=0 && (pdesc[lsockpdescpos].revents & POLLIN)) {
@@ -5433,10 +5765,8 @@ void matoclserv_serve(const std::vector<pollfd> &pdesc) {
 			tcpnonblock(ns);
 			tcpnodelay(ns);
 			eptr = new matoclserventry;
-			eptr->next = matoclservhead;
-			matoclservhead = eptr;
 			eptr->sock = ns;
-			eptr->pdescpos = -1;
+			eptr->flushqueued = false;
 			tcpgetpeer(ns,&(eptr->peerip),&(eptr->peerport));
 			eptr->registered = ClientState::kUnregistered;
 			eptr->iolimits = false;
@@ -5455,45 +5785,78 @@ void matoclserv_serve(const std::vector<pollfd> &pdesc) {
 			eptr->chunkdelayedops = NULL;
 			eptr->sesdata = NULL;
 			memset(eptr->passwordrnd,0,32);
+
+			if (!eventloop_fdregister(ns,POLLIN,matoclserv_fdserve,eptr)) {
+				safs_silent_errlog(LOG_NOTICE,"main master server module: can't register client socket");
+				tcpclose(ns);
+				delete eptr;
+			} else {
+				eptr->next = matoclservhead;
+				matoclservhead = eptr;
+			}
 		}
 	}
+}
 
-// read
-	for (eptr=matoclservhead ; eptr ; eptr=eptr->next) {
-		if (eptr->pdescpos>=0) {
-			if (pdesc[eptr->pdescpos].revents & (POLLERR|POLLHUP)) {
+/// Called after serving all the ready sockets of the loop: sends the new
+/// output, checks the connection timeouts (once a second) and closes the
+/// killed connections.
+void matoclserv_eachloop(void) {
+	uint32_t now=eventloop_time();
+	matoclserventry *eptr,**kptr;
+	packetstruct *pptr,*paptr;
+
+	matoclserv_run_read_batch();
+	matoclserv_send_cache_notifications();
+
+// timeouts
+	if (now!=matoclservlastcheck) {
+		matoclservlastcheck = now;
+		for (eptr=matoclservhead ; eptr ; eptr=eptr->next) {
+			if (eptr->lastwrite+2<now && eptr->registered != ClientState::kOldTools
+					&& eptr->outputhead==NULL) {
+				uint8_t *ptr = matoclserv_createpacket(eptr,ANTOAN_NOP,4);      // 4 byte length because of 'msgid'
+				*((uint32_t*)ptr) = 0;
+			}
+			if (eptr->lastread+10<now && exiting==0) {
 				eptr->mode = KILL;
 			}
-			if ((pdesc[eptr->pdescpos].revents & POLLIN) && eptr->mode!=KILL) {
-				eptr->lastread = now;
-				matoclserv_read(eptr);
+			if (eptr->mode==KILL) {
+				matoclservkillpending = true;
 			}
 		}
 	}
 
 // write
-	for (eptr=matoclservhead ; eptr ; eptr=eptr->next) {
-		if (eptr->lastwrite+2<now && eptr->registered != ClientState::kOldTools
-				&& eptr->outputhead==NULL) {
-			uint8_t *ptr = matoclserv_createpacket(eptr,ANTOAN_NOP,4);      // 4 byte length because of 'msgid'
-			*((uint32_t*)ptr) = 0;
-		}
-		if (eptr->pdescpos>=0) {
-			if ((((pdesc[eptr->pdescpos].events & POLLOUT)==0 && (eptr->outputhead)) || (pdesc[eptr->pdescpos].revents & POLLOUT)) && eptr->mode!=KILL) {
-				eptr->lastwrite = now;
-				matoclserv_write(eptr);
-			}
+	for (size_t i=0 ; i<matoclservflushqueue.size() ; i++) {
+		eptr = matoclservflushqueue[i];
+		eptr->flushqueued = false;
+		if (eptr->mode==KILL) {
+			matoclservkillpending = true;
+			continue;
 		}
-		if (eptr->lastread+10<now && exiting==0) {
-			eptr->mode = KILL;
+		if (eptr->outputhead) {
+			eptr->lastwrite = now;
+			matoclserv_write(eptr);
+		}
+		if (eptr->mode==KILL) {
+			matoclservkillpending = true;
+		} else {
+			matoclserv_update_events(eptr);
 		}
 	}
+	matoclservflushqueue.clear();
 
 // close
+	if (!matoclservkillpending) {
+		return;
+	}
+	matoclservkillpending = false;
 	kptr = &matoclservhead;
 	while ((eptr=*kptr)) {
 		if (eptr->mode == KILL) {
 			matocl_beforedisconnect(eptr);
+			eventloop_fdunregister(eptr->sock);
 			tcpclose(eptr->sock);
 			if (eptr->inputpacket.packet) {
 				free(eptr->inputpacket.packet);
@@ -5507,6 +5870,9 @@ void matoclserv_serve(const std::vector<pollfd> &pdesc) {
 				pptr = pptr->next;
 				free(paptr);
 			}
+			if (eptr->flushqueued) {
+				std::erase(matoclservflushqueue,eptr);
+			}
 			*kptr = eptr->next;
 			delete eptr;
 		} else {
@@ -5613,6 +5979,7 @@ void matoclserv_reload(void) {
 	}
 
 	RejectOld = cfg_getuint32("REJECT_OLD_CLIENTS",0);
+	matoclserv_reader_pool_reload();
 	SessionSustainTime = cfg_getuint32("SESSION_SUSTAIN_TIME",86400);
 	if (SessionSustainTime>7*86400) {
 		SessionSustainTime=7*86400;
@@ -5683,6 +6050,7 @@ int matoclserv_networkinit(void) {
 		ListenPort = cfg_getstr("MATOCU_LISTEN_PORT","9421");
 	}
 	RejectOld = cfg_getuint32("REJECT_OLD_CLIENTS",0);
+	matoclserv_reader_pool_reload();
 
 	if (matoclserv_iolimits_reload() != 0) {
 		return -1;
@@ -5715,12 +6083,14 @@ int matoclserv_networkinit(void) {
 	metadataserver::registerFunctionCalledOnPromotion(matoclserv_become_master);
 	eventloop_destructregister(matoclserv_term);
 	eventloop_pollregister(matoclserv_desc,matoclserv_serve);
+	eventloop_eachloopregister(matoclserv_eachloop);
 	eventloop_wantexitregister(matoclserv_wantexit);
 	eventloop_canexitregister(matoclserv_canexit);
 	return 0;
 }
 
 void matoclserv_session_unload(void) {
+	matoclservcachesessions.clear();
 	for (session* ss = sessionshead, *ssn = NULL; ss ; ss = ssn) {
 		ssn = ss->next;
 		ss->openedfiles.clear();
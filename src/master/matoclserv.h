@@ -23,6 +23,8 @@
 #include "common/platform.h"
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 void matoclserv_stats(uint64_t stats[5]);
 /*
@@ -39,6 +41,15 @@ int matoclserv_sessionsinit(void);
 int matoclserv_networkinit(void);
 void matoclserv_session_unload(void);
 
+/// Whether any mount subscribed to cache invalidation notices.
+bool matoclserv_has_cache_subscribers();
+
+/// Tell subscribed mounts that attributes of a node (with entries in \a parents) changed.
+void matoclserv_notify_inode_changed(uint32_t inode, const std::vector<uint32_t> &parents);
+
+/// Tell subscribed mounts that an entry of directory \a parent was added or removed.
+void matoclserv_notify_entry_changed(uint32_t parent, const std::string &name);
+
 /// Notify interested clients about the status of metadata saving process.
 void matoclserv_broadcast_metadata_saved(uint8_t status);
 
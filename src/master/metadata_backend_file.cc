@@ -27,6 +27,7 @@
 #include <memory>
 #include <sys/mman.h>
 
+#include <common/changelog_prefetching_reader.h>
 #include <common/cwrap.h>
 #include <common/event_loop.h>
 #include <common/rotate_files.h>
@@ -214,17 +215,15 @@ void MetadataBackendFile::load_changelogs() {
 void MetadataBackendFile::load_changelog(const std::string &path) {
 	std::string fullFileName =
 	    fs::getCurrentWorkingDirectoryNoThrow() + "/" + path;
-	std::ifstream changelog(path);
-	std::string line;
-	size_t end = 0;
+	ChangelogPrefetchingReader changelog(path);
+	std::string entry;
 	sassert(gMetadata->metaversion > 0);
 
 	uint64_t first = 0;
 	uint64_t id = 0;
 	uint64_t skippedEntries = 0;
 	uint64_t appliedEntries = 0;
-	while (std::getline(changelog, line).good()) {
-		id = std::stoull(line, &end);
+	while (changelog.next(id, entry)) {
 		if (id < fs_getversion()) {
 			++skippedEntries;
 			continue;
@@ -232,13 +231,17 @@ void MetadataBackendFile::load_changelog(const std::string &path) {
 			first = id;
 		}
 		++appliedEntries;
-		uint8_t status = restore(path.c_str(), id, line.c_str() + end,
+		uint8_t status = restore(path.c_str(), id, entry.c_str(),
 		                         RestoreRigor::kIgnoreParseErrors);
 		if (status != SAUNAFS_STATUS_OK) {
 			throw MetadataConsistencyException(
 			    "can't apply changelog " + fullFileName, status);
 		}
 	}
+	if (!changelog.error().empty()) {
+		throw ParseException("malformed changelog " + fullFileName + ": " +
+		                     changelog.error());
+	}
 	if (appliedEntries > 0) {
 		safs_pretty_syslog_attempt(LOG_NOTICE,
 		                           "%s: %" PRIu64 " changes applied (%" PRIu64
@@ -367,31 +370,13 @@ void MetadataBackendFile::changelogsMigrateFrom_1_6_29(const std::string& fname)
 #ifndef METALOGGER
 
 uint64_t MetadataBackendFile::changelogGetFirstLogVersion(const std::string& fname) {
-	uint8_t buff[50];
-	int32_t s,p;
-	uint64_t fv;
-	int fd;
-
-	fd = open(fname.c_str(), O_RDONLY);
-	if (fd<0) {
-		return 0;
-	}
-	s = read(fd,buff,50);
-	close(fd);
-	if (s<=0) {
-		return 0;
-	}
-	fv = 0;
-	p = 0;
-	while (p<s && buff[p]>='0' && buff[p]<='9') {
-		fv *= 10;
-		fv += buff[p]-'0';
-		p++;
-	}
-	if (p>=s || buff[p]!=':') {
+	ChangelogFileReader reader(fname);
+	uint64_t version;
+	std::string entry;
+	if (!reader.next(version, entry)) {
 		return 0;
 	}
-	return fv;
+	return version;
 }
 
 uint64_t MetadataBackendFile::changelogGetLastLogVersion(const std::string& fname) {
@@ -401,6 +386,19 @@ uint64_t MetadataBackendFile::changelogGetLastLogVersion(const std::string& fnam
 	if (fd.get() < 0) {
 		throw FilesystemException("open " + fname + " failed: " + errorString(errno));
 	}
+	ChangelogFileReader reader(fname);
+	if (reader.format() == ChangelogFormat::kBinary) {
+		// Records are found by their lengths, without looking at the contents
+		uint64_t version, lastLogVersion = 0;
+		std::string entry;
+		while (reader.next(version, entry)) {
+			lastLogVersion = version;
+		}
+		if (!reader.error().empty()) {
+			throw ParseException("malformed changelog " + fname + " (" + reader.error() + ")");
+		}
+		return lastLogVersion;
+	}
 	fstat(fd.get(), &st);
 
 	size_t fileSize = st.st_size;
@@ -714,16 +712,17 @@ int8_t fs_parseEdge(const std::shared_ptr<MemoryMappedFile> &metadataFile, size_
 			currentParentId = parentId;
 		}
 
-		hstorage::Handle *handlePtr = new hstorage::Handle(name);
-		auto it = parent->entries.insert({handlePtr, child}).first;
+		HString hname(name);
+		hstorage::Handle *handlePtr = new hstorage::Handle(hname);
+		auto it = parent->entries.insert({handlePtr, child}, hname.hash()).first;
 		parent->entries_hash ^= (*it).first->hash();
 
 		if (parent->case_insensitive) {
-			HString lowerCaseName = HString::hstringToLowerCase(HString(name));
+			HString lowerCaseName = HString::hstringToLowerCase(hname);
 			auto lowercaseHandlePtr = new hstorage::Handle(lowerCaseName);
-			auto it =
-			    parent->lowerCaseEntries.insert({lowercaseHandlePtr, child})
-			        .first;
+			auto it = parent->lowerCaseEntries
+			              .insert({lowercaseHandlePtr, child}, lowerCaseName.hash())
+			              .first;
 			parent->lowerCaseEntriesHash ^= (*it).first->hash();
 		}
 
@@ -838,9 +837,12 @@ int8_t fs_parseNode(const std::shared_ptr<MemoryMappedFile> & metadataFile, size
 		sectionOffset = metadataFile->offset(pSrc);
 		return kError;
 	}
-	uint32_t nodeIndex = NODEHASHPOS(node->id);
-	node->next = gMetadata->nodehash[nodeIndex];
-	gMetadata->nodehash[nodeIndex] = node;
+	if (!gMetadata->node_index.insert(node->id, node)) {
+		safs_pretty_syslog(LOG_ERR, "loading node: duplicated inode: %" PRIu32,
+		                   node->id);
+		sectionOffset = metadataFile->offset(pSrc);
+		return kError;
+	}
 	gMetadata->inode_pool.markAsAcquired(node->id);
 	gMetadata->nodes++;
 	fsnodes_quota_update(node, {{QuotaResource::kInodes, +1}});
@@ -870,24 +872,23 @@ int fs_lostnode(FSNode *p) {
 }
 
 int fs_checknodes(int ignoreflag) {
-	uint32_t i;
-	FSNode *p;
-	for (i = 0; i < NODEHASHSIZE; i++) {
-		for (p = gMetadata->nodehash[i]; p; p = p->next) {
-			if (p->parent.empty() && p != gMetadata->root &&
-			    (p->type != FSNode::kTrash) && (p->type != FSNode::kReserved)) {
-				safs_pretty_syslog(LOG_ERR, "found orphaned inode: %" PRIu32,
-				                   p->id);
-				if (ignoreflag) {
-					if (fs_lostnode(p) < 0) {
-						return -1;
-					}
-				} else {
-					safs_pretty_syslog(LOG_ERR,
-					                   "use sfsmetarestore (option -i) to "
-					                   "attach this node to root dir\n");
+	const auto &nodeIndex = gMetadata->node_index;
+	for (uint64_t id = nodeIndex.nextId(0); id < nodeIndex.idLimit();
+	     id = nodeIndex.nextId(id + 1)) {
+		FSNode *p = nodeIndex.find(id);
+		if (p->parent.empty() && p != gMetadata->root &&
+		    (p->type != FSNode::kTrash) && (p->type != FSNode::kReserved)) {
+			safs_pretty_syslog(LOG_ERR, "found orphaned inode: %" PRIu32,
+			                   p->id);
+			if (ignoreflag) {
+				if (fs_lostnode(p) < 0) {
 					return -1;
 				}
+			} else {
+				safs_pretty_syslog(LOG_ERR,
+				                   "use sfsmetarestore (option -i) to "
+				                   "attach this node to root dir\n");
+				return -1;
 			}
 		}
 	}
@@ -949,6 +950,49 @@ static bool fs_loadlocks(MetadataLoader::Options options) {
 	return true;
 }
 
+static bool fs_loadlazysnapshots(MetadataLoader::Options options) {
+	static constexpr uint32_t kRecordSize = 4 + 4 + 5 * 4 + 3 * 8;
+	const uint8_t *ptr;
+
+	try {
+		ptr = options.metadataFile->seek(options.offset);
+	} catch (const std::exception &e) {
+		safs_pretty_syslog(LOG_ERR, "loading snapshots: %s", e.what());
+		return false;
+	}
+
+	uint32_t count = get32bit(&ptr);
+	if (options.sectionLength && count != (options.sectionLength - 4) / kRecordSize) {
+		safs_pretty_syslog(LOG_ERR,
+		                   "loading snapshots: section size doesn't match number of snapshots");
+		if (!options.ignoreFlag) {
+			return false;
+		}
+		count = (options.sectionLength - 4) / kRecordSize;
+	}
+
+	// Only the lazy copies are loaded here, as the edges (and so the stats of the
+	// directories) are loaded concurrently; see fsnodes_lazy_snapshot_restore_stats
+	LazySnapshots &lazy = gMetadata->lazy_snapshots;
+	for (uint32_t i = 0; i < count; ++i) {
+		uint32_t copy = get32bit(&ptr);
+		LazySnapshots::Copy entry;
+		entry.source = get32bit(&ptr);
+		entry.stats.inodes = get32bit(&ptr);
+		entry.stats.dirs = get32bit(&ptr);
+		entry.stats.files = get32bit(&ptr);
+		entry.stats.links = get32bit(&ptr);
+		entry.stats.chunks = get32bit(&ptr);
+		entry.stats.length = get64bit(&ptr);
+		entry.stats.size = get64bit(&ptr);
+		entry.stats.realsize = get64bit(&ptr);
+		lazy.copies.emplace(copy, entry);
+		lazy.sources.emplace(entry.source, copy);
+	}
+	options.offset = options.metadataFile->offset(ptr);
+	return true;
+}
+
 bool fs_loadfree(MetadataLoader::Options options) {
 	const uint8_t *ptr;
 	uint32_t freeNodesToLoad, freeNodesNumber;
@@ -999,6 +1043,7 @@ static const std::vector<MetadataSection> kMetadataSections = {
     MetadataSection("ACLS 1.2", "Access Control Lists", fs_load_acls),
     MetadataSection("QUOT 1.1", "Quotas", fs_loadquotas),
     MetadataSection("FLCK 1.0", "File Locks", fs_loadlocks),
+    MetadataSection("LAZY 1.0", "Lazy Snapshots", fs_loadlazysnapshots),
     MetadataSection("CHNK 1.0", "Chunks", chunksLoadFromFile),
     /// Legacy Sections (won't be loaded):
     MetadataSection("QUOT 1.0", "Quotas",
@@ -1094,6 +1139,7 @@ int fs_load(const std::shared_ptr<MemoryMappedFile> &metadataFile,
 		    LOG_ERR, "error reading metadata (root node not a directory)");
 		return kOpFailure;
 	}
+	fsnodes_lazy_snapshot_restore_stats();
 	if (fs_checknodes(ignoreflag) < 0) {
 		return kOpFailure;
 	}
@@ -1103,7 +1149,6 @@ int fs_load(const std::shared_ptr<MemoryMappedFile> &metadataFile,
 #ifndef METARESTORE
 
 void fs_new(void) {
-	uint32_t nodepos;
 	gMetadata->maxnodeid = SPECIAL_INODE_ROOT;
 	gMetadata->metaversion = 1;
 	gMetadata->nextsessionid = 1;
@@ -1117,9 +1162,7 @@ void fs_new(void) {
 	gMetadata->root->mode = 0777;
 	gMetadata->root->uid = 0;
 	gMetadata->root->gid = 0;
-	nodepos = NODEHASHPOS(gMetadata->root->id);
-	gMetadata->root->next = gMetadata->nodehash[nodepos];
-	gMetadata->nodehash[nodepos] = gMetadata->root;
+	gMetadata->node_index.insert(gMetadata->root->id, gMetadata->root);
 	gMetadata->inode_pool.markAsAcquired(gMetadata->root->id);
 	chunk_newfs();
 	gMetadata->nodes = 1;
@@ -1318,13 +1361,7 @@ void MetadataBackendFile::storenode(FSNode *f, FILE *fd) {
 }
 
 void MetadataBackendFile::storenodes(FILE *fd) {
-	uint32_t i;
-	FSNode *p;
-	for (i = 0; i < NODEHASHSIZE; i++) {
-		for (p = gMetadata->nodehash[i]; p; p = p->next) {
-			storenode(p, fd);
-		}
-	}
+	gMetadata->node_index.forEach([this, fd](FSNode *p) { storenode(p, fd); });
 	storenode(NULL, fd);  // end marker
 }
 
@@ -1493,6 +1530,36 @@ void MetadataBackendFile::storelocks(FILE *fd) {
 	gMetadata->posix_locks.store(fd);
 }
 
+// Lazy snapshots
+
+void MetadataBackendFile::storelazysnapshots(FILE *fd) {
+	uint8_t wbuff[4 + 4 + 5 * 4 + 3 * 8], *ptr;
+
+	ptr = wbuff;
+	put32bit(&ptr, gMetadata->lazy_snapshots.copies.size());
+	if (fwrite(wbuff, 1, 4, fd) != (size_t)4) {
+		safs_pretty_syslog(LOG_NOTICE, "fwrite error");
+		return;
+	}
+	for (const auto &[copy, entry] : gMetadata->lazy_snapshots.copies) {
+		ptr = wbuff;
+		put32bit(&ptr, copy);
+		put32bit(&ptr, entry.source);
+		put32bit(&ptr, entry.stats.inodes);
+		put32bit(&ptr, entry.stats.dirs);
+		put32bit(&ptr, entry.stats.files);
+		put32bit(&ptr, entry.stats.links);
+		put32bit(&ptr, entry.stats.chunks);
+		put64bit(&ptr, entry.stats.length);
+		put64bit(&ptr, entry.stats.size);
+		put64bit(&ptr, entry.stats.realsize);
+		if (fwrite(wbuff, 1, sizeof(wbuff), fd) != sizeof(wbuff)) {
+			safs_pretty_syslog(LOG_NOTICE, "fwrite error");
+			return;
+		}
+	}
+}
+
 // Full FS
 
 int MetadataBackendFile::process_section(const char *label, uint8_t (&hdr)[16],
@@ -1571,6 +1638,11 @@ void MetadataBackendFile::store(FILE *fd, uint8_t fver) {
 		    SAUNAFS_STATUS_OK) {
 			return;
 		}
+		storelazysnapshots(fd);
+		if (process_section("LAZY 1.0", hdr, ptr, offbegin, offend, fd) !=
+		    SAUNAFS_STATUS_OK) {
+			return;
+		}
 	}
 	chunk_store(fd);
 	if (fver >= kMetadataVersionWithSections) {
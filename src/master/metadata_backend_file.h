@@ -123,6 +123,9 @@ private:
 	// Locks
 	void storelocks(FILE *fd);
 
+	// Lazy snapshots
+	void storelazysnapshots(FILE *fd);
+
 	// Full FS
 	static int process_section(const char *label, uint8_t (&hdr)[16],
 	                           uint8_t *&ptr, off_t &offbegin, off_t &offend,
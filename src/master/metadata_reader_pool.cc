@@ -0,0 +1,99 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+
+#include "master/metadata_reader_pool.h"
+
+#include <pthread.h>
+
+MetadataReaderPool::MetadataReaderPool(uint32_t threads, const std::string &name) {
+	threads_.reserve(threads);
+	for (uint32_t i = 0; i < threads; ++i) {
+		threads_.emplace_back([this, i, name]() {
+			std::string threadName = name + " " + std::to_string(i);
+			pthread_setname_np(pthread_self(), threadName.c_str());
+			workerLoop();
+		});
+	}
+}
+
+MetadataReaderPool::~MetadataReaderPool() {
+	{
+		std::unique_lock lock(mutex_);
+		terminate_ = true;
+	}
+	batchStarted_.notify_all();
+	for (auto &thread : threads_) {
+		thread.join();
+	}
+}
+
+void MetadataReaderPool::run(std::vector<Task> &tasks) {
+	if (tasks.empty()) { return; }
+
+	// Not worth waking the workers up
+	if (threads_.empty() || tasks.size() == 1) {
+		for (auto &task : tasks) { task(); }
+		return;
+	}
+
+	{
+		std::unique_lock lock(mutex_);
+		tasks_ = &tasks;
+		nextTask_ = 0;
+		busyWorkers_ = threads_.size();
+		++generation_;
+	}
+	batchStarted_.notify_all();
+
+	runTasks();
+
+	std::unique_lock lock(mutex_);
+	batchFinished_.wait(lock, [this]() { return busyWorkers_ == 0; });
+	tasks_ = nullptr;
+}
+
+void MetadataReaderPool::workerLoop() {
+	uint64_t seenGeneration = 0;
+
+	while (true) {
+		{
+			std::unique_lock lock(mutex_);
+			batchStarted_.wait(lock, [this, seenGeneration]() {
+				return terminate_ || generation_ != seenGeneration;
+			});
+			if (terminate_) { return; }
+			seenGeneration = generation_;
+		}
+
+		runTasks();
+
+		std::unique_lock lock(mutex_);
+		if (--busyWorkers_ == 0) {
+			batchFinished_.notify_one();
+		}
+	}
+}
+
+void MetadataReaderPool::runTasks() {
+	std::vector<Task> &tasks = *tasks_;
+	for (size_t i = nextTask_++; i < tasks.size(); i = nextTask_++) {
+		tasks[i]();
+	}
+}
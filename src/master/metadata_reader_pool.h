@@ -0,0 +1,79 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Pool of threads running batches of read-only metadata operations.
+///
+/// A batch is run by the pool threads together with the calling (main)
+/// thread, and run() returns only when all of its tasks are done. The main
+/// thread does not modify the metadata in the meantime, so the tasks see a
+/// consistent state of it without any locking, and the order of mutations
+/// (and of the changelog) is the same as without the pool.
+///
+/// Tasks must not modify any state shared with other tasks of the batch.
+class MetadataReaderPool {
+public:
+	using Task = std::function<void()>;
+
+	/// Starts \a threads helper threads (0 runs the batches on the caller),
+	/// named \a name followed by their number.
+	explicit MetadataReaderPool(uint32_t threads, const std::string &name = "metaReader");
+	~MetadataReaderPool();
+
+	MetadataReaderPool(const MetadataReaderPool &) = delete;
+	MetadataReaderPool &operator=(const MetadataReaderPool &) = delete;
+	MetadataReaderPool(MetadataReaderPool &&) = delete;
+	MetadataReaderPool &operator=(MetadataReaderPool &&) = delete;
+
+	/// Runs all \a tasks, returns when all of them are done.
+	void run(std::vector<Task> &tasks);
+
+	uint32_t threads() const { return threads_.size(); }
+
+private:
+	void workerLoop();
+	/// Runs the tasks of the current batch until none is left
+	void runTasks();
+
+	std::vector<std::thread> threads_;
+
+	std::mutex mutex_;
+	std::condition_variable batchStarted_;
+	std::condition_variable batchFinished_;
+	/// Incremented for each batch, wakes the workers up
+	uint64_t generation_ = 0;
+	bool terminate_ = false;
+	/// Number of workers still running tasks of the current batch
+	uint32_t busyWorkers_ = 0;
+
+	std::vector<Task> *tasks_ = nullptr;
+	std::atomic<size_t> nextTask_{0};
+};
@@ -0,0 +1,55 @@
+#include "common/platform.h"
+
+#include "master/metadata_reader_pool.h"
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(MetadataReaderPoolTests, RunsEachTaskOnce) {
+	MetadataReaderPool pool(4);
+	EXPECT_EQ(pool.threads(), 4U);
+
+	for (int batch = 0; batch < 100; ++batch) {
+		std::vector<int> counters(batch + 1, 0);
+		std::vector<MetadataReaderPool::Task> tasks;
+		for (auto &counter : counters) {
+			tasks.emplace_back([&counter]() { ++counter; });
+		}
+		pool.run(tasks);
+		for (int counter : counters) {
+			ASSERT_EQ(counter, 1) << "batch=" << batch;
+		}
+	}
+}
+
+TEST(MetadataReaderPoolTests, UsesWorkerThreads) {
+	MetadataReaderPool pool(3);
+	std::atomic<int> started{0};
+	std::mutex mutex;
+	std::set<std::thread::id> threads;
+
+	// Each task waits for all of them to start, so they must run in parallel
+	std::vector<MetadataReaderPool::Task> tasks(4, [&]() {
+		++started;
+		while (started < 4) { std::this_thread::yield(); }
+		std::unique_lock lock(mutex);
+		threads.insert(std::this_thread::get_id());
+	});
+	pool.run(tasks);
+
+	EXPECT_EQ(threads.size(), 4U);
+	EXPECT_EQ(threads.count(std::this_thread::get_id()), 1U);
+}
+
+TEST(MetadataReaderPoolTests, NoThreads) {
+	MetadataReaderPool pool(0);
+	int counter = 0;
+	std::vector<MetadataReaderPool::Task> tasks(10, [&counter]() { ++counter; });
+	pool.run(tasks);
+	EXPECT_EQ(counter, 10);
+}
@@ -60,6 +60,10 @@ int RemoveTask::execute(uint32_t ts, intrusive_list<Task> &work_queue) {
 	if (status != SAUNAFS_STATUS_OK) {
 		return status;
 	}
+	fsnodes_lazy_snapshot_before_entries_change(wd);
+	if (child->type == FSNode::kDirectory) {
+		fsnodes_lazy_snapshot_before_entries_change(static_cast<FSNodeDirectory*>(child));
+	}
 	if (child->type == FSNode::kDirectory &&
 	    !static_cast<FSNodeDirectory*>(child)->entries.empty()) {
 
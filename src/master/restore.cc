@@ -708,6 +708,24 @@ int do_clone_node(const char* filename, uint64_t lv, uint32_t ts, const char* pt
 				HString((const char*)name), can_overwrite);
 }
 
+int do_lazysnapshot(const char* filename, uint64_t lv, uint32_t, const char* ptr) {
+	uint32_t inode, inode_src;
+	EAT(ptr,filename,lv,'(');
+	GETU32(inode,ptr);
+	EAT(ptr,filename,lv,',');
+	GETU32(inode_src,ptr);
+	EAT(ptr,filename,lv,')');
+	return fs_apply_lazysnapshot(inode, inode_src);
+}
+
+int do_materialize(const char* filename, uint64_t lv, uint32_t, const char* ptr) {
+	uint32_t inode;
+	EAT(ptr,filename,lv,'(');
+	GETU32(inode,ptr);
+	EAT(ptr,filename,lv,')');
+	return fs_apply_materialize(inode);
+}
+
 int do_symlink(const char* filename, uint64_t lv, uint32_t ts, const char* ptr) {
 	uint32_t parent,uid,gid,inode;
 	uint8_t name[256];
@@ -884,11 +902,15 @@ int restore_line(const char* filename, uint64_t lv, const char* line) {
 				status = do_length(filename,lv,ts,ptr+6);
 			} else if (strncmp(ptr,"LINK",4)==0) {
 				status = do_link(filename,lv,ts,ptr+4);
+			} else if (strncmp(ptr,"LAZYSNAPSHOT",12)==0) {
+				status = do_lazysnapshot(filename,lv,ts,ptr+12);
 			}
 			break;
 		case 'M':
 			if (strncmp(ptr,"MOVE",4)==0) {
 				status = do_move(filename,lv,ts,ptr+4);
+			} else if (strncmp(ptr,"MATERIALIZE",11)==0) {
+				status = do_materialize(filename,lv,ts,ptr+11);
 			}
 			break;
 		case 'N':
@@ -0,0 +1,80 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "master/session_cache_tracker.h"
+
+#include <algorithm>
+
+void SessionCacheTracker::track(uint32_t inode) {
+	if (inodes_.size() >= maxInodes_) {
+		invalidateAll();
+	}
+	inodes_.insert(inode);
+}
+
+void SessionCacheTracker::inodeChanged(uint32_t inode, const std::vector<uint32_t> &parents) {
+	bool cached = inodes_.erase(inode) > 0;
+	for (uint32_t parent : parents) {
+		// The parent stays tracked, its entries didn't change
+		cached = cached || inodes_.count(parent) > 0;
+	}
+	if (!cached || all_) {
+		return;
+	}
+	if (isPendingFull()) {
+		invalidateAll();
+		return;
+	}
+	pendingInodes_.push_back(inode);
+}
+
+void SessionCacheTracker::entryChanged(uint32_t parent, const std::string &name) {
+	if (all_ || inodes_.count(parent) == 0) {
+		return;
+	}
+	if (isPendingFull()) {
+		invalidateAll();
+		return;
+	}
+	pendingEntries_.emplace_back(parent, name);
+}
+
+void SessionCacheTracker::invalidateAll() {
+	inodes_.clear();
+	all_ = true;
+	pendingInodes_.clear();
+	pendingEntries_.clear();
+}
+
+void SessionCacheTracker::takePending(bool &all, std::vector<uint32_t> &inodes,
+		std::vector<Entry> &entries) {
+	// A node changed by a few operations is reported once
+	std::sort(pendingInodes_.begin(), pendingInodes_.end());
+	pendingInodes_.erase(std::unique(pendingInodes_.begin(), pendingInodes_.end()),
+			pendingInodes_.end());
+	std::sort(pendingEntries_.begin(), pendingEntries_.end());
+	pendingEntries_.erase(std::unique(pendingEntries_.begin(), pendingEntries_.end()),
+			pendingEntries_.end());
+	all = all_;
+	inodes.clear();
+	entries.clear();
+	inodes.swap(pendingInodes_);
+	entries.swap(pendingEntries_);
+	all_ = false;
+}
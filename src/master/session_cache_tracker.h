@@ -0,0 +1,92 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/// Inodes cached by a mount which subscribed to cache invalidation notices.
+///
+/// Such a mount keeps the attributes and directory entries it got from the
+/// master until it is told that they have changed. The tracker remembers the
+/// inodes the mount was told about: looked up nodes, nodes whose attributes
+/// or symlink targets were read and listed directories (a listing carries the
+/// attributes of the children as well). Changes of these nodes and of entries
+/// of these directories are collected and sent to the mount later, in one
+/// notice, after which a node is forgotten until the mount asks about it again.
+///
+/// When the mount caches too many nodes or too many changes pile up, the
+/// tracker forgets everything and tells the mount to drop its whole cache.
+/// A new tracker starts that way too, so the mount drops the data it got
+/// before it subscribed.
+class SessionCacheTracker {
+public:
+	using Entry = std::pair<uint32_t, std::string>;
+
+	static constexpr uint32_t kDefaultMaxInodes = 1U << 20;
+	static constexpr uint32_t kDefaultMaxPending = 1U << 14;
+
+	explicit SessionCacheTracker(uint32_t maxInodes = kDefaultMaxInodes,
+			uint32_t maxPending = kDefaultMaxPending)
+			: maxInodes_(maxInodes),
+			  maxPending_(maxPending),
+			  all_(true) {
+	}
+
+	/// Remembers that the mount caches \a inode.
+	void track(uint32_t inode);
+
+	/// Notes that attributes of \a inode, which has entries in \a parents, have changed.
+	void inodeChanged(uint32_t inode, const std::vector<uint32_t> &parents);
+
+	/// Notes that entry \a name of directory \a parent was added or removed.
+	void entryChanged(uint32_t parent, const std::string &name);
+
+	/// Forgets everything, the mount is to drop its whole cache.
+	void invalidateAll();
+
+	bool hasPending() const {
+		return all_ || !pendingInodes_.empty() || !pendingEntries_.empty();
+	}
+
+	/// Moves the changes collected so far to the arguments.
+	void takePending(bool &all, std::vector<uint32_t> &inodes, std::vector<Entry> &entries);
+
+	/// Number of tracked inodes.
+	uint32_t size() const {
+		return inodes_.size();
+	}
+
+private:
+	bool isPendingFull() const {
+		return pendingInodes_.size() + pendingEntries_.size() >= maxPending_;
+	}
+
+	uint32_t maxInodes_;
+	uint32_t maxPending_;
+	std::unordered_set<uint32_t> inodes_;
+	bool all_;
+	std::vector<uint32_t> pendingInodes_;
+	std::vector<Entry> pendingEntries_;
+};
@@ -0,0 +1,90 @@
+#include "common/platform.h"
+
+#include "master/session_cache_tracker.h"
+
+#include <gtest/gtest.h>
+
+static void takePending(SessionCacheTracker &tracker, bool &all, std::vector<uint32_t> &inodes,
+		std::vector<SessionCacheTracker::Entry> &entries) {
+	tracker.takePending(all, inodes, entries);
+	EXPECT_FALSE(tracker.hasPending());
+}
+
+TEST(SessionCacheTrackerTests, StartsWithInvalidatingEverything) {
+	SessionCacheTracker tracker;
+	bool all = false;
+	std::vector<uint32_t> inodes;
+	std::vector<SessionCacheTracker::Entry> entries;
+	EXPECT_TRUE(tracker.hasPending());
+	takePending(tracker, all, inodes, entries);
+	EXPECT_TRUE(all);
+	EXPECT_TRUE(inodes.empty());
+	EXPECT_TRUE(entries.empty());
+}
+
+TEST(SessionCacheTrackerTests, ChangesOfTrackedInodes) {
+	SessionCacheTracker tracker;
+	bool all;
+	std::vector<uint32_t> inodes;
+	std::vector<SessionCacheTracker::Entry> entries;
+	takePending(tracker, all, inodes, entries);
+
+	tracker.track(10);
+	tracker.track(20);
+	tracker.inodeChanged(30, {});
+	tracker.entryChanged(30, "a");
+	EXPECT_FALSE(tracker.hasPending());
+
+	tracker.inodeChanged(10, {1});
+	tracker.inodeChanged(10, {1});
+	tracker.inodeChanged(21, {20});
+	tracker.entryChanged(20, "b");
+	tracker.entryChanged(20, "b");
+	takePending(tracker, all, inodes, entries);
+	EXPECT_FALSE(all);
+	EXPECT_EQ(inodes, (std::vector<uint32_t>{10, 21}));
+	EXPECT_EQ(entries, (std::vector<SessionCacheTracker::Entry>{{20, "b"}}));
+
+	// 10 is reported once, until the mount asks about it again
+	tracker.inodeChanged(10, {1});
+	EXPECT_FALSE(tracker.hasPending());
+	EXPECT_EQ(tracker.size(), 1U);
+}
+
+TEST(SessionCacheTrackerTests, TooManyInodes) {
+	SessionCacheTracker tracker(4);
+	bool all;
+	std::vector<uint32_t> inodes;
+	std::vector<SessionCacheTracker::Entry> entries;
+	takePending(tracker, all, inodes, entries);
+
+	for (uint32_t inode = 1; inode <= 4; ++inode) {
+		tracker.track(inode);
+	}
+	tracker.inodeChanged(1, {});
+	EXPECT_TRUE(tracker.hasPending());
+	tracker.track(5);
+	EXPECT_EQ(tracker.size(), 4U);
+	tracker.track(6);
+	takePending(tracker, all, inodes, entries);
+	EXPECT_TRUE(all);
+	EXPECT_TRUE(inodes.empty());
+	EXPECT_EQ(tracker.size(), 1U);
+}
+
+TEST(SessionCacheTrackerTests, TooManyChanges) {
+	SessionCacheTracker tracker(100, 3);
+	bool all;
+	std::vector<uint32_t> inodes;
+	std::vector<SessionCacheTracker::Entry> entries;
+	takePending(tracker, all, inodes, entries);
+
+	tracker.track(1);
+	for (uint32_t inode = 2; inode < 10; ++inode) {
+		tracker.inodeChanged(inode, {1});
+	}
+	takePending(tracker, all, inodes, entries);
+	EXPECT_TRUE(all);
+	EXPECT_TRUE(inodes.empty());
+	EXPECT_EQ(tracker.size(), 0U);
+}
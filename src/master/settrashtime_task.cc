@@ -36,6 +36,10 @@ int SetTrashtimeTask::execute(uint32_t ts, intrusive_list<Task> &work_queue) {
 		return SAUNAFS_ERROR_EINVAL;
 	}
 
+	fsnodes_lazy_snapshot_before_change(node);
+	if (node->type == FSNode::kDirectory && (smode_ & SMODE_RMASK)) {
+		fsnodes_lazy_snapshot_before_read(static_cast<FSNodeDirectory *>(node));
+	}
 	uint8_t result = setTrashtime(node, ts);
 
 	if (result != kNoAction) {
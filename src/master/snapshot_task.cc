@@ -29,14 +29,16 @@
 #include "master/filesystem_quota.h"
 
 int SnapshotTask::cloneNodeTest(FSNode *src_node, FSNode *dst_node, FSNodeDirectory *dst_parent) {
-	if (fsnodes_quota_exceeded_ug(src_node, {{QuotaResource::kInodes, 1}}) ||
-	    fsnodes_quota_exceeded_dir(dst_parent, {{QuotaResource::kInodes, 1}})) {
-		return SAUNAFS_ERROR_QUOTA;
-	}
-	if (src_node->type == FSNode::kFile &&
-	    (fsnodes_quota_exceeded_ug(src_node, {{QuotaResource::kSize, 1}}) ||
-	     fsnodes_quota_exceeded_dir(dst_parent, {{QuotaResource::kSize, 1}}))) {
-		return SAUNAFS_ERROR_QUOTA;
+	if (check_quota_) {
+		if (fsnodes_quota_exceeded_ug(src_node, {{QuotaResource::kInodes, 1}}) ||
+		    fsnodes_quota_exceeded_dir(dst_parent, {{QuotaResource::kInodes, 1}})) {
+			return SAUNAFS_ERROR_QUOTA;
+		}
+		if (src_node->type == FSNode::kFile &&
+		    (fsnodes_quota_exceeded_ug(src_node, {{QuotaResource::kSize, 1}}) ||
+		     fsnodes_quota_exceeded_dir(dst_parent, {{QuotaResource::kSize, 1}}))) {
+			return SAUNAFS_ERROR_QUOTA;
+		}
 	}
 	if (dst_node) {
 		if (orig_inode_ != 0 && dst_node->id == orig_inode_) {
@@ -217,6 +219,11 @@ int SnapshotTask::cloneNode(uint32_t ts) {
 		return SAUNAFS_ERROR_EINVAL;
 	}
 
+	fsnodes_lazy_snapshot_before_entries_change(dst_parent);
+	if (enqueue_work_ && src_node->type == FSNode::kDirectory) {
+		fsnodes_lazy_snapshot_before_read(static_cast<FSNodeDirectory *>(src_node));
+	}
+
 	FSNode *dst_node = fsnodes_lookup(dst_parent, current_subtask_->second);
 
 	int status = cloneNodeTest(src_node, dst_node, dst_parent);
@@ -44,11 +44,12 @@ public:
 
 	SnapshotTask(SubtaskContainer &&subtask, uint32_t orig_inode, uint32_t dst_parent_inode,
 		     uint32_t dst_inode, uint8_t can_overwrite, uint8_t ignore_missing_src,
-		     bool emit_changelog, bool enqueue_work) :
+		     bool emit_changelog, bool enqueue_work, bool check_quota = true) :
 		     subtask_(std::move(subtask)), orig_inode_(orig_inode),
 		     dst_parent_inode_(dst_parent_inode),dst_inode_(dst_inode),
 		     can_overwrite_(can_overwrite), ignore_missing_src_(ignore_missing_src),
-		     emit_changelog_(emit_changelog), enqueue_work_(enqueue_work), local_tasks_() {
+		     emit_changelog_(emit_changelog), enqueue_work_(enqueue_work),
+		     check_quota_(check_quota), local_tasks_() {
 		assert(subtask_.size() == 1 || (subtask_.size() > 1 && dst_inode == 0));
 		current_subtask_ = subtask_.begin();
 	}
@@ -118,6 +119,8 @@ private:
 	bool emit_changelog_;       /*!< If true change log message should be generated. */
 	bool enqueue_work_;         /*!< If true then new clone request should be created
 	                                 for source inode's children. */
+	bool check_quota_;          /*!< If false then quotas are not checked (e.g. when
+	                                 the clone is already counted in the quotas). */
 	intrusive_list<Task> local_tasks_; /*< List of snapshot tasks created by this
 	                                                   task for source inode's children. */
 };
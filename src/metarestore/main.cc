@@ -34,6 +34,7 @@
 #include <string>
 #include <vector>
 
+#include "common/crc.h"
 #include "common/cwrap.h"
 #include "common/rotate_files.h"
 #include "common/setup.h"
@@ -208,6 +209,8 @@ int main(int argc,char **argv) {
 	gMetadataBackend = std::make_unique<MetadataBackendFile>();
 
 	prepareEnvironment();
+	// For the checksums of the binary changelogs
+	mycrc32_init();
 
 	while ((ch = getopt(argc, argv, "gfck:vm:o:d:abB:xih:z#?")) != -1) {
 		switch (ch) {
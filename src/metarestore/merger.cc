@@ -27,18 +27,16 @@
 #include <string.h>
 #include <syslog.h>
 
+#include "common/changelog_prefetching_reader.h"
 #include "protocol/SFSCommunication.h"
 #include "errors/saunafs_error_codes.h"
 #include "slogger/slogger.h"
 #include "master/restore.h"
 
-#define BSIZE 200000
-
 typedef struct _hentry {
-	FILE *fd;
+	ChangelogPrefetchingReader *reader;
 	char *filename;
-	char *buff;
-	char *ptr;
+	std::string *entry;
 	uint64_t nextid;
 } hentry;
 
@@ -91,8 +89,8 @@ void merger_heap_sort_up(void) {
 
 
 void merger_nextentry(uint32_t pos) {
-	if (fgets(heap[pos].buff,BSIZE,heap[pos].fd)) {
-		uint64_t nextid = strtoull(heap[pos].buff,&(heap[pos].ptr),10);
+	uint64_t nextid;
+	if (heap[pos].reader->next(nextid, *heap[pos].entry)) {
 		if (heap[pos].nextid==0 || (nextid>heap[pos].nextid && nextid<heap[pos].nextid+maxidhole)) {
 			heap[pos].nextid = nextid;
 		} else {
@@ -101,36 +99,33 @@ void merger_nextentry(uint32_t pos) {
 			heap[pos].nextid = 0;
 		}
 	} else {
+		if (!heap[pos].reader->error().empty()) {
+			safs_pretty_syslog(LOG_ERR, "found garbage at the end of file: %s (%s)",
+					heap[pos].filename, heap[pos].reader->error().c_str());
+		}
 		heap[pos].nextid = 0;
 	}
 }
 
 void merger_delete_entry(void) {
-	if (heap[heapsize].fd) {
-		fclose(heap[heapsize].fd);
-	}
+	delete heap[heapsize].reader;
 	if (heap[heapsize].filename) {
 		free(heap[heapsize].filename);
 	}
-	if (heap[heapsize].buff) {
-		free(heap[heapsize].buff);
-	}
+	delete heap[heapsize].entry;
 }
 
 void merger_new_entry(const char *filename) {
 	// printf("add file: %s\n",filename);
-	if ((heap[heapsize].fd = fopen(filename,"r"))!=NULL) {
+	heap[heapsize].reader = new ChangelogPrefetchingReader(filename);
+	heap[heapsize].entry = new std::string();
+	heap[heapsize].nextid = 0;
+	if (heap[heapsize].reader->isOpen()) {
 		heap[heapsize].filename = strdup(filename);
-		heap[heapsize].buff = (char*) malloc(BSIZE);
-		heap[heapsize].ptr = NULL;
-		heap[heapsize].nextid = 0;
 		merger_nextentry(heapsize);
 	} else {
 		safs_pretty_syslog(LOG_ERR, "can't open changelog file: %s", filename);
 		heap[heapsize].filename = NULL;
-		heap[heapsize].buff = NULL;
-		heap[heapsize].ptr = NULL;
-		heap[heapsize].nextid = 0;
 	}
 }
 
@@ -158,8 +153,8 @@ uint8_t merger_loop(void) {
 	hentry h;
 
 	while (heapsize) {
-//              safs_pretty_syslog(LOG_DEBUG, "current id: %" PRIu64 " / %s",heap[0].nextid,heap[0].ptr);
-		if ((status=restore(heap[0].filename, heap[0].nextid, heap[0].ptr,
+//              safs_pretty_syslog(LOG_DEBUG, "current id: %" PRIu64 " / %s",heap[0].nextid,heap[0].entry->c_str());
+		if ((status=restore(heap[0].filename, heap[0].nextid, heap[0].entry->c_str(),
 				RestoreRigor::kIgnoreParseErrors)) != SAUNAFS_STATUS_OK) {
 			while (heapsize) {
 				heapsize--;
@@ -0,0 +1,153 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "mount/chunk_location_cache.h"
+
+#include <algorithm>
+
+#include "protocol/SFSCommunication.h"
+
+ChunkLocationCache gChunkLocationCache;
+
+std::shared_ptr<const ChunkLocationInfo> ChunkLocationCache::find(uint32_t inode,
+		uint32_t index) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	auto inodeIt = inodes_.find(inode);
+	if (inodeIt == inodes_.end()) {
+		return nullptr;
+	}
+	auto &chunks = inodeIt->second.chunks;
+	auto it = chunks.find(index);
+	if (it == chunks.end()) {
+		return nullptr;
+	}
+	if (it->second.expires <= SteadyClock::now()) {
+		chunks.erase(it);
+		--size_;
+		return nullptr;
+	}
+	return it->second.location;
+}
+
+uint32_t ChunkLocationCache::chunksToFetch(uint32_t inode, uint32_t index, uint64_t &epoch) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	makeRoom(0);
+	InodeEntry &entry = inodeEntry(inode);
+	epoch = entry.epoch;
+	uint32_t count = 1;
+	if (index == entry.nextIndex && entry.lastFetched > 0) {
+		// the file is read sequentially
+		count = std::min(2 * entry.lastFetched, kMaxChunksToFetch);
+	}
+	entry.nextIndex = index + count;
+	entry.lastFetched = count;
+	return count;
+}
+
+void ChunkLocationCache::insert(uint32_t inode, uint32_t index, uint64_t epoch,
+		const std::vector<std::shared_ptr<const ChunkLocationInfo>> &chunks) {
+	SteadyTimePoint expires = SteadyClock::now() + std::chrono::milliseconds(timeout_ms_.load());
+	std::unique_lock<std::mutex> lock(mutex_);
+	if (timeout_ms_ == 0) {
+		return;
+	}
+	makeRoom(chunks.size());
+	InodeEntry &entry = inodeEntry(inode);
+	if (entry.epoch != epoch) {
+		return;
+	}
+	for (const auto &location : chunks) {
+		uint64_t chunkEnd = (static_cast<uint64_t>(index) + 1) * SFSCHUNKSIZE;
+		if (chunkEnd > location->fileLength) {
+			break;
+		}
+		auto result = entry.chunks.insert_or_assign(index, Entry{location, expires});
+		if (result.second) {
+			++size_;
+		}
+		++index;
+	}
+}
+
+void ChunkLocationCache::invalidate(uint32_t inode, uint32_t index) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	// Entries created later start with the new epoch as well
+	++epoch_;
+	auto inodeIt = inodes_.find(inode);
+	if (inodeIt != inodes_.end()) {
+		inodeIt->second.epoch = epoch_;
+		size_ -= inodeIt->second.chunks.erase(index);
+	}
+}
+
+void ChunkLocationCache::invalidate(uint32_t inode) {
+	std::unique_lock<std::mutex> lock(mutex_);
+	++epoch_;
+	auto inodeIt = inodes_.find(inode);
+	if (inodeIt != inodes_.end()) {
+		InodeEntry &entry = inodeIt->second;
+		entry.epoch = epoch_;
+		size_ -= entry.chunks.size();
+		entry.chunks.clear();
+		entry.lastFetched = 0;
+	}
+}
+
+void ChunkLocationCache::clear() {
+	std::unique_lock<std::mutex> lock(mutex_);
+	++epoch_;
+	inodes_.clear();
+	size_ = 0;
+}
+
+ChunkLocationCache::InodeEntry &ChunkLocationCache::inodeEntry(uint32_t inode) {
+	auto result = inodes_.try_emplace(inode);
+	if (result.second) {
+		result.first->second.epoch = epoch_;
+	}
+	return result.first->second;
+}
+
+void ChunkLocationCache::makeRoom(uint32_t entries) {
+	if (size_ + entries <= maxEntries_ && inodes_.size() < maxEntries_) {
+		return;
+	}
+	// Entries of inodes without chunks keep only the history of fetches, drop them as well
+	SteadyTimePoint now = SteadyClock::now();
+	for (auto inodeIt = inodes_.begin(); inodeIt != inodes_.end();) {
+		auto &chunks = inodeIt->second.chunks;
+		for (auto it = chunks.begin(); it != chunks.end();) {
+			if (it->second.expires <= now) {
+				it = chunks.erase(it);
+				--size_;
+			} else {
+				++it;
+			}
+		}
+		if (chunks.empty()) {
+			inodeIt = inodes_.erase(inodeIt);
+		} else {
+			++inodeIt;
+		}
+	}
+	if (size_ + entries > maxEntries_ || inodes_.size() >= maxEntries_) {
+		inodes_.clear();
+		size_ = 0;
+	}
+}
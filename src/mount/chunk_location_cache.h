@@ -0,0 +1,120 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/platform.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/time_utils.h"
+#include "mount/chunk_locator.h"
+
+/*! \brief Locations of chunks, shared by all the readers of the mount.
+ *
+ * A reader which doesn't find a chunk here asks the master for a few consecutive chunks
+ * at once, as many as chunksToFetch() says. The number grows while the file is read
+ * sequentially, so a scan of a big file needs few requests to the master and random
+ * reads don't make the master locate chunks nobody needs.
+ *
+ * Only chunks which lie wholly inside the file are kept. The last chunk tells readers
+ * where the file ends, so it is always located anew. Entries are dropped after a timeout,
+ * when the file is changed by this mount and when a reader fails to use them (e.g. the
+ * version of the chunk is not up to date anymore).
+ *
+ * Thread safe.
+ */
+class ChunkLocationCache {
+public:
+	static constexpr uint32_t kDefaultTimeout_ms = 1000;
+	static constexpr uint32_t kDefaultMaxEntries = 1 << 16;
+	static constexpr uint32_t kMaxChunksToFetch = 64;
+
+	explicit ChunkLocationCache(uint32_t timeout_ms = kDefaultTimeout_ms,
+			uint32_t maxEntries = kDefaultMaxEntries)
+			: timeout_ms_(timeout_ms),
+			  maxEntries_(maxEntries),
+			  size_(0),
+			  epoch_(0) {
+	}
+
+	/// Returns the cached location of a chunk or nullptr.
+	std::shared_ptr<const ChunkLocationInfo> find(uint32_t inode, uint32_t index);
+
+	/*! \brief Says how many chunks to ask for, starting at \a index.
+	 *
+	 * \param epoch is set to a value which has to be passed to insert() with the locations.
+	 */
+	uint32_t chunksToFetch(uint32_t inode, uint32_t index, uint64_t &epoch);
+
+	/*! \brief Stores locations of chunks \a index, \a index + 1, ... of \a inode.
+	 *
+	 * Nothing is stored if chunks of \a inode were invalidated since \a epoch was obtained,
+	 * as the locations may be older than the invalidation.
+	 */
+	void insert(uint32_t inode, uint32_t index, uint64_t epoch,
+			const std::vector<std::shared_ptr<const ChunkLocationInfo>> &chunks);
+
+	void invalidate(uint32_t inode, uint32_t index);
+	void invalidate(uint32_t inode);
+	void clear();
+
+	/// Number of cached chunk locations.
+	uint32_t size() const {
+		return size_;
+	}
+
+	/// Timeout, exposed for the .saunafs_tweaks file.
+	std::atomic<uint32_t> &timeout_ms() {
+		return timeout_ms_;
+	}
+
+private:
+	struct Entry {
+		std::shared_ptr<const ChunkLocationInfo> location;
+		SteadyTimePoint expires;
+	};
+
+	struct InodeEntry {
+		std::map<uint32_t, Entry> chunks;
+		uint32_t nextIndex = 0;    ///< Index following the chunks fetched last time.
+		uint32_t lastFetched = 0;  ///< Number of chunks fetched last time.
+		uint64_t epoch = 0;        ///< Changed whenever chunks of the inode are invalidated.
+	};
+
+	/// Returns the entry of \a inode, creates it if needed. Requires mutex_.
+	InodeEntry &inodeEntry(uint32_t inode);
+
+	/// Drops expired entries (or everything) if \a entries more wouldn't fit in the cache.
+	void makeRoom(uint32_t entries);
+
+	std::atomic<uint32_t> timeout_ms_;
+	uint32_t maxEntries_;
+	std::atomic<uint32_t> size_;
+	uint64_t epoch_;  ///< Source of epochs of the inodes.
+	std::unordered_map<uint32_t, InodeEntry> inodes_;
+	std::mutex mutex_;
+};
+
+extern ChunkLocationCache gChunkLocationCache;
@@ -0,0 +1,142 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+#include "mount/chunk_location_cache.h"
+
+#include <chrono>
+#include <thread>
+#include <gtest/gtest.h>
+
+#include "protocol/SFSCommunication.h"
+
+static std::vector<std::shared_ptr<const ChunkLocationInfo>> locations(uint64_t firstChunkId,
+		uint32_t count, uint64_t fileLength) {
+	std::vector<std::shared_ptr<const ChunkLocationInfo>> result;
+	for (uint32_t i = 0; i < count; ++i) {
+		result.push_back(std::make_shared<ChunkLocationInfo>(firstChunkId + i, 1, fileLength,
+				ChunkLocationInfo::ChunkLocations()));
+	}
+	return result;
+}
+
+TEST(ChunkLocationCacheTests, InsertAndFind) {
+	ChunkLocationCache cache;
+	uint64_t epoch;
+	EXPECT_EQ(cache.find(1, 0), nullptr);
+	cache.chunksToFetch(1, 0, epoch);
+	cache.insert(1, 0, epoch, locations(100, 3, 3 * SFSCHUNKSIZE));
+	ASSERT_NE(cache.find(1, 0), nullptr);
+	EXPECT_EQ(cache.find(1, 0)->chunkId, 100U);
+	EXPECT_EQ(cache.find(1, 2)->chunkId, 102U);
+	EXPECT_EQ(cache.find(1, 3), nullptr);
+	EXPECT_EQ(cache.find(2, 0), nullptr);
+	EXPECT_EQ(cache.size(), 3U);
+}
+
+TEST(ChunkLocationCacheTests, LastChunkIsNotCached) {
+	ChunkLocationCache cache;
+	uint64_t epoch;
+	cache.chunksToFetch(1, 5, epoch);
+	cache.insert(1, 5, epoch, locations(100, 3, 7 * SFSCHUNKSIZE + 1));
+	EXPECT_NE(cache.find(1, 5), nullptr);
+	EXPECT_NE(cache.find(1, 6), nullptr);
+	EXPECT_EQ(cache.find(1, 7), nullptr);
+	EXPECT_EQ(cache.size(), 2U);
+}
+
+TEST(ChunkLocationCacheTests, ChunksToFetch) {
+	ChunkLocationCache cache;
+	uint64_t epoch;
+	EXPECT_EQ(cache.chunksToFetch(1, 0, epoch), 1U);
+	EXPECT_EQ(cache.chunksToFetch(1, 1, epoch), 2U);
+	EXPECT_EQ(cache.chunksToFetch(1, 3, epoch), 4U);
+	EXPECT_EQ(cache.chunksToFetch(2, 0, epoch), 1U);
+	EXPECT_EQ(cache.chunksToFetch(1, 7, epoch), 8U);
+	EXPECT_EQ(cache.chunksToFetch(1, 100, epoch), 1U);
+	uint32_t index = 101;
+	for (int i = 0; i < 10; ++i) {
+		index += cache.chunksToFetch(1, index, epoch);
+	}
+	EXPECT_EQ(cache.chunksToFetch(1, index, epoch), ChunkLocationCache::kMaxChunksToFetch);
+}
+
+TEST(ChunkLocationCacheTests, Invalidate) {
+	ChunkLocationCache cache;
+	uint64_t epoch;
+	cache.chunksToFetch(1, 0, epoch);
+	cache.insert(1, 0, epoch, locations(100, 4, 4 * SFSCHUNKSIZE));
+	cache.chunksToFetch(2, 0, epoch);
+	cache.insert(2, 0, epoch, locations(200, 4, 4 * SFSCHUNKSIZE));
+
+	cache.invalidate(1, 1);
+	EXPECT_NE(cache.find(1, 0), nullptr);
+	EXPECT_EQ(cache.find(1, 1), nullptr);
+	EXPECT_EQ(cache.size(), 7U);
+
+	cache.invalidate(2);
+	EXPECT_EQ(cache.find(2, 0), nullptr);
+	EXPECT_NE(cache.find(1, 0), nullptr);
+	EXPECT_EQ(cache.size(), 3U);
+
+	cache.clear();
+	EXPECT_EQ(cache.find(1, 0), nullptr);
+	EXPECT_EQ(cache.size(), 0U);
+}
+
+TEST(ChunkLocationCacheTests, LocationsFetchedBeforeInvalidationAreDropped) {
+	ChunkLocationCache cache;
+	uint64_t epoch1, epoch2;
+	cache.chunksToFetch(1, 0, epoch1);
+	cache.chunksToFetch(2, 0, epoch2);
+	cache.invalidate(1);
+	cache.insert(1, 0, epoch1, locations(100, 2, 2 * SFSCHUNKSIZE));
+	cache.insert(2, 0, epoch2, locations(200, 2, 2 * SFSCHUNKSIZE));
+	EXPECT_EQ(cache.find(1, 0), nullptr);
+	EXPECT_NE(cache.find(2, 0), nullptr);
+
+	cache.chunksToFetch(1, 0, epoch1);
+	cache.insert(1, 0, epoch1, locations(100, 2, 2 * SFSCHUNKSIZE));
+	EXPECT_NE(cache.find(1, 0), nullptr);
+}
+
+TEST(ChunkLocationCacheTests, Expiration) {
+	ChunkLocationCache cache(20);
+	uint64_t epoch;
+	cache.chunksToFetch(1, 0, epoch);
+	cache.insert(1, 0, epoch, locations(100, 2, 2 * SFSCHUNKSIZE));
+	EXPECT_NE(cache.find(1, 0), nullptr);
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	EXPECT_EQ(cache.find(1, 0), nullptr);
+
+	cache.timeout_ms() = 0;
+	cache.chunksToFetch(1, 0, epoch);
+	cache.insert(1, 0, epoch, locations(100, 2, 2 * SFSCHUNKSIZE));
+	EXPECT_EQ(cache.find(1, 0), nullptr);
+}
+
+TEST(ChunkLocationCacheTests, SizeIsLimited) {
+	ChunkLocationCache cache(ChunkLocationCache::kDefaultTimeout_ms, 10);
+	uint64_t epoch;
+	for (uint32_t inode = 1; inode <= 20; ++inode) {
+		cache.chunksToFetch(inode, 0, epoch);
+		cache.insert(inode, 0, epoch, locations(100 * inode, 3, 3 * SFSCHUNKSIZE));
+		EXPECT_LE(cache.size(), 10U);
+		EXPECT_NE(cache.find(inode, 2), nullptr);
+	}
+}
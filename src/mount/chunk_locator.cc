@@ -26,13 +26,17 @@
 #include "common/exceptions.h"
 #include "errors/sfserr.h"
 #include "devtools/request_log.h"
+#include "mount/chunk_location_cache.h"
 #include "mount/mastercomm.h"
 
 void ReadChunkLocator::invalidateCache(uint32_t inode, uint32_t index) {
-	std::unique_lock<std::mutex> lock(mutex_);
-	if (cache_ && inode == inode_ && index == index_) {
-		cache_ = nullptr;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (cache_ && inode == inode_ && index == index_) {
+			cache_ = nullptr;
+		}
 	}
+	gChunkLocationCache.invalidate(inode, index);
 }
 
 std::shared_ptr<const ChunkLocationInfo> ReadChunkLocator::locateChunk(uint32_t inode, uint32_t index) {
@@ -42,6 +46,52 @@ std::shared_ptr<const ChunkLocationInfo> ReadChunkLocator::locateChunk(uint32_t
 			return cache_;
 		}
 	}
+	std::shared_ptr<const ChunkLocationInfo> location = gChunkLocationCache.find(inode, index);
+	if (!location) {
+		location = fs_can_read_many_chunks() ? locateChunks(inode, index)
+		                                     : locateSingleChunk(inode, index);
+	}
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		inode_ = inode;
+		index_ = index;
+		cache_ = location;
+		return cache_;
+	}
+}
+
+std::shared_ptr<const ChunkLocationInfo> ReadChunkLocator::locateChunks(uint32_t inode,
+		uint32_t index) {
+	LOG_AVG_TILL_END_OF_SCOPE0("ReadChunkLocator::locateChunks");
+	uint64_t epoch;
+	uint32_t count = gChunkLocationCache.chunksToFetch(inode, index, epoch);
+	std::vector<ChunkWithVersionAndLocations> chunks;
+	uint64_t fileLength;
+	uint8_t status = fs_saureadchunks(chunks, fileLength, inode, index, count);
+	if (status != SAUNAFS_STATUS_OK) {
+		if (status == SAUNAFS_ERROR_ENOENT) {
+			throw UnrecoverableReadException("Chunk locator: error sent by master server", status);
+		} else {
+			throw RecoverableReadException("Chunk locator: error sent by master server", status);
+		}
+	}
+	if (chunks.empty()) {
+		// the chunk lies beyond the end of the file
+		return std::make_shared<ChunkLocationInfo>(0, 0, fileLength,
+				ChunkLocationInfo::ChunkLocations());
+	}
+	std::vector<std::shared_ptr<const ChunkLocationInfo>> locations;
+	locations.reserve(chunks.size());
+	for (auto &chunk : chunks) {
+		locations.push_back(std::make_shared<ChunkLocationInfo>(chunk.chunk_id,
+				chunk.chunk_version, fileLength, std::move(chunk.locations)));
+	}
+	gChunkLocationCache.insert(inode, index, epoch, locations);
+	return locations.front();
+}
+
+std::shared_ptr<const ChunkLocationInfo> ReadChunkLocator::locateSingleChunk(uint32_t inode,
+		uint32_t index) {
 	LOG_AVG_TILL_END_OF_SCOPE0("ReadChunkLocator::locateChunk");
 	uint64_t chunkId;
 	uint32_t version;
@@ -79,13 +129,7 @@ std::shared_ptr<const ChunkLocationInfo> ReadChunkLocator::locateChunk(uint32_t
 		}
 	}
 #endif
-	{
-		std::unique_lock<std::mutex> lock(mutex_);
-		inode_ = inode;
-		index_ = index;
-		cache_ = std::make_shared<ChunkLocationInfo>(chunkId, version, fileLength, locations);
-		return cache_;
-	}
+	return std::make_shared<ChunkLocationInfo>(chunkId, version, fileLength, locations);
 }
 
 void WriteChunkLocator::locateAndLockChunk(uint32_t inode, uint32_t index) {
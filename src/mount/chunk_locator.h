@@ -60,7 +60,8 @@ struct ChunkLocationInfo {
 };
 
 // Intended to be instantiated per descriptor.
-// May cache locations of previously queried chunks.
+// Remembers the location of the last queried chunk, looks for other chunks in
+// gChunkLocationCache before asking the master.
 // Thread safe.
 class ReadChunkLocator {
 public:
@@ -71,6 +72,10 @@ public:
 	void invalidateCache(uint32_t inode, uint32_t index);
 
 private:
+	// Asks the master for the chunk and a few following ones, caches them in gChunkLocationCache
+	std::shared_ptr<const ChunkLocationInfo> locateChunks(uint32_t inode, uint32_t index);
+	std::shared_ptr<const ChunkLocationInfo> locateSingleChunk(uint32_t inode, uint32_t index);
+
 	uint32_t inode_;
 	uint32_t index_;
 
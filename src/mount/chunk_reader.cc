@@ -48,7 +48,10 @@ void ChunkReader::prepareReadingChunk(uint32_t inode, uint32_t index, bool force
 	++preparations;
 	inode_ = inode;
 	index_ = index;
-	locator_->invalidateCache(inode, index);
+	if (force_prepare) {
+		// the location we know may be out of date
+		locator_->invalidateCache(inode, index);
+	}
 	location_ = locator_->locateChunk(inode, index);
 	chunkAlreadyRead = false;
 	if (location_->isEmptyChunk()) {
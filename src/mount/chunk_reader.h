@@ -46,6 +46,7 @@ public:
 	 * Uses a locator to locate the chunk and chooses chunkservers to read from.
 	 * Doesn't do anything if the chunk given by (inode, index) is already known to the reader
 	 * (ie. the last call to this method had the same inode and index) unless forcePrepare is true.
+	 * With forcePrepare the chunk is located by the master, not taken from a cache.
 	 */
 	void prepareReadingChunk(uint32_t inode, uint32_t index, bool forcePrepare);
 
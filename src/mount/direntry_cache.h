@@ -23,6 +23,7 @@
 #include <atomic>
 #include <limits>
 #include <sstream>
+#include <vector>
 
 #include "common/attributes.h"
 #include "common/shared_mutex.h"
@@ -182,7 +183,7 @@ public:
 	 * \param timeout    cache entry expiration timeout (us).
 	 */
 	DirEntryCache(uint64_t timeout = kDefaultTimeout_us)
-	    : timer_(), current_time_(0), timeout_(timeout) {
+	    : timer_(), current_time_(0), timeout_(timeout), invalidation_time_(0) {
 	}
 
 	~DirEntryCache() {
@@ -326,7 +327,7 @@ public:
 	            uint64_t index, uint64_t next_index, const std::string name,
 				const Attributes &attr, uint64_t timestamp) {
 		// Avoid inserting stale data
-		if (timestamp + timeout_ <= current_time_) {
+		if (isStale(timestamp)) {
 			return;
 		}
 		removeExpired(1, timestamp);
@@ -358,7 +359,7 @@ public:
 	            uint32_t inode, const std::string name, const Attributes &attr,
 	            uint64_t timestamp) {
 		// Avoid inserting stale data
-		if (timestamp + timeout_ <= current_time_) {
+		if (isStale(timestamp)) {
 			return;
 		}
 		removeExpired(1, timestamp);
@@ -383,7 +384,7 @@ public:
 	void insert(const SaunaClient::Context &ctx, uint32_t inode,
 	            const Attributes &attr, uint64_t timestamp) {
 		// Avoid inserting stale data
-		if (timestamp + timeout_ <= current_time_) {
+		if (isStale(timestamp)) {
 			return;
 		}
 		removeExpired(1, timestamp);
@@ -405,7 +406,7 @@ public:
 	void insertSequence(const SaunaClient::Context &ctx, uint32_t parent_inode,
 	                      const Container &container, uint64_t timestamp) {
 		// Avoid inserting stale data
-		if (timestamp + timeout_ <= current_time_) {
+		if (isStale(timestamp)) {
 			return;
 		}
 		removeExpired(container.size(), timestamp);
@@ -463,12 +464,7 @@ public:
 	 */
 	void lockAndInvalidateInode(uint32_t inode) {
 		std::unique_lock<SharedMutex> guard(rwlock_);
-		auto it = inode_multiset_.find(inode, InodeCompare());
-		while (it != inode_multiset_.end() && it->inode == inode) {
-			DirEntry *entry = std::addressof(*it);
-			++it;
-			erase(entry);
-		}
+		invalidateInode(inode);
 	}
 
 	/*! \brief Remove data from cache matching specified criteria.
@@ -479,25 +475,7 @@ public:
 	 */
 	void lockAndInvalidateParent(uint32_t parent_inode) {
 		std::unique_lock<SharedMutex> guard(rwlock_);
-		// lookup_set_ should contain all the elements inside index_set
-		auto it = lookup_set_.lower_bound(
-		    std::make_tuple(parent_inode, 0, 0, ""), LookupCompare());
-		while (it != lookup_set_.end() && it->parent_inode == parent_inode) {
-			DirEntry *entry = std::addressof(*it);
-			++it;
-			erase(entry);
-		}
-
-		// Make sure inode_multiset_ is also clean of outdated entries.
-		// There are scenarios where we can not determine yet the inodes from
-		// the parent, like in unlink
-		auto iter = inode_multiset_.lower_bound(parent_inode, InodeCompare());
-
-		while (iter != inode_multiset_.end() && iter->inode == parent_inode) {
-			DirEntry *entry = std::addressof(*iter);
-			++iter;
-			erase(entry);
-		}
+		invalidateParent(parent_inode);
 	}
 
 	/*! \brief Remove data from cache matching specified criteria.
@@ -538,6 +516,44 @@ public:
 		}
 	}
 
+	/*! \brief Remove data reported as changed by the master.
+	 *
+	 * Data obtained before this call is not inserted any more, as it could
+	 * have been read from the master before the change.
+	 *
+	 * \warning This function takes write (unique) lock.
+	 *
+	 * \param inodes Inodes whose attributes have changed. The master stops
+	 *               reporting changes of such an inode, so if it is
+	 *               a directory, its entries are removed as well.
+	 * \param parent_inodes Directories whose entries have changed.
+	 */
+	void lockAndInvalidateChanges(const std::vector<uint32_t> &inodes,
+	                              const std::vector<uint32_t> &parent_inodes) {
+		std::unique_lock<SharedMutex> guard(rwlock_);
+		for (uint32_t inode : inodes) {
+			invalidateInode(inode);
+			invalidateParent(inode);
+		}
+		for (uint32_t parent_inode : parent_inodes) {
+			invalidateParent(parent_inode);
+		}
+		invalidation_time_ = updateTime() + 1;
+	}
+
+	/*! \brief Remove all elements from cache and set entry expiration timeout (us).
+	 *
+	 * Data obtained before this call is not inserted any more.
+	 *
+	 * \warning This function takes write (unique) lock.
+	 */
+	void lockAndReset(uint64_t timeout) {
+		std::unique_lock<SharedMutex> guard(rwlock_);
+		clearUnlocked();
+		timeout_ = timeout;
+		invalidation_time_ = updateTime() + 1;
+	}
+
 	IndexSet::const_iterator index_end() const {
 		return index_set_.end();
 	}
@@ -597,12 +613,7 @@ public:
 	 */
 	void clear() {
 		std::unique_lock<SharedMutex> guard(rwlock_);
-		auto it = fifo_list_.begin();
-		while (it != fifo_list_.end()) {
-			auto next_it = std::next(it);
-			erase(std::addressof(*it));
-			it = next_it;
-		}
+		clearUnlocked();
 	}
 
 	/*! \brief Update internal time to wall time.
@@ -664,6 +675,51 @@ protected:
 		return entry.timestamp + timeout_ <= timestamp;
 	}
 
+	/*! \brief Check if data obtained at given time should not be cached. */
+	bool isStale(uint64_t timestamp) const {
+		return timestamp + timeout_ <= current_time_ || timestamp < invalidation_time_;
+	}
+
+	void clearUnlocked() {
+		auto it = fifo_list_.begin();
+		while (it != fifo_list_.end()) {
+			auto next_it = std::next(it);
+			erase(std::addressof(*it));
+			it = next_it;
+		}
+	}
+
+	void invalidateInode(uint32_t inode) {
+		auto it = inode_multiset_.find(inode, InodeCompare());
+		while (it != inode_multiset_.end() && it->inode == inode) {
+			DirEntry *entry = std::addressof(*it);
+			++it;
+			erase(entry);
+		}
+	}
+
+	void invalidateParent(uint32_t parent_inode) {
+		// lookup_set_ should contain all the elements inside index_set
+		auto it = lookup_set_.lower_bound(
+		    std::make_tuple(parent_inode, 0, 0, ""), LookupCompare());
+		while (it != lookup_set_.end() && it->parent_inode == parent_inode) {
+			DirEntry *entry = std::addressof(*it);
+			++it;
+			erase(entry);
+		}
+
+		// Make sure inode_multiset_ is also clean of outdated entries.
+		// There are scenarios where we can not determine yet the inodes from
+		// the parent, like in unlink
+		auto iter = inode_multiset_.lower_bound(parent_inode, InodeCompare());
+
+		while (iter != inode_multiset_.end() && iter->inode == parent_inode) {
+			DirEntry *entry = std::addressof(*iter);
+			++iter;
+			erase(entry);
+		}
+	}
+
 	void overwriteEntry(DirEntry &entry, DirectoryEntry de, uint64_t timestamp) {
 		if (entry.inode != de.inode) {
 			inode_multiset_.erase(inode_multiset_.iterator_to(entry));
@@ -720,6 +776,7 @@ protected:
 	Timer timer_;
 	std::atomic<uint64_t> current_time_;
 	uint64_t timeout_;
+	uint64_t invalidation_time_;
 	LookupSet lookup_set_;
 	IndexSet index_set_;
 	InodeMultiset inode_multiset_;
@@ -421,3 +421,37 @@ TEST(DirEntryCache, InvalidateParentItself) {
 	ASSERT_TRUE(cache.lookup(SaunaClient::Context(1, 0, 0, 0), 22, attr));
 	ASSERT_EQ(attr[0], 0);
 }
+
+TEST(DirEntryCache, InvalidateChanges) {
+	DirEntryCacheIntrospect cache(5000000);
+
+	Attributes dummy_attributes;
+	dummy_attributes.fill(0);
+	auto request_time = cache.updateTime();
+
+	cache.insert(SaunaClient::Context(0, 0, 0, 0), 1, 10, "a", dummy_attributes, request_time);
+	cache.insert(SaunaClient::Context(0, 0, 0, 0), 2, 20, "b", dummy_attributes, request_time);
+	cache.insert(SaunaClient::Context(0, 0, 0, 0), 3, 30, "c", dummy_attributes, request_time);
+
+	cache.lockAndInvalidateChanges({10}, {2});
+
+	Attributes attr;
+	uint32_t inode;
+	ASSERT_FALSE(cache.lookup(SaunaClient::Context(0, 0, 0, 0), 10, attr));
+	ASSERT_FALSE(cache.lookup(SaunaClient::Context(0, 0, 0, 0), 2, "b", inode, attr));
+	ASSERT_TRUE(cache.lookup(SaunaClient::Context(0, 0, 0, 0), 3, "c", inode, attr));
+	ASSERT_EQ(inode, 30U);
+
+	// Replies to requests sent before the invalidation might be outdated
+	cache.insert(SaunaClient::Context(0, 0, 0, 0), 1, 10, "a", dummy_attributes, request_time);
+	ASSERT_FALSE(cache.lookup(SaunaClient::Context(0, 0, 0, 0), 10, attr));
+
+	cache.insert(SaunaClient::Context(0, 0, 0, 0), 1, 10, "a", dummy_attributes,
+	             cache.updateTime() + 1);
+	ASSERT_TRUE(cache.lookup(SaunaClient::Context(0, 0, 0, 0), 10, attr));
+
+	cache.lockAndReset(10000000);
+	ASSERT_EQ(cache.size(), 0U);
+	cache.insert(SaunaClient::Context(0, 0, 0, 0), 1, 10, "a", dummy_attributes, request_time);
+	ASSERT_FALSE(cache.lookup(SaunaClient::Context(0, 0, 0, 0), 10, attr));
+}
@@ -229,6 +229,7 @@ static int mainloop(struct fuse_args *args, struct fuse_cmdline_opts *fuse_opts,
 	params.do_not_remember_password = gMountOptions.donotrememberpassword;
 	params.delayed_init = gMountOptions.delayedinit;
 	params.report_reserved_period = gMountOptions.reportreservedperiod;
+	params.master_connections = gMountOptions.masterconnections;
 	params.io_retries = gMountOptions.ioretries;
 	params.io_limits_config_file = gMountOptions.iolimits ? gMountOptions.iolimits : "";
 	params.bandwidth_overuse = gMountOptions.bandwidthoveruse;
@@ -251,6 +252,7 @@ static int mainloop(struct fuse_args *args, struct fuse_cmdline_opts *fuse_opts,
 	params.keep_cache = gMountOptions.keepcache;
 	params.direntry_cache_timeout = gMountOptions.direntrycacheto;
 	params.direntry_cache_size = gMountOptions.direntrycachesize;
+	params.notified_cache_timeout = gMountOptions.notifiedcacheto;
 	params.entry_cache_timeout = gMountOptions.entrycacheto;
 	params.attr_cache_timeout = gMountOptions.attrcacheto;
 	params.mkdir_copy_sgid = gMountOptions.mkdircopysgid;
@@ -339,12 +341,20 @@ static int mainloop(struct fuse_args *args, struct fuse_cmdline_opts *fuse_opts,
 		}
 	}
 
+	bool invalidateKernelCache = !gMountOptions.meta && gMountOptions.notifiedcacheto > 0;
+	if (invalidateKernelCache) {
+		sfs_start_kernel_cache_invalidation(se);
+	}
+
 	int err;
 	if (multithread) {
 		err = fuse_session_loop_mt(se, fuse_opts->clone_fd);
 	} else {
 		err = fuse_session_loop(se);
 	}
+	if (invalidateKernelCache) {
+		sfs_stop_kernel_cache_invalidation();
+	}
 	fuse_remove_signal_handlers(se);
 	fuse_session_unmount(se);
 	fuse_session_destroy(se);
@@ -76,6 +76,7 @@ struct fuse_opt gSfsOptsStage2[] = {
 	SFS_OPT("sfsdirentrycacheto=%lf", direntrycacheto, 0),
 	SFS_OPT("sfsaclcacheto=%lf", aclcacheto, 0),
 	SFS_OPT("sfsreportreservedperiod=%u", reportreservedperiod, 0),
+	SFS_OPT("sfsmasterconnections=%u", masterconnections, 0),
 	SFS_OPT("sfsiolimits=%s", iolimits, 0),
 	SFS_OPT("sfschunkserverrtt=%d", chunkserverrtt, 0),
 	SFS_OPT("sfschunkserverconnectreadto=%d", chunkserverconnectreadto, 0),
@@ -91,6 +92,7 @@ struct fuse_opt gSfsOptsStage2[] = {
 	SFS_OPT("symlinkcachetimeout=%d", symlinkcachetimeout, 3600),
 	SFS_OPT("bandwidthoveruse=%lf", bandwidthoveruse, 1),
 	SFS_OPT("sfsdirentrycachesize=%u", direntrycachesize, 0),
+	SFS_OPT("sfsnotifiedcacheto=%lf", notifiedcacheto, 0),
 	SFS_OPT("nostdmountoptions", nostdmountoptions, 1),
 	SFS_OPT("sfsignoreflush=%d", ignoreflush, 0),
 	SFS_OPT("limitglibcmallocarenas=%d", limitglibcmallocarenas, 0),
@@ -208,9 +210,14 @@ void usage(const char *progname) {
 				"(default: %.2f)\n"
 "    -o sfsdirentrycachesize=N   define directory entry cache size in number "
 				"of entries (default: %u)\n"
+"    -o sfsnotifiedcacheto=SEC   set directory entry cache timeout in seconds used "
+				"while the master reports changes of the cached entries (default: %.2f, "
+				"i.e. changes are not reported)\n"
 "    -o sfsaclcacheto=SEC        set ACL cache timeout in seconds (default: %.2f)\n"
 "    -o sfsreportreservedperiod=SEC  set reporting reserved inodes interval in "
 				"seconds (default: %u)\n"
+"    -o sfsmasterconnections=N   define number of connections to the master "
+				"carrying metadata requests (default: %u)\n"
 "    -o sfschunkserverrtt=MSEC   set timeout after which SYN packet is "
 				"considered lost during the first retry of "
 				"connecting a chunkserver (default: %u)\n"
@@ -266,8 +273,10 @@ void usage(const char *progname) {
 		SaunaClient::FsInitParams::kDefaultEntryCacheTimeout,
 		SaunaClient::FsInitParams::kDefaultDirentryCacheTimeout,
 		SaunaClient::FsInitParams::kDefaultDirentryCacheSize,
+		SaunaClient::FsInitParams::kDefaultNotifiedCacheTimeout,
 		SaunaClient::FsInitParams::kDefaultAclCacheTimeout,
 		SaunaClient::FsInitParams::kDefaultReportReservedPeriod,
+		SaunaClient::FsInitParams::kDefaultMasterConnections,
 		SaunaClient::FsInitParams::kDefaultRoundTime,
 		SaunaClient::FsInitParams::kDefaultChunkserverWaveReadTo,
 		SaunaClient::FsInitParams::kDefaultAclCacheSize,
@@ -97,7 +97,9 @@ struct sfsopts_ {
 	double entrycacheto;
 	double direntrycacheto;
 	unsigned direntrycachesize;
+	double notifiedcacheto;
 	unsigned reportreservedperiod;
+	unsigned masterconnections;
 	char *iolimits;
 	int chunkserverrtt;
 	int chunkserverconnectreadto;
@@ -157,7 +159,9 @@ struct sfsopts_ {
 		entrycacheto(SaunaClient::FsInitParams::kDefaultEntryCacheTimeout),
 		direntrycacheto(SaunaClient::FsInitParams::kDefaultDirentryCacheTimeout),
 		direntrycachesize(SaunaClient::FsInitParams::kDefaultDirentryCacheSize),
+		notifiedcacheto(SaunaClient::FsInitParams::kDefaultNotifiedCacheTimeout),
 		reportreservedperiod(SaunaClient::FsInitParams::kDefaultReportReservedPeriod),
+		masterconnections(SaunaClient::FsInitParams::kDefaultMasterConnections),
 		iolimits(NULL),
 		chunkserverrtt(SaunaClient::FsInitParams::kDefaultRoundTime),
 		chunkserverconnectreadto(SaunaClient::FsInitParams::kDefaultChunkserverConnectTo),
@@ -22,10 +22,15 @@
 #include "mount/fuse/sfs_fuse.h"
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
+#include <pthread.h>
 
 #include "common/lru_cache.h"
 #include "common/massert.h"
@@ -748,3 +753,104 @@ void safs_flock(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi, int o
 		}
 	}
 }
+
+namespace {
+
+/// Sends the changes reported by the master to the kernel. Such a notification waits
+/// for the kernel locks of the node, which may be held by an operation waiting for
+/// the master, so they are sent by a separate thread, not by one receiving packets.
+class KernelCacheInvalidator {
+public:
+	explicit KernelCacheInvalidator(struct fuse_session *se)
+			: se_(se),
+			  terminate_(false),
+			  thread_(&KernelCacheInvalidator::run, this) {
+	}
+
+	~KernelCacheInvalidator() {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			terminate_ = true;
+		}
+		cond_.notify_one();
+		thread_.join();
+	}
+
+	void invalidateInode(fuse_ino_t inode) {
+		push(Notice{0, inode, std::string()});
+	}
+
+	void invalidateEntry(fuse_ino_t parent, const std::string &name) {
+		push(Notice{parent, 0, name});
+	}
+
+private:
+	struct Notice {
+		fuse_ino_t parent;  // 0 for changed attributes of the inode
+		fuse_ino_t inode;
+		std::string name;
+	};
+
+	// The kernel caches expire anyway, notices above the limit are dropped
+	static constexpr std::size_t kMaxQueuedNotices = 100000;
+
+	void push(Notice notice) {
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (queue_.size() >= kMaxQueuedNotices) {
+			return;
+		}
+		queue_.push_back(std::move(notice));
+		cond_.notify_one();
+	}
+
+	void run() {
+		pthread_setname_np(pthread_self(), "kernelInval");
+		std::unique_lock<std::mutex> lock(mutex_);
+		for (;;) {
+			cond_.wait(lock, [this]() { return terminate_ || !queue_.empty(); });
+			if (terminate_) {
+				return;
+			}
+			Notice notice = std::move(queue_.front());
+			queue_.pop_front();
+			lock.unlock();
+			// ENOENT only means the kernel doesn't cache the node
+			if (notice.parent == 0) {
+				fuse_lowlevel_notify_inval_inode(se_, notice.inode, -1, 0);
+			} else {
+				fuse_lowlevel_notify_inval_entry(se_, notice.parent, notice.name.c_str(),
+						notice.name.size());
+			}
+			lock.lock();
+		}
+	}
+
+	struct fuse_session *se_;
+	std::mutex mutex_;
+	std::condition_variable cond_;
+	std::deque<Notice> queue_;
+	bool terminate_;
+	std::thread thread_;
+};
+
+std::unique_ptr<KernelCacheInvalidator> gKernelCacheInvalidator;
+
+} // anonymous namespace
+
+void sfs_start_kernel_cache_invalidation(struct fuse_session *se) {
+	gKernelCacheInvalidator = std::make_unique<KernelCacheInvalidator>(se);
+	KernelCacheInvalidator *invalidator = gKernelCacheInvalidator.get();
+	SaunaClient::setKernelCacheInvalidation(
+			[invalidator](SaunaClient::Inode inode) {
+				invalidator->invalidateInode(inode);
+			},
+			[invalidator](SaunaClient::Inode parent, const std::string &name) {
+				invalidator->invalidateEntry(parent, name);
+			});
+}
+
+void sfs_stop_kernel_cache_invalidation() {
+	// No callback is running when this returns
+	SaunaClient::setKernelCacheInvalidation({}, {});
+	gKernelCacheInvalidator.reset();
+}
@@ -62,3 +62,7 @@ void sfs_removexattr (fuse_req_t req, fuse_ino_t ino, const char *name);
 void safs_getlk(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi, struct flock *lock);
 void safs_setlk(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi, struct flock *lock, int sleep) ;
 void safs_flock(fuse_req_t req, fuse_ino_t ino, struct fuse_file_info *fi, int op);
+
+/// Starts passing the changes reported by the master (see sfsnotifiedcacheto) to the kernel.
+void sfs_start_kernel_cache_invalidation(struct fuse_session *se);
+void sfs_stop_kernel_cache_invalidation();
@@ -29,8 +29,11 @@
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -58,8 +61,9 @@
 #include "protocol/SFSCommunication.h"
 #include "protocol/packet.h"
 
+struct MasterConnection;
+
 struct threc {
-	pthread_t thid;
 	std::mutex mutex;
 	std::condition_variable condition;
 	MessageBuffer outputBuffer;
@@ -72,7 +76,8 @@ struct threc {
 	uint32_t receivedType;
 
 	uint32_t packetId;      // thread number
-	threc *next;
+	MasterConnection *connection;  // connection carrying the requests of the record
+	MasterConnection *sentOn;      // connection the last request was actually sent on
 
 	~threc() {
 		pthread_mutex_destroy(mutex.native_handle());
@@ -84,12 +89,54 @@ struct threc {
 #define NO_DATA_RECEIVED_FROM_MASTER NULL
 #define RECEIVE_TIMEOUT 10
 
-static threc *threchead=NULL;
+/// Limit of the requests a thread has in flight in the batch functions (fs_*_batch)
+static constexpr uint32_t kMaxRequestsInFlight = 64;
+
+/*! \brief Table of the request records indexed by their packetId.
+ *
+ * Pages are only ever added (and freed in fs_term, after the receive thread is joined),
+ * so the receive thread finds the record of each answer without taking recMutex.
+ */
+static constexpr uint32_t kThrecPageBits = 10;
+static constexpr uint32_t kThrecPageSize = 1U << kThrecPageBits;
+static constexpr uint32_t kThrecPages = 1024;
+struct ThrecPage {
+	std::array<std::atomic<threc *>, kThrecPageSize> slots{};
+};
+static std::array<std::atomic<ThrecPage *>, kThrecPages> threcPages{};
+
+static std::vector<threc *> threcs;      // all records, guarded by recMutex
+static std::vector<threc *> freeThrecs;  // records of finished threads, guarded by recMutex
+static std::atomic<uint64_t> threcGeneration(0);  // bumped when fs_term frees the records
+
+/// Request records of the current thread, handed back for reuse when the thread exits.
+struct ThrecHolder {
+	threc *rec = nullptr;
+	std::vector<threc *> batch;  // additional records, for having several requests in flight
+	uint64_t generation = 0;
+	~ThrecHolder();
+};
+static thread_local ThrecHolder myThrec;
+
+/*! \brief A TCP connection to the master.
+ *
+ * mainConnection registers the session and carries its housekeeping (NOPs, reserved
+ * inodes). The additional connections (sfsmasterconnections) join the same session and
+ * only carry the requests of the records assigned to them, each having its own receive
+ * thread.
+ */
+struct MasterConnection {
+	int fd = -1;
+	bool disconnect = false;
+	time_t lastwrite = 0;
+	uint32_t sessionid = 0;  // session an additional connection is registered to
+	std::mutex mutex;        // guards the fields above and writing to fd
+	pthread_t receiveThread;
+};
 
-static int fd;
-static bool disconnect;
-static time_t lastwrite;
-static int sessionlost;
+static MasterConnection mainConnection;
+static std::vector<std::unique_ptr<MasterConnection>> extraConnections;
+static std::atomic<int> sessionlost;
 
 // This constant means no master side mapping of uid/gid coming from client
 #define DEFAULT_UID_GID_MAPPING 999
@@ -102,8 +149,8 @@ int *mountingGid = nullptr;
 
 static uint32_t maxretries;
 
-static pthread_t rpthid,npthid;
-static std::mutex fdMutex, recMutex;
+static pthread_t npthid;
+static std::mutex recMutex;
 
 static uint32_t sessionid;
 static uint32_t masterversion;
@@ -114,7 +161,7 @@ static uint16_t masterport=0;
 static char srcstrip[17];
 static uint32_t srcip=0;
 
-static uint8_t fterm;
+static std::atomic<uint8_t> fterm;
 static std::atomic<bool> gIsKilled(false);
 
 typedef std::unordered_map<PacketHeader::Type, PacketHandler*> PerTypePacketHandlers;
@@ -155,6 +202,7 @@ struct InitParams {
 	std::string subfolder;
 	std::vector<uint8_t> password_digest;
 	unsigned report_reserved_period;
+	double notified_cache_timeout;
 
 	InitParams &operator=(const SaunaClient::FsInitParams &params) {
 		bind_host = params.bind_host;
@@ -166,6 +214,7 @@ struct InitParams {
 		subfolder = params.subfolder;
 		password_digest = params.password_digest;
 		report_reserved_period = params.report_reserved_period;
+		notified_cache_timeout = params.notified_cache_timeout;
 		return *this;
 	}
 };
@@ -198,9 +247,9 @@ void master_stats_add(uint8_t id,uint64_t s) {
 	}
 }
 
-static inline void setDisconnect(bool value) {
-	std::unique_lock<std::mutex> fdLock(fdMutex);
-	disconnect = value;
+static inline void setDisconnect(MasterConnection &connection, bool value) {
+	std::unique_lock<std::mutex> fdLock(connection.mutex);
+	connection.disconnect = value;
 #ifdef _WIN32
 	gIsDisconnectedFromMaster.store(value);
 #endif
@@ -211,6 +260,17 @@ static inline void setDisconnect(bool value) {
 	}
 }
 
+/// Drops the connection carrying the requests of the current thread.
+static inline void setDisconnect(bool value) {
+	if (myThrec.rec != nullptr &&
+	    myThrec.generation == threcGeneration.load(std::memory_order_relaxed)) {
+		threc *rec = myThrec.rec;
+		setDisconnect(rec->sentOn ? *rec->sentOn : *rec->connection, value);
+	} else {
+		setDisconnect(mainConnection, value);
+	}
+}
+
 void fs_inc_acnt(uint32_t inode) {
 	std::unique_lock<std::mutex> acquiredFileLock(acquiredFileMutex);
 	acquiredFiles[inode]++;
@@ -238,41 +298,92 @@ void fs_dec_acnt(uint32_t inode) {
 	}
 }
 
-threc* fs_get_my_threc() {
-	pthread_t mythid = pthread_self();
-	threc *rec;
+ThrecHolder::~ThrecHolder() {
+	if (rec == nullptr) {
+		return;
+	}
 	std::unique_lock<std::mutex> recLock(recMutex);
-	for (rec = threchead ; rec ; rec = rec->next) {
-		if (pthread_equal(rec->thid, mythid)) {
-			return rec;
-		}
+	if (generation == threcGeneration.load(std::memory_order_relaxed)) {
+		freeThrecs.push_back(rec);
+		freeThrecs.insert(freeThrecs.end(), batch.begin(), batch.end());
 	}
-	rec = new threc;
-	rec->thid = mythid;
-	rec->sent = false;
-	rec->status = 0;
-	rec->received = false;
-	rec->waiting = 0;
-	rec->receivedType = 0;
-	if (threchead==NULL) {
-		rec->packetId = 1;
+}
+
+/// Spreads the records over the connections to the master.
+static MasterConnection *fs_connection_for(uint32_t packetId) {
+	uint32_t index = packetId % (extraConnections.size() + 1);
+	return index == 0 ? &mainConnection : extraConnections[index - 1].get();
+}
+
+static void fs_publish_threc(threc *rec) {
+	uint32_t pageIndex = rec->packetId >> kThrecPageBits;
+	sassert(pageIndex < kThrecPages);
+	ThrecPage *page = threcPages[pageIndex].load(std::memory_order_relaxed);
+	if (page == nullptr) {
+		page = new ThrecPage;
+		threcPages[pageIndex].store(page, std::memory_order_release);
+	}
+	page->slots[rec->packetId & (kThrecPageSize - 1)].store(rec, std::memory_order_release);
+}
+
+// called with recMutex locked
+static threc *fs_new_threc() {
+	threc *rec;
+	if (!freeThrecs.empty()) {
+		// a finished thread has no request in flight, so its record (and packetId) is reused
+		rec = freeThrecs.back();
+		freeThrecs.pop_back();
 	} else {
-		rec->packetId = threchead->packetId + 1;
+		rec = new threc;
+		rec->sent = false;
+		rec->status = 0;
+		rec->received = false;
+		rec->waiting = 0;
+		rec->receivedType = 0;
+		rec->packetId = threcs.size() + 1;
+		rec->connection = fs_connection_for(rec->packetId);
+		rec->sentOn = nullptr;
+		threcs.push_back(rec);
+		fs_publish_threc(rec);
 	}
-	rec->next = threchead;
-	threchead = rec;
 	return rec;
 }
 
-threc* fs_get_threc_by_id(uint32_t packetId) {
-	threc *rec;
+threc* fs_get_my_threc() {
+	uint64_t generation = threcGeneration.load(std::memory_order_relaxed);
+	if (myThrec.rec != nullptr && myThrec.generation == generation) {
+		return myThrec.rec;
+	}
 	std::unique_lock<std::mutex> recLock(recMutex);
-	for (rec = threchead ; rec ; rec=rec->next) {
-		if (rec->packetId==packetId) {
-			return rec;
+	myThrec.rec = fs_new_threc();
+	myThrec.batch.clear();
+	myThrec.generation = generation;
+	return myThrec.rec;
+}
+
+/// Returns \a count records of the current thread, its usual one first.
+static std::vector<threc *> fs_get_my_threcs(uint32_t count) {
+	std::vector<threc *> recs = {fs_get_my_threc()};
+	if (myThrec.batch.size() + 1 < count) {
+		std::unique_lock<std::mutex> recLock(recMutex);
+		while (myThrec.batch.size() + 1 < count) {
+			myThrec.batch.push_back(fs_new_threc());
 		}
 	}
-	return NULL;
+	recs.insert(recs.end(), myThrec.batch.begin(), myThrec.batch.begin() + (count - 1));
+	return recs;
+}
+
+threc* fs_get_threc_by_id(uint32_t packetId) {
+	uint32_t pageIndex = packetId >> kThrecPageBits;
+	if (pageIndex >= kThrecPages) {
+		return NULL;
+	}
+	ThrecPage *page = threcPages[pageIndex].load(std::memory_order_acquire);
+	if (page == nullptr) {
+		return NULL;
+	}
+	return page->slots[packetId & (kThrecPageSize - 1)].load(std::memory_order_acquire);
 }
 
 uint8_t* fs_createpacket(threc *rec,uint32_t cmd,uint32_t size) {
@@ -296,26 +407,34 @@ bool fs_saucreatepacket(threc *rec, MessageBuffer message) {
 SAUNAFS_CREATE_EXCEPTION_CLASS_MSG(LostSessionException, Exception, "session lost");
 
 static bool fs_threc_flush(threc *rec) {
-	std::unique_lock<std::mutex> fdLock(fdMutex);
+	MasterConnection *connection = rec->connection;
+	std::unique_lock<std::mutex> fdLock(connection->mutex);
+	if (connection->fd==-1 && connection != &mainConnection) {
+		// an additional connection which has not joined the session (yet) is replaced by the main one
+		fdLock.unlock();
+		connection = &mainConnection;
+		fdLock = std::unique_lock<std::mutex>(connection->mutex);
+	}
 	if (sessionlost) {
 		throw LostSessionException();
 	}
-	if (fd==-1) {
+	if (connection->fd==-1) {
 		return false;
 	}
 	std::unique_lock<std::mutex> lock(rec->mutex);
 	const int32_t size = rec->outputBuffer.size();
-	if (tcptowrite(fd, rec->outputBuffer.data(), size, 1000) != size) {
+	if (tcptowrite(connection->fd, rec->outputBuffer.data(), size, 1000) != size) {
 		safs_pretty_syslog(LOG_WARNING, "tcp send error: %s", strerr(tcpgetlasterror()));
-		disconnect = true;
+		connection->disconnect = true;
 		return false;
 	}
 	rec->received = false;
 	rec->sent = true;
+	rec->sentOn = connection;
 	lock.unlock();
 	master_stats_add(MASTER_BYTESSENT, size);
 	master_stats_inc(MASTER_PACKETSSENT);
-	lastwrite = time(NULL);
+	connection->lastwrite = time(NULL);
 	return true;
 }
 
@@ -436,6 +555,39 @@ bool fs_sausendandreceive_any(threc *rec, MessageBuffer& messageData) {
 	return false;
 }
 
+/*! \brief Sends the requests of all the records before waiting for any answer.
+ *
+ * \return for each record whether the answer of the expected type came. The other
+ * requests are not retried, the caller should repeat them one by one.
+ */
+static std::vector<bool> fs_threcs_send_receive(const std::vector<threc *> &recs,
+		PacketHeader::Type expectedType) {
+	std::vector<bool> sent(recs.size(), false);
+	std::vector<bool> answered(recs.size(), false);
+	try {
+		for (size_t i = 0; i < recs.size(); ++i) {
+			sent[i] = fs_threc_flush(recs[i]);
+		}
+	} catch (LostSessionException&) {
+	}
+	// each sent request gets its answer or an error status on disconnect
+	for (size_t i = 0; i < recs.size(); ++i) {
+		if (!sent[i]) {
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(recs[i]->mutex);
+		if (fs_threc_wait(recs[i], lock)) {
+			if (recs[i]->receivedType == expectedType) {
+				answered[i] = true;
+			} else {
+				lock.unlock();
+				setDisconnect(*recs[i]->sentOn, true);
+			}
+		}
+	}
+	return answered;
+}
+
 int fs_resolve(bool verbose, const std::string &bindhostname, const std::string &masterhostname, const std::string &masterportname) {
 	if (!bindhostname.empty()) {
 		if (tcpresolve(bindhostname.c_str(), nullptr, &srcip, nullptr, 1) < 0) {
@@ -478,6 +630,27 @@ void fs_register_config() {
 	fs_send_custom(message);
 }
 
+/// Asks the master to report changes of the cached metadata on mainConnection, see
+/// SaunaClient::FsInitParams::notified_cache_timeout. Called with mainConnection.mutex
+/// locked (or before the threads are started).
+static void fs_subscribe_cache_notifications() {
+	if (gInitParams.meta || gInitParams.notified_cache_timeout <= 0
+			|| masterversion < kCacheNotificationsVersion) {
+		return;
+	}
+	MessageBuffer message;
+	cltoma::fuseCacheNotifications::serialize(message);
+	if (tcptowrite(mainConnection.fd, message.data(), message.size(), 1000)
+			!= (int32_t)message.size()) {
+		safs_pretty_syslog(LOG_WARNING, "master: can't subscribe to cache notifications (write: %s)",
+				strerr(tcpgetlasterror()));
+		mainConnection.disconnect = true;
+		return;
+	}
+	master_stats_add(MASTER_BYTESSENT, message.size());
+	master_stats_inc(MASTER_PACKETSSENT);
+}
+
 int fs_connect(bool verbose) {
 	uint32_t i,j;
 	uint8_t *wptr,*regbuff;
@@ -507,12 +680,12 @@ int fs_connect(bool verbose) {
 		regbuff = (uint8_t*) malloc(8+64+13+pleng+ileng+16);
 	}
 
-	fd = tcpsocket();
-	if (fd<0) {
+	mainConnection.fd = tcpsocket();
+	if (mainConnection.fd<0) {
 		free(regbuff);
 		return -1;
 	}
-	if (tcpnodelay(fd)<0) {
+	if (tcpnodelay(mainConnection.fd)<0) {
 		if (verbose) {
 			fprintf(stderr,"can't set TCP_NODELAY\n");
 		} else {
@@ -520,26 +693,26 @@ int fs_connect(bool verbose) {
 		}
 	}
 	if (srcip>0) {
-		if (tcpnumbind(fd,srcip,0)<0) {
+		if (tcpnumbind(mainConnection.fd,srcip,0)<0) {
 			if (verbose) {
 				fprintf(stderr,"can't bind socket to given ip (\"%s\")\n",srcstrip);
 			} else {
 				safs_pretty_syslog(LOG_WARNING,"can't bind socket to given ip (\"%s\")",srcstrip);
 			}
-			tcpclose(fd);
-			fd=-1;
+			tcpclose(mainConnection.fd);
+			mainConnection.fd=-1;
 			free(regbuff);
 			return -1;
 		}
 	}
-	if (tcpnumconnect(fd,masterip,masterport)<0) {
+	if (tcpnumconnect(mainConnection.fd,masterip,masterport)<0) {
 		if (verbose) {
 			fprintf(stderr,"can't connect to sfsmaster (\"%s\":\"%" PRIu16 "\")\n",masterstrip,masterport);
 		} else {
 			safs_pretty_syslog(LOG_WARNING,"can't connect to sfsmaster (\"%s\":\"%" PRIu16 "\")",masterstrip,masterport);
 		}
-		tcpclose(fd);
-		fd=-1;
+		tcpclose(mainConnection.fd);
+		mainConnection.fd=-1;
 		free(regbuff);
 		return -1;
 	}
@@ -550,25 +723,25 @@ int fs_connect(bool verbose) {
 		memcpy(wptr,FUSE_REGISTER_BLOB_ACL,64);
 		wptr+=64;
 		put8bit(&wptr,REGISTER_GETRANDOM);
-		if (tcptowrite(fd,regbuff,8+65,1000)!=8+65) {
+		if (tcptowrite(mainConnection.fd,regbuff,8+65,1000)!=8+65) {
 			if (verbose) {
 				fprintf(stderr,"error sending data to sfsmaster\n");
 			} else {
 				safs_pretty_syslog(LOG_WARNING,"error sending data to sfsmaster");
 			}
-			tcpclose(fd);
-			fd=-1;
+			tcpclose(mainConnection.fd);
+			mainConnection.fd=-1;
 			free(regbuff);
 			return -1;
 		}
-		if (tcptoread(fd,regbuff,8,1000)!=8) {
+		if (tcptoread(mainConnection.fd,regbuff,8,1000)!=8) {
 			if (verbose) {
 				fprintf(stderr,"error receiving data from sfsmaster\n");
 			} else {
 				safs_pretty_syslog(LOG_WARNING,"error receiving data from sfsmaster");
 			}
-			tcpclose(fd);
-			fd=-1;
+			tcpclose(mainConnection.fd);
+			mainConnection.fd=-1;
 			free(regbuff);
 			return -1;
 		}
@@ -580,8 +753,8 @@ int fs_connect(bool verbose) {
 			} else {
 				safs_pretty_syslog(LOG_WARNING,"got incorrect answer from sfsmaster");
 			}
-			tcpclose(fd);
-			fd=-1;
+			tcpclose(mainConnection.fd);
+			mainConnection.fd=-1;
 			free(regbuff);
 			return -1;
 		}
@@ -592,19 +765,19 @@ int fs_connect(bool verbose) {
 			} else {
 				safs_pretty_syslog(LOG_WARNING,"got incorrect answer from sfsmaster");
 			}
-			tcpclose(fd);
-			fd=-1;
+			tcpclose(mainConnection.fd);
+			mainConnection.fd=-1;
 			free(regbuff);
 			return -1;
 		}
-		if (tcptoread(fd,regbuff,32,1000)!=32) {
+		if (tcptoread(mainConnection.fd,regbuff,32,1000)!=32) {
 			if (verbose) {
 				fprintf(stderr,"error receiving data from sfsmaster\n");
 			} else {
 				safs_pretty_syslog(LOG_WARNING,"error receiving data from sfsmaster");
 			}
-			tcpclose(fd);
-			fd=-1;
+			tcpclose(mainConnection.fd);
+			mainConnection.fd=-1;
 			free(regbuff);
 			return -1;
 		}
@@ -645,18 +818,18 @@ int fs_connect(bool verbose) {
 	if (havepassword) {
 		memcpy(wptr+pleng,digest,16);
 	}
-	if (tcptowrite(fd,regbuff,8+64+(gInitParams.meta?9:13)+ileng+pleng+(havepassword?16:0),1000)!=(int32_t)(8+64+(gInitParams.meta?9:13)+ileng+pleng+(havepassword?16:0))) {
+	if (tcptowrite(mainConnection.fd,regbuff,8+64+(gInitParams.meta?9:13)+ileng+pleng+(havepassword?16:0),1000)!=(int32_t)(8+64+(gInitParams.meta?9:13)+ileng+pleng+(havepassword?16:0))) {
 		if (verbose) {
 			fprintf(stderr,"error sending data to sfsmaster: %s\n",strerr(tcpgetlasterror()));
 		} else {
 			safs_pretty_syslog(LOG_WARNING,"error sending data to sfsmaster: %s",strerr(tcpgetlasterror()));
 		}
-		tcpclose(fd);
-		fd=-1;
+		tcpclose(mainConnection.fd);
+		mainConnection.fd=-1;
 		free(regbuff);
 		return -1;
 	}
-	if (tcptoread(fd,regbuff,8,1000)!=8) {
+	if (tcptoread(mainConnection.fd,regbuff,8,1000)!=8) {
 		int tcplasterr = tcpgetlasterror();
 		const auto* errorMessage = (tcplasterr != 0) ? strerr(tcplasterr) : strerr(TCPNORESPONSE);
 		if (verbose) {
@@ -664,8 +837,8 @@ int fs_connect(bool verbose) {
 		} else {
 			safs_pretty_syslog(LOG_WARNING,"error receiving data from sfsmaster: %s", errorMessage);
 		}
-		tcpclose(fd);
-		fd=-1;
+		tcpclose(mainConnection.fd);
+		mainConnection.fd=-1;
 		free(regbuff);
 		return -1;
 	}
@@ -677,8 +850,8 @@ int fs_connect(bool verbose) {
 		} else {
 			safs_pretty_syslog(LOG_WARNING,"got incorrect answer from sfsmaster");
 		}
-		tcpclose(fd);
-		fd=-1;
+		tcpclose(mainConnection.fd);
+		mainConnection.fd=-1;
 		free(regbuff);
 		return -1;
 	}
@@ -689,19 +862,19 @@ int fs_connect(bool verbose) {
 		} else {
 			safs_pretty_syslog(LOG_WARNING,"got incorrect answer from sfsmaster");
 		}
-		tcpclose(fd);
-		fd=-1;
+		tcpclose(mainConnection.fd);
+		mainConnection.fd=-1;
 		free(regbuff);
 		return -1;
 	}
-	if (tcptoread(fd,regbuff,i,1000)!=(int32_t)i) {
+	if (tcptoread(mainConnection.fd,regbuff,i,1000)!=(int32_t)i) {
 		if (verbose) {
 			fprintf(stderr,"error receiving data from sfsmaster: %s\n",strerr(tcpgetlasterror()));
 		} else {
 			safs_pretty_syslog(LOG_WARNING,"error receiving data from sfsmaster: %s",strerr(tcpgetlasterror()));
 		}
-		tcpclose(fd);
-		fd=-1;
+		tcpclose(mainConnection.fd);
+		mainConnection.fd=-1;
 		free(regbuff);
 		return -1;
 	}
@@ -712,8 +885,8 @@ int fs_connect(bool verbose) {
 		} else {
 			safs_pretty_syslog(LOG_WARNING,"sfsmaster register error: %s",saunafs_error_string(rptr[0]));
 		}
-		tcpclose(fd);
-		fd=-1;
+		tcpclose(mainConnection.fd);
+		mainConnection.fd=-1;
 		free(regbuff);
 		return -1;
 	}
@@ -755,7 +928,8 @@ int fs_connect(bool verbose) {
 		maxtrashtime = 0;
 	}
 	free(regbuff);
-	lastwrite=time(NULL);
+	mainConnection.lastwrite=time(NULL);
+	fs_subscribe_cache_notifications();
 	if (!verbose) {
 		safs_pretty_syslog(LOG_NOTICE,"registered to master with new session (id #%" PRIu32 ")", sessionid);
 	}
@@ -902,36 +1076,35 @@ int fs_connect(bool verbose) {
 	return 0;
 }
 
-void fs_reconnect() {
+/*! \brief Connects a new socket to the master and registers it to the given session.
+ *
+ * \return the socket or -1, \a refused is set when the master rejected the session.
+ */
+static int fs_join_session(uint32_t session, bool &refused) {
 	uint32_t i;
 	uint8_t *wptr,regbuff[8+64+9];
 	const uint8_t *rptr;
+	int sock;
 
-	if (sessionid==0) {
-		safs_pretty_syslog(LOG_WARNING,"can't register: session not created");
-		return;
-	}
-
-	fd = tcpsocket();
-	if (fd<0) {
-		return;
+	refused = false;
+	sock = tcpsocket();
+	if (sock<0) {
+		return -1;
 	}
-	if (tcpnodelay(fd)<0) {
+	if (tcpnodelay(sock)<0) {
 		safs_pretty_syslog(LOG_WARNING,"can't set TCP_NODELAY: %s",strerr(tcpgetlasterror()));
 	}
 	if (srcip>0) {
-		if (tcpnumbind(fd,srcip,0)<0) {
+		if (tcpnumbind(sock,srcip,0)<0) {
 			safs_pretty_syslog(LOG_WARNING,"can't bind socket to given ip (\"%s\")",srcstrip);
-			tcpclose(fd);
-			fd=-1;
-			return;
+			tcpclose(sock);
+			return -1;
 		}
 	}
-	if (tcpnumconnect(fd,masterip,masterport)<0) {
+	if (tcpnumconnect(sock,masterip,masterport)<0) {
 		safs_pretty_syslog(LOG_WARNING,"can't connect to master (\"%s\":\"%" PRIu16 "\")",masterstrip,masterport);
-		tcpclose(fd);
-		fd=-1;
-		return;
+		tcpclose(sock);
+		return -1;
 	}
 	master_stats_inc(MASTER_CONNECTS);
 	wptr = regbuff;
@@ -940,57 +1113,69 @@ void fs_reconnect() {
 	memcpy(wptr,FUSE_REGISTER_BLOB_ACL,64);
 	wptr+=64;
 	put8bit(&wptr,REGISTER_RECONNECT);
-	put32bit(&wptr,sessionid);
+	put32bit(&wptr,session);
 	put16bit(&wptr,SAUNAFS_PACKAGE_VERSION_MAJOR);
 	put8bit(&wptr,SAUNAFS_PACKAGE_VERSION_MINOR);
 	put8bit(&wptr,SAUNAFS_PACKAGE_VERSION_MICRO);
-	if (tcptowrite(fd,regbuff,8+64+9,1000)!=8+64+9) {
+	if (tcptowrite(sock,regbuff,8+64+9,1000)!=8+64+9) {
 		safs_pretty_syslog(LOG_WARNING,"master: register error (write: %s)",strerr(tcpgetlasterror()));
-		tcpclose(fd);
-		fd=-1;
-		return;
+		tcpclose(sock);
+		return -1;
 	}
 	master_stats_add(MASTER_BYTESSENT,16+64);
 	master_stats_inc(MASTER_PACKETSSENT);
-	if (tcptoread(fd,regbuff,8,1000)!=8) {
+	if (tcptoread(sock,regbuff,8,1000)!=8) {
 		safs_pretty_syslog(LOG_WARNING,"master: register error (read header: %s)",strerr(tcpgetlasterror()));
-		tcpclose(fd);
-		fd=-1;
-		return;
+		tcpclose(sock);
+		return -1;
 	}
 	master_stats_add(MASTER_BYTESRCVD,8);
 	rptr = regbuff;
 	i = get32bit(&rptr);
 	if (i!=MATOCL_FUSE_REGISTER) {
 		safs_pretty_syslog(LOG_WARNING,"master: register error (bad answer: %" PRIu32 ")",i);
-		tcpclose(fd);
-		fd=-1;
-		return;
+		tcpclose(sock);
+		return -1;
 	}
 	i = get32bit(&rptr);
 	if (i!=1) {
 		safs_pretty_syslog(LOG_WARNING,"master: register error (bad length: %" PRIu32 ")",i);
-		tcpclose(fd);
-		fd=-1;
-		return;
+		tcpclose(sock);
+		return -1;
 	}
-	if (tcptoread(fd,regbuff,i,1000)!=(int32_t)i) {
+	if (tcptoread(sock,regbuff,i,1000)!=(int32_t)i) {
 		safs_pretty_syslog(LOG_WARNING,"master: register error (read data: %s)",strerr(tcpgetlasterror()));
-		tcpclose(fd);
-		fd=-1;
-		return;
+		tcpclose(sock);
+		return -1;
 	}
 	master_stats_add(MASTER_BYTESRCVD,i);
 	master_stats_inc(MASTER_PACKETSRCVD);
 	rptr = regbuff;
 	if (rptr[0]!=0) {
-		sessionlost=1;
+		refused = true;
 		safs_pretty_syslog(LOG_WARNING,"master: register status: %s",saunafs_error_string(rptr[0]));
-		tcpclose(fd);
-		fd=-1;
+		tcpclose(sock);
+		return -1;
+	}
+	return sock;
+}
+
+void fs_reconnect() {
+	bool refused;
+
+	if (sessionid==0) {
+		safs_pretty_syslog(LOG_WARNING,"can't register: session not created");
 		return;
 	}
-	lastwrite=time(NULL);
+	mainConnection.fd = fs_join_session(sessionid, refused);
+	if (refused) {
+		sessionlost=1;
+	}
+	if (mainConnection.fd<0) {
+		return;
+	}
+	mainConnection.lastwrite=time(NULL);
+	fs_subscribe_cache_notifications();
 	safs_pretty_syslog(LOG_NOTICE,"registered to master (session id #%" PRIu32 ")", sessionid);
 }
 
@@ -1008,7 +1193,7 @@ void fs_close_session(void) {
 	wptr+=64;
 	put8bit(&wptr,REGISTER_CLOSESESSION);
 	put32bit(&wptr,sessionid);
-	if (tcptowrite(fd,regbuff,8+64+5,1000)!=8+64+5) {
+	if (tcptowrite(mainConnection.fd,regbuff,8+64+5,1000)!=8+64+5) {
 		safs_pretty_syslog(LOG_WARNING,"master: close session error (write: %s)",strerr(tcpgetlasterror()));
 	}
 }
@@ -1019,10 +1204,29 @@ static void usr1_handler(int) {
 }
 #endif
 
+// called with connection.mutex locked
+static void fs_send_nop(MasterConnection &connection, int now) {
+	uint8_t *ptr,hdr[12];
+
+	if (connection.lastwrite+2<now) {
+		ptr = hdr;
+		put32bit(&ptr,ANTOAN_NOP);
+		put32bit(&ptr,4);
+		put32bit(&ptr,0);
+		if (tcptowrite(connection.fd,hdr,12,1000)!=12) {
+			connection.disconnect = true;
+		} else {
+			master_stats_add(MASTER_BYTESSENT,12);
+			master_stats_inc(MASTER_PACKETSSENT);
+		}
+		connection.lastwrite=now;
+	}
+}
+
 void* fs_nop_thread(void *arg) {
 	pthread_setname_np(pthread_self(), "nopThread");
 
-	uint8_t *ptr,hdr[12],*inodespacket;
+	uint8_t *ptr,*inodespacket;
 	int32_t inodesleng;
 	int now;
 	uint32_t inodeswritecnt=0;
@@ -1035,9 +1239,9 @@ void* fs_nop_thread(void *arg) {
 #endif
 	for (;;) {
 		now = time(NULL);
-		std::unique_lock<std::mutex> fdLock(fdMutex);
+		std::unique_lock<std::mutex> fdLock(mainConnection.mutex);
 		if (fterm) {
-			if (fd>=0) {
+			if (mainConnection.fd>=0) {
 				fs_close_session();
 			}
 			fdLock.unlock();
@@ -1048,20 +1252,8 @@ void* fs_nop_thread(void *arg) {
 			fdLock.unlock();
 			exit(SAUNAFS_EXIT_STATUS_GENTLY_KILL);
 		}
-		if (disconnect == false && fd >= 0) {
-			if (lastwrite+2<now) {  // NOP
-				ptr = hdr;
-				put32bit(&ptr,ANTOAN_NOP);
-				put32bit(&ptr,4);
-				put32bit(&ptr,0);
-				if (tcptowrite(fd,hdr,12,1000)!=12) {
-					disconnect = true;
-				} else {
-					master_stats_add(MASTER_BYTESSENT,12);
-					master_stats_inc(MASTER_PACKETSSENT);
-				}
-				lastwrite=now;
-			}
+		if (mainConnection.disconnect == false && mainConnection.fd >= 0) {
+			fs_send_nop(mainConnection, now);
 			if (++inodeswritecnt >= gInitParams.report_reserved_period) {
 				inodeswritecnt = 0;
 				std::unique_lock<std::mutex> asLock(acquiredFileMutex);
@@ -1073,8 +1265,8 @@ void* fs_nop_thread(void *arg) {
 				for (const auto &[inode, _] : acquiredFiles) {
 					put32bit(&ptr, inode);
 				}
-				if (tcptowrite(fd,inodespacket,inodesleng,1000)!=inodesleng) {
-					disconnect = true;
+				if (tcptowrite(mainConnection.fd,inodespacket,inodesleng,1000)!=inodesleng) {
+					mainConnection.disconnect = true;
 				} else {
 					master_stats_add(MASTER_BYTESSENT,inodesleng);
 					master_stats_inc(MASTER_PACKETSSENT);
@@ -1083,26 +1275,32 @@ void* fs_nop_thread(void *arg) {
 			}
 		}
 		fdLock.unlock();
+		for (auto &connection : extraConnections) {
+			std::unique_lock<std::mutex> connectionLock(connection->mutex);
+			if (connection->disconnect == false && connection->fd >= 0) {
+				fs_send_nop(*connection, now);
+			}
+		}
 		sleep(1);
 	}
 }
 
-bool fs_append_from_master(MessageBuffer& buffer, uint32_t size) {
+bool fs_append_from_master(MasterConnection &connection, MessageBuffer& buffer, uint32_t size) {
 	if (size == 0) {
 		return true;
 	}
 	const uint32_t oldSize = buffer.size();
 	buffer.resize(oldSize + size);
 	uint8_t *appendPointer = buffer.data() + oldSize;
-	int r = tcptoread(fd, appendPointer, size, RECEIVE_TIMEOUT * 1000);
+	int r = tcptoread(connection.fd, appendPointer, size, RECEIVE_TIMEOUT * 1000);
 	if (r == 0) {
 		safs_pretty_syslog(LOG_WARNING,"master: connection lost");
-		setDisconnect(true);
+		setDisconnect(connection, true);
 		return false;
 	}
 	if (r != (int)size) {
 		safs_pretty_syslog(LOG_WARNING,"master: tcp recv error: %s",strerr(tcpgetlasterror()));
-		setDisconnect(true);
+		setDisconnect(connection, true);
 		return false;
 	}
 	master_stats_add(MASTER_BYTESRCVD, size);
@@ -1110,28 +1308,128 @@ bool fs_append_from_master(MessageBuffer& buffer, uint32_t size) {
 }
 
 template<class... Args>
-bool fs_deserialize_from_master(uint32_t& remainingBytes, Args&... destination) {
+bool fs_deserialize_from_master(MasterConnection &connection, uint32_t& remainingBytes,
+		Args&... destination) {
 	const uint32_t size = serializedSize(destination...);
 	if (size > remainingBytes) {
 		safs_pretty_syslog(LOG_WARNING,"master: packet too short");
-		setDisconnect(true);
+		setDisconnect(connection, true);
 		return false;
 	}
 	MessageBuffer buffer;
-	if (!fs_append_from_master(buffer, size)) {
+	if (!fs_append_from_master(connection, buffer, size)) {
 		return false;
 	}
 	try {
 		deserialize(buffer, destination...);
 	} catch (IncorrectDeserializationException& e) {
 		safs_pretty_syslog(LOG_WARNING,"master: deserialization error: %s", e.what());
-		setDisconnect(true);
+		setDisconnect(connection, true);
 		return false;
 	}
 	remainingBytes -= size;
 	return true;
 }
 
+// called with connection.mutex locked
+static void fs_close_connection(MasterConnection &connection) {
+	tcpclose(connection.fd);
+	connection.fd=-1;
+	connection.disconnect = false;
+	// send to any threc waiting on this connection status error and unlock them
+	std::unique_lock<std::mutex>recLock(recMutex);
+	for (threc *rec : threcs) {
+		std::unique_lock<std::mutex> lock(rec->mutex);
+		if (rec->sent && rec->sentOn == &connection) {
+			rec->status = 1;
+			rec->received = true;
+			if (rec->waiting) {
+				rec->condition.notify_one();
+			}
+		}
+	}
+}
+
+/// Reads one packet from the connection and hands it to its record or packet handler.
+static void fs_receive_packet(MasterConnection &connection) {
+	PacketHeader packetHeader;
+	PacketVersion packetVersion = 0;
+	uint32_t messageId = 0;
+	uint32_t remainingBytes = serializedSize(packetHeader);
+	if (!fs_deserialize_from_master(connection, remainingBytes, packetHeader)) {
+		return;
+	}
+	master_stats_inc(MASTER_PACKETSRCVD);
+	remainingBytes = packetHeader.length;
+
+	{
+		std::unique_lock<std::mutex> lock(perTypePacketHandlersLock);
+		const PerTypePacketHandlers::iterator handler =
+				perTypePacketHandlers.find(packetHeader.type);
+		if (handler != perTypePacketHandlers.end()) {
+			MessageBuffer buffer;
+			if (fs_append_from_master(connection, buffer, remainingBytes)) {
+				handler->second->handle(std::move(buffer));
+			}
+			return;
+		}
+	}
+
+	if (packetHeader.isSauPacketType()) {
+		if (remainingBytes < serializedSize(packetVersion, messageId)) {
+			safs_pretty_syslog(LOG_WARNING,"master: packet too short: no msgid");
+			setDisconnect(connection, true);
+			return;
+		}
+		if (!fs_deserialize_from_master(connection, remainingBytes, packetVersion, messageId)) {
+			return;
+		}
+	} else {
+		if (remainingBytes < serializedSize(messageId)) {
+			safs_pretty_syslog(LOG_WARNING,"master: packet too short: no msgid");
+			setDisconnect(connection, true);
+			return;
+		}
+		if (!fs_deserialize_from_master(connection, remainingBytes, messageId)) {
+			return;
+		}
+	}
+
+	if (messageId == 0) {
+		if (packetHeader.type == ANTOAN_NOP && remainingBytes == 0) {
+			return;
+		}
+		if (packetHeader.type == ANTOAN_UNKNOWN_COMMAND ||
+				packetHeader.type == ANTOAN_BAD_COMMAND_SIZE) {
+			// just ignore these packets with packetId==0
+			return;
+		}
+	}
+	threc *rec = fs_get_threc_by_id(messageId);
+	if (rec == NULL) {
+		safs_pretty_syslog(LOG_WARNING,"master: got unexpected queryid");
+		setDisconnect(connection, true);
+		return;
+	}
+	std::unique_lock<std::mutex> lock(rec->mutex);
+	rec->inputBuffer.clear();
+	if (packetHeader.isSauPacketType()) {
+		serialize(rec->inputBuffer, packetVersion, messageId);
+	} else {
+		serialize(rec->inputBuffer, messageId);
+	}
+	if (!fs_append_from_master(connection, rec->inputBuffer, remainingBytes)) {
+		return;
+	}
+	rec->sent = false;
+	rec->status = 0;
+	rec->receivedType = packetHeader.type;
+	rec->received = true;
+	if (rec->waiting) {
+		rec->condition.notify_one();
+	}
+}
+
 void* fs_receive_thread(void *) {
 	uint32_t initialReconnectSleep_ms = 100;
 	uint32_t reconnectSleep_ms = initialReconnectSleep_ms;
@@ -1139,31 +1437,18 @@ void* fs_receive_thread(void *) {
 	pthread_setname_np(pthread_self(), "recFromMaster");
 
 	for (;;) {
-		std::unique_lock<std::mutex>fdLock(fdMutex);
+		std::unique_lock<std::mutex>fdLock(mainConnection.mutex);
 		if (fterm) {
 			return NULL;
 		}
-		if (disconnect) {
-			tcpclose(fd);
-			fd=-1;
-			disconnect = false;
-			// send to any threc status error and unlock them
-			std::unique_lock<std::mutex>recLock(recMutex);
-			for (threc *rec=threchead ; rec ; rec=rec->next) {
-				std::unique_lock<std::mutex> lock(rec->mutex);
-				if (rec->sent) {
-					rec->status = 1;
-					rec->received = true;
-					if (rec->waiting) {
-						rec->condition.notify_one();
-					}
-				}
-			}
+		if (mainConnection.disconnect) {
+			fs_close_connection(mainConnection);
+			SaunaClient::masterCacheNotificationsStopped();
 		}
-		if (fd==-1 && sessionid!=0) {
+		if (mainConnection.fd==-1 && sessionid!=0) {
 			fs_reconnect();         // try to register using the same session id
 		}
-		if (fd==-1) {   // still not connected
+		if (mainConnection.fd==-1) {   // still not connected
 			if (sessionlost) {      // if previous session is lost then try to register as a new session
 				if (fs_connect(false)==0) {
 					sessionlost=0;
@@ -1177,7 +1462,7 @@ void* fs_receive_thread(void *) {
 				}
 			}
 		}
-		if (fd==-1) {
+		if (mainConnection.fd==-1) {
 			fdLock.unlock();
 			usleep(reconnectSleep_ms * 1000);
 			// slowly increase timeout before each retry
@@ -1198,83 +1483,51 @@ void* fs_receive_thread(void *) {
 		}
 		fdLock.unlock();
 
-		PacketHeader packetHeader;
-		PacketVersion packetVersion = 0;
-		uint32_t messageId = 0;
-		uint32_t remainingBytes = serializedSize(packetHeader);
-		if (!fs_deserialize_from_master(remainingBytes, packetHeader)) {
-			continue;
-		}
-		master_stats_inc(MASTER_PACKETSRCVD);
-		remainingBytes = packetHeader.length;
-
-		{
-			std::unique_lock<std::mutex> lock(perTypePacketHandlersLock);
-			const PerTypePacketHandlers::iterator handler =
-					perTypePacketHandlers.find(packetHeader.type);
-			if (handler != perTypePacketHandlers.end()) {
-				MessageBuffer buffer;
-				if (fs_append_from_master(buffer, remainingBytes)) {
-					handler->second->handle(std::move(buffer));
-				}
-				continue;
-			}
-		}
+		fs_receive_packet(mainConnection);
+	}
+}
 
-		if (packetHeader.isSauPacketType()) {
-			if (remainingBytes < serializedSize(packetVersion, messageId)) {
-				safs_pretty_syslog(LOG_WARNING,"master: packet too short: no msgid");
-				setDisconnect(true);
-				continue;
-			}
-			if (!fs_deserialize_from_master(remainingBytes, packetVersion, messageId)) {
-				continue;
-			}
-		} else {
-			if (remainingBytes < serializedSize(messageId)) {
-				safs_pretty_syslog(LOG_WARNING,"master: packet too short: no msgid");
-				setDisconnect(true);
-				continue;
-			}
-			if (!fs_deserialize_from_master(remainingBytes, messageId)) {
-				continue;
-			}
-		}
+/*! \brief Receive thread of an additional connection.
+ *
+ * The connection only joins the session registered by mainConnection (and joins again
+ * when it changes), so it waits while mainConnection is not connected.
+ */
+void* fs_extra_receive_thread(void *arg) {
+	MasterConnection &connection = *static_cast<MasterConnection *>(arg);
 
-		if (messageId == 0) {
-			if (packetHeader.type == ANTOAN_NOP && remainingBytes == 0) {
-				continue;
-			}
-			if (packetHeader.type == ANTOAN_UNKNOWN_COMMAND ||
-					packetHeader.type == ANTOAN_BAD_COMMAND_SIZE) {
-				// just ignore these packets with packetId==0
-				continue;
-			}
-		}
-		threc *rec = fs_get_threc_by_id(messageId);
-		if (rec == NULL) {
-			safs_pretty_syslog(LOG_WARNING,"master: got unexpected queryid");
-			setDisconnect(true);
-			continue;
+	pthread_setname_np(pthread_self(), "recFromMaster");
+
+	for (;;) {
+		std::unique_lock<std::mutex> mainLock(mainConnection.mutex);
+		uint32_t session = (mainConnection.fd >= 0 && !sessionlost) ? sessionid : 0;
+		mainLock.unlock();
+
+		std::unique_lock<std::mutex> fdLock(connection.mutex);
+		if (fterm) {
+			return NULL;
 		}
-		std::unique_lock<std::mutex> lock(rec->mutex);
-		rec->inputBuffer.clear();
-		if (packetHeader.isSauPacketType()) {
-			serialize(rec->inputBuffer, packetVersion, messageId);
-		} else {
-			serialize(rec->inputBuffer, messageId);
+		if (connection.fd >= 0 && (connection.disconnect || connection.sessionid != session)) {
+			fs_close_connection(connection);
+		}
+		if (connection.fd == -1 && session != 0) {
+			bool refused;
+			mainLock.lock();  // fs_join_session reads the master address
+			int sock = fs_join_session(session, refused);
+			mainLock.unlock();
+			if (sock >= 0) {
+				connection.fd = sock;
+				connection.sessionid = session;
+				connection.lastwrite = time(NULL);
+			}
 		}
-		if (!fs_append_from_master(rec->inputBuffer, remainingBytes)) {
-			lock.unlock();
+		if (connection.fd == -1) {
+			fdLock.unlock();
+			sleep(1);
 			continue;
 		}
-		rec->sent = false;
-		rec->status = 0;
-		rec->receivedType = packetHeader.type;
-		rec->received = true;
-		if (rec->waiting) {
-			rec->condition.notify_one();
-		}
+		fdLock.unlock();
+
+		fs_receive_packet(connection);
 	}
 }
 
@@ -1289,10 +1542,14 @@ int fs_init_master_connection(SaunaClient::FsInitParams &params
 	gInitParams = params;
 	std::fill(params.password_digest.begin(), params.password_digest.end(), 0);
 
-	fd = -1;
+	mainConnection.fd = -1;
 	sessionlost = params.delayed_init;
 	sessionid = 0;
-	disconnect = false;
+	mainConnection.disconnect = false;
+	extraConnections.clear();
+	for (unsigned i = 1; i < params.master_connections; ++i) {
+		extraConnections.push_back(std::make_unique<MasterConnection>());
+	}
 
 	if (params.delayed_init) {
 		return 1;
@@ -1317,28 +1574,41 @@ void fs_init_threads(uint32_t retries) {
 
 	pthread_attr_init(&thattr);
 	pthread_attr_setstacksize(&thattr,0x100000);
-	pthread_create(&rpthid,&thattr,fs_receive_thread,NULL);
+	pthread_create(&mainConnection.receiveThread,&thattr,fs_receive_thread,NULL);
+	for (auto &connection : extraConnections) {
+		pthread_create(&connection->receiveThread,&thattr,fs_extra_receive_thread,connection.get());
+	}
 	pthread_create(&npthid,&thattr,fs_nop_thread,NULL);
 	pthread_attr_destroy(&thattr);
 }
 
 void fs_term(void) {
-	threc *tr,*trn;
-	std::unique_lock<std::mutex> fd_lock(fdMutex);
+	std::unique_lock<std::mutex> fd_lock(mainConnection.mutex);
 	fterm = 1;
 	fd_lock.unlock();
 	pthread_join(npthid,NULL);
-	pthread_join(rpthid,NULL);
+	pthread_join(mainConnection.receiveThread,NULL);
+	for (auto &connection : extraConnections) {
+		pthread_join(connection->receiveThread,NULL);
+		if (connection->fd>=0) {
+			tcpclose(connection->fd);
+		}
+	}
 	std::unique_lock<std::mutex> rec_lock(recMutex);
-	for (tr = threchead ; tr ; tr = trn) {
-		trn = tr->next;
+	for (threc *tr : threcs) {
 		tr->mutex.lock();  // Make helgrind happy
 		tr->outputBuffer.clear();
 		tr->inputBuffer.clear();
 		tr->mutex.unlock();
 		delete tr;
 	}
-	threchead = nullptr;
+	threcs.clear();
+	freeThrecs.clear();
+	for (auto &page : threcPages) {
+		delete page.exchange(nullptr);
+	}
+	threcGeneration.fetch_add(1, std::memory_order_relaxed);
+	extraConnections.clear();
 	rec_lock.unlock();
 	std::unique_lock<std::mutex> af_lock(acquiredFileMutex);
 #ifdef _WIN32
@@ -1348,8 +1618,8 @@ void fs_term(void) {
 	acquiredFiles.clear();
 	af_lock.unlock();
 	fd_lock.lock();
-	if (fd>=0) {
-		tcpclose(fd);
+	if (mainConnection.fd>=0) {
+		tcpclose(mainConnection.fd);
 	}
 }
 
@@ -1413,15 +1683,7 @@ uint8_t fs_access(uint32_t inode,uint32_t uid,uint32_t gid,uint8_t modemask) {
 	return ret;
 }
 
-uint8_t fs_lookup(uint32_t parent, const std::string &path, uint32_t uid, uint32_t gid, uint32_t *inode, Attributes &attr) {
-	threc *rec = fs_get_my_threc();
-	auto message = cltoma::wholePathLookup::build(rec->packetId, parent, path, uid, gid);
-	if (!fs_saucreatepacket(rec, message)) {
-		return SAUNAFS_ERROR_IO;
-	}
-	if (!fs_sausendandreceive(rec, SAU_MATOCL_WHOLE_PATH_LOOKUP, message)) {
-		return SAUNAFS_ERROR_IO;
-	}
+static uint8_t fs_lookup_answer(const MessageBuffer &message, uint32_t *inode, Attributes &attr) {
 	try {
 		uint32_t msgid;
 		PacketVersion packet_version;
@@ -1449,32 +1711,106 @@ uint8_t fs_lookup(uint32_t parent, const std::string &path, uint32_t uid, uint32
 	}
 }
 
-uint8_t fs_getattr(uint32_t inode, uint32_t uid, uint32_t gid, Attributes &attr) {
-	uint8_t *wptr;
-	const uint8_t *rptr;
-	uint32_t i;
-	uint8_t ret;
+uint8_t fs_lookup(uint32_t parent, const std::string &path, uint32_t uid, uint32_t gid, uint32_t *inode, Attributes &attr) {
 	threc *rec = fs_get_my_threc();
-	wptr = fs_createpacket(rec,CLTOMA_FUSE_GETATTR,12);
-	if (!wptr) {
+	auto message = cltoma::wholePathLookup::build(rec->packetId, parent, path, uid, gid);
+	if (!fs_saucreatepacket(rec, message)) {
 		return SAUNAFS_ERROR_IO;
 	}
-	put32bit(&wptr,inode);
-	put32bit(&wptr,uid);
-	put32bit(&wptr,gid);
-	rptr = fs_sendandreceive(rec,MATOCL_FUSE_GETATTR,&i);
+	if (!fs_sausendandreceive(rec, SAU_MATOCL_WHOLE_PATH_LOOKUP, message)) {
+		return SAUNAFS_ERROR_IO;
+	}
+	return fs_lookup_answer(message, inode, attr);
+}
+
+void fs_lookup_batch(uint32_t parent, const std::vector<std::string> &paths, uint32_t uid,
+		uint32_t gid, std::vector<uint8_t> &statuses, std::vector<uint32_t> &inodes,
+		std::vector<Attributes> &attrs) {
+	statuses.assign(paths.size(), SAUNAFS_ERROR_IO);
+	inodes.assign(paths.size(), 0);
+	attrs.resize(paths.size());
+	for (size_t first = 0; first < paths.size(); first += kMaxRequestsInFlight) {
+		size_t count = std::min<size_t>(paths.size() - first, kMaxRequestsInFlight);
+		std::vector<threc *> recs = fs_get_my_threcs(count);
+		for (size_t i = 0; i < count; ++i) {
+			fs_saucreatepacket(recs[i], cltoma::wholePathLookup::build(recs[i]->packetId,
+					parent, paths[first + i], uid, gid));
+		}
+		std::vector<bool> answered = fs_threcs_send_receive(recs, SAU_MATOCL_WHOLE_PATH_LOOKUP);
+		for (size_t i = 0; i < count; ++i) {
+			size_t n = first + i;
+			if (!answered[i]) {
+				statuses[n] = fs_lookup(parent, paths[n], uid, gid, &inodes[n], attrs[n]);
+				continue;
+			}
+			MessageBuffer message;
+			std::unique_lock<std::mutex> lock(recs[i]->mutex);
+			recs[i]->received = false;  // we steal ownership of the received buffer
+			message = std::move(recs[i]->inputBuffer);
+			lock.unlock();
+			statuses[n] = fs_lookup_answer(message, &inodes[n], attrs[n]);
+		}
+	}
+}
+
+static uint8_t fs_getattr_answer(const uint8_t *rptr, uint32_t i, Attributes &attr) {
 	if (rptr==NULL) {
-		ret = SAUNAFS_ERROR_IO;
+		return SAUNAFS_ERROR_IO;
 	} else if (i==1) {
-		ret = rptr[0];
+		return rptr[0];
 	} else if (i != attr.size()) {
 		setDisconnect(true);
-		ret = SAUNAFS_ERROR_IO;
-	} else {
-		memcpy(attr.data(), rptr, attr.size());
-		ret = SAUNAFS_STATUS_OK;
+		return SAUNAFS_ERROR_IO;
+	}
+	memcpy(attr.data(), rptr, attr.size());
+	return SAUNAFS_STATUS_OK;
+}
+
+static uint8_t *fs_getattr_packet(threc *rec, uint32_t inode, uint32_t uid, uint32_t gid) {
+	uint8_t *wptr = fs_createpacket(rec,CLTOMA_FUSE_GETATTR,12);
+	if (wptr) {
+		put32bit(&wptr,inode);
+		put32bit(&wptr,uid);
+		put32bit(&wptr,gid);
+	}
+	return wptr;
+}
+
+uint8_t fs_getattr(uint32_t inode, uint32_t uid, uint32_t gid, Attributes &attr) {
+	const uint8_t *rptr;
+	uint32_t i;
+	threc *rec = fs_get_my_threc();
+	if (!fs_getattr_packet(rec, inode, uid, gid)) {
+		return SAUNAFS_ERROR_IO;
+	}
+	rptr = fs_sendandreceive(rec,MATOCL_FUSE_GETATTR,&i);
+	return fs_getattr_answer(rptr, i, attr);
+}
+
+void fs_getattr_batch(const std::vector<uint32_t> &inodes, uint32_t uid, uint32_t gid,
+		std::vector<uint8_t> &statuses, std::vector<Attributes> &attrs) {
+	statuses.assign(inodes.size(), SAUNAFS_ERROR_IO);
+	attrs.resize(inodes.size());
+	for (size_t first = 0; first < inodes.size(); first += kMaxRequestsInFlight) {
+		size_t count = std::min<size_t>(inodes.size() - first, kMaxRequestsInFlight);
+		std::vector<threc *> recs = fs_get_my_threcs(count);
+		for (size_t i = 0; i < count; ++i) {
+			fs_getattr_packet(recs[i], inodes[first + i], uid, gid);
+		}
+		std::vector<bool> answered = fs_threcs_send_receive(recs, MATOCL_FUSE_GETATTR);
+		for (size_t i = 0; i < count; ++i) {
+			size_t n = first + i;
+			if (!answered[i]) {
+				statuses[n] = fs_getattr(inodes[n], uid, gid, attrs[n]);
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(recs[i]->mutex);
+			MessageBuffer answer = recs[i]->inputBuffer;
+			lock.unlock();
+			// legacy answers start with the message id
+			statuses[n] = fs_getattr_answer(answer.data() + 4, answer.size() - 4, attrs[n]);
+		}
 	}
-	return ret;
 }
 
 uint8_t fs_setattr(uint32_t inode, uint32_t uid, uint32_t gid, uint8_t setmask, uint16_t attrmode, uint32_t attruid, uint32_t attrgid, uint32_t attratime, uint32_t attrmtime, uint8_t sugidclearmode, Attributes &attr) {
@@ -2146,6 +2482,48 @@ uint8_t fs_saureadchunk(std::vector<ChunkTypeWithAddress> &chunkservers, uint64_
 	return SAUNAFS_STATUS_OK;
 }
 
+uint8_t fs_saureadchunks(std::vector<ChunkWithVersionAndLocations> &chunks, uint64_t &fileLength,
+		uint32_t inode, uint32_t chunkIndex, uint32_t chunkCount) {
+	threc *rec = fs_get_my_threc();
+
+	auto message = cltoma::fuseReadChunks::build(rec->packetId, inode, chunkIndex, chunkCount);
+	if (!fs_saucreatepacket(rec, message)) {
+		return SAUNAFS_ERROR_IO;
+	}
+	if (!fs_sausendandreceive(rec, SAU_MATOCL_FUSE_READ_CHUNKS, message)) {
+		return SAUNAFS_ERROR_IO;
+	}
+	try {
+		uint32_t messageId;
+		PacketVersion packetVersion;
+		deserializePacketVersionNoHeader(message, packetVersion);
+		if (packetVersion == matocl::fuseReadChunks::kStatusPacketVersion) {
+			uint8_t status;
+			matocl::fuseReadChunks::deserialize(message, messageId, status);
+			if (status == SAUNAFS_STATUS_OK) {
+				fs_got_inconsistent("SAU_MATOCL_FUSE_READ_CHUNKS", message.size(),
+				                    "version 0 and SAUNAFS_STATUS_OK");
+				return SAUNAFS_ERROR_IO;
+			}
+			return status;
+		} else if (packetVersion == matocl::fuseReadChunks::kResponsePacketVersion) {
+			matocl::fuseReadChunks::deserialize(message, messageId, fileLength, chunks);
+			return SAUNAFS_STATUS_OK;
+		} else {
+			fs_got_inconsistent("SAU_MATOCL_FUSE_READ_CHUNKS", message.size(),
+			                    "unknown version " + std::to_string(packetVersion));
+			return SAUNAFS_ERROR_IO;
+		}
+	} catch (Exception &ex) {
+		fs_got_inconsistent("SAU_MATOCL_FUSE_READ_CHUNKS", message.size(), ex.what());
+		return SAUNAFS_ERROR_IO;
+	}
+}
+
+bool fs_can_read_many_chunks() {
+	return masterversion >= kReadChunksVersion;
+}
+
 uint8_t fs_writechunk(uint32_t inode,uint32_t indx,uint64_t *length,uint64_t *chunkid,uint32_t *version,const uint8_t **csdata,uint32_t *csdatasize) {
 	uint8_t *wptr;
 	const uint8_t *rptr;
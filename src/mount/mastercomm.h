@@ -57,6 +57,19 @@ void fs_statfs(uint64_t *totalspace,uint64_t *availspace,uint64_t *trashspace,ui
 uint8_t fs_access(uint32_t inode,uint32_t uid,uint32_t gid,uint8_t modemask);
 uint8_t fs_lookup(uint32_t parent, const std::string &path, uint32_t uid, uint32_t gid, uint32_t *inode, Attributes &attr);
 uint8_t fs_getattr(uint32_t inode, uint32_t uid, uint32_t gid, Attributes &attr);
+
+/*! \brief Batched versions of fs_lookup and fs_getattr.
+ *
+ * All the requests (up to a limit) are sent before waiting for any answer, so the
+ * batch costs about one round trip to the master. The answers may come in any order.
+ * The results are stored at the indices of the corresponding requests.
+ */
+void fs_lookup_batch(uint32_t parent, const std::vector<std::string> &paths, uint32_t uid,
+		uint32_t gid, std::vector<uint8_t> &statuses, std::vector<uint32_t> &inodes,
+		std::vector<Attributes> &attrs);
+void fs_getattr_batch(const std::vector<uint32_t> &inodes, uint32_t uid, uint32_t gid,
+		std::vector<uint8_t> &statuses, std::vector<Attributes> &attrs);
+
 uint8_t fs_setattr(uint32_t inode, uint32_t uid, uint32_t gid, uint8_t setmask, uint16_t attrmode, uint32_t attruid, uint32_t attrgid, uint32_t attratime, uint32_t attrmtime, uint8_t sugidclearmode, Attributes &attr);
 uint8_t fs_truncate(uint32_t inode, bool opened, uint32_t uid, uint32_t gid, uint64_t length,
 		bool& clientPerforms, Attributes& attr, uint64_t& oldLength, uint32_t& lockId);
@@ -81,6 +94,10 @@ void fs_release(uint32_t inode);
 uint8_t fs_readchunk(uint32_t inode,uint32_t indx,uint64_t *length,uint64_t *chunkid,uint32_t *version,const uint8_t **csdata,uint32_t *csdatasize);
 uint8_t fs_saureadchunk(std::vector<ChunkTypeWithAddress> &serverList, uint64_t &chunkId,
 		uint32_t &chunkVersion, uint64_t &fileLength, uint32_t inode, uint32_t index);
+uint8_t fs_saureadchunks(std::vector<ChunkWithVersionAndLocations> &chunks, uint64_t &fileLength,
+		uint32_t inode, uint32_t chunkIndex, uint32_t chunkCount);
+/// Tells if the master understands fs_saureadchunks.
+bool fs_can_read_many_chunks();
 uint8_t fs_writechunk(uint32_t inode,uint32_t indx,uint64_t *length,uint64_t *chunkid,uint32_t *version,const uint8_t **csdata,uint32_t *csdatasize);
 uint8_t fs_sauwritechunk(uint32_t inode, uint32_t chunkIndex, uint32_t &lockId,
 		uint64_t &fileLength, uint64_t &chunkId, uint32_t &chunkVersion,
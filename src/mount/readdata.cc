@@ -43,6 +43,7 @@
 #include "slogger/slogger.h"
 #include "common/sockets.h"
 #include "common/time_utils.h"
+#include "mount/chunk_location_cache.h"
 #include "mount/chunk_locator.h"
 #include "mount/chunk_reader.h"
 #include "mount/mastercomm.h"
@@ -559,6 +560,8 @@ void* read_worker(void *arg) {
 }
 
 ReadRecord *read_data_new(uint32_t inode) {
+	// locations cached before the file was opened may miss changes made by other clients
+	gChunkLocationCache.invalidate(inode);
 	ReadRecord *rrec = new ReadRecord(inode);
 	std::unique_lock gMutexLock(gMutex);
 
@@ -629,9 +632,11 @@ void read_data_init(uint32_t retries,
 	gTweaks.registerVariable("ReadCacheMaxSize", gReadCacheMaxSize);
 	gTweaks.registerVariable("MaxReadaheadRequests", gMaxReadaheadRequests);
 	gTweaks.registerVariable("ReadChunkPrepare", ChunkReader::preparations);
+	gTweaks.registerVariable("ChunkLocationCacheTimeout", gChunkLocationCache.timeout_ms());
 	gTweaks.registerVariable("ReqExecutedTotal", ReadPlanExecutor::executions_total_);
 	gTweaks.registerVariable("ReqExecutedUsingAll", ReadPlanExecutor::executions_with_additional_operations_);
 	gTweaks.registerVariable("ReqFinishedUsingAll", ReadPlanExecutor::executions_finished_by_additional_operations_);
+	gTweaks.registerVariable("ReqHedged", ReadPlanExecutor::executions_hedged_);
 }
 
 void read_data_term(void) {
@@ -650,6 +655,7 @@ void read_data_term(void) {
 	}
 
 	clear_active_read_records();
+	gChunkLocationCache.clear();
 	gMemoryInfo.reset();
 }
 
@@ -661,6 +667,7 @@ void read_inode_ops(uint32_t inode) { // attributes of inode have been changed -
 	for (auto it = range.first; it != range.second; ++it) {
 		it->second->refreshCounter = REFRESHTICKS; // force reconnect on forthcoming access
 	}
+	gChunkLocationCache.invalidate(inode);
 }
 
 int read_data_sleep_time_ms(int tryCounter) {
@@ -349,6 +349,74 @@ void masterDisconnectedCallback() {
 	}
 }
 
+// While the master reports changes of the cached metadata, the directory entry cache
+// keeps the data for gNotifiedCacheTimeout instead of direntry_cache_timeout
+static std::mutex gCacheNotificationsMutex;
+static bool gCacheNotificationsActive = false;
+static double gNotifiedCacheTimeout = 0.0;
+static std::function<void(Inode)> gKernelInvalidateInode;
+static std::function<void(Inode, const std::string &)> gKernelInvalidateEntry;
+
+/// Applies the cache invalidation notices sent by the master.
+class CacheInvalidationHandler : public PacketHandler {
+public:
+	bool handle(MessageBuffer buffer) override {
+		bool all;
+		std::vector<uint32_t> inodes;
+		std::vector<matocl::fuseInvalidate::Entry> entries;
+		try {
+			matocl::fuseInvalidate::deserialize(buffer.data(), buffer.size(), all, inodes,
+					entries);
+		} catch (IncorrectDeserializationException &ex) {
+			safs_pretty_syslog(LOG_ERR, "Malformed SAU_MATOCL_FUSE_INVALIDATE: %s", ex.what());
+			return false;
+		}
+
+		std::unique_lock<std::mutex> lock(gCacheNotificationsMutex);
+		if (all) {
+			// Sent after subscribing and when the master stops tracking the cache
+			gCacheNotificationsActive = true;
+			gDirEntryCache.lockAndReset(gNotifiedCacheTimeout * 1000000);
+			return true;
+		}
+		std::vector<uint32_t> parents;
+		parents.reserve(entries.size());
+		for (const auto &entry : entries) {
+			parents.push_back(entry.first);
+		}
+		gDirEntryCache.lockAndInvalidateChanges(inodes, parents);
+		for (uint32_t inode : inodes) {
+			symlink_cache_invalidate(inode);
+			if (gKernelInvalidateInode) {
+				gKernelInvalidateInode(inode);
+			}
+		}
+		if (gKernelInvalidateEntry) {
+			for (const auto &entry : entries) {
+				gKernelInvalidateEntry(entry.first, entry.second);
+			}
+		}
+		return true;
+	}
+};
+
+static CacheInvalidationHandler gCacheInvalidationHandler;
+
+void masterCacheNotificationsStopped() {
+	std::unique_lock<std::mutex> lock(gCacheNotificationsMutex);
+	if (gCacheNotificationsActive) {
+		gCacheNotificationsActive = false;
+		gDirEntryCache.lockAndReset(direntry_cache_timeout * 1000000);
+	}
+}
+
+void setKernelCacheInvalidation(std::function<void(Inode)> invalidateInode,
+		std::function<void(Inode, const std::string &)> invalidateEntry) {
+	std::unique_lock<std::mutex> lock(gCacheNotificationsMutex);
+	gKernelInvalidateInode = std::move(invalidateInode);
+	gKernelInvalidateEntry = std::move(invalidateEntry);
+}
+
 inline void eraseAclCache(Inode inode) {
 	acl_cache->erase(
 			inode    , 0, 0,
@@ -814,6 +882,9 @@ EntryParam lookup(Context &ctx, Inode parent, const char *name) {
 			return special_lookup(ino, ctx, parent, name, attrstr);
 		}
 	}
+	// Taken before asking the master, so the reply is not cached if the master
+	// reports a change meanwhile
+	auto data_acquire_time = gDirEntryCache.updateTime();
 	if (parent == SPECIAL_INODE_FILE_BY_INODE) {
 		char *endptr = nullptr;
 		inode = strtol(name, &endptr, 10);
@@ -887,8 +958,6 @@ EntryParam lookup(Context &ctx, Inode parent, const char *name) {
 	// Files with at least one hardlink are impossible to keep track of, so it is
 	// better to don't track them.
 	if (!icacheflag && !(e.attr.st_nlink > 1 && attr[0] == TYPE_FILE)) {
-		auto data_acquire_time = gDirEntryCache.updateTime();
-
 		std::unique_lock<shared_mutex> write_guard(gDirEntryCache.rwlock());
 		gDirEntryCache.updateTime();
 
@@ -936,6 +1005,7 @@ AttrReply getattr(Context &ctx, Inode ino) {
 	}
 
 	maxfleng = write_data_getmaxfleng(ino);
+	auto data_acquire_time = gDirEntryCache.updateTime();
 	if (usedircache && gDirEntryCache.lookup(ctx,ino,attr)) {
 		if (debug_mode) {
 			safs::log_debug("getattr: sending data from dircache");
@@ -970,8 +1040,6 @@ AttrReply getattr(Context &ctx, Inode ino) {
 	// Files with at least one hardlink are impossible to keep track of, so it is
 	// better to don't track them.
 	if (!fromCache && !(o_stbuf.st_nlink > 1 && attr[0] == TYPE_FILE)) {
-		auto data_acquire_time = gDirEntryCache.updateTime();
-
 		std::unique_lock<shared_mutex> write_guard(gDirEntryCache.rwlock());
 		gDirEntryCache.updateTime();
 
@@ -1820,6 +1888,7 @@ std::vector<DirEntry> readdir(Context &ctx, uint64_t fh, Inode ino, off_t off, s
 		sassert(sessionIt != gReaddirSessions.end() || gReaddirSessions.empty());
 		readdirSession = &sessionIt->second;
 	}
+	auto data_acquire_time = gDirEntryCache.updateTime();
 	do {
 		updateNextReaddirEntryIndexIfMasterRestarted(*readdirSession, entry_index, ctx, ino, request_size);
 		status = fs_getdir(ino, ctx.uid, ctx.gid, entry_index, request_size, dir_entries);
@@ -1830,8 +1899,6 @@ std::vector<DirEntry> readdir(Context &ctx, uint64_t fh, Inode ino, off_t off, s
 		}
 	} while (readdirSession->restarted);
 
-	auto data_acquire_time = gDirEntryCache.updateTime();
-
 	if(status != SAUNAFS_STATUS_OK) {
 		throw RequestException(status);
 	}
@@ -3457,7 +3524,12 @@ void init(int debug_mode_, int keep_cache_, double direntry_cache_timeout_, unsi
 	sugid_clear_mode = static_cast<decltype (sugid_clear_mode)>(sugid_clear_mode_);
 	use_rwlock = use_rwlock_;
 	uint64_t timeout = (uint64_t)(direntry_cache_timeout * 1000000);
-	gDirEntryCache.setTimeout(timeout);
+	{
+		std::unique_lock<std::mutex> lock(gCacheNotificationsMutex);
+		if (!gCacheNotificationsActive) {
+			gDirEntryCache.setTimeout(timeout);
+		}
+	}
 	gDirEntryCacheMaxSize = direntry_cache_size_;
 	gDirectIo = direct_io;
 	if (debug_mode) {
@@ -3492,6 +3564,10 @@ void init(int debug_mode_, int keep_cache_, double direntry_cache_timeout_, unsi
 void fs_init(FsInitParams &params) {
 	socketinit();
 	mycrc32_init();
+	if (params.notified_cache_timeout > 0) {
+		gNotifiedCacheTimeout = params.notified_cache_timeout;
+		fs_register_packet_type_handler(SAU_MATOCL_FUSE_INVALIDATE, &gCacheInvalidationHandler);
+	}
 	int connection_ret = fs_init_master_connection(params
 #ifdef _WIN32
 	, session_flags, params.mounting_uid, params.mounting_gid
@@ -3561,6 +3637,7 @@ void fs_term() {
 	read_data_term();
 	masterproxy_term();
 	::fs_term();
+	fs_unregister_packet_type_handler(SAU_MATOCL_FUSE_INVALIDATE, &gCacheInvalidationHandler);
 	symlink_cache_term();
 	socketrelease();
 	notifications_area_logging_term();
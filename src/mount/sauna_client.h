@@ -26,6 +26,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <functional>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -71,6 +72,7 @@ struct FsInitParams {
 	static constexpr unsigned kDefaultReportReservedPeriod = 30;
 #endif
 	static constexpr unsigned kDefaultIoRetries = 30;
+	static constexpr unsigned kDefaultMasterConnections = 1;
 	static constexpr unsigned kDefaultRoundTime = 200;
 	static constexpr unsigned kDefaultChunkserverConnectTo = 2000;
 	static constexpr unsigned kDefaultChunkserverReadTo = 2000;
@@ -107,6 +109,7 @@ struct FsInitParams {
 	static constexpr int      kDefaultKeepCache = 0;
 	static constexpr double   kDefaultDirentryCacheTimeout = 0.25;
 	static constexpr unsigned kDefaultDirentryCacheSize = 100000;
+	static constexpr double   kDefaultNotifiedCacheTimeout = 0.0;
 	static constexpr double   kDefaultEntryCacheTimeout = 0.0;
 	static constexpr double   kDefaultAttrCacheTimeout = 1.0;
 #ifdef __linux__
@@ -134,6 +137,7 @@ struct FsInitParams {
 	             : bind_host(), host(), port(), meta(false), mountpoint(), subfolder(kDefaultSubfolder),
 	             do_not_remember_password(kDefaultDoNotRememberPassword), delayed_init(kDefaultDelayedInit),
 	             report_reserved_period(kDefaultReportReservedPeriod),
+	             master_connections(kDefaultMasterConnections),
 	             io_retries(kDefaultIoRetries),
 	             chunkserver_round_time_ms(kDefaultRoundTime),
 	             chunkserver_connect_timeout_ms(kDefaultChunkserverConnectTo),
@@ -153,6 +157,7 @@ struct FsInitParams {
 	             symlink_cache_timeout_s(kDefaultSymlinkCacheTimeout),
 	             debug_mode(kDefaultDebugMode), keep_cache(kDefaultKeepCache),
 	             direntry_cache_timeout(kDefaultDirentryCacheTimeout), direntry_cache_size(kDefaultDirentryCacheSize),
+	             notified_cache_timeout(kDefaultNotifiedCacheTimeout),
 	             entry_cache_timeout(kDefaultEntryCacheTimeout), attr_cache_timeout(kDefaultAttrCacheTimeout),
 	             mkdir_copy_sgid(kDefaultMkdirCopySgid), sugid_clear_mode(kDefaultSugidClearMode),
 	             use_rw_lock(kDefaultUseRwLock),
@@ -177,6 +182,7 @@ struct FsInitParams {
 	             : bind_host(bind_host), host(host), port(port), meta(false), mountpoint(mountpoint), subfolder(kDefaultSubfolder),
 	             do_not_remember_password(kDefaultDoNotRememberPassword), delayed_init(kDefaultDelayedInit),
 	             report_reserved_period(kDefaultReportReservedPeriod),
+	             master_connections(kDefaultMasterConnections),
 	             io_retries(kDefaultIoRetries),
 	             chunkserver_round_time_ms(kDefaultRoundTime),
 	             chunkserver_connect_timeout_ms(kDefaultChunkserverConnectTo),
@@ -196,6 +202,7 @@ struct FsInitParams {
 	             symlink_cache_timeout_s(kDefaultSymlinkCacheTimeout),
 	             debug_mode(kDefaultDebugMode), keep_cache(kDefaultKeepCache),
 	             direntry_cache_timeout(kDefaultDirentryCacheTimeout), direntry_cache_size(kDefaultDirentryCacheSize),
+	             notified_cache_timeout(kDefaultNotifiedCacheTimeout),
 	             entry_cache_timeout(kDefaultEntryCacheTimeout), attr_cache_timeout(kDefaultAttrCacheTimeout),
 	             mkdir_copy_sgid(kDefaultMkdirCopySgid), sugid_clear_mode(kDefaultSugidClearMode),
 	             use_rw_lock(kDefaultUseRwLock),
@@ -226,6 +233,7 @@ struct FsInitParams {
 	bool do_not_remember_password;
 	bool delayed_init;
 	unsigned report_reserved_period;
+	unsigned master_connections;
 
 	unsigned io_retries;
 	unsigned chunkserver_round_time_ms;
@@ -252,6 +260,8 @@ struct FsInitParams {
 	int keep_cache;
 	double direntry_cache_timeout;
 	unsigned direntry_cache_size;
+	// Timeout of the directory entry cache while the master reports changes, 0 - don't subscribe
+	double notified_cache_timeout;
 	double entry_cache_timeout;
 	double attr_cache_timeout;
 	bool mkdir_copy_sgid;
@@ -388,6 +398,15 @@ void updateGroups(Context &ctx);
 
 void masterDisconnectedCallback();
 
+/// Called when the master connection which got cache invalidation notices is closed.
+void masterCacheNotificationsStopped();
+
+/// Sets functions passing the changes reported by the master to the kernel, empty
+/// functions stop it. They are called by the thread receiving packets from the master,
+/// so they may not wait for any filesystem operation.
+void setKernelCacheInvalidation(std::function<void(Inode)> invalidateInode,
+		std::function<void(Inode, const std::string &)> invalidateEntry);
+
 // TODO what about this one? Will decide when writing non-fuse client
 // void fsinit(void *userdata, struct fuse_conn_info *conn);
 bool isSpecialInode(SaunaClient::Inode ino);
@@ -170,6 +170,31 @@ int symlink_cache_search(uint32_t inode,const uint8_t **path) {
 	return 0;
 }
 
+void symlink_cache_invalidate(uint32_t inode) {
+	uint32_t primes[HASH_FUNCTIONS] = {1072573589U,3465827623U,2848548977U,748191707U};
+	hashbucket *hb;
+	uint8_t h,i;
+
+	pthread_mutex_lock(&slcachelock);
+	for (h=0 ; h<HASH_FUNCTIONS ; h++) {
+		hb = symlinkhash + ((inode*primes[h])%HASH_BUCKETS);
+		for (i=0 ; i<HASH_BUCKET_SIZE ; i++) {
+			if (hb->inode[i]==inode) {
+				if (hb->path[i]) {
+					free(hb->path[i]);
+					hb->path[i]=NULL;
+				}
+				hb->time[i]=0;
+				hb->inode[i]=0;
+				pthread_mutex_unlock(&slcachelock);
+				symlink_cache_stats_dec(LINKS);
+				return;
+			}
+		}
+	}
+	pthread_mutex_unlock(&slcachelock);
+}
+
 void symlink_cache_init(uint32_t cache_time) {
 	symlinkhash = (hashbucket*) malloc(sizeof(hashbucket)*HASH_BUCKETS);
 	memset(symlinkhash,0,sizeof(hashbucket)*HASH_BUCKETS);
@@ -26,5 +26,6 @@
 
 void symlink_cache_insert(uint32_t inode,const uint8_t *path);
 int symlink_cache_search(uint32_t inode,const uint8_t **path);
+void symlink_cache_invalidate(uint32_t inode);
 void symlink_cache_init(uint32_t cache_time = 3600);
 void symlink_cache_term(void);
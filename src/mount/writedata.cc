@@ -31,6 +31,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 #include <vector>
@@ -203,16 +205,30 @@ struct DelayedQueueEntry {
 } // anonymous namespace
 
 static std::atomic<uint32_t> maxretries;
-static std::mutex gMutex;
+// Lock of the shard of the inode being processed (see InodeDataShard)
 typedef std::unique_lock<std::mutex> Glock;
 
+// Free cache blocks are counted without any lock, the mutex is only for the waiters
+static std::mutex fcbMutex;
 static std::condition_variable fcbcond;
-static uint32_t fcbwaiting = 0;
-static int64_t freecacheblocks;
+static std::atomic<uint32_t> fcbwaiting(0);
+static std::atomic<int64_t> freecacheblocks;
 
 // <inode, respective inodedata> and sorted by inode
 using InodeDataMap = std::map<uint32_t, inodedata *>;
-static InodeDataMap inodedataMap;
+
+/*! \brief Part of the inodes, chosen by the inode number, with their own lock.
+ *
+ * The mutex protects the map and all the inodedata in it, so writes to files
+ * from different shards never wait for each other.
+ */
+struct alignas(64) InodeDataShard {
+	std::mutex mutex;
+	InodeDataMap inodedataMap;
+};
+
+static constexpr uint32_t kInodeDataShards = 128;
+static std::array<InodeDataShard, kInodeDataShards> inodedataShards;
 
 static uint32_t gWriteWindowSize;
 static uint32_t gChunkserverTimeout_ms;
@@ -224,73 +240,98 @@ static pthread_t delayed_queue_worker_th;
 static std::vector<pthread_t> write_worker_th;
 
 static std::unique_ptr<ProducerConsumerQueue> jobsQueue;
+static std::mutex delayedQueueMutex;
 static std::list<DelayedQueueEntry> delayedQueue;
 
 static ConnectionPool gChunkserverConnectionPool;
 static ChunkConnectorUsingPool gChunkConnector(gChunkserverConnectionPool);
 
-void write_cb_release_blocks(uint32_t count, Glock&) {
+static std::mutex &write_inode_mutex(uint32_t inode) {
+	return inodedataShards[inode % kInodeDataShards].mutex;
+}
+
+void write_cb_release_blocks(uint32_t count) {
 	freecacheblocks += count;
-	if (fcbwaiting > 0 && freecacheblocks > 0) {
+	if (fcbwaiting > 0) {
+		// Taking the mutex makes sure the waiter either sees the new value or is woken up
+		std::lock_guard<std::mutex> fcbLock(fcbMutex);
 		fcbcond.notify_all();
 	}
 }
 
-void write_cb_acquire_blocks(uint32_t count, Glock&) {
+void write_cb_acquire_blocks(uint32_t count) {
 	freecacheblocks -= count;
 }
 
+/*! Wait until the inode may take a new block from the cache.
+ *
+ * The inode lock is released while waiting, as the blocks are given back by
+ * the write workers which need it. Concurrent writers of different shards may
+ * take the last free blocks at once, so the counter can go a few blocks below
+ * zero, in which case the next writers wait longer.
+ */
 void write_cb_wait_for_block(inodedata* id, Glock& glock) {
 	LOG_AVG_TILL_END_OF_SCOPE0("write_cb_wait_for_block");
-	fcbwaiting++;
 	uint64_t dataChainSize = id->dataChain.size();
-	while (freecacheblocks <= 0
-			// dataChainSize / (dataChainSize + freecacheblocks) > gCachePerInodePercentage / 100
-			// really means "0 > 0"
-			|| dataChainSize * 100 > (dataChainSize + freecacheblocks) * gCachePerInodePercentage)
+	auto canTakeBlock = [dataChainSize]() {
+		int64_t freeBlocks = freecacheblocks;
+		// dataChainSize / (dataChainSize + freeBlocks) > gCachePerInodePercentage / 100
+		// really means "0 > 0"
+		return freeBlocks > 0
+		    && dataChainSize * 100 <= (dataChainSize + freeBlocks) * gCachePerInodePercentage;
+	};
+	if (canTakeBlock()) {
+		return;
+	}
+	glock.unlock();
 	{
-		fcbcond.wait(glock);
+		std::unique_lock<std::mutex> fcbLock(fcbMutex);
+		fcbwaiting++;
+		fcbcond.wait(fcbLock, canTakeBlock);
+		fcbwaiting--;
 	}
-	fcbwaiting--;
+	glock.lock();
 }
 
 /* inode */
 
 inodedata *write_find_inodedata(uint32_t inode, Glock &) {
-	if (inodedataMap.contains(inode)) {
-		return inodedataMap[inode];
-	}
-	return NULL;
+	auto &inodedataMap = inodedataShards[inode % kInodeDataShards].inodedataMap;
+	auto it = inodedataMap.find(inode);
+	return it != inodedataMap.end() ? it->second : nullptr;
 }
 
 inodedata *write_get_inodedata(uint32_t inode, Glock &) {
-	if (inodedataMap.contains(inode)) {
-		return inodedataMap[inode];
+	auto &inodedataMap = inodedataShards[inode % kInodeDataShards].inodedataMap;
+	auto [it, inserted] = inodedataMap.try_emplace(inode, nullptr);
+	if (inserted) {
+		it->second = new inodedata(inode);
 	}
-	auto id = new inodedata(inode);
-	inodedataMap[inode] = id;
-	return id;
+	return it->second;
 }
 
 void write_free_inodedata(inodedata *fid, Glock &) {
 	uint32_t inode = fid->inode;
-	if (!inodedataMap.contains(inode)) {
+	auto &inodedataMap = inodedataShards[inode % kInodeDataShards].inodedataMap;
+	auto it = inodedataMap.find(inode);
+	if (it == inodedataMap.end()) {
 		return;
 	}
 
-	auto id = inodedataMap[inode];
-	sassert(id == fid);
-	delete id;
-	inodedataMap.erase(inode);
+	sassert(it->second == fid);
+	delete it->second;
+	inodedataMap.erase(it);
 }
 
-/* delayed queue */
+/* delayed queue | delayedQueueMutex: UNLOCKED */
 
-static void delayed_queue_put(inodedata* id, uint32_t seconds, Glock&) {
+static void delayed_queue_put(inodedata* id, uint32_t seconds) {
+	std::lock_guard<std::mutex> queueLock(delayedQueueMutex);
 	delayedQueue.push_back(DelayedQueueEntry(id, seconds * DelayedQueueEntry::kTicksPerSecond));
 }
 
 static bool delayed_queue_remove(inodedata* id, Glock&) {
+	std::lock_guard<std::mutex> queueLock(delayedQueueMutex);
 	for (auto it = delayedQueue.begin(); it != delayedQueue.end(); ++it) {
 		if (it->inodeData == id) {
 			delayedQueue.erase(it);
@@ -305,7 +346,7 @@ void* delayed_queue_worker(void*) {
 
 	for (;;) {
 		Timeout timeout(std::chrono::microseconds(1000000 / DelayedQueueEntry::kTicksPerSecond));
-		Glock lock(gMutex);
+		std::unique_lock<std::mutex> lock(delayedQueueMutex);
 		auto it = delayedQueue.begin();
 		while (it != delayedQueue.end()) {
 			if (it->inodeData == NULL) {
@@ -327,9 +368,9 @@ void* delayed_queue_worker(void*) {
 
 /* queues */
 
-void write_delayed_enqueue(inodedata* id, uint32_t seconds, Glock& lock) {
+void write_delayed_enqueue(inodedata* id, uint32_t seconds, Glock&) {
 	if (seconds > 0) {
-		delayed_queue_put(id, seconds, lock);
+		delayed_queue_put(id, seconds);
 	} else {
 		jobsQueue->put(0, 0, reinterpret_cast<uint8_t*>(id), 0);
 	}
@@ -357,7 +398,7 @@ void write_job_delayed_end(inodedata* id, int status, int seconds, Glock &lock)
 		write_delayed_enqueue(id, seconds, lock);
 	} else {        // no more work or error occurred
 		// if this is an error then release all data blocks
-		write_cb_release_blocks(id->dataChain.size(), lock);
+		write_cb_release_blocks(id->dataChain.size());
 		id->dataChain.clear();
 		id->inqueue = false;
 		// We don't reset maxfleng (id->maxfleng = 0;) for a while longer, to
@@ -402,7 +443,7 @@ void InodeChunkWriter::processJob(inodedata* inodeData) {
 	inodeData_ = inodeData;
 
 	// First, choose index of some chunk to write
-	Glock lock(gMutex);
+	Glock lock(write_inode_mutex(inodeData_->inode));
 	int status = inodeData_->status;
 	bool haveDataToWrite;
 	if (inodeData_->locator) {
@@ -437,7 +478,7 @@ void InodeChunkWriter::processJob(inodedata* inodeData) {
 	try {
 		try {
 			locator->locateAndLockChunk(inodeData_->inode, chunkIndex_);
-			Glock lock(gMutex);
+			Glock lock(write_inode_mutex(inodeData_->inode));
 			inodeData_->maxfleng =
 			    std::max(inodeData_->maxfleng, locator->fileLength());
 			lock.unlock();
@@ -474,7 +515,7 @@ void InodeChunkWriter::processJob(inodedata* inodeData) {
 			std::string errorString = e.what();
 			addPathByInodeBasedNotificationMessage(
 			    "Write error: " + std::string(e.what()), inodeData_->inode);
-			Glock lock(gMutex);
+			Glock lock(write_inode_mutex(inodeData_->inode));
 			if (e.status() != SAUNAFS_ERROR_LOCKED) {
 				inodeData_->trycnt++;
 				errorString += " (try counter: " + std::to_string(inodeData->trycnt) + ")";
@@ -504,7 +545,7 @@ void InodeChunkWriter::processJob(inodedata* inodeData) {
 	} catch (UnrecoverableWriteException& e) {
 		addPathByInodeBasedNotificationMessage(
 		    "Write error: " + std::string(e.what()), inodeData_->inode);
-		Glock lock(gMutex);
+		Glock lock(write_inode_mutex(inodeData_->inode));
 		if (e.status() == SAUNAFS_ERROR_ENOENT) {
 			write_job_end(inodeData_, SAUNAFS_ERROR_EBADF, lock);
 		} else if (e.status() == SAUNAFS_ERROR_QUOTA) {
@@ -519,7 +560,7 @@ void InodeChunkWriter::processJob(inodedata* inodeData) {
 			addPathByInodeBasedNotificationMessage(
 			    "Write error: " + std::string(e.what()), inodeData_->inode);
 		}
-		Glock lock(gMutex);
+		Glock lock(write_inode_mutex(inodeData_->inode));
 		int waitTime = 1;
 		if (inodeData_->trycnt > 10) {
 			waitTime = std::min<int>(10, inodeData_->trycnt - 9);
@@ -552,13 +593,13 @@ void InodeChunkWriter::processDataChain(ChunkWriter& writer) {
 		bool can_expect_next_block = true;
 		if (wholeOperationTimer.elapsed_s() + kTimeToFinishOperations < maximumTime
 				&& writer.acceptsNewOperations()) {
-			Glock lock(gMutex);
+			Glock lock(write_inode_mutex(inodeData_->inode));
 			// While there is any block worth sending, we add new write operation
 			while (haveBlockWorthWriting(writer.getUnfinishedOperationsCount(), lock)) {
 				// Remove block from cache and pass it to the writer
 				writer.addOperation(std::move(inodeData_->dataChain.front()));
 				inodeData_->popFromChain();
-				write_cb_release_blocks(1, lock);
+				write_cb_release_blocks(1);
 			}
 			if (inodeData_->requiresFlushing() && !haveAnyBlockInCurrentChunk(lock)) {
 				// No more data and some flushing is needed or required, so flush everything
@@ -570,7 +611,7 @@ void InodeChunkWriter::processDataChain(ChunkWriter& writer) {
 			can_expect_next_block = haveAnyBlockInCurrentChunk(lock);
 		} else if (writer.acceptsNewOperations()) {
 			// We are running out of time...
-			Glock lock(gMutex);
+			Glock lock(write_inode_mutex(inodeData_->inode));
 			if (!inodeData_->requiresFlushing()) {
 				// Nobody is waiting for the data to be flushed and the data in write chain
 				// isn't too old. Let's postpone any operations
@@ -583,7 +624,7 @@ void InodeChunkWriter::processDataChain(ChunkWriter& writer) {
 			can_expect_next_block = haveAnyBlockInCurrentChunk(lock);
 		}
 
-		Glock lock(gMutex);
+		Glock lock(write_inode_mutex(inodeData_->inode));
 		writer.setChunkSizeInBlocks(
 		    std::min(inodeData_->maxfleng - chunkIndex_ * SFSCHUNKSIZE,
 		             (uint64_t)SFSCHUNKSIZE));
@@ -606,9 +647,9 @@ void InodeChunkWriter::processDataChain(ChunkWriter& writer) {
 	}
 }
 
-void InodeChunkWriter::returnJournalToDataChain(std::list<WriteCacheBlock> &&journal, Glock &lock) {
+void InodeChunkWriter::returnJournalToDataChain(std::list<WriteCacheBlock> &&journal, Glock &) {
 	if (!journal.empty()) {
-		write_cb_acquire_blocks(journal.size(), lock);
+		write_cb_acquire_blocks(journal.size());
 		uint64_t prev_id = journal.front().chunkIndex;
 		int alterations = (!inodeData_->dataChain.empty()
 				&& journal.back().chunkIndex != inodeData_->dataChain.front().chunkIndex) ? 1 : 0;
@@ -722,10 +763,7 @@ void write_data_init(uint32_t cachesize, uint32_t retries, uint32_t workers,
 void write_data_term(void) {
 	uint32_t i;
 
-	{
-		Glock lock(gMutex);
-		delayed_queue_put(nullptr, 0, lock);
-	}
+	delayed_queue_put(nullptr, 0);
 	for (i = 0; i < write_worker_th.size(); i++) {
 		jobsQueue->put(0, 0, nullptr, 0);
 	}
@@ -734,15 +772,17 @@ void write_data_term(void) {
 	}
 	pthread_join(delayed_queue_worker_th, NULL);
 	jobsQueue.reset();
-	for (const auto &[_, id] : inodedataMap) {
-		delete id;
+	for (auto &shard : inodedataShards) {
+		for (const auto &[_, id] : shard.inodedataMap) {
+			delete id;
+		}
+		shard.inodedataMap.clear();
 	}
-	inodedataMap.clear();
 }
 
 /* glock: UNLOCKED */
 int write_block(inodedata *id, uint32_t chindx, uint16_t pos, uint32_t from, uint32_t to, const uint8_t *data) {
-	Glock lock(gMutex);
+	Glock lock(write_inode_mutex(id->inode));
 	id->lastWriteToDataChain.reset();
 
 	// Try to expand the last block
@@ -759,7 +799,7 @@ int write_block(inodedata *id, uint32_t chindx, uint16_t pos, uint32_t from, uin
 
 	// Didn't manage to expand an existing block, so allocate a new one
 	write_cb_wait_for_block(id, lock);
-	write_cb_acquire_blocks(1, lock);
+	write_cb_acquire_blocks(1);
 	id->pushToChain(WriteCacheBlock(chindx, pos, WriteCacheBlock::kWritableBlock));
 	sassert(id->dataChain.back().expand(from, to, data));
 	if (id->inqueue) {
@@ -818,7 +858,7 @@ int write_data(void *vid, uint64_t offset, uint32_t size, const uint8_t *data,
 		return SAUNAFS_ERROR_IO;
 	}
 
-	Glock lock(gMutex);
+	Glock lock(write_inode_mutex(id->inode));
 	status = id->status;
 	id->maxfleng = std::max(id->maxfleng, currentSize);
 	if (status == SAUNAFS_STATUS_OK) {
@@ -873,7 +913,7 @@ inline void write_data_lcnt_decrease(inodedata *id, Glock& lock) {
 
 void* write_data_new(uint32_t inode) {
 	inodedata* id;
-	Glock lock(gMutex);
+	Glock lock(write_inode_mutex(inode));
 	id = write_get_inodedata(inode, lock);
 	if (id == NULL) {
 		return NULL;
@@ -902,14 +942,18 @@ static int write_data_flush(void* vid, Glock& lock) {
 }
 
 int write_data_flush(void* vid) {
-	Glock lock(gMutex);
-	return write_data_flush(vid, lock);
+	inodedata* id = (inodedata*) vid;
+	if (id == NULL) {
+		return SAUNAFS_ERROR_IO;
+	}
+	Glock lock(write_inode_mutex(id->inode));
+	return write_data_flush(id, lock);
 }
 
 uint64_t write_data_getmaxfleng(uint32_t inode) {
 	uint64_t maxfleng;
 	inodedata* id;
-	Glock lock(gMutex);
+	Glock lock(write_inode_mutex(inode));
 	id = write_find_inodedata(inode, lock);
 	if (id) {
 		maxfleng = id->maxfleng;
@@ -920,7 +964,7 @@ uint64_t write_data_getmaxfleng(uint32_t inode) {
 }
 
 int write_data_flush_inode(uint32_t inode) {
-	Glock lock(gMutex);
+	Glock lock(write_inode_mutex(inode));
 	inodedata* id = write_find_inodedata(inode, lock);
 	if (id == NULL) {
 		return 0;
@@ -930,7 +974,7 @@ int write_data_flush_inode(uint32_t inode) {
 
 int write_data_truncate(uint32_t inode, bool opened, uint32_t uid, uint32_t gid, uint64_t length,
 		Attributes& attr) {
-	Glock lock(gMutex);
+	Glock lock(write_inode_mutex(inode));
 
 	// 1. Flush writes but don't finish it completely - it'll be done at the end of truncate
 	inodedata* id = write_get_inodedata(inode, lock);
@@ -1031,6 +1075,7 @@ int write_data_truncate(uint32_t inode, bool opened, uint32_t uid, uint32_t gid,
 	// Now we can tell the master server to finish the truncate operation and then unblock the inode
 	lock.unlock();
 	status = fs_truncateend(inode, uid, gid, length, lockId, attr);
+	lock.lock();
 	write_data_flushwaiting_decrease(id, lock);
 	write_data_lcnt_decrease(id, lock);
 
@@ -1042,11 +1087,11 @@ int write_data_truncate(uint32_t inode, bool opened, uint32_t uid, uint32_t gid,
 }
 
 int write_data_end(void* vid) {
-	Glock lock(gMutex);
 	inodedata* id = (inodedata*) vid;
 	if (id == NULL) {
 		return SAUNAFS_ERROR_IO;
 	}
+	Glock lock(write_inode_mutex(id->inode));
 	int status = write_data_flush(id, lock);
 	write_data_lcnt_decrease(id, lock);
 	return status;
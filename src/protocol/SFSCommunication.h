@@ -1749,6 +1749,23 @@ enum class SugidClearMode {
 // 0x646
 #define SAU_MATOCL_FULL_PATH_BY_INODE (1000U + 606U)
 
+// 0x647
+#define SAU_CLTOMA_FUSE_READ_CHUNKS (1000U + 607U)
+/// msgid:32 inode:32 chunkindex:32 chunkcount:32
+
+// 0x648
+#define SAU_MATOCL_FUSE_READ_CHUNKS (1000U + 608U)
+/// version==0 msgid:32 status:8
+/// version==1 msgid:32 filelength:64 chunks:(N * [chunkid:64 chunkversion:32 locations:(M * [ip:32 port:16 chunktype:16 csversion:32])])
+
+// 0x649
+#define SAU_CLTOMA_FUSE_CACHE_NOTIFICATIONS (1000U + 609U)
+/// - (no answer, the master sends SAU_MATOCL_FUSE_INVALIDATE on this connection from now on)
+
+// 0x64A
+#define SAU_MATOCL_FUSE_INVALIDATE (1000U + 610U)
+/// all:8 inodes:(N * [inode:32]) entries:(N * [parent:32 name:STDSTRING])
+
 // CHUNKSERVER STATS
 
 // 0x0258
@@ -214,6 +214,18 @@ SAUNAFS_DEFINE_PACKET_SERIALIZATION(
 		uint32_t, chunk_index,
 		uint32_t, chunk_count)
 
+// SAU_CLTOMA_FUSE_READ_CHUNKS
+SAUNAFS_DEFINE_PACKET_SERIALIZATION(
+		cltoma, fuseReadChunks, SAU_CLTOMA_FUSE_READ_CHUNKS, 0,
+		uint32_t, message_id,
+		uint32_t, inode,
+		uint32_t, chunk_index,
+		uint32_t, chunk_count)
+
+// SAU_CLTOMA_FUSE_CACHE_NOTIFICATIONS
+SAUNAFS_DEFINE_PACKET_SERIALIZATION(
+		cltoma, fuseCacheNotifications, SAU_CLTOMA_FUSE_CACHE_NOTIFICATIONS, 0)
+
 // SAU_CLTOMA_HOSTNAME
 SAUNAFS_DEFINE_PACKET_SERIALIZATION(
 		cltoma, hostname, SAU_CLTOMA_HOSTNAME, 0)
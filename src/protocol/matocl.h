@@ -263,6 +263,41 @@ SAUNAFS_DEFINE_PACKET_SERIALIZATION(
 		uint32_t, message_id,
 		std::vector<ChunkWithAddressAndLabel>, chunks)
 
+// SAU_MATOCL_FUSE_READ_CHUNKS
+namespace matocl {
+namespace fuseReadChunks {
+	static constexpr uint32_t kMaxNumberOfResultEntries = 256;
+}
+}
+
+SAUNAFS_DEFINE_PACKET_VERSION(matocl, fuseReadChunks, kStatusPacketVersion, 0)
+SAUNAFS_DEFINE_PACKET_VERSION(matocl, fuseReadChunks, kResponsePacketVersion, 1)
+
+SAUNAFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, fuseReadChunks, SAU_MATOCL_FUSE_READ_CHUNKS, kStatusPacketVersion,
+		uint32_t, message_id,
+		uint8_t, status)
+
+SAUNAFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, fuseReadChunks, SAU_MATOCL_FUSE_READ_CHUNKS, kResponsePacketVersion,
+		uint32_t, message_id,
+		uint64_t, file_length,
+		std::vector<ChunkWithVersionAndLocations>, chunks)
+
+// SAU_MATOCL_FUSE_INVALIDATE
+namespace matocl {
+namespace fuseInvalidate {
+	// Directory and name of a changed entry
+	using Entry = std::pair<uint32_t, std::string>;
+}
+}
+
+SAUNAFS_DEFINE_PACKET_SERIALIZATION(
+		matocl, fuseInvalidate, SAU_MATOCL_FUSE_INVALIDATE, 0,
+		bool, all,
+		std::vector<uint32_t>, inodes,
+		std::vector<matocl::fuseInvalidate::Entry>, entries)
+
 // SAU_MATOCL_HOSTNAME
 SAUNAFS_DEFINE_PACKET_SERIALIZATION(
 		matocl, hostname, SAU_MATOCL_HOSTNAME, 0,
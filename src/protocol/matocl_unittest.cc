@@ -241,3 +241,22 @@ TEST(MatoclCommunicationTests, FuseSetAcl) {
 	SAUNAFS_VERIFY_INOUT_PAIR(messageId);
 	SAUNAFS_VERIFY_INOUT_PAIR(status);
 }
+
+TEST(MatoclCommunicationTests, FuseInvalidate) {
+	SAUNAFS_DEFINE_INOUT_PAIR(bool, all, false, true);
+	SAUNAFS_DEFINE_INOUT_VECTOR_PAIR(uint32_t, inodes) = {5, 17};
+	SAUNAFS_DEFINE_INOUT_VECTOR_PAIR(matocl::fuseInvalidate::Entry, entries) = {
+			{1, "file"}, {17, "dir"}};
+
+	std::vector<uint8_t> buffer;
+	ASSERT_NO_THROW(matocl::fuseInvalidate::serialize(buffer, allIn, inodesIn, entriesIn));
+
+	verifyHeader(buffer, SAU_MATOCL_FUSE_INVALIDATE);
+	removeHeaderInPlace(buffer);
+	ASSERT_NO_THROW(matocl::fuseInvalidate::deserialize(buffer.data(), buffer.size(),
+			allOut, inodesOut, entriesOut));
+
+	SAUNAFS_VERIFY_INOUT_PAIR(all);
+	SAUNAFS_VERIFY_INOUT_PAIR(inodes);
+	SAUNAFS_VERIFY_INOUT_PAIR(entries);
+}
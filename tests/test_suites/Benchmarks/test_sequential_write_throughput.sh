@@ -0,0 +1,39 @@
+# Measures the throughput of sequential writes through chains of chunkservers.
+# Consecutive blocks of a chunk received while the disk is busy are written with
+# a single vectored write, which matters most for small application writes.
+# The idea is to use it to compare the performance after some changes.
+
+timeout_set 5 minutes
+
+CHUNKSERVERS=3 \
+	USE_RAMDISK=YES \
+	MOUNT_EXTRA_CONFIG="sfscachemode=NEVER" \
+	CHUNKSERVER_EXTRA_CONFIG="GARBAGE_COLLECTION_FREQ_MS = 0|HDD_TEST_FREQ = 100000" \
+	AUTO_SHADOW_MASTER="NO" \
+	setup_local_empty_saunafs info
+
+cd "${info[mount0]}"
+
+file_size_mb=512
+
+for goal in 1 3; do
+	for block_size_kb in 64 1024; do
+		test_filename=write_${goal}_${block_size_kb}K
+		touch "$test_filename"
+		saunafs setgoal $goal "$test_filename"
+
+		drop_caches
+		time_file=$TEMP_DIR/$(unique_file)
+		/usr/bin/time -o "$time_file" -f %e dd \
+			if=/dev/zero \
+			of="$test_filename" \
+			bs=${block_size_kb}K \
+			count=$((file_size_mb * 1024 / block_size_kb)) \
+			conv=fsync
+		write_time=$(cat "$time_file")
+		write_speed=$(echo "scale=3;${file_size_mb}/${write_time}" | bc)
+		echo "Goal ${goal}, ${block_size_kb}K writes: ${write_speed} MB/s"
+
+		rm -f "$test_filename"
+	done
+done
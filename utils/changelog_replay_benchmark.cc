@@ -0,0 +1,163 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "common/changelog_file.h"
+#include "common/changelog_prefetching_reader.h"
+#include "common/crc.h"
+
+namespace {
+
+/// Keeps the simulated application from being optimized out
+volatile uint64_t gApplyResult;
+
+void showHelpMessageAndExit(char *progName, int status) {
+	std::cerr
+	    << "Usage:\n"
+	       "    "
+	    << progName
+	    << " <ENTRIES> text|binary\n\n"
+	       "    Writes a synthetic changelog of ENTRIES changes (creation, writes and\n"
+	       "    removal of files) in the given format to a temporary file and replays\n"
+	       "    it in two ways:\n"
+	       "       - sequential: the changes are read and applied by one thread,\n"
+	       "       - pipelined: the changes are read and decoded by a worker thread\n"
+	       "         ahead of the applying one (ChangelogPrefetchingReader), as done\n"
+	       "         by sfsmetarestore and by the master loading changelogs.\n"
+	       "    The application of a change is simulated by parsing its arguments.\n"
+	       "    Entries per second are reported for both.\n"
+	    << std::endl;
+	exit(status);
+}
+
+std::string synthesizeEntry(uint64_t version) {
+	uint64_t inode = version / 3 + 2;
+	std::string ts = std::to_string(1700000000 + version / 1000);
+	switch (version % 3) {
+	case 0:
+		return ts + "|CREATE(1,file%2C" + std::to_string(inode) + ",f,420,0,0,0):" +
+		       std::to_string(inode);
+	case 1:
+		return ts + "|WRITE(" + std::to_string(inode) + ",0,1):" + std::to_string(version);
+	default:
+		return ts + "|UNLINK(1,file%2C" + std::to_string(inode) + "):" +
+		       std::to_string(inode);
+	}
+}
+
+/// Stand-in for restore(): splits the entry and parses its arguments
+uint64_t applyEntry(const std::string &entry) {
+	const char *ptr = entry.c_str() + 2;
+	char *end;
+	uint64_t result = strtoull(ptr, &end, 10);
+	const char *command = end + 1;
+	const char *args = strchr(command, '(');
+	if (args == nullptr) {
+		return result;
+	}
+	result += args - command;
+	for (ptr = args + 1; *ptr != '\0'; ++ptr) {
+		if (*ptr >= '0' && *ptr <= '9') {
+			result += strtoull(ptr, &end, 10);
+			ptr = end - 1;
+		} else if (*ptr == '%' && ptr[1] != '\0' && ptr[2] != '\0') {
+			result += strtoul(std::string(ptr + 1, 2).c_str(), nullptr, 16);
+			ptr += 2;
+		}
+	}
+	return result;
+}
+
+template <class Reader>
+double replay(const std::string &fileName, uint64_t expectedEntries) {
+	auto start = std::chrono::steady_clock::now();
+	Reader reader(fileName);
+	uint64_t version;
+	uint64_t entries = 0;
+	uint64_t checksum = 0;
+	std::string entry;
+	while (reader.next(version, entry)) {
+		checksum += applyEntry(entry);
+		++entries;
+	}
+	double seconds =
+	    std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (entries != expectedEntries || !reader.error().empty()) {
+		std::cerr << "Replayed " << entries << " of " << expectedEntries
+		          << " entries: " << reader.error() << std::endl;
+		exit(1);
+	}
+	gApplyResult = checksum;
+	return entries / seconds;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	if (argc != 3) { showHelpMessageAndExit(argv[0], 1); }
+	long long entries = atoll(argv[1]);
+	ChangelogFormat format;
+	if (strcmp(argv[2], "text") == 0) {
+		format = ChangelogFormat::kText;
+	} else if (strcmp(argv[2], "binary") == 0) {
+		format = ChangelogFormat::kBinary;
+	} else {
+		showHelpMessageAndExit(argv[0], 1);
+	}
+	if (entries <= 0) { showHelpMessageAndExit(argv[0], 1); }
+	mycrc32_init();
+
+	char fileName[] = "/tmp/changelog_replay_benchmark_XXXXXX";
+	int fd = mkstemp(fileName);
+	FILE *file = fd < 0 ? nullptr : fdopen(fd, "w");
+	if (file == nullptr) {
+		std::cerr << "Failed to create a temporary file: " << strerror(errno) << std::endl;
+		return 1;
+	}
+	bool ok = format == ChangelogFormat::kText || writeBinaryChangelogHeader(file);
+	for (long long version = 1; ok && version <= entries; ++version) {
+		ok = writeChangelogEntry(file, format, version, synthesizeEntry(version).c_str());
+	}
+	if (fclose(file) != 0 || !ok) {
+		std::cerr << "Failed to write " << fileName << ": " << strerror(errno) << std::endl;
+		unlink(fileName);
+		return 1;
+	}
+
+	// The first pass brings the file into the page cache
+	replay<ChangelogFileReader>(fileName, entries);
+	double sequential = replay<ChangelogFileReader>(fileName, entries);
+	double pipelined = replay<ChangelogPrefetchingReader>(fileName, entries);
+	unlink(fileName);
+
+	std::cout << std::fixed << std::setprecision(0) << argv[2] << " changelog, " << entries
+	          << " entries: sequential " << sequential << " entries/s, pipelined " << pipelined
+	          << " entries/s" << std::endl;
+	return 0;
+}
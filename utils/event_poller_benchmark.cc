@@ -0,0 +1,158 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+
+#include <poll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/event_poller.h"
+
+namespace {
+
+constexpr int kDefaultIterations = 10000;
+
+void showHelpMessageAndExit(char *progName, int status) {
+	std::cerr
+	    << "Usage:\n"
+	       "    "
+	    << progName
+	    << " <NUMBER_OF_CONNECTIONS> [ITERATIONS]\n\n"
+	       "    Measures the cost of a single wakeup of the event loop with\n"
+	       "    NUMBER_OF_CONNECTIONS idle descriptors (pipes) and one active\n"
+	       "    descriptor, for both ways of waiting for events:\n"
+	       "       - poll: the pollfd vector is rebuilt before every call, as\n"
+	       "         done by the desc/serve modules of the event loop.\n"
+	       "       - poller: the descriptors stay registered in an\n"
+	       "         EventPoller (epoll on Linux).\n\n"
+	       "    Default ITERATIONS is "
+	    << kDefaultIterations << ".\n"
+	    << std::endl;
+	exit(status);
+}
+
+void raiseDescriptorLimit(rlim_t needed) {
+	rlimit limit{};
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < needed) {
+		limit.rlim_cur = std::min(needed, limit.rlim_max);
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+}
+
+/// Makes the active descriptor readable and consumes the byte after the wakeup
+struct ActivePipe {
+	int fds[2] = {-1, -1};
+
+	void trigger() const {
+		if (write(fds[1], "x", 1) != 1) { std::abort(); }
+	}
+	void drain() const {
+		char byte;
+		if (read(fds[0], &byte, 1) != 1) { std::abort(); }
+	}
+};
+
+double measurePoll(const std::vector<int> &idle, const ActivePipe &active,
+                   int iterations) {
+	std::vector<pollfd> pdesc;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		active.trigger();
+		pdesc.clear();
+		for (int fd : idle) { pdesc.push_back({fd, POLLIN, 0}); }
+		pdesc.push_back({active.fds[0], POLLIN, 0});
+		if (poll(pdesc.data(), pdesc.size(), -1) != 1) { std::abort(); }
+		for (const auto &descriptor : pdesc) {
+			if (descriptor.revents & POLLIN) { active.drain(); }
+		}
+	}
+	std::chrono::duration<double, std::micro> elapsed =
+	    std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+
+double measurePoller(const std::vector<int> &idle, const ActivePipe &active,
+                     int iterations) {
+	EventPoller poller;
+	for (int fd : idle) { poller.add(fd, POLLIN); }
+	poller.add(active.fds[0], POLLIN);
+
+	std::vector<pollfd> ready;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		active.trigger();
+		if (poller.wait(-1, ready) != 1) { std::abort(); }
+		for (const auto &descriptor : ready) {
+			if (descriptor.revents & POLLIN) { active.drain(); }
+		}
+	}
+	std::chrono::duration<double, std::micro> elapsed =
+	    std::chrono::steady_clock::now() - start;
+	return elapsed.count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	if (argc < 2 || argc > 3) { showHelpMessageAndExit(argv[0], 1); }
+
+	int connections = std::atoi(argv[1]);
+	int iterations = argc == 3 ? std::atoi(argv[2]) : kDefaultIterations;
+	if (connections <= 0 || iterations <= 0) {
+		showHelpMessageAndExit(argv[0], 1);
+	}
+
+	raiseDescriptorLimit(2 * static_cast<rlim_t>(connections) + 64);
+
+	std::vector<int> idle;
+	std::vector<int> writeEnds;
+	for (int i = 0; i < connections; ++i) {
+		int fds[2];
+		if (pipe(fds) < 0) {
+			std::cerr << "Can't create " << connections
+			          << " pipes, raise the descriptor limit" << std::endl;
+			return 1;
+		}
+		idle.push_back(fds[0]);
+		writeEnds.push_back(fds[1]);
+	}
+	ActivePipe active;
+	if (pipe(active.fds) < 0) { return 1; }
+
+	double pollUs = measurePoll(idle, active, iterations);
+	double pollerUs = measurePoller(idle, active, iterations);
+
+	std::cout << std::fixed << std::setprecision(2)
+	          << "connections: " << connections << '\n'
+	          << "poll:   " << pollUs << " us/wakeup\n"
+	          << "poller: " << pollerUs << " us/wakeup" << std::endl;
+
+	for (int fd : idle) { close(fd); }
+	for (int fd : writeEnds) { close(fd); }
+	close(active.fds[0]);
+	close(active.fds[1]);
+	return 0;
+}
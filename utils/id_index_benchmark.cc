@@ -0,0 +1,171 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common/platform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "master/dense_id_map.h"
+
+namespace {
+
+constexpr uint32_t kDefaultLookups = 10000000;
+/// Size of the hash tables the master used to keep the nodes and the chunks in
+constexpr uint32_t kChainedHashBits = 22;
+constexpr uint32_t kChainedHashSize = 1U << kChainedHashBits;
+/// Part of the chunk ids left unused, like after deleting chunks
+constexpr double kDeletedChunksRatio = 0.2;
+
+/// Stands for FSNode or Chunk, with a similar size
+struct Element {
+	uint64_t id;
+	Element *next;  ///< only used by the chained hash table
+	char payload[80];
+};
+
+void showHelpMessageAndExit(char *progName, int status) {
+	std::cerr
+	    << "Usage:\n"
+	       "    "
+	    << progName
+	    << " <inodes|chunks> <COUNT> [LOOKUPS]\n\n"
+	       "    Measures the latency of random lookups, the time of iterating\n"
+	       "    over all the elements and the memory used per element by:\n"
+	       "       - chained: the fixed hash table of 2^"
+	    << kChainedHashBits
+	    << " buckets with\n"
+	       "         the collision chains going through the elements.\n"
+	       "       - dense: DenseIdMap indexed by the id.\n\n"
+	       "    Inodes are numbered from 1, as handed out by the inode pool.\n"
+	       "    Chunk ids are sequential too, but "
+	    << int(kDeletedChunksRatio * 100)
+	    << "% of them are left unused.\n"
+	       "    Default LOOKUPS is "
+	    << kDefaultLookups << ".\n"
+	    << std::endl;
+	exit(status);
+}
+
+template <typename Find>
+double measureLookups(const std::vector<uint64_t> &ids, Find find) {
+	uint64_t checksum = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (uint64_t id : ids) { checksum += find(id)->payload[0]; }
+	std::chrono::duration<double, std::nano> elapsed =
+	    std::chrono::steady_clock::now() - start;
+	if (checksum != 0) { std::abort(); }
+	return elapsed.count() / ids.size();
+}
+
+template <typename ForEach>
+double measureIteration(size_t count, ForEach forEach) {
+	uint64_t visited = 0;
+	auto start = std::chrono::steady_clock::now();
+	forEach([&visited](const Element *element) { visited += 1 + element->payload[0]; });
+	std::chrono::duration<double, std::milli> elapsed =
+	    std::chrono::steady_clock::now() - start;
+	if (visited != count) { std::abort(); }
+	return elapsed.count();
+}
+
+template <typename IdType>
+void runBenchmark(const std::vector<uint64_t> &usedIds, long lookups) {
+	std::vector<std::unique_ptr<Element>> elements(usedIds.size());
+	std::vector<Element *> chained(kChainedHashSize, nullptr);
+	DenseIdMap<IdType, Element> dense;
+	for (size_t i = 0; i < usedIds.size(); ++i) {
+		elements[i] = std::make_unique<Element>();
+		Element *element = elements[i].get();
+		element->id = usedIds[i];
+		uint32_t bucket = element->id & (kChainedHashSize - 1);
+		element->next = chained[bucket];
+		chained[bucket] = element;
+		dense.insert(element->id, element);
+	}
+
+	std::mt19937 generator(usedIds.size());
+	std::uniform_int_distribution<size_t> distribution(0, usedIds.size() - 1);
+	std::vector<uint64_t> ids(lookups);
+	for (auto &id : ids) { id = usedIds[distribution(generator)]; }
+
+	double chainedNs = measureLookups(ids, [&chained](uint64_t id) {
+		Element *element = chained[id & (kChainedHashSize - 1)];
+		while (element->id != id) { element = element->next; }
+		return element;
+	});
+	double denseNs = measureLookups(ids, [&dense](uint64_t id) { return dense.find(id); });
+
+	double chainedMs = measureIteration(usedIds.size(), [&chained](auto func) {
+		for (const Element *bucket : chained) {
+			for (const Element *element = bucket; element; element = element->next) {
+				func(element);
+			}
+		}
+	});
+	double denseMs = measureIteration(usedIds.size(),
+	                                  [&dense](auto func) { dense.forEach(func); });
+
+	size_t count = usedIds.size();
+	double chainedBytes =
+	    double(kChainedHashSize * sizeof(Element *) + count * sizeof(Element::next)) / count;
+	double denseBytes = double(dense.memoryUsage()) / count;
+
+	std::cout << std::fixed << std::setprecision(2) << "elements: " << count << '\n'
+	          << "chained: " << chainedNs << " ns/lookup, " << chainedMs << " ms/iteration, "
+	          << chainedBytes << " bytes/element\n"
+	          << "dense:   " << denseNs << " ns/lookup, " << denseMs << " ms/iteration, "
+	          << denseBytes << " bytes/element" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	if (argc < 3 || argc > 4) { showHelpMessageAndExit(argv[0], 1); }
+
+	std::string kind = argv[1];
+	long count = std::atol(argv[2]);
+	long lookups = argc == 4 ? std::atol(argv[3]) : kDefaultLookups;
+	if ((kind != "inodes" && kind != "chunks") || count <= 0 || lookups <= 0 ||
+	    count >= (1L << 32) - 1) {
+		showHelpMessageAndExit(argv[0], 1);
+	}
+
+	std::vector<uint64_t> usedIds;
+	usedIds.reserve(count);
+	if (kind == "inodes") {
+		for (long i = 1; i <= count; ++i) { usedIds.push_back(i); }
+		runBenchmark<uint32_t>(usedIds, lookups);
+	} else {
+		std::mt19937 generator(count);
+		std::bernoulli_distribution deleted(kDeletedChunksRatio);
+		for (uint64_t id = 1; usedIds.size() < size_t(count); ++id) {
+			if (!deleted(generator)) { usedIds.push_back(id); }
+		}
+		runBenchmark<uint64_t>(usedIds, lookups);
+	}
+	return 0;
+}
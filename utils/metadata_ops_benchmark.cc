@@ -0,0 +1,121 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+/// Lookup, create, close and unlink of a fresh file name (so no kernel cache answers them)
+constexpr int kOperationsPerIteration = 4;
+
+void showHelpMessageAndExit(char *progName, int status) {
+	std::cerr
+	    << "Usage:\n"
+	       "    "
+	    << progName
+	    << " <TESTING_PATH> <THREADS> <SECONDS>\n\n"
+	       "    Creates a folder 'metadata_ops_benchmark_<TIMESTAMP>' in the provided\n"
+	       "    path and runs THREADS threads for SECONDS seconds, each one repeating\n"
+	       "    in its own subfolder (like a build writing small files):\n"
+	       "       - lookup of a missing file,\n"
+	       "       - create,\n"
+	       "       - close,\n"
+	       "       - unlink.\n\n"
+	       "    The number of metadata operations per second is reported.\n\n"
+	       "    Note: THREADS and SECONDS must be positive.\n"
+	    << std::endl;
+	exit(status);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	if (argc != 4) { showHelpMessageAndExit(argv[0], 1); }
+
+	std::string testingPath(argv[1]);
+	int threadsCount = atoi(argv[2]);
+	int seconds = atoi(argv[3]);
+	if (threadsCount <= 0 || seconds <= 0) { showHelpMessageAndExit(argv[0], 1); }
+
+	std::string folderPath =
+	    testingPath + "/metadata_ops_benchmark_" + std::to_string(time(0));
+	if (!std::filesystem::create_directory(folderPath)) {
+		std::cerr << "Failed to create folder '" << folderPath << "'." << std::endl;
+		return 1;
+	}
+
+	std::atomic<bool> stop(false);
+	std::atomic<bool> failed(false);
+	std::vector<uint64_t> iterations(threadsCount, 0);
+	std::vector<std::thread> threads;
+	auto start = std::chrono::steady_clock::now();
+	for (int t = 0; t < threadsCount; ++t) {
+		threads.emplace_back([&, t]() {
+			std::string threadPath = folderPath + "/thread_" + std::to_string(t);
+			if (mkdir(threadPath.c_str(), 0755) != 0) {
+				std::cerr << "Failed to create folder '" << threadPath << "'." << std::endl;
+				failed = true;
+				return;
+			}
+			struct stat st;
+			for (uint64_t i = 0; !stop && !failed; ++i) {
+				std::string filePath = threadPath + "/file_" + std::to_string(i);
+				if (stat(filePath.c_str(), &st) == 0) {
+					std::cerr << "File '" << filePath << "' should not exist." << std::endl;
+					failed = true;
+					return;
+				}
+				int fd = open(filePath.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+				if (fd == -1 || close(fd) != 0 || unlink(filePath.c_str()) != 0) {
+					std::cerr << "Failed to create/close/delete file '" << filePath << "'."
+					          << std::endl;
+					failed = true;
+					return;
+				}
+				++iterations[t];
+			}
+		});
+	}
+	std::this_thread::sleep_for(std::chrono::seconds(seconds));
+	stop = true;
+	for (auto &thread : threads) { thread.join(); }
+	std::chrono::duration<double> elapsedTime = std::chrono::steady_clock::now() - start;
+
+	std::filesystem::remove_all(folderPath);
+	if (failed) { return 1; }
+
+	uint64_t operations = 0;
+	for (uint64_t count : iterations) { operations += count * kOperationsPerIteration; }
+	std::cout << std::fixed << std::setprecision(0) << "threads: " << threadsCount
+	          << ", operations: " << operations << ", "
+	          << operations / elapsedTime.count() << " metadata ops/s" << std::endl;
+	return 0;
+}
@@ -0,0 +1,148 @@
+/*
+   Copyright 2023 Leil Storage OÜ
+
+   This file is part of SaunaFS.
+
+   SaunaFS is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, version 3.
+
+   SaunaFS is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with SaunaFS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mount/client/saunafs_c_api.h"
+
+namespace {
+
+constexpr uint32_t kDefaultBlockSizeKiB = 64;
+/// Big enough for the writers not to wait for free blocks when they are few
+constexpr unsigned kWriteCacheSizeMiB = 1024;
+
+void showHelpMessageAndExit(char *progName, int status) {
+	std::cerr
+	    << "Usage:\n"
+	       "    "
+	    << progName
+	    << " <HOST> <PORT> <WRITERS> <MiB_PER_WRITER> [BLOCK_KiB]\n\n"
+	       "    Connects to the master server with the client library and runs\n"
+	       "    WRITERS threads, each one writing MiB_PER_WRITER MiB to its own new file\n"
+	       "    in the root folder in sequential writes of BLOCK_KiB KiB (default "
+	    << kDefaultBlockSizeKiB
+	    << ").\n"
+	       "    The throughput of the writes going into the write cache and the\n"
+	       "    throughput including the final flush to the chunkservers are reported.\n"
+	       "    The files are removed at the end.\n\n"
+	       "    Note: WRITERS, MiB_PER_WRITER and BLOCK_KiB must be positive.\n"
+	    << std::endl;
+	exit(status);
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+	if (argc < 5 || argc > 6) { showHelpMessageAndExit(argv[0], 1); }
+
+	int writersCount = atoi(argv[3]);
+	long mebibytesPerWriter = atol(argv[4]);
+	long blockSize = (argc == 6 ? atol(argv[5]) : kDefaultBlockSizeKiB) * 1024;
+	if (writersCount <= 0 || mebibytesPerWriter <= 0 || blockSize <= 0) {
+		showHelpMessageAndExit(argv[0], 1);
+	}
+
+	sau_init_params_t params;
+	sau_set_default_init_params(&params, argv[1], argv[2], "write_throughput_benchmark");
+	params.write_cache_size = kWriteCacheSizeMiB;
+	sau_t *instance = sau_init_with_params(&params);
+	if (instance == nullptr) {
+		std::cerr << "Failed to connect to the master server: "
+		          << sau_error_string(sau_last_err()) << std::endl;
+		return 1;
+	}
+
+	std::string prefix = "write_throughput_benchmark_" + std::to_string(time(0)) + "_";
+	std::atomic<bool> failed(false);
+	std::atomic<int> writersDone(0);
+	std::atomic<bool> startWriting(false);
+	std::chrono::steady_clock::time_point start;
+	double cachedSeconds = 0;
+	std::vector<std::thread> threads;
+	for (int t = 0; t < writersCount; ++t) {
+		threads.emplace_back([&, t]() {
+			sau_context_t *ctx = sau_create_context();
+			std::string name = prefix + std::to_string(t);
+			sau_entry_t entry;
+			sau_fileinfo_t *fileinfo = nullptr;
+			if (sau_mknod(instance, ctx, SAUNAFS_INODE_ROOT, name.c_str(), 0644, 0, &entry) != 0 ||
+			    (fileinfo = sau_open(instance, ctx, entry.ino, O_WRONLY)) == nullptr) {
+				std::cerr << "Failed to create file '" << name
+				          << "': " << sau_error_string(sau_last_err()) << std::endl;
+				failed = true;
+			}
+			std::vector<char> buffer(blockSize, char('a' + t % 26));
+			while (!startWriting) { std::this_thread::yield(); }
+
+			off_t end = mebibytesPerWriter * 1024 * 1024;
+			for (off_t offset = 0; fileinfo && !failed && offset < end; offset += blockSize) {
+				size_t size = std::min<off_t>(blockSize, end - offset);
+				if (sau_write(instance, ctx, fileinfo, offset, size, buffer.data()) !=
+				    ssize_t(size)) {
+					std::cerr << "Failed to write file '" << name
+					          << "': " << sau_error_string(sau_last_err()) << std::endl;
+					failed = true;
+				}
+			}
+			if (++writersDone == writersCount) { cachedSeconds = secondsSince(start); }
+			if (fileinfo) {
+				if (!failed && sau_flush(instance, ctx, fileinfo) != 0) {
+					std::cerr << "Failed to flush file '" << name
+					          << "': " << sau_error_string(sau_last_err()) << std::endl;
+					failed = true;
+				}
+				sau_release(instance, fileinfo);
+			}
+			sau_destroy_context(&ctx);
+		});
+	}
+	start = std::chrono::steady_clock::now();
+	startWriting = true;
+	for (auto &thread : threads) { thread.join(); }
+	double totalSeconds = secondsSince(start);
+
+	sau_context_t *ctx = sau_create_context();
+	for (int t = 0; t < writersCount; ++t) {
+		sau_unlink(instance, ctx, SAUNAFS_INODE_ROOT, (prefix + std::to_string(t)).c_str());
+	}
+	sau_destroy_context(&ctx);
+	sau_destroy(instance);
+	if (failed) { return 1; }
+
+	double mebibytes = double(writersCount) * mebibytesPerWriter;
+	std::cout << std::fixed << std::setprecision(1) << "writers: " << writersCount
+	          << ", written: " << mebibytes << " MiB, " << mebibytes / cachedSeconds
+	          << " MiB/s into the write cache, " << mebibytes / totalSeconds
+	          << " MiB/s including the flush" << std::endl;
+	return 0;
+}